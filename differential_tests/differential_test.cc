@@ -0,0 +1,541 @@
+/*!
+ \file differential_test.cc
+ \brief randomized comparison of optimized paths against the reference
+ engine
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "differential_tests/differential_test.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "interpolate-genetic-position/compiled_genetic_map.h"
+#include "interpolate-genetic-position/genetic_map.h"
+#include "interpolate-genetic-position/gmp_arena.h"
+#include "interpolate-genetic-position/input_genetic_map_file.h"
+#include "interpolate-genetic-position/interpolator.h"
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+/*!
+ * \brief read an optional numeric setting from the environment
+ * \param name name of environment variable
+ * \param fallback value used if the variable is unset or empty
+ * \return value of setting
+ */
+double environment_setting(const char *name, double fallback) {
+  const char *value = std::getenv(name);
+  if (!value || !*value) {
+    return fallback;
+  }
+  char *end = NULL;
+  double res = std::strtod(value, &end);
+  if (*end) {
+    throw std::runtime_error(std::string("cannot parse ") + name + ": \"" +
+                             value + "\"");
+  }
+  return res;
+}
+
+/*!
+ * \brief name a chromosome code in one of the conventions seen in
+ * real datasets
+ * \param code numeric chromosome code
+ * \param prefix whether to prefix the name with "chr"
+ * \return name of chromosome
+ */
+std::string chromosome_name(int code, bool prefix) {
+  std::string name = code == 23 ? "X" : std::to_string(code);
+  return prefix ? "chr" + name : name;
+}
+
+/*!
+ * \brief draw a uniform integer from a closed range
+ * \param rng random number generator
+ * \param low minimum value
+ * \param high maximum value
+ * \return drawn value
+ */
+int64_t uniform(std::mt19937_64 *rng, int64_t low, int64_t high) {
+  return std::uniform_int_distribution<int64_t>(low, high)(*rng);
+}
+
+/*!
+ * \brief format a fixed point value for a map file
+ * \param value value in units of the final decimal place
+ * \param digits number of digits after the decimal
+ * \return formatted value
+ */
+std::string format_fixed(int64_t value, int digits) {
+  std::string res = std::to_string(value);
+  if (res.size() <= static_cast<size_t>(digits)) {
+    res.insert(0, digits + 1 - res.size(), '0');
+  }
+  res.insert(res.size() - digits, ".");
+  return res;
+}
+
+/*!
+ * \brief summarize a segment for failure messages
+ * \param result segment to summarize
+ * \return description of segment
+ */
+std::string describe(const igp::query_result &result) {
+  std::ostringstream o;
+  o << result.get_chr() << ":" << result.get_startpos() << "-"
+    << result.get_endpos() << " gpos " << result.get_gpos() << " rate "
+    << result.get_rate();
+  return o.str();
+}
+
+/*!
+ * \brief determine whether two segments are identical
+ * \param lhs first segment
+ * \param rhs second segment
+ * \return whether the segments are identical
+ */
+bool identical(const igp::query_result &lhs, const igp::query_result &rhs) {
+  return !lhs.get_chr().compare(rhs.get_chr()) &&
+         !cmp(lhs.get_startpos(), rhs.get_startpos()) &&
+         !cmp(lhs.get_endpos(), rhs.get_endpos()) &&
+         !cmp(lhs.get_gpos(), rhs.get_gpos()) &&
+         !cmp(lhs.get_rate(), rhs.get_rate());
+}
+
+/*!
+ * \brief run the reference engine over queries, one segment at a time
+ * \param mapfile opened genetic map
+ * \param queries sorted queries
+ * \return every segment of every query
+ */
+std::vector<igp::query_result> run_reference(
+    igp::base_input_genetic_map_file *mapfile,
+    const std::vector<differential_query> &queries) {
+  igp::genetic_map gm(mapfile);
+  std::vector<igp::query_result> res, segments;
+  for (std::vector<differential_query>::const_iterator iter = queries.begin();
+       iter != queries.end(); ++iter) {
+    gm.query(iter->chr, iter->pos1, iter->pos2, false, &segments);
+    res.insert(res.end(), segments.begin(), segments.end());
+  }
+  return res;
+}
+}  // namespace
+
+differentialTest::differentialTest()
+    : testing::Test(),
+      _seed(static_cast<unsigned long long>(
+          environment_setting("IGP_DIFFERENTIAL_SEED", 1.0))),
+      _rounds(static_cast<unsigned>(
+          environment_setting("IGP_DIFFERENTIAL_ROUNDS", 40.0))),
+      _tolerance(environment_setting("IGP_DIFFERENTIAL_TOLERANCE", 1e-9)) {}
+
+differentialTest::~differentialTest() throw() {
+  for (std::vector<std::string>::const_iterator iter = _tmpfiles.begin();
+       iter != _tmpfiles.end(); ++iter) {
+    if (boost::filesystem::exists(*iter)) {
+      boost::filesystem::remove(*iter);
+    }
+  }
+}
+
+differential_map differentialTest::generate_map(std::mt19937_64 *rng,
+                                                igp::format_type ft) const {
+  differential_map map;
+  map.ft = ft;
+  std::ostringstream content;
+  if (ft == igp::BOLT) {
+    content << "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n";
+  }
+  bool prefix = uniform(rng, 0, 1);
+  // a sparse subset of chromosomes, so that queries fall on chromosomes
+  // before, between and after those in the map
+  std::vector<int> codes;
+  for (int code = 1; code <= 23; ++code) {
+    if (!uniform(rng, 0, 5)) {
+      codes.push_back(code);
+    }
+  }
+  if (codes.empty()) {
+    codes.push_back(static_cast<int>(uniform(rng, 1, 23)));
+  }
+  for (std::vector<int>::const_iterator code = codes.begin();
+       code != codes.end(); ++code) {
+    std::string chr = chromosome_name(*code, prefix);
+    map.chromosomes.push_back(chr);
+    map.boundaries.push_back(std::vector<int64_t>());
+    std::vector<int64_t> &boundaries = map.boundaries.back();
+    // single row chromosomes are a separate case at both ends
+    int64_t n_rows = uniform(rng, 0, 4) ? uniform(rng, 2, 12) : 1;
+    int64_t pos = uniform(rng, 0, 200000);
+    // genetic position is accumulated exactly, in units of 1e-12 cM, so
+    // that rows agree with interpolation from the rows before them
+    int64_t gpos = 0;
+    for (int64_t i = 0; i < n_rows; ++i) {
+      // rate in units of 1e-6 cM/Mb; some zero rates, and the final rate
+      // is often zero
+      bool nonzero =
+          uniform(rng, 0, 4) && (i + 1 < n_rows || uniform(rng, 0, 1));
+      int64_t rate = nonzero ? uniform(rng, 1, 3000000) : 0;
+      // some rows are adjacent, to exercise exact boundary matches
+      int64_t width =
+          uniform(rng, 0, 5) ? uniform(rng, 1, 300000) : uniform(rng, 1, 3);
+      if (ft == igp::BOLT) {
+        content << chr << ' ' << pos + 1 << ' ' << format_fixed(rate, 6)
+                << ' ' << format_fixed(gpos, 12) << '\n';
+        boundaries.push_back(pos + 1);
+        gpos += rate * width;
+        pos += width;
+      } else {
+        content << chr << '\t' << pos << '\t' << pos + width << '\t'
+                << format_fixed(rate, 6) << '\n';
+        boundaries.push_back(pos + 1);
+        boundaries.push_back(pos + width);
+        boundaries.push_back(pos + width + 1);
+        // bedgraph tracks may skip ranges without estimates
+        pos += width + (uniform(rng, 0, 2) ? 0 : uniform(rng, 1, 50000));
+      }
+    }
+  }
+  map.content = content.str();
+  return map;
+}
+
+std::vector<differential_query> differentialTest::generate_points(
+    std::mt19937_64 *rng, const differential_map &map) const {
+  std::vector<differential_query> queries;
+  bool prefix = uniform(rng, 0, 1);
+  for (int code = 1; code <= 23; ++code) {
+    std::vector<std::string>::const_iterator finder = map.chromosomes.end();
+    for (std::vector<std::string>::const_iterator iter =
+             map.chromosomes.begin();
+         iter != map.chromosomes.end(); ++iter) {
+      if (igp::chromosome_compare(*iter, chromosome_name(code, prefix)) ==
+          igp::EQUAL) {
+        finder = iter;
+      }
+    }
+    std::vector<int64_t> candidates;
+    if (finder != map.chromosomes.end()) {
+      const std::vector<int64_t> &boundaries =
+          map.boundaries.at(finder - map.chromosomes.begin());
+      for (std::vector<int64_t>::const_iterator iter = boundaries.begin();
+           iter != boundaries.end(); ++iter) {
+        for (int64_t offset = -1; offset <= 1; ++offset) {
+          if (*iter + offset > 0 && uniform(rng, 0, 2)) {
+            candidates.push_back(*iter + offset);
+          }
+        }
+      }
+      for (unsigned i = 0; i < 10; ++i) {
+        candidates.push_back(uniform(rng, 1, boundaries.back() + 100000));
+      }
+    } else if (!uniform(rng, 0, 3)) {
+      for (unsigned i = 0; i < 3; ++i) {
+        candidates.push_back(uniform(rng, 1, 1000000));
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (std::vector<int64_t>::const_iterator iter = candidates.begin();
+         iter != candidates.end(); ++iter) {
+      differential_query query;
+      query.chr = chromosome_name(code, prefix);
+      query.pos1 = *iter;
+      query.pos2 = -1;
+      queries.push_back(query);
+    }
+  }
+  return queries;
+}
+
+std::vector<differential_query> differentialTest::generate_regions(
+    std::mt19937_64 *rng, const differential_map &map) const {
+  std::vector<differential_query> points = generate_points(rng, map);
+  std::vector<differential_query> regions;
+  unsigned label = 0;
+  for (std::vector<differential_query>::const_iterator iter = points.begin();
+       iter + 1 < points.end(); ++iter) {
+    std::vector<differential_query>::const_iterator next = iter + 1;
+    if (iter->chr.compare(next->chr) || iter->pos1 == next->pos1) {
+      continue;
+    }
+    // regions either share an endpoint with the previous region, or are
+    // separated from it by a gap
+    if (!regions.empty() && !regions.back().chr.compare(iter->chr) &&
+        regions.back().pos2 > iter->pos1) {
+      continue;
+    }
+    if (uniform(rng, 0, 3)) {
+      differential_query region = *iter;
+      region.pos2 = next->pos1;
+      if (uniform(rng, 0, 2) == 0) {
+        ++label;
+      }
+      region.label = "l" + std::to_string(label);
+      regions.push_back(region);
+    }
+  }
+  return regions;
+}
+
+void differentialTest::write_file(const std::string &filename,
+                                  const std::string &content,
+                                  bool compress) const {
+  if (compress) {
+    gzFile output = gzopen(filename.c_str(), "wb");
+    if (!output) {
+      throw std::runtime_error("write_file: cannot open write connection");
+    }
+    int n_written = content.empty() ? 0
+                                    : gzwrite(output, content.c_str(),
+                                              static_cast<unsigned>(
+                                                  content.size()));
+    gzclose(output);
+    if (n_written != static_cast<int>(content.size())) {
+      throw std::runtime_error("write_file: cannot write to file");
+    }
+    return;
+  }
+  std::ofstream output(filename.c_str(), std::ios::binary);
+  if (!(output << content)) {
+    throw std::runtime_error("write_file: cannot write to file");
+  }
+}
+
+std::string differentialTest::read_file(const std::string &filename) const {
+  std::ifstream input(filename.c_str(), std::ios::binary);
+  if (!input.is_open()) {
+    throw std::runtime_error("read_file: cannot open \"" + filename + "\"");
+  }
+  std::ostringstream content;
+  content << input.rdbuf();
+  return content.str();
+}
+
+bool differentialTest::within_tolerance(double observed,
+                                        const mpf_class &expected) const {
+  double reference = expected.get_d();
+  return std::fabs(observed - reference) <=
+         _tolerance * std::max(1.0, std::fabs(reference));
+}
+
+std::string differentialTest::run_interpolator(
+    const std::string &query_filename, const std::string &preset,
+    const std::string &map_filename, const std::string &map_format,
+    const std::string &output_filename, const std::string &output_format,
+    double step_interval, bool pipelined) const {
+  {
+    igp::interpolator ip;
+    ip.set_pipelined(pipelined);
+    ip.interpolate(query_filename, preset, map_filename, map_format,
+                   output_filename, output_format, false, step_interval, 0,
+                   false);
+  }
+  return read_file(output_filename);
+}
+
+std::string differentialTest::temporary_file(const std::string &suffix) {
+  _tmpfiles.push_back(boost::filesystem::unique_path().native() + suffix);
+  return _tmpfiles.back();
+}
+
+TEST_F(differentialTest, pointQueriesAgree) {
+  std::string map_filename = temporary_file(".map");
+  for (unsigned round = 0; round < _rounds; ++round) {
+    unsigned long long seed = _seed + round;
+    SCOPED_TRACE("IGP_DIFFERENTIAL_SEED=" + std::to_string(seed));
+    std::mt19937_64 rng(seed);
+    differential_map map =
+        generate_map(&rng, round % 2 ? igp::BEDGRAPH : igp::BOLT);
+    std::vector<differential_query> queries = generate_points(&rng, map);
+    write_file(map_filename, map.content, false);
+    // reference: the mpf engine reading a file in place
+    igp::input_genetic_map_file mapped;
+    mapped.open(map_filename, map.ft);
+    std::vector<igp::query_result> expected = run_reference(&mapped, queries);
+    ASSERT_EQ(expected.size(), queries.size());
+    // the mpf engine reading the same map from a stream
+    std::istringstream strm(map.content);
+    igp::input_genetic_map_file streamed;
+    streamed.set_fallback_stream(&strm);
+    streamed.open("", map.ft);
+    std::vector<igp::query_result> observed = run_reference(&streamed, queries);
+    ASSERT_EQ(observed.size(), expected.size());
+    for (unsigned i = 0; i < expected.size(); ++i) {
+      ASSERT_TRUE(identical(observed.at(i), expected.at(i)))
+          << "streamed map: " << describe(observed.at(i))
+          << ", reference: " << describe(expected.at(i));
+    }
+    // double precision batches, one chromosome at a time
+    igp::compiled_genetic_map compiled;
+    compiled.open(map_filename, map.ft);
+    for (unsigned start = 0; start < queries.size();) {
+      unsigned end = start;
+      std::vector<int64_t> positions;
+      while (end < queries.size() &&
+             !queries.at(end).chr.compare(queries.at(start).chr)) {
+        positions.push_back(queries.at(end).pos1);
+        ++end;
+      }
+      std::vector<double> gpos(positions.size()), rate(positions.size());
+      compiled.interpolate(queries.at(start).chr, positions.data(),
+                           positions.size(), gpos.data(), rate.data());
+      for (unsigned i = start; i < end; ++i) {
+        ASSERT_TRUE(within_tolerance(gpos.at(i - start),
+                                     expected.at(i).get_gpos()) &&
+                    within_tolerance(rate.at(i - start),
+                                     expected.at(i).get_rate()))
+            << "compiled map: gpos " << gpos.at(i - start) << " rate "
+            << rate.at(i - start) << ", reference: " << describe(expected.at(i))
+            << "\nmap:\n"
+            << map.content;
+      }
+      start = end;
+    }
+  }
+}
+
+TEST_F(differentialTest, regionQueriesAgree) {
+  std::string map_filename = temporary_file(".map");
+  for (unsigned round = 0; round < _rounds; ++round) {
+    unsigned long long seed = _seed + round;
+    SCOPED_TRACE("IGP_DIFFERENTIAL_SEED=" + std::to_string(seed));
+    std::mt19937_64 rng(seed);
+    differential_map map =
+        generate_map(&rng, round % 2 ? igp::BEDGRAPH : igp::BOLT);
+    std::vector<differential_query> regions = generate_regions(&rng, map);
+    write_file(map_filename, map.content, false);
+    // reference: each region split into segments one query at a time
+    igp::input_genetic_map_file reference_file;
+    reference_file.open(map_filename, map.ft);
+    std::vector<igp::query_result> expected =
+        run_reference(&reference_file, regions);
+    // swept regions, with and without the verbose path that skips the
+    // interval shortcut
+    for (unsigned verbose = 0; verbose < 2; ++verbose) {
+      igp::input_genetic_map_file sweep_file;
+      sweep_file.open(map_filename, map.ft);
+      igp::genetic_map gm(&sweep_file);
+      std::ostringstream logstrm;
+      gm.set_logstrm(&logstrm);
+      std::vector<igp::query_result> observed;
+      for (std::vector<differential_query>::const_iterator iter =
+               regions.begin();
+           iter != regions.end(); ++iter) {
+        gm.sweep(iter->chr, iter->pos1, iter->pos2, verbose,
+                 [&observed](const igp::query_result &result) {
+                   observed.push_back(result);
+                 });
+      }
+      ASSERT_EQ(observed.size(), expected.size()) << "verbose " << verbose;
+      for (unsigned i = 0; i < expected.size(); ++i) {
+        ASSERT_TRUE(identical(observed.at(i), expected.at(i)))
+            << "sweep (verbose " << verbose
+            << "): " << describe(observed.at(i))
+            << ", reference: " << describe(expected.at(i));
+      }
+    }
+    // every segment starts where a point query would report the same
+    // values
+    igp::compiled_genetic_map compiled;
+    compiled.open(map_filename, map.ft);
+    for (unsigned i = 0; i < expected.size(); ++i) {
+      int64_t pos = expected.at(i).get_startpos().get_si();
+      double gpos = 0.0, rate = 0.0;
+      compiled.interpolate(expected.at(i).get_chr(), &pos, 1, &gpos, &rate);
+      ASSERT_TRUE(within_tolerance(gpos, expected.at(i).get_gpos()) &&
+                  within_tolerance(rate, expected.at(i).get_rate()))
+          << "compiled map: gpos " << gpos << " rate " << rate
+          << ", reference: " << describe(expected.at(i)) << "\nmap:\n"
+          << map.content;
+    }
+  }
+}
+
+TEST_F(differentialTest, outputBytesAgreeAcrossModes) {
+  std::string map_plain = temporary_file(".map");
+  std::string map_compressed = temporary_file(".map.gz");
+  std::string query_plain = temporary_file(".query");
+  std::string query_compressed = temporary_file(".query.gz");
+  std::string output_filename = temporary_file(".output");
+  for (unsigned round = 0; round < _rounds; ++round) {
+    unsigned long long seed = _seed + round;
+    SCOPED_TRACE("IGP_DIFFERENTIAL_SEED=" + std::to_string(seed));
+    std::mt19937_64 rng(seed);
+    differential_map map =
+        generate_map(&rng, round % 2 ? igp::BEDGRAPH : igp::BOLT);
+    std::string map_format = map.ft == igp::BOLT ? "bolt" : "bedgraph";
+    write_file(map_plain, map.content, false);
+    write_file(map_compressed, map.content, true);
+    // point queries as a bim file, and regions as a bed file
+    for (unsigned regions = 0; regions < 2; ++regions) {
+      std::vector<differential_query> queries =
+          regions ? generate_regions(&rng, map) : generate_points(&rng, map);
+      std::ostringstream query_content;
+      for (unsigned i = 0; i < queries.size(); ++i) {
+        const differential_query &query = queries.at(i);
+        if (regions) {
+          query_content << query.chr << '\t' << query.pos1 - 1 << '\t'
+                        << query.pos2 - 1 << '\t' << query.label << '\n';
+        } else {
+          query_content << query.chr << "\trs" << i << "\t0\t" << query.pos1
+                        << "\tA\tC\n";
+        }
+      }
+      write_file(query_plain, query_content.str(), false);
+      write_file(query_compressed, query_content.str(), true);
+      std::string preset = regions ? "bed" : "bim";
+      std::vector<std::string> output_formats;
+      if (regions) {
+        output_formats.push_back("bolt");
+      } else {
+        output_formats.push_back("bim");
+        output_formats.push_back("arrow");
+      }
+      double step_interval = regions && round % 3 ? 0.5 : 0.0;
+      for (std::vector<std::string>::const_iterator output_format =
+               output_formats.begin();
+           output_format != output_formats.end(); ++output_format) {
+        SCOPED_TRACE(preset + " input, " + *output_format + " output");
+        // reference: sequential, files read in place
+        std::string expected, observed;
+        ASSERT_NO_THROW(expected = run_interpolator(
+                            query_plain, preset, map_plain, map_format,
+                            output_filename, *output_format, step_interval,
+                            false))
+            << "map:\n"
+            << map.content << "queries:\n"
+            << query_content.str();
+        // pipelined
+        ASSERT_NO_THROW(observed = run_interpolator(
+                            query_plain, preset, map_plain, map_format,
+                            output_filename, *output_format, step_interval,
+                            true));
+        EXPECT_EQ(observed, expected) << "pipelined";
+        // compressed inputs, read through the streaming readers
+        ASSERT_NO_THROW(observed = run_interpolator(
+                            query_compressed, preset, map_compressed,
+                            map_format, output_filename, *output_format,
+                            step_interval, false));
+        EXPECT_EQ(observed, expected) << "compressed";
+        // GMP temporaries from the arena
+        igp::gmp_arena::install();
+        EXPECT_NO_THROW(observed = run_interpolator(
+                            query_plain, preset, map_plain, map_format,
+                            output_filename, *output_format, step_interval,
+                            false));
+        igp::gmp_arena::uninstall();
+        EXPECT_EQ(observed, expected) << "gmp arena";
+      }
+    }
+  }
+}
@@ -0,0 +1,146 @@
+/*!
+ \file differential_test.h
+ \brief randomized comparison of optimized paths against the reference
+ engine
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef DIFFERENTIAL_TESTS_DIFFERENTIAL_TEST_H_
+#define DIFFERENTIAL_TESTS_DIFFERENTIAL_TEST_H_
+
+#include <gmpxx.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+#include "interpolate-genetic-position/utilities.h"
+
+/*!
+ * \struct differential_map
+ * \brief a randomly generated genetic map, as file text
+ */
+struct differential_map {
+  interpolate_genetic_position::format_type ft;  //!< bolt or bedgraph
+  std::string content;                           //!< text of map file
+  std::vector<std::string> chromosomes;  //!< chromosomes, in file order
+  std::vector<std::vector<int64_t> > boundaries;  //!< interesting positions
+};
+
+/*!
+ * \struct differential_query
+ * \brief a point or region query
+ */
+struct differential_query {
+  std::string chr;  //!< chromosome of query
+  int64_t pos1;     //!< 1-based start position of query
+  int64_t pos2;     //!< 1-based end position of region, or -1 for points
+  std::string label;  //!< label of region
+};
+
+/*!
+ * \class differentialTest
+ * \brief generate randomized maps and queries, including edge cases at
+ * chromosome starts and ends, bedgraph end positions and gaps between
+ * regions, and require every optimized path to agree with the reference
+ * mpf engine.
+ *
+ * The following environment variables adjust the run:
+ *   - IGP_DIFFERENTIAL_SEED: seed of the first round (default 1)
+ *   - IGP_DIFFERENTIAL_ROUNDS: number of random cases per test (default 40)
+ *   - IGP_DIFFERENTIAL_TOLERANCE: allowed difference, relative to
+ *     max(1, |reference|), for paths computed in double precision
+ *     (default 1e-9)
+ *
+ * Paths using GMP arithmetic must agree exactly, or produce identical
+ * output bytes. Failures report the seed of the round, which can be
+ * passed back in with IGP_DIFFERENTIAL_ROUNDS=1 to reproduce it.
+ */
+class differentialTest : public testing::Test {
+ protected:
+  differentialTest();
+  ~differentialTest() throw();
+  /*!
+   * \brief generate a random genetic map
+   * \param rng random number generator
+   * \param ft format of map, bolt or bedgraph
+   * \return generated map
+   */
+  differential_map generate_map(std::mt19937_64 *rng,
+                                interpolate_genetic_position::format_type ft)
+      const;
+  /*!
+   * \brief generate sorted point queries against a map
+   * \param rng random number generator
+   * \param map generated map
+   * \return sorted point queries, including chromosomes absent from the
+   * map
+   */
+  std::vector<differential_query> generate_points(
+      std::mt19937_64 *rng, const differential_map &map) const;
+  /*!
+   * \brief generate sorted, nonoverlapping regions against a map
+   * \param rng random number generator
+   * \param map generated map
+   * \return sorted regions, including chromosomes absent from the map
+   */
+  std::vector<differential_query> generate_regions(
+      std::mt19937_64 *rng, const differential_map &map) const;
+  /*!
+   * \brief write text to a file, compressing with gzip if requested
+   * \param filename name of file to write
+   * \param content text to write
+   * \param compress whether to write gzip format
+   */
+  void write_file(const std::string &filename, const std::string &content,
+                  bool compress) const;
+  /*!
+   * \brief read the contents of a file
+   * \param filename name of file to read
+   * \return contents of file
+   */
+  std::string read_file(const std::string &filename) const;
+  /*!
+   * \brief run a full interpolation pass
+   * \param query_filename name of query file
+   * \param preset format of query file
+   * \param map_filename name of genetic map file
+   * \param map_format format of genetic map file
+   * \param output_filename name of output file
+   * \param output_format format of output file
+   * \param step_interval genetic distance added between bed regions
+   * \param pipelined whether to run stages on dedicated threads
+   * \return contents of output file
+   */
+  std::string run_interpolator(const std::string &query_filename,
+                               const std::string &preset,
+                               const std::string &map_filename,
+                               const std::string &map_format,
+                               const std::string &output_filename,
+                               const std::string &output_format,
+                               double step_interval, bool pipelined) const;
+  /*!
+   * \brief determine whether a double-precision result is within
+   * tolerance of the reference
+   * \param observed result of path under test
+   * \param expected reference result
+   * \return whether the result is within tolerance
+   */
+  bool within_tolerance(double observed, const mpf_class &expected) const;
+  /*!
+   * \brief get a temporary file name, removed with the fixture
+   * \param suffix suffix of file name
+   * \return temporary file name
+   */
+  std::string temporary_file(const std::string &suffix);
+  unsigned long long _seed;  //!< seed of first round
+  unsigned _rounds;          //!< number of rounds per test
+  double _tolerance;         //!< tolerance of double-precision paths
+  std::vector<std::string> _tmpfiles;  //!< temporary files to remove
+};
+
+#endif  // DIFFERENTIAL_TESTS_DIFFERENTIAL_TEST_H_
@@ -69,6 +69,26 @@ std::string integrationTest::create_compressed_file(
   return content;
 }
 
+std::string integrationTest::create_zstd_file(
+    const std::string &filename, const std::string &content) const {
+  std::vector<char> buffer(ZSTD_compressBound(content.size()));
+  size_t res = ZSTD_compress(buffer.data(), buffer.size(), content.c_str(),
+                             content.size(), 3);
+  if (ZSTD_isError(res)) {
+    throw std::runtime_error("create_zstd_file: cannot compress content");
+  }
+  std::ofstream output;
+  output.open(filename.c_str(), std::ios::binary);
+  if (!output.is_open()) {
+    throw std::runtime_error("create_zstd_file: cannot open write connection");
+  }
+  if (!output.write(buffer.data(), res)) {
+    throw std::runtime_error("create_zstd_file: cannot write to file");
+  }
+  output.close();
+  return content;
+}
+
 std::string integrationTest::create_bigwig(const std::string &filename,
                                            const std::string &content) const {
   // requires direct interaction with libBigWig
@@ -189,6 +209,14 @@ std::string integrationTest::get_map_content() const {
          "3 rs3 0 1000000\n";
 }
 
+std::string integrationTest::get_pvar_content() const {
+  return "##fileformat=PVARv1.0\n"
+         "#CHROM\tPOS\tID\tREF\tALT\tINFO\n"
+         "1\t500000\trs1\tT\tA\tAF=0.1\n"
+         "1\t1500000\trs2\tG\tC\t.\n"
+         "3\t1000000\trs3\tC\tA\t.\n";
+}
+
 std::string integrationTest::get_bolt_content() const {
   return "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n"
          "1 1000000 0.1 0\n"
@@ -238,6 +266,31 @@ TEST_F(integrationTest, vcfInputBimOutput) {
   EXPECT_EQ(expected_output, observed_output);
 }
 
+TEST_F(integrationTest, vcfInputVcfOutput) {
+  std::string input_gmap =
+      create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+  std::string expected_records =
+      "chr1\t500000\trs1\tA\tT\t.\tPASS\tCM=0\tGT\t0/0\n"
+      "chr1\t1500000\trs2\tA\tT\t.\tPASS\tCM=0.05\tGT\t0/0\n"
+      "chr3\t1000000\trs3\tA\tC\t.\tPASS\tCM=0\tGT\t0/0\n";
+  igp::interpolator ip;
+  ip.interpolate("unit_tests/test.vcf.gz", "vcf", _in_gmap_tmpfile, "bolt",
+                 _out_tmpfile, "vcf", false, 0.0, 0, false);
+  EXPECT_TRUE(boost::filesystem::exists(_out_tmpfile));
+  std::istringstream observed_output(load_plaintext_file(_out_tmpfile));
+  std::string line = "", observed_records = "";
+  bool found_info_header = false;
+  while (std::getline(observed_output, line)) {
+    if (line.find("##INFO=<ID=CM,") == 0) {
+      found_info_header = true;
+    } else if (line.find("#") != 0) {
+      observed_records += line + "\n";
+    }
+  }
+  EXPECT_TRUE(found_info_header);
+  EXPECT_EQ(expected_records, observed_records);
+}
+
 TEST_F(integrationTest, bedfileInputBoltOutputNoIncrement) {
   std::string input_query =
       create_plaintext_file(_in_query_tmpfile, get_bedfile_content());
@@ -302,6 +355,29 @@ TEST_F(integrationTest, bimfileInputBimfileOutput) {
   EXPECT_EQ(expected_output, observed_output);
 }
 
+TEST_F(integrationTest, bimfileInputArrowOutput) {
+  std::string input_query =
+      create_plaintext_file(_in_query_tmpfile, get_bim_content());
+  std::string input_gmap =
+      create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+  igp::interpolator ip;
+  ip.interpolate(_in_query_tmpfile, "bim", _in_gmap_tmpfile, "bolt",
+                 _out_tmpfile, "arrow", false, 0.0, 0, false);
+  EXPECT_TRUE(boost::filesystem::exists(_out_tmpfile));
+  std::ifstream input(_out_tmpfile.c_str(), std::ios::binary);
+  std::ostringstream contents;
+  contents << input.rdbuf();
+  input.close();
+  std::string observed_output = contents.str();
+  ASSERT_GT(observed_output.size(), 12u);
+  EXPECT_EQ(observed_output.substr(0, 6), "ARROW1");
+  EXPECT_EQ(observed_output.substr(observed_output.size() - 6), "ARROW1");
+  // identifiers and alleles are passed through as typed string columns
+  EXPECT_NE(observed_output.find("rs1rs2rs3"), std::string::npos);
+  EXPECT_NE(observed_output.find("ACA"), std::string::npos);
+  EXPECT_NE(observed_output.find("TGC"), std::string::npos);
+}
+
 TEST_F(integrationTest, mapfileInputMapfileOutput) {
   std::string input_query =
       create_plaintext_file(_in_query_tmpfile, get_map_content());
@@ -319,6 +395,84 @@ TEST_F(integrationTest, mapfileInputMapfileOutput) {
   EXPECT_EQ(expected_output, observed_output);
 }
 
+TEST_F(integrationTest, pvarInputPvarOutput) {
+  std::string input_query =
+      create_plaintext_file(_in_query_tmpfile, get_pvar_content());
+  std::string input_gmap =
+      create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+  std::string expected_output =
+      "##fileformat=PVARv1.0\n"
+      "#CHROM\tPOS\tID\tREF\tALT\tINFO\tCM\n"
+      "1\t500000\trs1\tT\tA\tAF=0.1\t0\n"
+      "1\t1500000\trs2\tG\tC\t.\t0.05\n"
+      "3\t1000000\trs3\tC\tA\t.\t0\n";
+  igp::interpolator ip;
+  ip.interpolate(_in_query_tmpfile, "pvar", _in_gmap_tmpfile, "bolt",
+                 _out_tmpfile, "pvar", false, 0.0, 0, false);
+  EXPECT_TRUE(boost::filesystem::exists(_out_tmpfile));
+  std::string observed_output = load_plaintext_file(_out_tmpfile);
+  EXPECT_EQ(expected_output, observed_output);
+}
+
+TEST_F(integrationTest, pvarInputBimOutput) {
+  std::string input_query =
+      create_plaintext_file(_in_query_tmpfile, get_pvar_content());
+  std::string input_gmap =
+      create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+  std::string expected_output =
+      "1\trs1\t0\t500000\tA\tT\n"
+      "1\trs2\t0.05\t1500000\tC\tG\n"
+      "3\trs3\t0\t1000000\tA\tC\n";
+  igp::interpolator ip;
+  ip.interpolate(_in_query_tmpfile, "pvar", _in_gmap_tmpfile, "bolt",
+                 _out_tmpfile, "bim", false, 0.0, 0, false);
+  EXPECT_TRUE(boost::filesystem::exists(_out_tmpfile));
+  std::string observed_output = load_plaintext_file(_out_tmpfile);
+  EXPECT_EQ(expected_output, observed_output);
+}
+
+TEST_F(integrationTest, zstdPvarInputReplacesCmColumn) {
+  const std::string in_query_tmpfile =
+      boost::filesystem::unique_path().native() + ".pvar.zst";
+  try {
+    std::string input_query = create_zstd_file(
+        in_query_tmpfile,
+        "#CHROM\tPOS\tID\tREF\tALT\tCM\n"
+        "1\t500000\trs1\tT\tA\t9\n"
+        "1\t1500000\trs2\tG\tC\t9\n");
+    std::string input_gmap =
+        create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+    std::string expected_output =
+        "#CHROM\tPOS\tID\tREF\tALT\tCM\n"
+        "1\t500000\trs1\tT\tA\t0\n"
+        "1\t1500000\trs2\tG\tC\t0.05\n";
+    igp::interpolator ip;
+    ip.interpolate(in_query_tmpfile, "pvar", _in_gmap_tmpfile, "bolt",
+                   _out_tmpfile, "pvar", false, 0.0, 0, false);
+    EXPECT_TRUE(boost::filesystem::exists(_out_tmpfile));
+    std::string observed_output = load_plaintext_file(_out_tmpfile);
+    EXPECT_EQ(expected_output, observed_output);
+    boost::filesystem::remove(in_query_tmpfile);
+  } catch (...) {
+    if (boost::filesystem::exists(in_query_tmpfile)) {
+      boost::filesystem::remove(in_query_tmpfile);
+    }
+    throw;
+  }
+}
+
+TEST_F(integrationTest, headerlessPvarInputIsRejected) {
+  std::string input_query =
+      create_plaintext_file(_in_query_tmpfile, "1\trs1\t0\t500000\tA\tT\n");
+  std::string input_gmap =
+      create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+  igp::interpolator ip;
+  EXPECT_THROW(ip.interpolate(_in_query_tmpfile, "pvar", _in_gmap_tmpfile,
+                              "bolt", _out_tmpfile, "pvar", false, 0.0, 0,
+                              false),
+               std::runtime_error);
+}
+
 TEST_F(integrationTest, gzippedMapfileInputMapfileOutput) {
   const std::string in_query_tmpfile =
       boost::filesystem::unique_path().native() + ".gz";
@@ -405,6 +559,417 @@ TEST_F(integrationTest, bigwigGeneticMap) {
   EXPECT_EQ(expected_output, observed_output);
 }
 
+TEST_F(integrationTest, bigwigGeneticMapParallelDecoding) {
+  std::string input_query =
+      create_plaintext_file(_in_query_tmpfile, get_map_content());
+  write_bigwig_content(_in_gmap_tmpfile);
+  std::string expected_output =
+      "1\trs1\t0\t500000\n"
+      "1\trs2\t0.05\t1500000\n"
+      "3\trs3\t0\t1000000\n";
+  igp::interpolator ip;
+  ip.set_threads(4);
+  ip.interpolate(_in_query_tmpfile, "map", _in_gmap_tmpfile, "bigwig",
+                 _out_tmpfile, "map", false, 0.0, 0, false);
+  EXPECT_TRUE(boost::filesystem::exists(_out_tmpfile));
+  std::string observed_output = load_plaintext_file(_out_tmpfile);
+  EXPECT_EQ(expected_output, observed_output);
+}
+
+TEST_F(integrationTest, bigwigOutputRoundTrip) {
+  // a rate track of bed region segments is a genetic map in its own right
+  create_plaintext_file(_in_query_tmpfile, "chr1\t0\t2500000\tr1\n");
+  create_plaintext_file(_in_gmap_tmpfile,
+                        "chr1\t0\t1000000\t1.0\n"
+                        "chr1\t1000000\t2000000\t2.0\n"
+                        "chr1\t2000000\t3000000\t0.5\n");
+  igp::interpolator ip;
+  ip.set_output_bigwig_rate(true);
+  ip.interpolate(_in_query_tmpfile, "bed", _in_gmap_tmpfile, "bedgraph",
+                 _out_tmpfile, "bigwig", false, 0.0, 0, false);
+  EXPECT_TRUE(boost::filesystem::exists(_out_tmpfile));
+  igp::bigwig_reader reader;
+  std::string chr = "";
+  mpz_class pos1, pos2;
+  mpf_class rate;
+  reader.open(_out_tmpfile);
+  EXPECT_TRUE(reader.get(&chr, &pos1, &pos2, &rate));
+  EXPECT_EQ(pos1, mpz_class(0));
+  EXPECT_EQ(pos2, mpz_class(1000000));
+  EXPECT_EQ(rate, mpf_class(1.0));
+  EXPECT_TRUE(reader.get(&chr, &pos1, &pos2, &rate));
+  EXPECT_EQ(pos1, mpz_class(1000000));
+  EXPECT_EQ(pos2, mpz_class(2000000));
+  EXPECT_EQ(rate, mpf_class(2.0));
+  EXPECT_TRUE(reader.get(&chr, &pos1, &pos2, &rate));
+  EXPECT_EQ(pos1, mpz_class(2000000));
+  EXPECT_EQ(pos2, mpz_class(2500000));
+  EXPECT_EQ(rate, mpf_class(0.5));
+  EXPECT_FALSE(reader.get(&chr, &pos1, &pos2, &rate));
+  reader.close();
+  // and interpolates as the original map does within the regions
+  create_plaintext_file(_in_query_tmpfile,
+                        "1 rs1 0 500000\n"
+                        "1 rs2 0 1500000\n"
+                        "1 rs3 0 2200000\n");
+  boost::filesystem::rename(_out_tmpfile, _in_gmap_tmpfile);
+  igp::interpolator ip_map;
+  ip_map.interpolate(_in_query_tmpfile, "map", _in_gmap_tmpfile, "bigwig",
+                     _out_tmpfile, "map", false, 0.0, 0, false);
+  EXPECT_EQ(load_plaintext_file(_out_tmpfile),
+            "1\trs1\t0.499999\t500000\n"
+            "1\trs2\t2\t1500000\n"
+            "1\trs3\t3.1\t2200000\n");
+}
+
+TEST_F(integrationTest, severalInputFilesShareOneMap) {
+  create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+  std::vector<std::string> inputs, outputs, expected;
+  for (unsigned i = 0; i < 5; ++i) {
+    inputs.push_back(_in_query_tmpfile + "." + std::to_string(i));
+    outputs.push_back(_out_tmpfile + "." + std::to_string(i));
+    // each file gets a different subset of the queries
+    std::string content = i % 2 ? get_bim_content() : "";
+    content += "3\trs" + std::to_string(i) + "\t0\t1000000\tA\tC\n";
+    create_plaintext_file(inputs.back(), content);
+    igp::interpolator ip;
+    ip.interpolate(inputs.back(), "bim", _in_gmap_tmpfile, "bolt",
+                   outputs.back(), "bim", false, 0.0, 0, false);
+    expected.push_back(load_plaintext_file(outputs.back()));
+    boost::filesystem::remove(outputs.back());
+  }
+  for (unsigned n_jobs = 1; n_jobs <= 3; ++n_jobs) {
+    igp::interpolator ip;
+    ip.set_jobs(n_jobs);
+    ip.interpolate_files(inputs, "bim", _in_gmap_tmpfile, "bolt", outputs,
+                         "bim", false, 0.0, 0, false);
+    for (unsigned i = 0; i < inputs.size(); ++i) {
+      EXPECT_EQ(load_plaintext_file(outputs.at(i)), expected.at(i));
+      boost::filesystem::remove(outputs.at(i));
+    }
+  }
+  // outputs must be distinct, and a failing file is reported
+  igp::interpolator ip;
+  std::vector<std::string> same_outputs(inputs.size(), _out_tmpfile);
+  EXPECT_THROW(ip.interpolate_files(inputs, "bim", _in_gmap_tmpfile, "bolt",
+                                    same_outputs, "bim", false, 0.0, 0, false),
+               std::runtime_error);
+  boost::filesystem::remove(inputs.at(2));
+  EXPECT_THROW(ip.interpolate_files(inputs, "bim", _in_gmap_tmpfile, "bolt",
+                                    outputs, "bim", false, 0.0, 0, false),
+               std::runtime_error);
+  for (unsigned i = 0; i < inputs.size(); ++i) {
+    boost::filesystem::remove(inputs.at(i));
+    boost::filesystem::remove(outputs.at(i));
+  }
+}
+
+TEST_F(integrationTest, severalMapsShareOneInput) {
+  std::vector<std::string> maps, map_formats, outputs;
+  maps.push_back(_in_gmap_tmpfile);
+  map_formats.push_back("bolt");
+  create_plaintext_file(maps.back(), get_bolt_content());
+  maps.push_back(_in_gmap_tmpfile + ".bedgraph");
+  map_formats.push_back("bedgraph");
+  // a map with rates of its own, so the outputs differ
+  create_plaintext_file(maps.back(),
+                        "chr1 999999 1999999 0.3\n"
+                        "chr1 1999999 2999999 0.4\n"
+                        "chr2 999999 2999999 0.5\n");
+  outputs.push_back(_out_tmpfile + ".0");
+  outputs.push_back(_out_tmpfile + ".1");
+  // bed queries are swept region by region, unlike the others
+  const char *presets[] = {"bim", "bed"};
+  const char *output_formats[] = {"bim", "bolt"};
+  for (unsigned p = 0; p < 2; ++p) {
+    create_plaintext_file(_in_query_tmpfile, p ? get_bedfile_content()
+                                               : get_bim_content());
+    std::vector<std::string> expected;
+    for (unsigned i = 0; i < maps.size(); ++i) {
+      igp::interpolator ip;
+      ip.interpolate(_in_query_tmpfile, presets[p], maps.at(i),
+                     map_formats.at(i), _out_tmpfile, output_formats[p], false,
+                     0.0, 0, false);
+      expected.push_back(load_plaintext_file(_out_tmpfile));
+    }
+    EXPECT_NE(expected.at(0), expected.at(1));
+    for (unsigned pipelined = 0; pipelined < 2; ++pipelined) {
+      igp::interpolator ip;
+      ip.set_pipelined(pipelined);
+      ip.interpolate_maps(_in_query_tmpfile, presets[p], maps, map_formats,
+                          outputs, output_formats[p], false, 0.0, 0, false);
+      for (unsigned i = 0; i < maps.size(); ++i) {
+        EXPECT_EQ(load_plaintext_file(outputs.at(i)), expected.at(i));
+        boost::filesystem::remove(outputs.at(i));
+      }
+    }
+  }
+  // each map needs its own output, and none can come from stdin
+  igp::interpolator ip;
+  std::vector<std::string> same_outputs(maps.size(), _out_tmpfile);
+  EXPECT_THROW(ip.interpolate_maps(_in_query_tmpfile, "bim", maps, map_formats,
+                                   same_outputs, "bim", false, 0.0, 0, false),
+               std::runtime_error);
+  std::vector<std::string> stdin_maps(maps);
+  stdin_maps.at(1) = "";
+  EXPECT_THROW(
+      ip.interpolate_maps(_in_query_tmpfile, "bim", stdin_maps, map_formats,
+                          outputs, "bim", false, 0.0, 0, false),
+      std::runtime_error);
+  boost::filesystem::remove(maps.at(1));
+}
+
+TEST_F(integrationTest, severalOutputFormatsFromOnePass) {
+  create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+  // pvar output needs the input lines kept, unlike the others; bed
+  // queries are swept region by region when there is a single output
+  const char *presets[] = {"pvar", "bim", "bed"};
+  std::vector<std::vector<std::string> > formats(3);
+  formats.at(0).push_back("bim");
+  formats.at(0).push_back("pvar");
+  formats.at(0).push_back("snp");
+  formats.at(1).push_back("bim");
+  formats.at(1).push_back("map");
+  formats.at(1).push_back("arrow");
+  formats.at(2).push_back("bolt");
+  formats.at(2).push_back("arrow");
+  for (unsigned p = 0; p < 3; ++p) {
+    create_plaintext_file(_in_query_tmpfile,
+                          p == 0   ? get_pvar_content()
+                          : p == 1 ? get_bim_content()
+                                   : get_bedfile_content());
+    std::vector<std::string> outputs, expected;
+    for (unsigned i = 0; i < formats.at(p).size(); ++i) {
+      outputs.push_back(_out_tmpfile + "." + std::to_string(i));
+      igp::interpolator ip;
+      ip.interpolate(_in_query_tmpfile, presets[p], _in_gmap_tmpfile, "bolt",
+                     _out_tmpfile, formats.at(p).at(i), false, 0.0, 0, false);
+      expected.push_back(load_plaintext_file(_out_tmpfile));
+    }
+    for (unsigned pipelined = 0; pipelined < 2; ++pipelined) {
+      igp::interpolator ip;
+      ip.set_pipelined(pipelined);
+      ip.interpolate_outputs(_in_query_tmpfile, presets[p], _in_gmap_tmpfile,
+                             "bolt", outputs, formats.at(p), false, 0.0, 0,
+                             false);
+      for (unsigned i = 0; i < outputs.size(); ++i) {
+        EXPECT_EQ(load_plaintext_file(outputs.at(i)), expected.at(i));
+        boost::filesystem::remove(outputs.at(i));
+      }
+    }
+  }
+  // each output needs its own file and format
+  igp::interpolator ip;
+  std::vector<std::string> same_outputs(2, _out_tmpfile);
+  std::vector<std::string> two_formats(2, "bim");
+  EXPECT_THROW(ip.interpolate_outputs(_in_query_tmpfile, "bim",
+                                      _in_gmap_tmpfile, "bolt", same_outputs,
+                                      two_formats, false, 0.0, 0, false),
+               std::runtime_error);
+  two_formats.pop_back();
+  same_outputs.at(1) = _out_tmpfile + ".1";
+  EXPECT_THROW(ip.interpolate_outputs(_in_query_tmpfile, "bim",
+                                      _in_gmap_tmpfile, "bolt", same_outputs,
+                                      two_formats, false, 0.0, 0, false),
+               std::runtime_error);
+}
+
+TEST_F(integrationTest, outputPerChromosomeSplitsSingleOutput) {
+  create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+  // bolt output carries its end of chromosome placeholder into each file
+  const char *presets[] = {"bim", "bed"};
+  const char *formats[] = {"bim", "bolt"};
+  std::string prefix = _out_tmpfile + ".";
+  for (unsigned p = 0; p < 2; ++p) {
+    create_plaintext_file(_in_query_tmpfile,
+                          p == 0 ? get_bim_content() : get_bedfile_content());
+    igp::interpolator single;
+    single.interpolate(_in_query_tmpfile, presets[p], _in_gmap_tmpfile, "bolt",
+                       _out_tmpfile, formats[p], false, 0.0, 0, false);
+    std::istringstream combined(load_plaintext_file(_out_tmpfile));
+    std::string line, header;
+    if (p == 1) {
+      std::getline(combined, header);
+      header += "\n";
+    }
+    std::vector<std::string> chromosomes, expected;
+    while (std::getline(combined, line)) {
+      std::string chr = line.substr(0, line.find('\t'));
+      if (chromosomes.empty() || chromosomes.back().compare(chr)) {
+        chromosomes.push_back(chr);
+        expected.push_back(header);
+      }
+      expected.back() += line + "\n";
+    }
+    ASSERT_EQ(chromosomes.size(), 2u);
+    for (unsigned pipelined = 0; pipelined < 2; ++pipelined) {
+      igp::interpolator ip;
+      ip.set_pipelined(pipelined);
+      ip.set_output_per_chromosome(true);
+      ip.interpolate(_in_query_tmpfile, presets[p], _in_gmap_tmpfile, "bolt",
+                     prefix, formats[p], false, 0.0, 0, false);
+      for (unsigned i = 0; i < chromosomes.size(); ++i) {
+        std::string filename =
+            prefix + chromosomes.at(i) + "." + std::string(formats[p]);
+        EXPECT_EQ(load_plaintext_file(filename), expected.at(i));
+        boost::filesystem::remove(filename);
+      }
+    }
+  }
+  // a chromosome cannot come back once its file has been finished
+  create_plaintext_file(_in_query_tmpfile,
+                        "1 rs1 0 500000 A T\n"
+                        "3 rs3 0 1000000 A C\n"
+                        "1 rs2 0 1500000 C G\n");
+  igp::interpolator ip;
+  ip.set_output_per_chromosome(true);
+  EXPECT_THROW(ip.interpolate(_in_query_tmpfile, "bim", _in_gmap_tmpfile,
+                              "bolt", prefix, "bim", false, 0.0, 0, false),
+               std::runtime_error);
+  boost::filesystem::remove(prefix + "1.bim");
+  boost::filesystem::remove(prefix + "3.bim");
+}
+
+TEST_F(integrationTest, mapIndexSkipsAheadForSparseQueries) {
+  // enough rows per chromosome for several index checkpoints, and
+  // queries sparse enough to jump between them
+  std::ostringstream bolt, bedgraph;
+  bolt << "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n";
+  std::vector<std::string> maps, formats;
+  maps.push_back(_in_gmap_tmpfile);
+  formats.push_back("bolt");
+  maps.push_back(_in_gmap_tmpfile + ".bedgraph");
+  formats.push_back("bedgraph");
+  maps.push_back(_in_gmap_tmpfile + ".bw");
+  formats.push_back("bigwig");
+  igp::bigwig_writer bigwig;
+  bigwig.open(maps.at(2));
+  for (unsigned chr = 1; chr <= 3; ++chr) {
+    double gpos = 0.0;
+    for (unsigned row = 0; row < 5000; ++row) {
+      unsigned pos = 1000 + row * 100;
+      double rate = static_cast<double>((row * 7 + chr) % 13) / 4.0;
+      bolt << chr << ' ' << pos << ' ' << rate << ' ' << gpos << '\n';
+      bedgraph << "chr" << chr << ' ' << pos - 1 << ' ' << pos + 99 << ' '
+               << rate << '\n';
+      bigwig.append("chr" + std::to_string(chr), pos, pos + 100, rate);
+      gpos += rate * 100.0 / 1000000.0;
+    }
+  }
+  bigwig.close();
+  create_plaintext_file(maps.at(0), bolt.str());
+  create_plaintext_file(maps.at(1), bedgraph.str());
+  // no queries on chromosome 2, and queries before, at and beyond rows
+  std::ostringstream bim, bed;
+  const unsigned positions[] = {500, 1000, 150000, 150050, 420000, 499950,
+                                600000};
+  for (unsigned chr = 1; chr <= 3; chr += 2) {
+    for (unsigned i = 0; i < 7; ++i) {
+      bim << chr << " rs" << chr << '_' << i << " 0 " << positions[i]
+          << " A C\n";
+    }
+    bed << "chr" << chr << " 149000 151000 r1\n"
+        << "chr" << chr << " 300000 300001 r2\n"
+        << "chr" << chr << " 499000 650000 r3\n";
+  }
+  const char *presets[] = {"bim", "bed"};
+  const char *output_formats[] = {"bim", "bolt"};
+  for (unsigned p = 0; p < 2; ++p) {
+    create_plaintext_file(_in_query_tmpfile, p == 0 ? bim.str() : bed.str());
+    for (unsigned m = 0; m < maps.size(); ++m) {
+      igp::interpolator sequential;
+      sequential.interpolate(_in_query_tmpfile, presets[p], maps.at(m),
+                             formats.at(m), _out_tmpfile, output_formats[p],
+                             false, 0.0, 0, false);
+      std::string expected = load_plaintext_file(_out_tmpfile);
+      // the index is built on first use, then reused
+      for (unsigned run = 0; run < 2; ++run) {
+        igp::interpolator ip;
+        ip.set_map_index(true);
+        ip.interpolate(_in_query_tmpfile, presets[p], maps.at(m),
+                       formats.at(m), _out_tmpfile, output_formats[p], false,
+                       0.0, 0, false);
+        EXPECT_TRUE(boost::filesystem::exists(maps.at(m) + ".igpindex"));
+        EXPECT_EQ(load_plaintext_file(_out_tmpfile), expected);
+      }
+    }
+  }
+  for (unsigned m = 0; m < maps.size(); ++m) {
+    boost::filesystem::remove(maps.at(m) + ".igpindex");
+    if (m) {
+      boost::filesystem::remove(maps.at(m));
+    }
+  }
+}
+
+TEST_F(integrationTest, mapIndexSkipsAheadInGzipMaps) {
+  // enough text for several gzip access points, so that threaded runs
+  // decompress spans of the map ahead on workers
+  std::ostringstream bolt, bedgraph;
+  bolt << "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n";
+  for (unsigned chr = 1; chr <= 3; ++chr) {
+    double gpos = 0.0;
+    for (unsigned row = 0; row < 40000; ++row) {
+      unsigned pos = 1000 + row * 100;
+      double rate = static_cast<double>((row * 7 + chr) % 13) / 4.0;
+      bolt << chr << ' ' << pos << ' ' << rate << ' ' << gpos << '\n';
+      bedgraph << "chr" << chr << ' ' << pos - 1 << ' ' << pos + 99 << ' '
+               << rate << '\n';
+      gpos += rate * 100.0 / 1000000.0;
+    }
+  }
+  std::vector<std::string> maps, formats;
+  maps.push_back(_in_gmap_tmpfile + ".gz");
+  formats.push_back("bolt");
+  maps.push_back(_in_gmap_tmpfile + ".bedgraph.gz");
+  formats.push_back("bedgraph");
+  create_compressed_file(maps.at(0), bolt.str());
+  create_compressed_file(maps.at(1), bedgraph.str());
+  std::ostringstream bim;
+  const unsigned positions[] = {500, 150000, 1200000, 1200050, 2900000,
+                                3950000, 5000000};
+  for (unsigned chr = 1; chr <= 3; chr += 2) {
+    for (unsigned i = 0; i < 7; ++i) {
+      bim << chr << " rs" << chr << '_' << i << " 0 " << positions[i]
+          << " A C\n";
+    }
+  }
+  create_plaintext_file(_in_query_tmpfile, bim.str());
+  for (unsigned m = 0; m < maps.size(); ++m) {
+    igp::interpolator sequential;
+    sequential.interpolate(_in_query_tmpfile, "bim", maps.at(m), formats.at(m),
+                           _out_tmpfile, "bim", false, 0.0, 0, false);
+    std::string expected = load_plaintext_file(_out_tmpfile);
+    // built on first use, then reused, with and without worker threads
+    for (unsigned run = 0; run < 3; ++run) {
+      igp::interpolator ip;
+      ip.set_map_index(true);
+      ip.set_threads(run == 2 ? 4 : 1);
+      ip.interpolate(_in_query_tmpfile, "bim", maps.at(m), formats.at(m),
+                     _out_tmpfile, "bim", false, 0.0, 0, false);
+      EXPECT_TRUE(boost::filesystem::exists(maps.at(m) + ".igpindex"));
+      EXPECT_EQ(load_plaintext_file(_out_tmpfile), expected);
+    }
+    boost::filesystem::remove(maps.at(m) + ".igpindex");
+    boost::filesystem::remove(maps.at(m));
+  }
+}
+
+TEST_F(integrationTest, mapIndexSkipsUnsortedMaps) {
+  create_plaintext_file(_in_query_tmpfile, "1 rs1 0 500000 A T\n");
+  create_plaintext_file(_in_gmap_tmpfile,
+                        "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n"
+                        "1 1000000 0.1 0\n"
+                        "1 3000000 0.25 0.3\n"
+                        "1 2000000 0.2 0.1\n");
+  igp::interpolator ip;
+  ip.set_map_index(true);
+  ip.interpolate(_in_query_tmpfile, "bim", _in_gmap_tmpfile, "bolt",
+                 _out_tmpfile, "bim", false, 0.0, 0, false);
+  EXPECT_FALSE(boost::filesystem::exists(_in_gmap_tmpfile + ".igpindex"));
+  EXPECT_EQ(load_plaintext_file(_out_tmpfile), "1\trs1\t0\t500000\tA\tT\n");
+}
+
 TEST_F(integrationTest, bedfileInputBoltOutputSparseQueries) {
   std::string input_query =
       create_plaintext_file(_in_query_tmpfile,
@@ -463,3 +1028,66 @@ TEST_F(integrationTest, bedfileInputRespectLabelColumn) {
   std::string observed_output = load_plaintext_file(_out_tmpfile);
   EXPECT_EQ(expected_output, observed_output);
 }
+
+TEST_F(integrationTest, bimfileInputBimfileOutputPipelined) {
+  std::string input_query =
+      create_plaintext_file(_in_query_tmpfile, get_bim_content());
+  std::string input_gmap =
+      create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+  std::string expected_output =
+      "1\trs1\t0\t500000\tA\tT\n"
+      "1\trs2\t0.05\t1500000\tC\tG\n"
+      "3\trs3\t0\t1000000\tA\tC\n";
+  igp::interpolator ip;
+  ip.set_pipelined(true);
+  ip.interpolate(_in_query_tmpfile, "bim", _in_gmap_tmpfile, "bolt",
+                 _out_tmpfile, "bim", false, 0.0, 0, false);
+  EXPECT_TRUE(boost::filesystem::exists(_out_tmpfile));
+  std::string observed_output = load_plaintext_file(_out_tmpfile);
+  EXPECT_EQ(expected_output, observed_output);
+}
+
+TEST_F(integrationTest, bedfileInputRespectLabelColumnPipelined) {
+  std::string input_query =
+      create_plaintext_file(_in_query_tmpfile,
+                            "chr22\t17083846\t17084010\tthing1\n"
+                            "chr22\t17084010\t17084050\tthing1\n"
+                            "chr22\t17084050\t17084100\tthing2\n"
+                            "chr22\t17084100\t17084145\tthing2\n");
+  std::string input_gmap = create_plaintext_file(
+      _in_gmap_tmpfile,
+      "chr22\t17076254\t17081023\t0\t0\n"
+      "chr22\t17081023\t17083846\t0.137252\t0\n"
+      "chr22\t17083846\t17084017\t4.00811\t0.000387462396\n"
+      "chr22\t17084017\t17084145\t1.91398e-06\t0.001072849206\n"
+      "chr22\t17084145\t17086809\t0.925629\t0.00107284945098944\n"
+      "chr22\t17086809\t17087057\t7.31739e-12\t0.00353872510698944\n");
+  std::string expected_output =
+      "chr\tposition\tCOMBINED_rate(cM/Mb)\tGenetic_Map(cM)\n"
+      "chr22\t17083847\t4.00811\t0.000387462\n"
+      "chr22\t17084011\t4.00811\t0.00104479\n"
+      "chr22\t17084018\t1.91398e-06\t0.00107285\n"
+      "chr22\t17084051\t1.91398e-06\t0.101073\n"
+      "chr22\t17084101\t1.91398e-06\t0.101073\n"
+      "chr22\t17084146\t0\t0.201073\n";
+  igp::interpolator ip;
+  ip.set_pipelined(true);
+  ip.interpolate(_in_query_tmpfile, "bed", _in_gmap_tmpfile, "bedgraph",
+                 _out_tmpfile, "bolt", false, 0.1, 0, false);
+  EXPECT_TRUE(boost::filesystem::exists(_out_tmpfile));
+  std::string observed_output = load_plaintext_file(_out_tmpfile);
+  EXPECT_EQ(expected_output, observed_output);
+}
+
+TEST_F(integrationTest, pipelinedModeReportsStageFailure) {
+  std::string input_query = create_plaintext_file(
+      _in_query_tmpfile, "1 rs1 0 500000 A T\n1 rs2 0\n");
+  std::string input_gmap =
+      create_plaintext_file(_in_gmap_tmpfile, get_bolt_content());
+  igp::interpolator ip;
+  ip.set_pipelined(true);
+  EXPECT_THROW(ip.interpolate(_in_query_tmpfile, "bim", _in_gmap_tmpfile,
+                              "bolt", _out_tmpfile, "bim", false, 0.0, 0,
+                              false),
+               std::runtime_error);
+}
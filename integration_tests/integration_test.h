@@ -14,8 +14,11 @@
 
 #include <bigWig.h>
 #include <zlib.h>
+#include <zstd.h>
 
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -31,6 +34,8 @@ class integrationTest : public testing::Test {
                                     const std::string &content) const;
   std::string create_compressed_file(const std::string &filename,
                                      const std::string &content) const;
+  std::string create_zstd_file(const std::string &filename,
+                               const std::string &content) const;
   std::string create_bigwig(const std::string &filename,
                             const std::string &content) const;
   std::string load_plaintext_file(const std::string &filename) const;
@@ -38,6 +43,7 @@ class integrationTest : public testing::Test {
   std::string get_bedfile_content() const;
   std::string get_bim_content() const;
   std::string get_map_content() const;
+  std::string get_pvar_content() const;
   std::string get_bolt_content() const;
   std::string get_bedgraph_content() const;
   void write_bigwig_content(const std::string &filename) const;
@@ -0,0 +1,572 @@
+/*!
+ \file arrow_writer.cc
+ \brief implementation of Arrow IPC file output
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/arrow_writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "interpolate-genetic-position/utilities.h"
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+/*!
+ * \class flatbuffer_builder
+ * \brief just enough of a flatbuffer encoder for Arrow metadata
+ *
+ * Like the reference implementation, the buffer is built back to
+ * front, so that every object is complete before anything refers to
+ * it. Bytes are stored in reverse and flipped by finish(); an object
+ * is identified by the size of the buffer when it was completed.
+ */
+class flatbuffer_builder {
+ public:
+  flatbuffer_builder() : _minalign(1), _table_start(0) {}
+  /*!
+   * \brief current size of buffer
+   */
+  uint32_t size() const { return static_cast<uint32_t>(_data.size()); }
+  /*!
+   * \brief add padding so that, once a number of further bytes are
+   * added, the buffer size is a multiple of an alignment
+   */
+  void align(size_t alignment, size_t additional) {
+    _minalign = std::max(_minalign, alignment);
+    while ((_data.size() + additional) % alignment) {
+      _data.push_back(0);
+    }
+  }
+  /*!
+   * \brief add a little-endian value of the specified width in bytes
+   */
+  void push(uint64_t value, unsigned width) {
+    for (unsigned i = width; i > 0; --i) {
+      _data.push_back(static_cast<char>((value >> (8 * (i - 1))) & 0xff));
+    }
+  }
+  /*!
+   * \brief add a reference to a completed object
+   */
+  void push_offset(uint32_t target) {
+    align(4, 0);
+    push(size() + 4 - target, 4);
+  }
+  /*!
+   * \brief create a string
+   */
+  uint32_t create_string(const std::string &value) {
+    align(4, value.size() + 1);
+    _data.push_back(0);
+    for (std::string::const_reverse_iterator iter = value.rbegin();
+         iter != value.rend(); ++iter) {
+      _data.push_back(*iter);
+    }
+    push(value.size(), 4);
+    return size();
+  }
+  /*!
+   * \brief prepare for a vector; elements must then be pushed last
+   * to first, followed by end_vector()
+   */
+  void start_vector(size_t element_size, size_t n, size_t alignment) {
+    align(4, element_size * n);
+    align(alignment, element_size * n);
+  }
+  /*!
+   * \brief complete a vector
+   */
+  uint32_t end_vector(size_t n) {
+    push(n, 4);
+    return size();
+  }
+  /*!
+   * \brief create a vector of references to completed objects
+   */
+  uint32_t create_offset_vector(const std::vector<uint32_t> &targets) {
+    start_vector(4, targets.size(), 4);
+    for (std::vector<uint32_t>::const_reverse_iterator iter = targets.rbegin();
+         iter != targets.rend(); ++iter) {
+      push_offset(*iter);
+    }
+    return end_vector(targets.size());
+  }
+  /*!
+   * \brief begin a table; its fields must then be added, after which
+   * no other object may be started until end_table()
+   */
+  void start_table() {
+    _fields.clear();
+    _table_start = size();
+  }
+  /*!
+   * \brief add a scalar field to the current table
+   */
+  void add_scalar(unsigned field, uint64_t value, unsigned width) {
+    align(width, 0);
+    push(value, width);
+    _fields.push_back(std::make_pair(field, size()));
+  }
+  /*!
+   * \brief add a reference field to the current table
+   */
+  void add_offset(unsigned field, uint32_t target) {
+    push_offset(target);
+    _fields.push_back(std::make_pair(field, size()));
+  }
+  /*!
+   * \brief complete the current table, along with its vtable
+   */
+  uint32_t end_table() {
+    align(4, 0);
+    push(0, 4);
+    uint32_t table = size();
+    unsigned n_fields = 0;
+    for (unsigned i = 0; i < _fields.size(); ++i) {
+      n_fields = std::max(n_fields, _fields[i].first + 1);
+    }
+    std::vector<uint16_t> entries(n_fields, 0);
+    for (unsigned i = 0; i < _fields.size(); ++i) {
+      entries[_fields[i].first] =
+          static_cast<uint16_t>(table - _fields[i].second);
+    }
+    for (unsigned i = n_fields; i > 0; --i) {
+      push(entries[i - 1], 2);
+    }
+    push(table - _table_start, 2);
+    push(4 + 2 * n_fields, 2);
+    // the table begins with the distance back to its vtable
+    uint32_t distance = size() - table;
+    for (unsigned i = 0; i < 4; ++i) {
+      _data[table - 1 - i] = static_cast<char>((distance >> (8 * i)) & 0xff);
+    }
+    return table;
+  }
+  /*!
+   * \brief complete the buffer with a root table
+   * \return the encoded buffer, padded to a multiple of 8 bytes
+   */
+  std::string finish(uint32_t root) {
+    align(std::max<size_t>(_minalign, 8), 4);
+    push_offset(root);
+    return std::string(_data.rbegin(), _data.rend());
+  }
+
+ private:
+  std::string _data;  //!< buffer contents, in reverse
+  size_t _minalign;   //!< largest alignment requested
+  uint32_t _table_start;  //!< size of buffer when current table began
+  std::vector<std::pair<unsigned, uint32_t> > _fields;  //!< current table
+};
+
+// enumerations from the Arrow flatbuffer schemas
+const uint64_t metadata_version_v5 = 4;
+const uint64_t type_int = 2;
+const uint64_t type_floating_point = 3;
+const uint64_t type_utf8 = 5;
+const uint64_t precision_double = 2;
+const uint64_t header_schema = 1;
+const uint64_t header_dictionary_batch = 2;
+const uint64_t header_record_batch = 3;
+const int64_t chr_dictionary_id = 0;
+const int64_t padding_alignment = 8;
+
+/*!
+ * \brief round a length up to the padding alignment
+ */
+int64_t padded_length(int64_t length) {
+  return (length + padding_alignment - 1) / padding_alignment *
+         padding_alignment;
+}
+
+/*!
+ * \brief create an Int type table
+ */
+uint32_t create_int_type(flatbuffer_builder *fb, unsigned bit_width) {
+  fb->start_table();
+  fb->add_scalar(0, bit_width, 4);
+  fb->add_scalar(1, 1, 1);
+  return fb->end_table();
+}
+
+/*!
+ * \brief create a Field table for a column
+ * \param fb builder
+ * \param name column name
+ * \param type_type kind of the column's value type
+ * \param nullable whether the column may contain nulls
+ * \param dictionary_encoded whether the column is dictionary encoded
+ */
+uint32_t create_field(flatbuffer_builder *fb, const std::string &name,
+                      uint64_t type_type, bool nullable,
+                      bool dictionary_encoded) {
+  uint32_t name_offset = fb->create_string(name);
+  uint32_t type_offset = 0;
+  if (type_type == type_int) {
+    type_offset = create_int_type(fb, 64);
+  } else if (type_type == type_floating_point) {
+    fb->start_table();
+    fb->add_scalar(0, precision_double, 2);
+    type_offset = fb->end_table();
+  } else {
+    fb->start_table();
+    type_offset = fb->end_table();
+  }
+  uint32_t dictionary_offset = 0;
+  if (dictionary_encoded) {
+    uint32_t index_type = create_int_type(fb, 32);
+    fb->start_table();
+    fb->add_scalar(0, chr_dictionary_id, 8);
+    fb->add_offset(1, index_type);
+    dictionary_offset = fb->end_table();
+  }
+  // readers require the children vector even when it is empty
+  uint32_t children = fb->create_offset_vector(std::vector<uint32_t>());
+  fb->start_table();
+  fb->add_offset(0, name_offset);
+  fb->add_scalar(1, nullable, 1);
+  fb->add_scalar(2, type_type, 1);
+  fb->add_offset(3, type_offset);
+  if (dictionary_encoded) {
+    fb->add_offset(4, dictionary_offset);
+  }
+  fb->add_offset(5, children);
+  return fb->end_table();
+}
+
+/*!
+ * \brief create the Schema table shared by every output file
+ */
+uint32_t create_schema(flatbuffer_builder *fb) {
+  std::vector<uint32_t> fields;
+  fields.push_back(create_field(fb, "chrom", type_utf8, false, true));
+  fields.push_back(create_field(fb, "pos", type_int, false, false));
+  fields.push_back(create_field(fb, "end", type_int, true, false));
+  fields.push_back(create_field(fb, "id", type_utf8, false, false));
+  fields.push_back(create_field(fb, "a1", type_utf8, false, false));
+  fields.push_back(create_field(fb, "a2", type_utf8, false, false));
+  fields.push_back(create_field(fb, "gpos", type_floating_point, false, false));
+  fields.push_back(create_field(fb, "rate", type_floating_point, false, false));
+  uint32_t fields_offset = fb->create_offset_vector(fields);
+  // buffers are written in host byte order
+  uint16_t probe = 1;
+  unsigned char first_byte = 0;
+  memcpy(&first_byte, &probe, 1);
+  fb->start_table();
+  fb->add_scalar(0, first_byte ? 0 : 1, 2);
+  fb->add_offset(1, fields_offset);
+  return fb->end_table();
+}
+
+/*!
+ * \brief create a RecordBatch table
+ * \param fb builder
+ * \param length number of rows
+ * \param null_counts number of nulls in each column
+ * \param buffers body buffers of the batch, in schema order
+ */
+uint32_t create_record_batch(flatbuffer_builder *fb, int64_t length,
+                             const std::vector<int64_t> &null_counts,
+                             const std::vector<std::string_view> &buffers) {
+  // FieldNode structs: length, null_count
+  fb->start_vector(16, null_counts.size(), 8);
+  for (std::vector<int64_t>::const_reverse_iterator iter =
+           null_counts.rbegin();
+       iter != null_counts.rend(); ++iter) {
+    fb->push(static_cast<uint64_t>(*iter), 8);
+    fb->push(static_cast<uint64_t>(length), 8);
+  }
+  uint32_t nodes = fb->end_vector(null_counts.size());
+  // Buffer structs: offset, length
+  std::vector<int64_t> offsets(buffers.size(), 0);
+  int64_t offset = 0;
+  for (unsigned i = 0; i < buffers.size(); ++i) {
+    offsets[i] = offset;
+    offset += padded_length(static_cast<int64_t>(buffers[i].size()));
+  }
+  fb->start_vector(16, buffers.size(), 8);
+  for (unsigned i = buffers.size(); i > 0; --i) {
+    fb->push(buffers[i - 1].size(), 8);
+    fb->push(static_cast<uint64_t>(offsets[i - 1]), 8);
+  }
+  uint32_t buffer_offsets = fb->end_vector(buffers.size());
+  fb->start_table();
+  fb->add_scalar(0, static_cast<uint64_t>(length), 8);
+  fb->add_offset(1, nodes);
+  fb->add_offset(2, buffer_offsets);
+  return fb->end_table();
+}
+
+/*!
+ * \brief create a Message table and finish the buffer with it
+ */
+std::string finish_message(flatbuffer_builder *fb, uint64_t header_type,
+                           uint32_t header, int64_t body_length) {
+  fb->start_table();
+  fb->add_scalar(3, static_cast<uint64_t>(body_length), 8);
+  fb->add_offset(2, header);
+  fb->add_scalar(0, metadata_version_v5, 2);
+  fb->add_scalar(1, header_type, 1);
+  return fb->finish(fb->end_table());
+}
+
+/*!
+ * \brief sum the padded lengths of body buffers
+ */
+int64_t body_length(const std::vector<std::string_view> &buffers) {
+  int64_t length = 0;
+  for (unsigned i = 0; i < buffers.size(); ++i) {
+    length += padded_length(static_cast<int64_t>(buffers[i].size()));
+  }
+  return length;
+}
+
+/*!
+ * \brief view the contents of a vector as raw bytes
+ */
+template <class value_type>
+std::string_view as_bytes(const std::vector<value_type> &values) {
+  return std::string_view(reinterpret_cast<const char *>(values.data()),
+                          values.size() * sizeof(value_type));
+}
+}  // namespace
+
+igp::arrow_writer::arrow_writer()
+    : _target(NULL),
+      _batch_size(default_batch_size),
+      _offset(0),
+      _last_chr_code(-1),
+      _end_nulls(0) {}
+igp::arrow_writer::arrow_writer(const arrow_writer &obj) {
+  throw std::runtime_error(
+      "arrow_writer: copy constructor operation is invalid for this class");
+}
+igp::arrow_writer::~arrow_writer() throw() {}
+void igp::arrow_writer::open(std::ostream *target, unsigned batch_size) {
+  if (!target) {
+    throw std::runtime_error("arrow_writer::open: target is NULL");
+  }
+  if (!batch_size) {
+    throw std::runtime_error("arrow_writer::open: batch size must be nonzero");
+  }
+  _target = target;
+  _batch_size = batch_size;
+  _offset = 0;
+  _batches.clear();
+  _chr_codes.clear();
+  reset_string(&_chr_values);
+  _last_chr.clear();
+  _last_chr_code = -1;
+  _chr.clear();
+  _pos.clear();
+  _end.clear();
+  _end_valid.clear();
+  _end_nulls = 0;
+  reset_string(&_id);
+  reset_string(&_a1);
+  reset_string(&_a2);
+  _gpos.clear();
+  _rate.clear();
+  // magic, padded to 8 bytes
+  write_bytes("ARROW1\0\0", 8);
+  flatbuffer_builder fb;
+  uint32_t schema = create_schema(&fb);
+  write_message(finish_message(&fb, header_schema, schema, 0),
+                std::vector<std::string_view>(), 0);
+}
+bool igp::arrow_writer::is_open() const { return _target != NULL; }
+void igp::arrow_writer::append(const std::string &chr, const mpz_class &pos1,
+                               const mpz_class &pos2, const std::string &id,
+                               const mpf_class &gpos, const mpf_class &rate,
+                               const std::string &a1, const std::string &a2) {
+  if (!_target) {
+    throw std::runtime_error("arrow_writer::append: no file is open");
+  }
+  // results arrive grouped by chromosome, so the lookup is rarely needed
+  if (_last_chr_code < 0 || _last_chr.compare(chr)) {
+    std::map<std::string, int32_t>::const_iterator finder =
+        _chr_codes.find(chr);
+    if (finder == _chr_codes.end()) {
+      _last_chr_code = static_cast<int32_t>(_chr_codes.size());
+      _chr_codes[chr] = _last_chr_code;
+      append_string(&_chr_values, chr);
+    } else {
+      _last_chr_code = finder->second;
+    }
+    _last_chr = chr;
+  }
+  unsigned row = _chr.size();
+  _chr.push_back(_last_chr_code);
+  _pos.push_back(pos1.get_si());
+  if (row % 8 == 0) {
+    _end_valid.push_back(0);
+  }
+  if (cmp(pos2, 0) < 0) {
+    _end.push_back(0);
+    ++_end_nulls;
+  } else {
+    _end.push_back(pos2.get_si());
+    _end_valid.back() |= static_cast<uint8_t>(1u << (row % 8));
+  }
+  append_string(&_id, id);
+  append_string(&_a1, a1);
+  append_string(&_a2, a2);
+  _gpos.push_back(mpf_to_double(gpos));
+  _rate.push_back(mpf_to_double(rate));
+  if (_chr.size() == _batch_size) {
+    write_batch();
+  }
+}
+void igp::arrow_writer::close() {
+  if (!_target) {
+    return;
+  }
+  if (!_chr.empty()) {
+    write_batch();
+  }
+  write_dictionary();
+  // end of stream marker
+  write_bytes("\xff\xff\xff\xff\0\0\0\0", 8);
+  flatbuffer_builder fb;
+  uint32_t schema = create_schema(&fb);
+  // Block structs: offset, metadata length, padding, body length
+  fb.start_vector(24, _batches.size(), 8);
+  for (std::vector<block>::const_reverse_iterator iter = _batches.rbegin();
+       iter != _batches.rend(); ++iter) {
+    fb.push(static_cast<uint64_t>(iter->body_length), 8);
+    fb.push(0, 4);
+    fb.push(static_cast<uint64_t>(iter->metadata_length), 4);
+    fb.push(static_cast<uint64_t>(iter->offset), 8);
+  }
+  uint32_t batches = fb.end_vector(_batches.size());
+  fb.start_vector(24, 1, 8);
+  fb.push(static_cast<uint64_t>(_dictionary.body_length), 8);
+  fb.push(0, 4);
+  fb.push(static_cast<uint64_t>(_dictionary.metadata_length), 4);
+  fb.push(static_cast<uint64_t>(_dictionary.offset), 8);
+  uint32_t dictionaries = fb.end_vector(1);
+  fb.start_table();
+  fb.add_offset(1, schema);
+  fb.add_offset(2, dictionaries);
+  fb.add_offset(3, batches);
+  fb.add_scalar(0, metadata_version_v5, 2);
+  std::string footer = fb.finish(fb.end_table());
+  write_bytes(footer.data(), footer.size());
+  char footer_length[4];
+  for (unsigned i = 0; i < 4; ++i) {
+    footer_length[i] = static_cast<char>((footer.size() >> (8 * i)) & 0xff);
+  }
+  write_bytes(footer_length, 4);
+  write_bytes("ARROW1", 6);
+  _target->flush();
+  if (!*_target) {
+    throw std::runtime_error("arrow_writer::close: cannot write to file");
+  }
+  _target = NULL;
+}
+void igp::arrow_writer::append_string(string_column *column,
+                                      const std::string &value) {
+  if (column->offsets.empty()) {
+    column->offsets.push_back(0);
+  }
+  column->data.append(value);
+  column->offsets.push_back(static_cast<int32_t>(column->data.size()));
+}
+void igp::arrow_writer::reset_string(string_column *column) {
+  column->offsets.clear();
+  column->offsets.push_back(0);
+  column->data.clear();
+}
+void igp::arrow_writer::write_batch() {
+  int64_t length = static_cast<int64_t>(_chr.size());
+  std::vector<int64_t> null_counts(8, 0);
+  null_counts[2] = _end_nulls;
+  std::vector<std::string_view> buffers;
+  // each column is a validity bitmap followed by its values; bitmaps
+  // may be omitted for columns without nulls
+  buffers.push_back(std::string_view());
+  buffers.push_back(as_bytes(_chr));
+  buffers.push_back(std::string_view());
+  buffers.push_back(as_bytes(_pos));
+  buffers.push_back(_end_nulls ? as_bytes(_end_valid) : std::string_view());
+  buffers.push_back(as_bytes(_end));
+  const string_column *strings[] = {&_id, &_a1, &_a2};
+  for (unsigned i = 0; i < 3; ++i) {
+    buffers.push_back(std::string_view());
+    buffers.push_back(as_bytes(strings[i]->offsets));
+    buffers.push_back(strings[i]->data);
+  }
+  buffers.push_back(std::string_view());
+  buffers.push_back(as_bytes(_gpos));
+  buffers.push_back(std::string_view());
+  buffers.push_back(as_bytes(_rate));
+  flatbuffer_builder fb;
+  uint32_t batch = create_record_batch(&fb, length, null_counts, buffers);
+  int64_t total = body_length(buffers);
+  _batches.push_back(write_message(
+      finish_message(&fb, header_record_batch, batch, total), buffers,
+      total));
+  _chr.clear();
+  _pos.clear();
+  _end.clear();
+  _end_valid.clear();
+  _end_nulls = 0;
+  reset_string(&_id);
+  reset_string(&_a1);
+  reset_string(&_a2);
+  _gpos.clear();
+  _rate.clear();
+}
+void igp::arrow_writer::write_dictionary() {
+  std::vector<std::string_view> buffers;
+  buffers.push_back(std::string_view());
+  buffers.push_back(as_bytes(_chr_values.offsets));
+  buffers.push_back(_chr_values.data);
+  flatbuffer_builder fb;
+  uint32_t data = create_record_batch(
+      &fb, static_cast<int64_t>(_chr_codes.size()), std::vector<int64_t>(1, 0),
+      buffers);
+  fb.start_table();
+  fb.add_scalar(0, chr_dictionary_id, 8);
+  fb.add_offset(1, data);
+  uint32_t dictionary = fb.end_table();
+  int64_t total = body_length(buffers);
+  _dictionary = write_message(
+      finish_message(&fb, header_dictionary_batch, dictionary, total), buffers,
+      total);
+}
+igp::arrow_writer::block igp::arrow_writer::write_message(
+    const std::string &metadata, const std::vector<std::string_view> &buffers,
+    int64_t body_length) {
+  block location;
+  location.offset = _offset;
+  // continuation marker and metadata length, then metadata padded so
+  // that the body starts 8-byte aligned
+  int64_t metadata_length = padded_length(static_cast<int64_t>(metadata.size()));
+  char prefix[8] = {'\xff', '\xff', '\xff', '\xff', 0, 0, 0, 0};
+  for (unsigned i = 0; i < 4; ++i) {
+    prefix[4 + i] = static_cast<char>((metadata_length >> (8 * i)) & 0xff);
+  }
+  write_bytes(prefix, 8);
+  write_bytes(metadata.data(), metadata.size());
+  const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  write_bytes(padding, metadata_length - metadata.size());
+  for (unsigned i = 0; i < buffers.size(); ++i) {
+    write_bytes(buffers[i].data(), buffers[i].size());
+    write_bytes(padding, padded_length(buffers[i].size()) - buffers[i].size());
+  }
+  location.metadata_length = static_cast<int32_t>(metadata_length + 8);
+  location.body_length = body_length;
+  return location;
+}
+void igp::arrow_writer::write_bytes(const char *data, size_t length) {
+  if (length && !_target->write(data, static_cast<std::streamsize>(length))) {
+    throw std::runtime_error("arrow_writer: cannot write to file");
+  }
+  _offset += static_cast<int64_t>(length);
+}
@@ -0,0 +1,167 @@
+/*!
+ \file arrow_writer.h
+ \brief columnar output in the Arrow IPC file format
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_ARROW_WRITER_H_
+#define INTERPOLATE_GENETIC_POSITION_ARROW_WRITER_H_
+
+#include <gmpxx.h>
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace interpolate_genetic_position {
+/*!
+ * \class arrow_writer
+ * \brief write interpolated results as typed columns in the Arrow IPC
+ * file format (also known as Feather version 2).
+ *
+ * The file has the columns chrom (dictionary encoded utf8), pos (int64),
+ * end (int64, null for point queries), id, a1, a2 (utf8), gpos and rate
+ * (float64). Results are buffered and written as a record batch each
+ * time a fixed number of rows is reached. The flatbuffer metadata that
+ * the format requires is encoded directly, so that no Arrow library is
+ * needed.
+ *
+ * Chromosome names are collected as they are seen and written as a
+ * single dictionary batch when the file is closed; the file format
+ * permits dictionaries to follow the record batches that use them.
+ * Nothing is written until open() is called.
+ */
+class arrow_writer {
+ public:
+  /*!
+   * \brief default constructor
+   */
+  arrow_writer();
+  /*!
+   * \brief copy constructor
+   *
+   * Copy constructor is disabled due to buffered output.
+   */
+  arrow_writer(const arrow_writer &obj);
+  /*!
+   * \brief destructor
+   *
+   * Does not finish the file; call close() for that.
+   */
+  ~arrow_writer() throw();
+  /*!
+   * \brief begin a file on an output stream
+   * \param target stream to which the file is written. must be opened
+   * in binary mode, and must outlive close()
+   * \param batch_size number of rows in each record batch
+   */
+  void open(std::ostream *target, unsigned batch_size = default_batch_size);
+  /*!
+   * \brief determine whether a file is in progress
+   * \return whether a file is in progress
+   */
+  bool is_open() const;
+  /*!
+   * \brief add a result to the file
+   * \param chr chromosome of result
+   * \param pos1 start position of result
+   * \param pos2 end position of result, or -1 if not applicable
+   * \param id variant identifier of result
+   * \param gpos genetic position of result
+   * \param rate recombination rate of result
+   * \param a1 first allele of result
+   * \param a2 second allele of result
+   */
+  void append(const std::string &chr, const mpz_class &pos1,
+              const mpz_class &pos2, const std::string &id,
+              const mpf_class &gpos, const mpf_class &rate,
+              const std::string &a1, const std::string &a2);
+  /*!
+   * \brief write any buffered rows, the chromosome dictionary, and
+   * the file footer
+   */
+  void close();
+  static const unsigned default_batch_size = 65536;  //!< rows per batch
+
+ private:
+  /*!
+   * \struct block
+   * \brief location of a message within the file, for the footer
+   */
+  struct block {
+    int64_t offset;           //!< file offset of start of message
+    int32_t metadata_length;  //!< length of framed message metadata
+    int64_t body_length;      //!< length of message body
+  };
+  /*!
+   * \struct string_column
+   * \brief buffered utf8 column in arrow layout
+   */
+  struct string_column {
+    std::vector<int32_t> offsets;  //!< n + 1 offsets into data
+    std::string data;              //!< concatenated values
+  };
+  /*!
+   * \brief add a value to a buffered utf8 column
+   * \param column column to extend
+   * \param value value to append
+   */
+  static void append_string(string_column *column, const std::string &value);
+  /*!
+   * \brief empty a buffered utf8 column
+   * \param column column to reset
+   */
+  static void reset_string(string_column *column);
+  /*!
+   * \brief write buffered rows as a record batch
+   */
+  void write_batch();
+  /*!
+   * \brief write the chromosome dictionary as a dictionary batch
+   */
+  void write_dictionary();
+  /*!
+   * \brief frame and write a message with its body buffers
+   * \param metadata flatbuffer-encoded message
+   * \param buffers body buffers, in schema order
+   * \param body_length total length of body, with padding
+   * \return location of the message
+   */
+  block write_message(const std::string &metadata,
+                      const std::vector<std::string_view> &buffers,
+                      int64_t body_length);
+  /*!
+   * \brief write raw bytes, tracking the file offset
+   * \param data bytes to write
+   * \param length number of bytes to write
+   */
+  void write_bytes(const char *data, size_t length);
+  std::ostream *_target;        //!< destination of the file
+  unsigned _batch_size;         //!< rows per record batch
+  int64_t _offset;              //!< bytes written so far
+  std::vector<block> _batches;  //!< locations of record batches
+  block _dictionary;            //!< location of dictionary batch
+  std::map<std::string, int32_t> _chr_codes;  //!< dictionary lookup
+  string_column _chr_values;  //!< dictionary values in code order
+  std::string _last_chr;      //!< chromosome of previous row
+  int32_t _last_chr_code;     //!< dictionary code of previous row
+  std::vector<int32_t> _chr;  //!< buffered chromosome codes
+  std::vector<int64_t> _pos;  //!< buffered start positions
+  std::vector<int64_t> _end;  //!< buffered end positions
+  std::vector<uint8_t> _end_valid;  //!< validity bitmap of end positions
+  int64_t _end_nulls;               //!< null end positions in batch
+  string_column _id;                //!< buffered variant identifiers
+  string_column _a1;                //!< buffered first alleles
+  string_column _a2;                //!< buffered second alleles
+  std::vector<double> _gpos;        //!< buffered genetic positions
+  std::vector<double> _rate;        //!< buffered recombination rates
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_ARROW_WRITER_H_
@@ -8,10 +8,18 @@
 
 #include "interpolate-genetic-position/bigwig_reader.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace igp = interpolate_genetic_position;
 
 igp::bigwig_reader::bigwig_reader()
-    : _input(NULL), _intervals(NULL), _chr(""), _interval_index(0) {}
+    : _input(NULL),
+      _intervals(NULL),
+      _chr(""),
+      _interval_index(0),
+      _next_chromosome(0),
+      _eof(false) {}
 
 igp::bigwig_reader::~bigwig_reader() throw() {
   close();
@@ -30,22 +38,53 @@ void igp::bigwig_reader::open(const std::string &filename) {
   if (!_input) {
     throw std::runtime_error("bigwig_reader: cannot open \"" + filename + "\"");
   }
+  index_chromosomes();
   load_chr(find_minimum_chromosome());
 }
 
-std::string igp::bigwig_reader::find_minimum_chromosome() const {
-  std::string bwchr = "";
-  int bigwig_chrint = 0, min_bigwig_chrint = 777777;
-  if (_input && _input->cl) {
-    for (int64_t i = 0; i < _input->cl->nKeys; ++i) {
-      bwchr = std::string(_input->cl->chrom[i]);
+void igp::bigwig_reader::index_chromosomes() {
+  _chromosomes = list_chromosomes(_input);
+  _chromosome_index.clear();
+  int bigwig_chrint = 0;
+  for (unsigned i = 0; i < _chromosomes.size(); ++i) {
+    chromosome_to_integer(_chromosomes.at(i), &bigwig_chrint);
+    _chromosome_index[bigwig_chrint] = i;
+  }
+}
+
+std::vector<std::string> igp::bigwig_reader::list_chromosomes(
+    const bigWigFile_t *input) {
+  std::vector<std::pair<int, std::string> > recognized;
+  int bigwig_chrint = 0;
+  if (input && input->cl) {
+    for (int64_t i = 0; i < input->cl->nKeys; ++i) {
+      std::string bwchr(input->cl->chrom[i]);
       if (chromosome_to_integer(bwchr, &bigwig_chrint)) {
-        if (bigwig_chrint < min_bigwig_chrint) {
-          min_bigwig_chrint = bigwig_chrint;
-        }
+        recognized.push_back(std::make_pair(bigwig_chrint, bwchr));
       }
     }
-    if (min_bigwig_chrint == 777777) {
+  }
+  // headers are often in lexicographic order, but downstream consumers
+  // expect karyotypic order
+  std::stable_sort(recognized.begin(), recognized.end(),
+                   [](const std::pair<int, std::string> &lhs,
+                      const std::pair<int, std::string> &rhs) {
+                     return lhs.first < rhs.first;
+                   });
+  std::vector<std::string> res;
+  for (unsigned i = 0; i < recognized.size(); ++i) {
+    if (!i || recognized.at(i).first != recognized.at(i - 1).first) {
+      res.push_back(recognized.at(i).second);
+    }
+  }
+  return res;
+}
+
+std::string igp::bigwig_reader::find_minimum_chromosome() const {
+  int min_bigwig_chrint = 0;
+  if (_input) {
+    if (_chromosomes.empty() ||
+        !chromosome_to_integer(_chromosomes.front(), &min_bigwig_chrint)) {
       throw std::runtime_error("bigwig_reader: min chromosome not recognized");
     }
     return integer_to_chromosome(min_bigwig_chrint);
@@ -56,6 +95,8 @@ std::string igp::bigwig_reader::find_minimum_chromosome() const {
 }
 
 void igp::bigwig_reader::close() {
+  // the background decode must finish before its handle goes away
+  cancel_prefetch();
   if (_input) {
     bwClose(_input);
     _input = NULL;
@@ -67,42 +108,101 @@ void igp::bigwig_reader::close() {
   }
   _chr = "";
   _interval_index = 0;
+  _chromosomes.clear();
+  _chromosome_index.clear();
+  _next_chromosome = 0;
+  _eof = false;
 }
 
 const std::string &igp::bigwig_reader::get_loaded_chr() const { return _chr; }
 
 bool igp::bigwig_reader::load_chr(const std::string &chr) {
+  cancel_prefetch();
   _interval_index = 0;
   if (_intervals) {
     bwDestroyOverlappingIntervals(_intervals);
     _intervals = 0;
   }
   _chr = interpret_chr(chr);
+  _eof = false;
+  int chrint = 0;
+  if (chromosome_to_integer(_chr, &chrint)) {
+    std::unordered_map<int, unsigned>::const_iterator finder =
+        _chromosome_index.find(chrint);
+    if (finder != _chromosome_index.end()) {
+      _next_chromosome = finder->second + 1;
+    }
+  }
   _intervals = bwGetOverlappingIntervals(_input, _chr.c_str(), 0, 1000000000);
+  start_prefetch();
   // failed load is denoted by NULL return pointer
   return _intervals != NULL;
 }
 
 bool igp::bigwig_reader::load_next_chr() {
-  if (eof()) return false;
-  return load_chr(next_chromosome(get_loaded_chr()));
+  if (!_input || _next_chromosome >= _chromosomes.size()) return false;
+  _interval_index = 0;
+  if (_intervals) {
+    bwDestroyOverlappingIntervals(_intervals);
+    _intervals = 0;
+  }
+  _chr = _chromosomes.at(_next_chromosome);
+  ++_next_chromosome;
+  if (_prefetch.valid()) {
+    _intervals = _prefetch.get();
+  } else {
+    _intervals =
+        bwGetOverlappingIntervals(_input, _chr.c_str(), 0, 1000000000);
+  }
+  start_prefetch();
+  return _intervals != NULL;
 }
 
-bool igp::bigwig_reader::is_open() const { return _input != NULL; }
+void igp::bigwig_reader::start_prefetch() {
+  if (_prefetch.valid() || _next_chromosome >= _chromosomes.size()) return;
+  bigWigFile_t *input = _input;
+  std::string chr = _chromosomes.at(_next_chromosome);
+  _prefetch = std::async(std::launch::async, [input, chr]() {
+    return bwGetOverlappingIntervals(input, chr.c_str(), 0, 1000000000);
+  });
+}
+
+void igp::bigwig_reader::cancel_prefetch() {
+  if (_prefetch.valid()) {
+    bwOverlappingIntervals_t *intervals = _prefetch.get();
+    if (intervals) {
+      bwDestroyOverlappingIntervals(intervals);
+    }
+  }
+}
 
-bool igp::bigwig_reader::eof() const {
-  return _chr == "chrM" && (!_intervals || _interval_index == _intervals->l);
+unsigned igp::bigwig_reader::tell() const { return _interval_index; }
+
+bool igp::bigwig_reader::seek(const std::string &chr, unsigned index) {
+  if (!_input) return false;
+  if (!_intervals || interpret_chr(chr).compare(_chr)) {
+    if (!load_chr(chr)) return false;
+  }
+  _interval_index = index;
+  _eof = false;
+  return true;
 }
 
+bool igp::bigwig_reader::is_open() const { return _input != NULL; }
+
+bool igp::bigwig_reader::eof() const { return _eof; }
+
 bool igp::bigwig_reader::get(std::string *chr, mpz_class *pos1, mpz_class *pos2,
                              mpf_class *rate) {
-  if (!_intervals || eof()) return false;
-  if (_interval_index == _intervals->l) {
-    while (!eof()) {
-      if (load_next_chr()) break;
+  if (!_input || _eof) return false;
+  // chromosomes without any intervals are skipped
+  while (!_intervals || _interval_index == _intervals->l) {
+    if (_next_chromosome >= _chromosomes.size()) {
+      _eof = true;
+      return false;
     }
+    load_next_chr();
   }
-  if (eof()) return false;
   *chr = get_loaded_chr();
   *pos1 = _intervals->start[_interval_index];
   *pos2 = _intervals->end[_interval_index];
@@ -112,28 +212,15 @@ bool igp::bigwig_reader::get(std::string *chr, mpz_class *pos1, mpz_class *pos2,
 }
 
 std::string igp::bigwig_reader::interpret_chr(const std::string &chr) const {
-  /*
-   * From libBigWig's docs, it seems that a bigwig contains a chromosome
-   * index in its leading metadata, and that index is available in the
-   * loaded file object.
-   *
-   * The class anticipates that this will be called a very small number
-   * of times relative to the total number of file operations. As such,
-   * this is gonna be sloppy and not record its work for the moment.
-   */
-  std::string bwchr = "";
-  int query_chrint = 0, bigwig_chrint = 0;
+  int query_chrint = 0;
   if (!chromosome_to_integer(chr, &query_chrint)) {
     throw std::runtime_error("unrecognized query chromosome: \"" + chr + "\"");
   }
-  if (_input && _input->cl) {
-    for (int64_t i = 0; i < _input->cl->nKeys; ++i) {
-      bwchr = std::string(_input->cl->chrom[i]);
-      if (chromosome_to_integer(bwchr, &bigwig_chrint)) {
-        if (query_chrint == bigwig_chrint) {
-          return bwchr;
-        }
-      }
+  if (_input) {
+    std::unordered_map<int, unsigned>::const_iterator finder =
+        _chromosome_index.find(query_chrint);
+    if (finder != _chromosome_index.end()) {
+      return _chromosomes.at(finder->second);
     }
     // no match was found. this could be bad, or it could be relatively
     // mild. not sure if returning silently is the appropriate option.
@@ -13,10 +13,12 @@
 #include <gmpxx.h>
 
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "interpolate-genetic-position/utilities.h"
@@ -26,6 +28,12 @@ namespace interpolate_genetic_position {
  * \class bigwig_reader
  * \brief C++ style interface on top of libBigWig for streaming
  * reading of bigwig genetic recombination data.
+ *
+ * The chromosomes present in the bigwig header are indexed once at
+ * open, and iterated in karyotypic order. While the caller consumes one
+ * chromosome, the intervals of the next one are decoded on a background
+ * thread. Only that thread touches the libBigWig handle until its
+ * result is collected.
  */
 class bigwig_reader {
  public:
@@ -53,8 +61,8 @@ class bigwig_reader {
    */
   void close();
   /*!
-   * \brief get next entry from bigwig file. how exactly the progression
-   * between chromosomes will be handled is not yet clear.
+   * \brief get next entry from bigwig file, moving on to the next
+   * chromosome in the file once the current one is exhausted
    * \param chr pointer to string for result chromosome
    * \param pos1 pointer to arbitrary precision integer for start position
    * \param pos2 pointer to arbitrary precision integer for end position
@@ -82,6 +90,8 @@ class bigwig_reader {
   /*!
    * \brief determine whether entire bigwig has been iterated
    * \return whether valid chromosomes have been exhausted
+   *
+   * As with streams, this is set by the first get that runs out of data.
    */
   bool eof() const;
   /*!
@@ -90,12 +100,40 @@ class bigwig_reader {
    * current file is not EOF
    */
   bool load_next_chr();
+  /*!
+   * \brief get the position of the next entry within its chromosome
+   * \return index of the next entry among the loaded chromosome's intervals
+   */
+  unsigned tell() const;
+  /*!
+   * \brief move to an entry of a chromosome
+   * \param chr chromosome of the entry
+   * \param index index of the entry among the chromosome's intervals, as
+   * reported by tell()
+   * \return whether the chromosome could be loaded
+   *
+   * The chromosome is only decoded if it is not the one already loaded;
+   * chromosomes between the two are never decoded.
+   */
+  bool seek(const std::string &chr, unsigned index);
+  /*!
+   * \brief list the recognized chromosomes in a bigwig header
+   * \param input open bigwig file handle
+   * \return chromosome names as they appear in the header, sorted
+   * karyotypically. where several names resolve to the same chromosome,
+   * only the first one in the header is listed
+   *
+   * Unrecognized chromosome names are omitted.
+   */
+  static std::vector<std::string> list_chromosomes(const bigWigFile_t *input);
 
  protected:
   /*!
    * \brief attempt to load all region data for a specified chromosome
    * \param chr requested chromosome
    * \return whether load operation returned anything
+   *
+   * Iteration continues from the chromosome after this one.
    */
   bool load_chr(const std::string &chr);
   /*!
@@ -116,10 +154,29 @@ class bigwig_reader {
   std::string find_minimum_chromosome() const;
 
  private:
+  /*!
+   * \brief index the recognized chromosomes in the bigwig header
+   */
+  void index_chromosomes();
+  /*!
+   * \brief start decoding the next chromosome in the background, if any
+   */
+  void start_prefetch();
+  /*!
+   * \brief wait for any background decode and release its result
+   */
+  void cancel_prefetch();
   bigWigFile_t *_input;                  //!< file handle to bigwig file
   bwOverlappingIntervals_t *_intervals;  //!< loaded bedgraph regions
   std::string _chr;          //!< chromosome range currently stored in intervals
   unsigned _interval_index;  //!< current accessor location in interval
+  std::vector<std::string> _chromosomes;  //!< bigwig chromosomes, sorted
+  std::unordered_map<int, unsigned>
+      _chromosome_index;  //!< chromosome code to index in _chromosomes
+  unsigned _next_chromosome;  //!< index of next chromosome to load
+  std::future<bwOverlappingIntervals_t *>
+      _prefetch;  //!< background decode of next chromosome
+  bool _eof;      //!< whether iteration ran out of chromosomes
 };
 }  // namespace interpolate_genetic_position
 
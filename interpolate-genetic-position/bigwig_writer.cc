@@ -0,0 +1,162 @@
+/*!
+ \file bigwig_writer.cc
+ \brief implementation of bigwig track output
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/bigwig_writer.h"
+
+#include <algorithm>
+
+namespace igp = interpolate_genetic_position;
+
+igp::bigwig_writer::bigwig_writer()
+    : _filename(""),
+      _open(false),
+      _pending(false),
+      _pending_start(0),
+      _pending_end(0),
+      _pending_value(0.0f) {}
+igp::bigwig_writer::bigwig_writer(const bigwig_writer &obj)
+    : _open(false),
+      _pending(false),
+      _pending_start(0),
+      _pending_end(0),
+      _pending_value(0.0f) {
+  throw std::runtime_error(
+      "bigwig_writer: copy constructor operation is invalid for this class");
+}
+igp::bigwig_writer::~bigwig_writer() throw() {}
+void igp::bigwig_writer::open(const std::string &filename) {
+  if (filename.empty()) {
+    throw std::runtime_error(
+        "bigwig_writer::open: bigwig output requires an output file");
+  }
+  _filename = filename;
+  _tracks.clear();
+  _pending = false;
+  _open = true;
+}
+bool igp::bigwig_writer::is_open() const { return _open; }
+uint32_t igp::bigwig_writer::to_coordinate(const mpz_class &pos) {
+  if (pos < 1 || pos > mpz_class(4294967296.0)) {
+    throw std::runtime_error(
+        "bigwig_writer: position out of range for bigwig: " + pos.get_str());
+  }
+  return static_cast<uint32_t>(mpz_class(pos - 1).get_ui());
+}
+void igp::bigwig_writer::append(const std::string &chr, const mpz_class &pos1,
+                                const mpz_class &pos2, double value) {
+  if (!_open) {
+    throw std::runtime_error("bigwig_writer::append: no track in progress");
+  }
+  uint32_t start = to_coordinate(pos1);
+  if (_tracks.empty() || _tracks.back().chr.compare(chr)) {
+    if (_pending) {
+      flush_pending(_pending_end);
+    }
+    for (unsigned i = 0; i < _tracks.size(); ++i) {
+      if (!_tracks.at(i).chr.compare(chr)) {
+        throw std::runtime_error(
+            "bigwig_writer::append: results for chromosome \"" + chr +
+            "\" are not contiguous");
+      }
+    }
+    _tracks.push_back(chromosome_track());
+    _tracks.back().chr = chr;
+  } else if (_pending) {
+    if (start < _pending_start) {
+      throw std::runtime_error(
+          "bigwig_writer::append: results on chromosome \"" + chr +
+          "\" are unsorted");
+    }
+    if (start > _pending_start) {
+      flush_pending(start);
+    }
+  }
+  _pending = true;
+  _pending_start = start;
+  _pending_end = start + 1;
+  if (pos2 > pos1) {
+    _pending_end = std::max(_pending_end, to_coordinate(pos2));
+  }
+  _pending_value = static_cast<float>(value);
+}
+void igp::bigwig_writer::flush_pending(uint32_t end) {
+  chromosome_track &track = _tracks.back();
+  track.start.push_back(_pending_start);
+  track.end.push_back(end);
+  track.value.push_back(_pending_value);
+  _pending = false;
+}
+void igp::bigwig_writer::close() {
+  if (!_open) return;
+  _open = false;
+  if (_pending) {
+    flush_pending(_pending_end);
+  }
+  if (_tracks.empty()) {
+    throw std::runtime_error(
+        "bigwig_writer::close: no results to write to \"" + _filename + "\"");
+  }
+  if (bwInit(1 << 17)) {
+    throw std::runtime_error("bigwig_writer: unable to bwInit");
+  }
+  bigWigFile_t *output = bwOpen(_filename.c_str(), NULL, "w");
+  if (!output) {
+    bwCleanup();
+    throw std::runtime_error("bigwig_writer: cannot open \"" + _filename +
+                             "\" for writing");
+  }
+  try {
+    write_intervals(output);
+  } catch (...) {
+    bwClose(output);
+    bwCleanup();
+    _tracks.clear();
+    throw;
+  }
+  // the zoom levels and index are finished here
+  bwClose(output);
+  bwCleanup();
+  _tracks.clear();
+}
+void igp::bigwig_writer::write_intervals(bigWigFile_t *output) const {
+  // zoom levels are summarized as the intervals are added
+  if (bwCreateHdr(output, 10)) {
+    throw std::runtime_error("bigwig_writer: cannot create header");
+  }
+  // without known chromosome lengths, each chromosome ends with its
+  // last interval
+  std::vector<const char *> chromosomes;
+  std::vector<uint32_t> lengths;
+  for (unsigned i = 0; i < _tracks.size(); ++i) {
+    chromosomes.push_back(_tracks.at(i).chr.c_str());
+    lengths.push_back(_tracks.at(i).end.back());
+  }
+  output->cl = bwCreateChromList(chromosomes.data(), lengths.data(),
+                                 static_cast<int64_t>(chromosomes.size()));
+  if (!output->cl) {
+    throw std::runtime_error("bigwig_writer: cannot create chromosome list");
+  }
+  if (bwWriteHdr(output)) {
+    throw std::runtime_error("bigwig_writer: cannot write header");
+  }
+  for (unsigned i = 0; i < _tracks.size(); ++i) {
+    const chromosome_track &track = _tracks.at(i);
+    const char *chr = track.chr.c_str();
+    // the first interval of a chromosome names it; the rest follow on
+    if (bwAddIntervals(output, &chr, track.start.data(), track.end.data(),
+                       track.value.data(), 1) ||
+        (track.start.size() > 1 &&
+         bwAppendIntervals(output, track.start.data() + 1,
+                           track.end.data() + 1, track.value.data() + 1,
+                           static_cast<uint32_t>(track.start.size() - 1)))) {
+      throw std::runtime_error(
+          "bigwig_writer: cannot write intervals for chromosome \"" +
+          track.chr + "\"");
+    }
+  }
+}
@@ -0,0 +1,121 @@
+/*!
+ \file bigwig_writer.h
+ \brief bigwig track output of interpolated results
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_BIGWIG_WRITER_H_
+#define INTERPOLATE_GENETIC_POSITION_BIGWIG_WRITER_H_
+
+#include <bigWig.h>
+#include <gmpxx.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace interpolate_genetic_position {
+/*!
+ * \class bigwig_writer
+ * \brief write one value per interpolated result as a bigwig track,
+ * with libBigWig's writer.
+ *
+ * Each result covers the bases from its own position up to the next
+ * result on the same chromosome, so that a rate track has the same
+ * meaning as a bolt map and can be read back with --map-format bigwig.
+ * The last result of a chromosome extends to its end position if it has
+ * one (bed regions), and otherwise covers a single base. Of several
+ * results at one position, the last is kept.
+ *
+ * A bigwig header lists every chromosome and its length before any
+ * data, and neither is known until every result has been seen, so the
+ * intervals are held in memory as compact arrays and the file is
+ * written by close(). libBigWig builds the zoom levels as the intervals
+ * are added, in the same pass.
+ */
+class bigwig_writer {
+ public:
+  /*!
+   * \brief default constructor
+   */
+  bigwig_writer();
+  /*!
+   * \brief copy constructor
+   *
+   * Copy constructor is disabled due to buffered output.
+   */
+  bigwig_writer(const bigwig_writer &obj);
+  /*!
+   * \brief destructor
+   *
+   * Does not write the file; call close() for that.
+   */
+  ~bigwig_writer() throw();
+  /*!
+   * \brief begin collecting a track
+   * \param filename name of bigwig file written by close()
+   */
+  void open(const std::string &filename);
+  /*!
+   * \brief determine whether a track is in progress
+   * \return whether a track is in progress
+   */
+  bool is_open() const;
+  /*!
+   * \brief add a result to the track
+   * \param chr chromosome of result
+   * \param pos1 1-based position of result
+   * \param pos2 1-based end position of result, or -1 if not applicable
+   * \param value value reported for result
+   *
+   * Results must be grouped by chromosome and sorted by position.
+   */
+  void append(const std::string &chr, const mpz_class &pos1,
+              const mpz_class &pos2, double value);
+  /*!
+   * \brief write the bigwig file
+   */
+  void close();
+
+ private:
+  /*!
+   * \struct chromosome_track
+   * \brief intervals of one chromosome, as libBigWig takes them
+   */
+  struct chromosome_track {
+    std::string chr;              //!< name of chromosome
+    std::vector<uint32_t> start;  //!< 0-based interval starts
+    std::vector<uint32_t> end;    //!< 0-based exclusive interval ends
+    std::vector<float> value;     //!< interval values
+  };
+  /*!
+   * \brief convert a 1-based position to a 0-based bigwig coordinate
+   * \param pos 1-based position
+   * \return 0-based coordinate
+   */
+  static uint32_t to_coordinate(const mpz_class &pos);
+  /*!
+   * \brief add the pending result to its chromosome, ending at a given
+   * coordinate
+   * \param end 0-based exclusive end of the pending result
+   */
+  void flush_pending(uint32_t end);
+  /*!
+   * \brief pass the collected intervals to libBigWig
+   * \param output bigwig file opened for writing
+   */
+  void write_intervals(bigWigFile_t *output) const;
+  std::string _filename;                  //!< name of output file
+  bool _open;                             //!< whether a track is in progress
+  std::vector<chromosome_track> _tracks;  //!< intervals per chromosome
+  bool _pending;           //!< whether a result awaits its end
+  uint32_t _pending_start;  //!< start of pending result
+  uint32_t _pending_end;   //!< end of pending result if it is the last
+  float _pending_value;    //!< value of pending result
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_BIGWIG_WRITER_H_
@@ -30,21 +30,52 @@ void igp::cargs::initialize_options() {
       "verbose,v", "emit extremely verbose debug logs")(
       "version", "emit program version and exit")(
       "input,i",
+      boost::program_options::value<std::vector<std::string> >()
+          ->composing(),
+      "name of input variant/region query file (default: read from stdin). "
+      "may be given more than once, in which case --output names a "
+      "directory that receives one output file per input")(
+      "input-list",
       boost::program_options::value<std::string>()->default_value(""),
-      "name of input variant/region query file (default: read from stdin)")(
+      "name of file listing input query files, one per line, processed "
+      "against a single load of the genetic map; as with several -i, "
+      "--output names the output directory")(
+      "jobs", boost::program_options::value<unsigned>()->default_value(1),
+      "number of input files processed at once, when there are several")(
       "preset,p", boost::program_options::value<std::string>(),
-      "format of input file (accepted values: bim, map, snp, vcf, bed)")(
+      "format of input file (accepted values: bim, map, snp, vcf, bed, "
+      "pvar)")(
       "genetic-map,g",
-      boost::program_options::value<std::string>()->default_value(""),
-      "name of input genetic recombination map (default: read from stdin)")(
-      "map-format,m", boost::program_options::value<std::string>(),
+      boost::program_options::value<std::vector<std::string> >()
+          ->composing(),
+      "name of input genetic recombination map (default: read from stdin). "
+      "may be given more than once, in which case the input is "
+      "interpolated against every map in one pass, and each map's stem is "
+      "inserted into --output before its extension")(
+      "map-format,m",
+      boost::program_options::value<std::vector<std::string> >()
+          ->composing(),
       "format of input recombination map (accepted values: bolt, bedgraph, "
-      "bigwig)")(
+      "bigwig). with several maps, give either one format for all of "
+      "them, or one per map, in order")(
       "output,o",
+      boost::program_options::value<std::vector<std::string> >()
+          ->composing(),
+      "name of output file (default: write to stdout). may be given more "
+      "than once, paired in order with several -f, to write the same "
+      "results in several formats from one pass")(
+      "output-per-chromosome",
       boost::program_options::value<std::string>()->default_value(""),
-      "name of output file (default: write to stdout)")(
-      "output-format,f", boost::program_options::value<std::string>(),
-      "format of output file (accepted values: bim, map, snp, bolt)")(
+      "write each chromosome to its own file, named with this prefix "
+      "followed by the chromosome and the output format's extension; "
+      "replaces -o")(
+      "output-format,f",
+      boost::program_options::value<std::vector<std::string> >()
+          ->composing(),
+      "format of output file (accepted values: bim, map, snp, bolt, vcf, "
+      "bcf, pvar, arrow, bigwig). vcf/bcf INFO values are 32-bit floats "
+      "(about 7 significant digits), unaffected by --precision and "
+      "--fixed-output-width")(
       "output-morgans",
       "emit output genetic position in morgans instead of centimorgans")(
       "region-step-interval",
@@ -59,7 +90,32 @@ void igp::cargs::initialize_options() {
       "set width of output floating point values. larger width will "
       "potentially lead to more reasonable downstream interpolation, "
       "at the cost of file size. leaving this unset or set to 0 will cause "
-      "the output width to be dynamically scaled to significant digits");
+      "the output width to be dynamically scaled to significant digits")(
+      "profile-memory",
+      "count heap and GMP allocations per processing stage and report them, "
+      "along with peak RSS, to stderr on exit")(
+      "disable-gmp-arena",
+      "back GMP arithmetic with the system allocator instead of the "
+      "default per-thread arena; mostly useful for debugging")(
+      "pipeline",
+      "run input parsing, interpolation and output formatting concurrently "
+      "on separate threads. output is identical to the default mode")(
+      "output-cm-rate",
+      "for vcf/bcf output, also annotate each record with its local "
+      "recombination rate in the INFO field CM_RATE")(
+      "bigwig-rate-track",
+      "for bigwig output, write the local recombination rate (cM/Mb) "
+      "track instead of genetic position")(
+      "map-index",
+      "read text (plain or gzipped) or bigwig genetic maps with a sidecar "
+      "index, built next to the map on first use, so that sparse queries "
+      "skip over the map rows between them. output is identical either "
+      "way")(
+      "threads", boost::program_options::value<unsigned>()->default_value(1),
+      "number of threads htslib may use for decompression of vcf/bcf "
+      "input and compression of vcf/bcf output. above 1, bigwig genetic "
+      "maps are also decoded this many chromosomes at a time, and indexed "
+      "gzip maps decompressed this many stretches at a time");
 }
 
 bool igp::cargs::help() const { return compute_flag("help"); }
@@ -69,44 +125,107 @@ bool igp::cargs::verbose() const { return compute_flag("verbose"); }
 bool igp::cargs::version() const { return compute_flag("version"); }
 
 std::string igp::cargs::get_input_filename() const {
-  return compute_parameter<std::string>("input");
+  std::vector<std::string> filenames = get_input_filenames();
+  return filenames.empty() ? "" : filenames.at(0);
+}
+
+std::vector<std::string> igp::cargs::get_input_filenames() const {
+  std::vector<std::string> res;
+  if (_vm.count("input")) {
+    res = compute_parameter<std::vector<std::string> >("input");
+  }
+  return res;
+}
+
+std::string igp::cargs::get_input_list() const {
+  return compute_parameter<std::string>("input-list");
+}
+
+unsigned igp::cargs::get_jobs() const {
+  unsigned res = compute_parameter<unsigned>("jobs");
+  if (!res) {
+    throw std::runtime_error("cargs::get_jobs: at least one job is required");
+  }
+  return res;
 }
 
 std::string igp::cargs::get_input_preset() const {
   std::string preset = compute_parameter<std::string>("preset");
   if (preset.compare("bim") && preset.compare("map") && preset.compare("bed") &&
-      preset.compare("snp") && preset.compare("vcf")) {
+      preset.compare("snp") && preset.compare("vcf") &&
+      preset.compare("pvar")) {
     throw std::runtime_error("invalid input preset format: \"" + preset + "\"");
   }
   return preset;
 }
 
 std::string igp::cargs::get_recombination_map() const {
-  return compute_parameter<std::string>("genetic-map");
+  std::vector<std::string> filenames = get_recombination_maps();
+  return filenames.empty() ? "" : filenames.at(0);
+}
+
+std::vector<std::string> igp::cargs::get_recombination_maps() const {
+  std::vector<std::string> res;
+  if (_vm.count("genetic-map")) {
+    res = compute_parameter<std::vector<std::string> >("genetic-map");
+  }
+  return res;
 }
 
 std::string igp::cargs::get_map_format() const {
-  std::string map_format = compute_parameter<std::string>("map-format");
-  if (map_format.compare("bolt") && map_format.compare("bedgraph") &&
-      map_format.compare("bigwig")) {
-    throw std::runtime_error("invalid genetic map format: \"" + map_format +
-                             "\"");
+  return get_map_formats().at(0);
+}
+
+std::vector<std::string> igp::cargs::get_map_formats() const {
+  std::vector<std::string> res =
+      compute_parameter<std::vector<std::string> >("map-format");
+  for (unsigned i = 0; i < res.size(); ++i) {
+    const std::string &map_format = res.at(i);
+    if (map_format.compare("bolt") && map_format.compare("bedgraph") &&
+        map_format.compare("bigwig")) {
+      throw std::runtime_error("invalid genetic map format: \"" + map_format +
+                               "\"");
+    }
   }
-  return map_format;
+  return res;
 }
 
 std::string igp::cargs::get_output_filename() const {
-  return compute_parameter<std::string>("output");
+  std::vector<std::string> filenames = get_output_filenames();
+  return filenames.empty() ? "" : filenames.at(0);
+}
+
+std::vector<std::string> igp::cargs::get_output_filenames() const {
+  std::vector<std::string> res;
+  if (_vm.count("output")) {
+    res = compute_parameter<std::vector<std::string> >("output");
+  }
+  return res;
+}
+
+std::string igp::cargs::get_output_per_chromosome() const {
+  return compute_parameter<std::string>("output-per-chromosome");
 }
 
 std::string igp::cargs::get_output_format() const {
-  std::string output_format = compute_parameter<std::string>("output-format");
-  if (output_format.compare("bim") && output_format.compare("map") &&
-      output_format.compare("bolt") && output_format.compare("snp")) {
-    throw std::runtime_error("invalid output format: \"" + output_format +
-                             "\"");
+  return get_output_formats().at(0);
+}
+
+std::vector<std::string> igp::cargs::get_output_formats() const {
+  std::vector<std::string> res =
+      compute_parameter<std::vector<std::string> >("output-format");
+  for (unsigned i = 0; i < res.size(); ++i) {
+    const std::string &output_format = res.at(i);
+    if (output_format.compare("bim") && output_format.compare("map") &&
+        output_format.compare("bolt") && output_format.compare("snp") &&
+        output_format.compare("vcf") && output_format.compare("bcf") &&
+        output_format.compare("pvar") && output_format.compare("arrow") &&
+        output_format.compare("bigwig")) {
+      throw std::runtime_error("invalid output format: \"" + output_format +
+                               "\"");
+    }
   }
-  return output_format;
+  return res;
 }
 
 bool igp::cargs::output_morgans() const {
@@ -135,6 +254,35 @@ unsigned igp::cargs::get_fixed_output_width() const {
   return res;
 }
 
+bool igp::cargs::profile_memory() const {
+  return compute_flag("profile-memory");
+}
+
+bool igp::cargs::disable_gmp_arena() const {
+  return compute_flag("disable-gmp-arena");
+}
+
+bool igp::cargs::pipeline() const { return compute_flag("pipeline"); }
+
+bool igp::cargs::output_cm_rate() const {
+  return compute_flag("output-cm-rate");
+}
+
+bool igp::cargs::output_bigwig_rate() const {
+  return compute_flag("bigwig-rate-track");
+}
+
+bool igp::cargs::map_index() const { return compute_flag("map-index"); }
+
+unsigned igp::cargs::get_threads() const {
+  unsigned res = compute_parameter<unsigned>("threads");
+  if (!res) {
+    throw std::runtime_error(
+        "cargs::get_threads: at least one thread is required");
+  }
+  return res;
+}
+
 bool igp::cargs::compute_flag(const std::string &tag) const {
   return _vm.count(tag);
 }
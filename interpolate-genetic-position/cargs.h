@@ -77,9 +77,29 @@ class cargs {
    * \brief get name of input variant/region query file
    * \return name of input variant/query region file
    *
-   * this string can be empty, in which case input is pulled from cin
+   * this string can be empty, in which case input is pulled from cin.
+   * if -i was given more than once, this is the first
    */
   std::string get_input_filename() const;
+  /*!
+   * \brief get names of all input variant/region query files given
+   * with -i
+   * \return names of input files, in command line order; empty if -i
+   * was not given
+   */
+  std::vector<std::string> get_input_filenames() const;
+  /*!
+   * \brief get name of file listing input query files, one per line
+   * \return name of input list file, or empty string if not given
+   */
+  std::string get_input_list() const;
+  /*!
+   * \brief get number of input files processed at once
+   * \return number of input files processed at once
+   *
+   * Only used when there are several input files.
+   */
+  unsigned get_jobs() const;
   /*!
    * \brief get input variant/region file format
    * \return input variant/region file format
@@ -91,9 +111,16 @@ class cargs {
   std::string get_input_preset() const;
   /*!
    * \brief get name of input recombination map
-   * \return name of input recombination map
+   * \return name of first input recombination map, or an empty string
+   * for stdin
    */
   std::string get_recombination_map() const;
+  /*!
+   * \brief get names of all input recombination maps
+   * \return names of input recombination maps, in command line order;
+   * empty if none was given
+   */
+  std::vector<std::string> get_recombination_maps() const;
   /*!
    * \brief get input recombination map format
    * \return input recombination map format
@@ -106,18 +133,42 @@ class cargs {
    * (https://hgdownload.soe.ucsc.edu/gbdb/hg38/recombRate/recombAvg.bw)
    *     - note that this needs to be converted to bedgraph before being used
    * with this software
+   *
+   * With several maps, this is the format of the first.
    */
   std::string get_map_format() const;
+  /*!
+   * \brief get all input recombination map formats
+   * \return input recombination map formats, in command line order
+   */
+  std::vector<std::string> get_map_formats() const;
   /*!
    * \brief get name of output file
-   * \return name of output file
+   * \return name of first output file, or an empty string for stdout
    */
   std::string get_output_filename() const;
+  /*!
+   * \brief get names of all output files
+   * \return names of output files, in command line order; empty if
+   * none was given
+   */
+  std::vector<std::string> get_output_filenames() const;
+  /*!
+   * \brief get prefix of output files written per chromosome
+   * \return prefix of output files written per chromosome, or an empty
+   * string for a single output
+   */
+  std::string get_output_per_chromosome() const;
   /*!
    * \brief get requested format of output file
-   * \return output file format
+   * \return format of first output file
    */
   std::string get_output_format() const;
+  /*!
+   * \brief get requested formats of all output files
+   * \return output file formats, in command line order
+   */
+  std::vector<std::string> get_output_formats() const;
 
   /*!
     \brief determine whether genetic position should be output in morgans,
@@ -163,6 +214,58 @@ class cargs {
    * behavior of dynamic output width to be used.
    */
   unsigned get_fixed_output_width() const;
+  /*!
+   * \brief determine whether the user has requested allocation profiling
+   * \return whether the user has requested allocation profiling
+   *
+   * This is a diagnostic mode: allocations through operator new and GMP
+   * are counted per processing stage, and a summary including allocations
+   * per processed row and peak RSS is reported to stderr on exit.
+   */
+  bool profile_memory() const;
+  /*!
+   * \brief determine whether the user has requested that GMP use
+   * the system allocator instead of the per-thread arena
+   * \return whether the GMP arena should be left uninstalled
+   */
+  bool disable_gmp_arena() const;
+  /*!
+   * \brief determine whether the user has requested that reading,
+   * interpolation and writing run concurrently
+   * \return whether reading, interpolation and writing should run
+   * on dedicated threads
+   */
+  bool pipeline() const;
+  /*!
+   * \brief determine whether the user has requested that vcf/bcf
+   * output records be annotated with recombination rate in addition
+   * to genetic position
+   * \return whether INFO/CM_RATE should be added to vcf/bcf output
+   */
+  bool output_cm_rate() const;
+  /*!
+   * \brief determine whether the user has requested that bigwig output
+   * report recombination rate instead of genetic position
+   * \return whether bigwig output should be the rate track
+   */
+  bool output_bigwig_rate() const;
+  /*!
+   * \brief determine whether the user has requested that genetic maps
+   * be read with a sidecar index, to skip ahead between sparse queries
+   * \return whether genetic maps should be read with an index
+   */
+  bool map_index() const;
+  /*!
+   * \brief get number of threads available to htslib
+   * \return number of threads available to htslib
+   *
+   * Threads are used for decompression of vcf/bcf input and compression
+   * of vcf/bcf output; each gets its own pool. A value of 1 means this
+   * work happens on the reading and writing threads themselves. Above
+   * 1, bigwig genetic maps are also decoded this many chromosomes at a
+   * time.
+   */
+  unsigned get_threads() const;
   /*!
     \brief find status of arbitrary flag
     @param tag name of flag
@@ -0,0 +1,461 @@
+/*!
+ \file compiled_genetic_map.cc
+ \brief implementation of in-memory genetic map for batch interpolation
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/compiled_genetic_map.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+/*!
+ * \struct double_double
+ * \brief unevaluated sum of two doubles, the low word holding the
+ * rounding error of the high word
+ */
+struct double_double {
+  double hi;  //!< value rounded to double
+  double lo;  //!< remainder of exact value
+};
+/*!
+ * \brief add two doubles without losing the rounding error
+ * \param a first term
+ * \param b second term
+ * \return exact sum of terms
+ */
+double_double two_sum(double a, double b) {
+  double s = a + b;
+  double v = s - a;
+  return {s, (a - (s - v)) + (b - v)};
+}
+/*!
+ * \brief add two double-double values
+ * \param a first term
+ * \param b second term
+ * \return sum of terms, renormalized
+ */
+double_double add(const double_double &a, const double_double &b) {
+  double_double s = two_sum(a.hi, b.hi);
+  return two_sum(s.hi, s.lo + a.lo + b.lo);
+}
+/*!
+ * \brief genetic distance covered by a rate over a physical distance
+ * \param rate rate in cM/Mb
+ * \param width physical distance in bases
+ * \return rate * width / 1e6, keeping the rounding error of both the
+ * product and the quotient
+ */
+double_double distance(double rate, int64_t width) {
+  double w = static_cast<double>(width);
+  double product = rate * w;
+  double product_error = std::fma(rate, w, -product);
+  double quotient = product / 1000000.0;
+  double remainder = std::fma(-quotient, 1000000.0, product);
+  return {quotient, (remainder + product_error) / 1000000.0};
+}
+/*!
+ * \brief run a task over a range of items on several threads
+ * \param n_threads maximum number of threads
+ * \param n_items number of items
+ * \param task function applied to each item index
+ *
+ * Threads claim items in order from a shared counter. The first failure
+ * of any thread is rethrown once all have finished.
+ */
+void run_parallel(unsigned n_threads, size_t n_items,
+                  const std::function<void(size_t)> &task) {
+  size_t n_workers = std::min(static_cast<size_t>(n_threads), n_items);
+  if (n_workers <= 1) {
+    for (size_t i = 0; i < n_items; ++i) {
+      task(i);
+    }
+    return;
+  }
+  std::atomic<size_t> next(0);
+  std::vector<std::exception_ptr> errors(n_workers);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < n_workers; ++i) {
+    workers.push_back(std::thread([&, i]() {
+      try {
+        for (size_t j = next++; j < n_items; j = next++) {
+          task(j);
+        }
+      } catch (...) {
+        errors.at(i) = std::current_exception();
+      }
+    }));
+  }
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers.at(i).join();
+  }
+  for (size_t i = 0; i < errors.size(); ++i) {
+    if (errors.at(i)) {
+      std::rethrow_exception(errors.at(i));
+    }
+  }
+}
+/*!
+ * \brief write a value to a binary stream in native byte order
+ * \param out output stream
+ * \param value value to write
+ */
+template <class value_type>
+void write_value(std::ostream &out, const value_type &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value_type));
+}
+/*!
+ * \brief write an array to a binary stream in native byte order
+ * \param out output stream
+ * \param values array to write
+ */
+template <class value_type>
+void write_array(std::ostream &out, const std::vector<value_type> &values) {
+  out.write(reinterpret_cast<const char *>(values.data()),
+            static_cast<std::streamsize>(values.size() * sizeof(value_type)));
+}
+/*!
+ * \brief read an array from a binary stream in native byte order
+ * \param in input stream
+ * \param n number of values to read
+ * \param values pointer to array to fill
+ * \return whether all values were read
+ */
+template <class value_type>
+bool read_array(std::istream &in, size_t n, std::vector<value_type> *values) {
+  values->resize(n);
+  in.read(reinterpret_cast<char *>(values->data()),
+          static_cast<std::streamsize>(n * sizeof(value_type)));
+  return static_cast<bool>(in);
+}
+/*!
+ * \brief leading bytes of a compiled map cache
+ */
+const char cache_magic[8] = {'i', 'g', 'p', 'c', 'a', 'c', 'h', 'e'};
+/*!
+ * \brief version of compiled map cache layout
+ */
+const int64_t cache_version = 2;
+/*!
+ * \brief marker to reject caches written with another byte order
+ */
+const int64_t cache_byte_order = 0x0102030405060708;
+/*!
+ * \brief number of rows summed as one task of the prefix sum
+ */
+const size_t prefix_block_rows = 65536;
+}  // namespace
+
+igp::compiled_genetic_map::compiled_genetic_map() : _size(0) {}
+igp::compiled_genetic_map::compiled_genetic_map(
+    const compiled_genetic_map &obj)
+    : _size(0) {
+  throw std::runtime_error(
+      "compiled_genetic_map: copy constructor operation is invalid for this "
+      "class");
+}
+igp::compiled_genetic_map::~compiled_genetic_map() throw() {}
+void igp::compiled_genetic_map::open(const std::string &filename,
+                                     format_type ft, unsigned n_threads,
+                                     bool use_cache) {
+  if (!n_threads) {
+    throw std::runtime_error(
+        "compiled_genetic_map::open: at least one thread is required");
+  }
+  // the map file is identified by format, size and modification time
+  std::vector<int64_t> header;
+  struct stat info;
+  std::string cache_filename = filename + ".igpcache";
+  if (use_cache && !stat(filename.c_str(), &info) && S_ISREG(info.st_mode)) {
+    header.push_back(static_cast<int64_t>(ft));
+    header.push_back(static_cast<int64_t>(info.st_size));
+    header.push_back(static_cast<int64_t>(info.st_mtime));
+    if (restore_cache(cache_filename, header)) {
+      return;
+    }
+  }
+  bool rate_only = ft == BEDGRAPH || ft == BIGWIG;
+  if (ft == BIGWIG && n_threads > 1) {
+    parallel_bigwig_map_file source;
+    source.set_threads(n_threads);
+    source.set_accumulate_gpos(!rate_only);
+    source.open(filename, ft);
+    load(&source);
+    source.close();
+  } else {
+    input_genetic_map_file source;
+    source.set_accumulate_gpos(!rate_only);
+    source.open(filename, ft);
+    load(&source);
+    source.close();
+  }
+  if (rate_only) {
+    accumulate_gpos(n_threads);
+  }
+  if (!header.empty()) {
+    save_cache(cache_filename, header);
+  }
+}
+void igp::compiled_genetic_map::load(base_input_genetic_map_file *source) {
+  if (!source) {
+    throw std::runtime_error("compiled_genetic_map::load: source is NULL");
+  }
+  _chromosomes.clear();
+  _size = 0;
+  map_block block;
+  while (source->get_block(&block, 65536)) {
+    chromosome &rows = _chromosomes[chromosome_code(block.get_chr())];
+    for (unsigned i = 0; i < block.size(); ++i) {
+      int64_t startpos = block.get_startpos(i).get_si();
+      if (!rows.startpos.empty() && startpos < rows.startpos.back()) {
+        throw std::runtime_error(
+            "compiled_genetic_map::load: genetic map rows on chromosome \"" +
+            block.get_chr() +
+            "\" are unsorted. For now, the only solution to this issue is "
+            "to sort your input data.");
+      }
+      rows.startpos.push_back(startpos);
+      rows.endpos.push_back(block.get_endpos(i).get_si());
+      // rounded to nearest, where mpf_get_d would truncate
+      rows.gpos.push_back(mpf_to_double(block.get_gpos(i)));
+      rows.rate.push_back(mpf_to_double(block.get_rate(i)));
+    }
+    _size += block.size();
+  }
+}
+bool igp::compiled_genetic_map::has_chromosome(const std::string &chr) const {
+  return find(chr) != NULL;
+}
+size_t igp::compiled_genetic_map::size() const { return _size; }
+void igp::compiled_genetic_map::interpolate(const std::string &chr,
+                                            const int64_t *positions, size_t n,
+                                            double *gpos, double *rate) const {
+  if (n && (!positions || !gpos || !rate)) {
+    throw std::runtime_error("compiled_genetic_map::interpolate: NULL array");
+  }
+  const chromosome *rows = find(chr);
+  if (!rows) {
+    std::fill(gpos, gpos + n, 0.0);
+    std::fill(rate, rate + n, 0.0);
+    return;
+  }
+  const std::vector<int64_t> &starts = rows->startpos;
+  // number of rows starting at or before the current position
+  size_t upper = 0;
+  for (size_t i = 0; i < n; ++i) {
+    int64_t pos = positions[i];
+    std::vector<int64_t>::const_iterator search_start = starts.begin();
+    if (i && pos >= positions[i - 1]) {
+      // sorted runs continue scanning from the previous position, and
+      // only search once the next position is more than a few rows away
+      unsigned steps = 0;
+      while (upper < starts.size() && starts[upper] <= pos && steps < 8) {
+        ++upper;
+        ++steps;
+      }
+      if (steps < 8) {
+        search_start = starts.end();
+      } else {
+        search_start += static_cast<std::ptrdiff_t>(upper);
+      }
+    }
+    if (search_start != starts.end()) {
+      upper = static_cast<size_t>(
+          std::upper_bound(search_start, starts.end(), pos) - starts.begin());
+    }
+    if (!upper) {
+      gpos[i] = 0.0;
+      rate[i] = 0.0;
+    } else {
+      interpolate_row(*rows, upper - 1, pos, gpos + i, rate + i);
+    }
+  }
+}
+void igp::compiled_genetic_map::accumulate_gpos(unsigned n_threads) {
+  /*!
+   * \struct prefix_block
+   * \brief a run of rows of one chromosome, summed as one task
+   */
+  struct prefix_block {
+    chromosome *rows;         //!< rows of chromosome
+    size_t begin;             //!< index of first row of block
+    size_t end;               //!< index past last row of block
+    std::vector<double> lo;   //!< low words of sums within block
+    double_double total;      //!< sum of block
+    double_double offset;     //!< sum of preceding blocks of chromosome
+  };
+  std::vector<prefix_block> blocks;
+  for (std::map<int, chromosome>::iterator iter = _chromosomes.begin();
+       iter != _chromosomes.end(); ++iter) {
+    size_t n = iter->second.startpos.size();
+    for (size_t begin = 0; begin < n; begin += prefix_block_rows) {
+      blocks.push_back(prefix_block());
+      blocks.back().rows = &iter->second;
+      blocks.back().begin = begin;
+      blocks.back().end = std::min(n, begin + prefix_block_rows);
+    }
+  }
+  // the distance to each row depends only on the rate of the row before
+  // it, so blocks can be summed independently
+  run_parallel(n_threads, blocks.size(), [&blocks](size_t i) {
+    prefix_block &block = blocks.at(i);
+    chromosome &rows = *block.rows;
+    block.lo.resize(block.end - block.begin);
+    double_double sum = {0.0, 0.0};
+    for (size_t j = block.begin; j < block.end; ++j) {
+      if (j) {
+        sum = add(sum, distance(rows.rate[j - 1],
+                                rows.startpos[j] - rows.startpos[j - 1]));
+      }
+      rows.gpos[j] = sum.hi;
+      block.lo[j - block.begin] = sum.lo;
+    }
+    block.total = sum;
+  });
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    if (blocks.at(i).begin) {
+      blocks.at(i).offset =
+          add(blocks.at(i - 1).offset, blocks.at(i - 1).total);
+    } else {
+      blocks.at(i).offset = {0.0, 0.0};
+    }
+  }
+  run_parallel(n_threads, blocks.size(), [&blocks](size_t i) {
+    prefix_block &block = blocks.at(i);
+    chromosome &rows = *block.rows;
+    for (size_t j = block.begin; j < block.end; ++j) {
+      rows.gpos[j] =
+          add(block.offset, {rows.gpos[j], block.lo[j - block.begin]}).hi;
+    }
+    std::vector<double>().swap(block.lo);
+  });
+}
+bool igp::compiled_genetic_map::save_cache(
+    const std::string &filename, const std::vector<int64_t> &header) const {
+  // written in full under a temporary name, so readers never see a
+  // partial cache
+  std::string tmp_filename = filename + ".tmp";
+  std::ofstream output(tmp_filename.c_str(), std::ios::binary);
+  if (!output.is_open()) {
+    return false;
+  }
+  output.write(cache_magic, sizeof(cache_magic));
+  write_value(output, cache_version);
+  write_value(output, cache_byte_order);
+  for (unsigned i = 0; i < header.size(); ++i) {
+    write_value(output, header.at(i));
+  }
+  write_value(output, static_cast<int64_t>(_chromosomes.size()));
+  for (std::map<int, chromosome>::const_iterator iter = _chromosomes.begin();
+       iter != _chromosomes.end(); ++iter) {
+    write_value(output, static_cast<int64_t>(iter->first));
+    write_value(output, static_cast<int64_t>(iter->second.startpos.size()));
+    write_array(output, iter->second.startpos);
+    write_array(output, iter->second.endpos);
+    write_array(output, iter->second.gpos);
+    write_array(output, iter->second.rate);
+  }
+  output.close();
+  if (!output || std::rename(tmp_filename.c_str(), filename.c_str())) {
+    std::remove(tmp_filename.c_str());
+    return false;
+  }
+  return true;
+}
+bool igp::compiled_genetic_map::restore_cache(
+    const std::string &filename, const std::vector<int64_t> &header) {
+  std::ifstream input(filename.c_str(), std::ios::binary);
+  if (!input.is_open()) {
+    return false;
+  }
+  char magic[sizeof(cache_magic)];
+  std::vector<int64_t> expected, observed;
+  expected.push_back(cache_version);
+  expected.push_back(cache_byte_order);
+  expected.insert(expected.end(), header.begin(), header.end());
+  input.read(magic, sizeof(magic));
+  if (!input || !std::equal(magic, magic + sizeof(magic), cache_magic) ||
+      !read_array(input, expected.size(), &observed) ||
+      observed != expected) {
+    return false;
+  }
+  // each row takes 32 bytes, which bounds the row counts a truncated or
+  // damaged cache can claim
+  input.seekg(0, std::ios::end);
+  int64_t remaining = static_cast<int64_t>(input.tellg());
+  input.seekg(static_cast<std::streamoff>(sizeof(magic) +
+                                          expected.size() * sizeof(int64_t)));
+  std::vector<int64_t> counts;
+  if (!read_array(input, 1, &counts) || counts.at(0) < 0) {
+    return false;
+  }
+  std::map<int, chromosome> chromosomes;
+  size_t total = 0;
+  for (int64_t i = 0; i < counts.at(0); ++i) {
+    std::vector<int64_t> entry;
+    if (!read_array(input, 2, &entry) || entry.at(1) < 0 ||
+        entry.at(1) > remaining / 32) {
+      return false;
+    }
+    size_t n = static_cast<size_t>(entry.at(1));
+    chromosome &rows = chromosomes[static_cast<int>(entry.at(0))];
+    if (!read_array(input, n, &rows.startpos) ||
+        !read_array(input, n, &rows.endpos) ||
+        !read_array(input, n, &rows.gpos) ||
+        !read_array(input, n, &rows.rate)) {
+      return false;
+    }
+    total += n;
+  }
+  _chromosomes.swap(chromosomes);
+  _size = total;
+  return true;
+}
+const igp::compiled_genetic_map::chromosome *igp::compiled_genetic_map::find(
+    const std::string &chr) const {
+  std::map<int, chromosome>::const_iterator finder =
+      _chromosomes.find(chromosome_code(chr));
+  return finder == _chromosomes.end() ? NULL : &finder->second;
+}
+int igp::compiled_genetic_map::chromosome_code(const std::string &chr) {
+  // unrecognized names share a code, matching chromosome_compare
+  int code = 0;
+  chromosome_to_integer(chr, &code);
+  return code;
+}
+void igp::compiled_genetic_map::interpolate_row(const chromosome &rows,
+                                                size_t i, int64_t pos,
+                                                double *gpos, double *rate) {
+  int64_t startpos = rows.startpos[i];
+  double row_rate = rows.rate[i];
+  if (i + 1 < rows.startpos.size()) {
+    *gpos = rows.gpos[i] + static_cast<double>(pos - startpos) / 1000000.0 *
+                               row_rate;
+    *rate = row_rate;
+    return;
+  }
+  // past the final row of the chromosome: maps without end positions
+  // report the final row, while bedgraph-style maps extend to its end
+  int64_t endpos = rows.endpos[i];
+  if (endpos < 0) {
+    *gpos = rows.gpos[i];
+    *rate = row_rate;
+    return;
+  }
+  *gpos = rows.gpos[i] + static_cast<double>(std::min(pos, endpos) - startpos) /
+                             1000000.0 * row_rate;
+  *rate = pos < endpos ? row_rate : 0.0;
+}
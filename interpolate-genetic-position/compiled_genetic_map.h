@@ -0,0 +1,177 @@
+/*!
+ \file compiled_genetic_map.h
+ \brief genetic map held in memory for batch point interpolation
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_COMPILED_GENETIC_MAP_H_
+#define INTERPOLATE_GENETIC_POSITION_COMPILED_GENETIC_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "interpolate-genetic-position/input_genetic_map_file.h"
+#include "interpolate-genetic-position/parallel_bigwig_map_file.h"
+#include "interpolate-genetic-position/utilities.h"
+
+namespace interpolate_genetic_position {
+/*!
+ * \class compiled_genetic_map
+ * \brief an entire genetic map converted to plain arrays, for
+ * interpolating large batches of positions from library callers.
+ *
+ * The map is read once, in file order, and each chromosome is stored as
+ * parallel arrays of start and end positions, genetic positions and
+ * rates. Queries follow the point query rules of genetic_map, but in
+ * double precision and without any cursor state: positions need not be
+ * sorted, and a loaded map may be queried from several threads at once.
+ *
+ * Chromosomes are matched by their numeric code, so "1" and "chr1" are
+ * the same chromosome, as elsewhere in this program.
+ *
+ * Bedgraph and bigwig maps carry only rates. When such a map is opened
+ * from file, its rows are loaded without genetic positions, which are
+ * then computed for all chromosomes at once as a blocked prefix sum:
+ * blocks of rows are summed on separate threads, each block is offset by
+ * the total of the blocks before it, and the offsets are applied in
+ * parallel again. Every sum is carried in double-double arithmetic, so
+ * the result is at least as precise as the default GMP accumulation
+ * before it is rounded to double.
+ */
+class compiled_genetic_map {
+ public:
+  /*!
+   * \brief default constructor
+   */
+  compiled_genetic_map();
+  /*!
+   * \brief copy constructor
+   * \param obj existing compiled_genetic_map
+   *
+   * Copy constructor is disabled, as maps may be very large.
+   */
+  compiled_genetic_map(const compiled_genetic_map &obj);
+  /*!
+   * \brief destructor
+   */
+  ~compiled_genetic_map() throw();
+  /*!
+   * \brief load a genetic map from file
+   * \param filename name of map file
+   * \param ft format of map file
+   * \param n_threads number of threads used to decode bigwig chromosomes
+   * and to accumulate the genetic positions of rate-only maps
+   * \param use_cache whether to reuse, or else create, a cache of the
+   * loaded table next to the map file
+   *
+   * The cache is named after the map file with the suffix ".igpcache",
+   * and is only used if it was built from a map of the same format,
+   * size and modification time on a machine of the same byte order.
+   * Otherwise the map is loaded as usual and the cache replaced; if the
+   * cache cannot be written, it is skipped.
+   */
+  void open(const std::string &filename, format_type ft,
+            unsigned n_threads = 1, bool use_cache = false);
+  /*!
+   * \brief load a genetic map from an opened map connection
+   * \param source open map connection; all of its rows are consumed
+   *
+   * Any previously loaded map is discarded. Rows within a chromosome
+   * must be sorted by position.
+   */
+  void load(base_input_genetic_map_file *source);
+  /*!
+   * \brief determine whether a chromosome is present in the map
+   * \param chr name of chromosome
+   * \return whether the chromosome is present in the map
+   */
+  bool has_chromosome(const std::string &chr) const;
+  /*!
+   * \brief get the total number of map rows loaded
+   * \return the total number of map rows loaded
+   */
+  size_t size() const;
+  /*!
+   * \brief interpolate genetic position for a batch of positions
+   * \param chr chromosome of all positions in the batch
+   * \param positions array of physical positions
+   * \param n number of positions
+   * \param gpos array of at least n values to receive genetic positions
+   * \param rate array of at least n values to receive rates
+   *
+   * Positions before the first map row of the chromosome, or on a
+   * chromosome absent from the map, are reported with genetic position
+   * and rate 0. Sorted batches are resolved with a forward scan rather
+   * than a search per position.
+   */
+  void interpolate(const std::string &chr, const int64_t *positions, size_t n,
+                   double *gpos, double *rate) const;
+
+ private:
+  /*!
+   * \struct chromosome
+   * \brief map rows of a single chromosome
+   */
+  struct chromosome {
+    std::vector<int64_t> startpos;  //!< start position of each row
+    std::vector<int64_t> endpos;    //!< end position of each row, or -1
+    std::vector<double> gpos;       //!< genetic position at each start
+    std::vector<double> rate;       //!< rate of change from each start
+  };
+  /*!
+   * \brief find the rows of a chromosome
+   * \param chr name of chromosome
+   * \return pointer to the rows, or NULL if absent
+   */
+  const chromosome *find(const std::string &chr) const;
+  /*!
+   * \brief numeric code used to match chromosome names
+   * \param chr name of chromosome
+   * \return code of chromosome, or 0 if not recognized
+   */
+  static int chromosome_code(const std::string &chr);
+  /*!
+   * \brief interpolate a single position against one row
+   * \param rows rows of the chromosome of the position
+   * \param i index of last row starting at or before the position
+   * \param pos physical position
+   * \param gpos pointer to storage for genetic position
+   * \param rate pointer to storage for rate
+   */
+  static void interpolate_row(const chromosome &rows, size_t i, int64_t pos,
+                              double *gpos, double *rate);
+  /*!
+   * \brief compute genetic positions of every loaded row from rates
+   * \param n_threads number of threads to sum blocks of rows on
+   *
+   * Genetic position restarts at 0 on each chromosome.
+   */
+  void accumulate_gpos(unsigned n_threads);
+  /*!
+   * \brief write the loaded table to a cache file
+   * \param filename name of cache file
+   * \param header identity of the map file the table was loaded from
+   * \return whether the cache was written
+   */
+  bool save_cache(const std::string &filename,
+                  const std::vector<int64_t> &header) const;
+  /*!
+   * \brief load the table from a cache file
+   * \param filename name of cache file
+   * \param header identity of the map file the cache must match
+   * \return whether the cache matched and was loaded
+   */
+  bool restore_cache(const std::string &filename,
+                     const std::vector<int64_t> &header);
+  std::map<int, chromosome> _chromosomes;  //!< rows by chromosome code
+  size_t _size;                            //!< total rows loaded
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_COMPILED_GENETIC_MAP_H_
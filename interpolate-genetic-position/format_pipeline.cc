@@ -0,0 +1,74 @@
+/*!
+ \file format_pipeline.cc
+ \brief implementation of format pair reporting pipelines
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/format_pipeline.h"
+
+namespace igp = interpolate_genetic_position;
+
+igp::base_format_pipeline::base_format_pipeline() {}
+igp::base_format_pipeline::~base_format_pipeline() throw() {}
+
+namespace {
+/*!
+ * \brief create a pipeline for a fixed query format and one of
+ * the output formats accepted for variant queries
+ * \tparam input_ft format of query file
+ * \param output_ft format of output file
+ * \param output output file handler
+ * \return newly allocated pipeline, or NULL if output_ft is not supported
+ */
+template <igp::format_type input_ft>
+igp::base_format_pipeline *make_variant_pipeline(
+    igp::format_type output_ft, igp::output_variant_file *output) {
+  if (output_ft == igp::MAP) {
+    return new igp::format_pipeline<input_ft, igp::MAP>(output);
+  } else if (output_ft == igp::SNP) {
+    return new igp::format_pipeline<input_ft, igp::SNP>(output);
+  } else if (output_ft == igp::BIM) {
+    return new igp::format_pipeline<input_ft, igp::BIM>(output);
+  } else if (output_ft == igp::ARROW) {
+    return new igp::format_pipeline<input_ft, igp::ARROW>(output);
+  } else if (output_ft == igp::BIGWIG) {
+    return new igp::format_pipeline<input_ft, igp::BIGWIG>(output);
+  }
+  return NULL;
+}
+}  // namespace
+
+igp::base_format_pipeline *igp::make_format_pipeline(
+    format_type input_ft, format_type output_ft, output_variant_file *output) {
+  // these mirror the combinations permitted by check_io_combinations
+  if (input_ft == BIM) {
+    return make_variant_pipeline<BIM>(output_ft, output);
+  } else if (input_ft == SNP) {
+    return make_variant_pipeline<SNP>(output_ft, output);
+  } else if (input_ft == VCF && output_ft == VCF) {
+    return new format_pipeline<VCF, VCF>(output);
+  } else if (input_ft == VCF && output_ft == BCF) {
+    return new format_pipeline<VCF, BCF>(output);
+  } else if (input_ft == VCF) {
+    return make_variant_pipeline<VCF>(output_ft, output);
+  } else if (input_ft == PVAR && output_ft == PVAR) {
+    return new format_pipeline<PVAR, PVAR>(output);
+  } else if (input_ft == PVAR) {
+    return make_variant_pipeline<PVAR>(output_ft, output);
+  } else if (input_ft == MAP && output_ft == MAP) {
+    return new format_pipeline<MAP, MAP>(output);
+  } else if (input_ft == MAP && output_ft == ARROW) {
+    return new format_pipeline<MAP, ARROW>(output);
+  } else if (input_ft == MAP && output_ft == BIGWIG) {
+    return new format_pipeline<MAP, BIGWIG>(output);
+  } else if (input_ft == BED && output_ft == BOLT) {
+    return new format_pipeline<BED, BOLT>(output);
+  } else if (input_ft == BED && output_ft == ARROW) {
+    return new format_pipeline<BED, ARROW>(output);
+  } else if (input_ft == BED && output_ft == BIGWIG) {
+    return new format_pipeline<BED, BIGWIG>(output);
+  }
+  return NULL;
+}
@@ -0,0 +1,204 @@
+/*!
+ \file format_pipeline.h
+ \brief result reporting specialized at compile time for each
+ supported pair of query and output formats
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_FORMAT_PIPELINE_H_
+#define INTERPOLATE_GENETIC_POSITION_FORMAT_PIPELINE_H_
+
+#include <gmpxx.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "interpolate-genetic-position/genetic_map.h"
+#include "interpolate-genetic-position/output_variant_file.h"
+#include "interpolate-genetic-position/record_batch.h"
+#include "interpolate-genetic-position/utilities.h"
+
+namespace interpolate_genetic_position {
+/*!
+ * \class base_format_pipeline
+ * \brief interface for reporting batches of results, with the
+ * query and output formats selected once before processing begins
+ */
+class base_format_pipeline {
+ public:
+  /*!
+   * \brief default constructor
+   */
+  base_format_pipeline();
+  /*!
+   * \brief destructor
+   */
+  virtual ~base_format_pipeline() throw();
+  /*!
+   * \brief report the interpolated results of every query in a batch,
+   * in order
+   * \param batch batch of queries with results filled in
+   * \param result_set index of the result set of batch to report
+   */
+  virtual void report(const record_batch &batch, unsigned result_set) = 0;
+  /*!
+   * \brief interpolate and report every query in a batch, in order,
+   * writing each segment of a query as soon as it is interpolated
+   * \param batch batch of queries; results are not filled in
+   * \param gm pointer to opened genetic map
+   * \param verbose whether to emit (extremely) verbose logging
+   */
+  virtual void report_sweep(const record_batch &batch, genetic_map *gm,
+                            bool verbose) = 0;
+};
+
+/*!
+ * \class format_pipeline
+ * \brief report results for a single query/output format pair
+ * \tparam input_ft format of query file
+ * \tparam output_ft format of output file
+ *
+ * Equivalent to reporting each query with query_file::report(), but
+ * format decisions are resolved at compile time, and output stream
+ * formatting is applied once per batch rather than once per result.
+ * For vcf/bcf and pvar output, the retained input record of each query
+ * is annotated and written instead.
+ */
+template <format_type input_ft, format_type output_ft>
+class format_pipeline : public base_format_pipeline {
+ public:
+  /*!
+   * \brief constructor
+   * \param output output file handler, already opened with output_ft
+   */
+  explicit format_pipeline(output_variant_file *output)
+      : base_format_pipeline(), _output(output), _previous_bed_label("") {
+    if (!_output) {
+      throw std::runtime_error("format_pipeline: output is NULL");
+    }
+    if (_output->get_format() != output_ft) {
+      throw std::runtime_error(
+          "format_pipeline: output file format does not match pipeline");
+    }
+  }
+  /*!
+   * \brief destructor
+   */
+  ~format_pipeline() throw() {}
+  /*!
+   * \brief report the interpolated results of every query in a batch,
+   * in order
+   * \param batch batch of queries with results filled in
+   * \param result_set index of the result set of batch to report
+   */
+  void report(const record_batch &batch, unsigned result_set) {
+    std::ostream &target = _output->get_stream();
+    output_format_guard guard(target, _output->get_fixed_width());
+    for (unsigned i = 0; i < batch.size(); ++i) {
+      /*
+       * for bed input only, respect column 4 of each query as an indicator
+       * of whether the query should be considered part of a different unit
+       * than the previous query, with respect to fixed value increments.
+       */
+      if constexpr (input_ft == BED) {
+        update_bed_label(batch.get_label(i));
+      }
+      const std::vector<query_result> &results =
+          batch.get_results(i, result_set);
+      // vcf/bcf output annotates the input record, which has one result
+      if constexpr (output_ft == VCF || output_ft == BCF) {
+        _output->write_vcf(batch.get_vcf_record(i),
+                           results.begin()->get_gpos(),
+                           results.begin()->get_rate());
+      } else if constexpr (output_ft == PVAR) {
+        // pvar output rewrites the input line, which has one result
+        _output->write_pvar_record(target, batch.get_line_contents(i),
+                                   results.begin()->get_chr(),
+                                   results.begin()->get_gpos());
+      } else {
+        const std::string &id = batch.get_id(i);
+        const std::string &a1 = batch.get_a1(i);
+        const std::string &a2 = batch.get_a2(i);
+        for (std::vector<query_result>::const_iterator iter = results.begin();
+             iter != results.end(); ++iter) {
+          _output->write_record<output_ft>(
+              target, iter->get_chr(), iter->get_startpos(),
+              iter->get_endpos(), id, iter->get_gpos(), iter->get_rate(), a1,
+              a2);
+        }
+      }
+    }
+  }
+  /*!
+   * \brief interpolate and report every query in a batch, in order,
+   * writing each segment of a query as soon as it is interpolated
+   * \param batch batch of queries; results are not filled in
+   * \param gm pointer to opened genetic map
+   * \param verbose whether to emit (extremely) verbose logging
+   *
+   * Output is identical to filling in the results of the batch with
+   * genetic_map::query() and calling report(), but no query's segments
+   * are stored.
+   */
+  void report_sweep(const record_batch &batch, genetic_map *gm,
+                    bool verbose) {
+    std::ostream &target = _output->get_stream();
+    output_format_guard guard(target, _output->get_fixed_width());
+    for (unsigned i = 0; i < batch.size(); ++i) {
+      if constexpr (input_ft == BED) {
+        update_bed_label(batch.get_label(i));
+      }
+      if constexpr (output_ft == VCF || output_ft == BCF ||
+                    output_ft == PVAR) {
+        throw std::runtime_error(
+            "format_pipeline::report_sweep: output rewriting input records "
+            "cannot be streamed");
+      } else {
+        const std::string &id = batch.get_id(i);
+        const std::string &a1 = batch.get_a1(i);
+        const std::string &a2 = batch.get_a2(i);
+        gm->sweep(batch.get_chr(i), batch.get_pos1(i), batch.get_pos2(i),
+                  verbose, [&](const query_result &result) {
+                    _output->write_record<output_ft>(
+                        target, result.get_chr(), result.get_startpos(),
+                        result.get_endpos(), id, result.get_gpos(),
+                        result.get_rate(), a1, a2);
+                  });
+      }
+    }
+  }
+
+ private:
+  /*!
+   * \brief start a new fixed increment unit if a bed query's label
+   * differs from that of the previous query
+   * \param label label of the current query
+   */
+  void update_bed_label(const std::string &label) {
+    if (_previous_bed_label.compare(label) && !_previous_bed_label.empty()) {
+      _output->set_index_on_chromosome(_output->get_index_on_chromosome() +
+                                       1);
+    }
+    _previous_bed_label = label;
+  }
+  output_variant_file *_output;     //!< output file handler
+  std::string _previous_bed_label;  //!< label of previous bed format query
+};
+
+/*!
+ * \brief create the reporting pipeline for a query/output format pair
+ * \param input_ft format of query file
+ * \param output_ft format of output file
+ * \param output output file handler, already opened with output_ft
+ * \return newly allocated pipeline, owned by the caller, or NULL if
+ * the pair is not one accepted by check_io_combinations()
+ */
+base_format_pipeline *make_format_pipeline(format_type input_ft,
+                                           format_type output_ft,
+                                           output_variant_file *output);
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_FORMAT_PIPELINE_H_
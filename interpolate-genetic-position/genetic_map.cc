@@ -18,7 +18,7 @@ igp::genetic_map::genetic_map(const genetic_map &obj) {
       "genetic_map: copy constructor operation is invalid for this class");
 }
 igp::genetic_map::genetic_map(base_input_genetic_map_file *ptr)
-    : _interface(ptr), _logstrm(&std::cerr) {}
+    : _interface(ptr), _logstrm(&std::cerr), _mb_adjustment(1000000.0) {}
 igp::genetic_map::~genetic_map() throw() { _interface->close(); }
 void igp::genetic_map::open(const std::string &filename, format_type ft) {
   _interface->open(filename, ft);
@@ -27,16 +27,23 @@ void igp::genetic_map::query(const std::string &chr_query,
                              const mpz_class &pos1_query,
                              const mpz_class &pos2_query, bool verbose,
                              std::vector<query_result> *results) {
-  results->clear();
-  query_result result;
   // this was all very straightforward until I considered how to support
   // queries based on bedfiles. regions that cross boundaries in the
   // genetic map file need to return multiple results, each with their
   // own position and rate estimates. what a mess.
+  //
+  // existing entries in the result vector are overwritten in place rather
+  // than cleared and rebuilt, so that their GMP storage is reused across
+  // queries instead of being reallocated for every variant.
+  std::vector<query_result>::size_type n_results = 0;
   mpz_class current_pos1 = pos1_query;
   while (true) {
+    if (results->size() == n_results) {
+      results->push_back(query_result());
+    }
+    query_result &result = results->at(n_results);
+    ++n_results;
     query(chr_query, current_pos1, pos2_query, verbose, &result);
-    results->push_back(result);
     // if the initial query was a point estimate, or if the result reaches
     // the end of the query range, it's done.
     if (cmp(pos2_query, 0) == -1 || cmp(result.get_endpos(), pos2_query) == 0) {
@@ -46,6 +53,68 @@ void igp::genetic_map::query(const std::string &chr_query,
     // in this loop
     current_pos1 = result.get_endpos();
   }
+  results->resize(n_results);
+}
+void igp::genetic_map::sweep(const std::string &chr_query,
+                             const mpz_class &pos1_query,
+                             const mpz_class &pos2_query, bool verbose,
+                             const segment_callback &emit) {
+  query(chr_query, pos1_query, pos2_query, verbose, &_sweep_result);
+  emit(_sweep_result);
+  if (cmp(pos2_query, 0) == -1) {
+    return;
+  }
+  while (cmp(_sweep_result.get_endpos(), pos2_query) != 0) {
+    // verbose logging is only emitted by query(), so the shortcut is
+    // skipped to keep the log identical to unswept queries
+    if (!verbose &&
+        sweep_next_interval(chr_query, pos2_query, &_sweep_result)) {
+      emit(_sweep_result);
+      continue;
+    }
+    // query() reads its start position after overwriting the result
+    _sweep_pos = _sweep_result.get_endpos();
+    query(chr_query, _sweep_pos, pos2_query, verbose, &_sweep_result);
+    emit(_sweep_result);
+  }
+}
+bool igp::genetic_map::sweep_next_interval(const std::string &chr_query,
+                                           const mpz_class &pos2_query,
+                                           query_result *result) {
+  // the previous segment must have stopped exactly at the upper bound
+  // of a sorted window lying entirely on the query chromosome. query()
+  // would respond to that by advancing the window once, and then find
+  // the segment start on its new lower bound.
+  if (_interface->eof() ||
+      cmp(result->get_endpos(), _interface->get_startpos_upper_bound()) ||
+      cmp(_interface->get_startpos_lower_bound(), result->get_endpos()) != -1 ||
+      chromosome_compare(chr_query, _interface->get_chr_lower_bound()) !=
+          EQUAL ||
+      chromosome_compare(chr_query, _interface->get_chr_upper_bound()) !=
+          EQUAL) {
+    return false;
+  }
+  _interface->get();
+  result->set_startpos(result->get_endpos());
+  if (_interface->eof()) {
+    // the final window; query() handles both its interior and the
+    // final row
+    return false;
+  }
+  mpz_class startpos_upper_bound = _interface->get_startpos_upper_bound();
+  if (chromosome_compare(chr_query, _interface->get_chr_upper_bound()) !=
+          EQUAL ||
+      cmp(result->get_startpos(), startpos_upper_bound) != -1) {
+    // a chromosome boundary or sort error; query() handles both
+    return false;
+  }
+  // exact lower boundary rate
+  result->set_gpos(_interface->get_gpos_lower_bound());
+  result->set_endpos(cmp(pos2_query, startpos_upper_bound) < 0
+                         ? pos2_query
+                         : startpos_upper_bound);
+  result->set_rate(_interface->get_rate_lower_bound());
+  return true;
 }
 void igp::genetic_map::query(const std::string &chr_query,
                              const mpz_class &pos1_query,
@@ -60,13 +129,18 @@ void igp::genetic_map::query(const std::string &chr_query,
   // that are encountered in datasets.
   direction query_vs_lower_bound = EQUAL;
   direction query_vs_upper_bound = EQUAL;
-  mpf_class mb_adjustment = 1000000.0;
+  const mpf_class &mb_adjustment = _mb_adjustment;
   if (verbose) {
     get_logstrm() << "query: chr is " << chr_query << ", pos is " << pos1_query
                   << std::endl;
   }
   result->set_chr(chr_query);
   result->set_startpos(pos1_query);
+  // sparse queries can jump over the map rows between them. verbose
+  // logging narrates every step of the walk, so it keeps to the walk
+  if (!verbose) {
+    _interface->skip_to(chr_query, pos1_query);
+  }
   std::string chr_lower_bound = _interface->get_chr_lower_bound();
   std::string chr_upper_bound = _interface->get_chr_upper_bound();
   if (chromosome_compare(chr_lower_bound, chr_upper_bound) == GREATER_THAN) {
@@ -171,41 +245,7 @@ void igp::genetic_map::query(const std::string &chr_query,
       }
     } else if (query_vs_lower_bound == EQUAL &&
                query_vs_upper_bound == LESS_THAN) {
-      // gpos extension beyond end of range
-      mpf_class gpos_interpolated;
-      // certain genetic maps terminate their regions with a non-zero rate
-      // window. for those situations, the extension needs to adjust for the end
-      // position's interpolation from the reported rate of the start position
-      // of the range.
-      mpz_class startpos_lower_bound = _interface->get_startpos_lower_bound();
-      mpz_class endpos_lower_bound = _interface->get_endpos_lower_bound();
-      if (cmp(endpos_lower_bound, 0) == -1) {
-        // there is no end position; the position is fixed
-        gpos_interpolated = _interface->get_gpos_lower_bound();
-        result->set_endpos(pos2_query);
-        result->set_rate(_interface->get_rate_lower_bound());
-      } else {
-        // there is an end position; partial interpolation is required,
-        // though if the reported rate is 0, this will be the same
-        // as the above condition
-        gpos_interpolated =
-            _interface->get_gpos_lower_bound() +
-            ((cmp(pos1_query, endpos_lower_bound) == -1 ? pos1_query
-                                                        : endpos_lower_bound) -
-             startpos_lower_bound) /
-                mb_adjustment * _interface->get_rate_lower_bound();
-        result->set_endpos(cmp(pos1_query, endpos_lower_bound) == -1
-                               ? endpos_lower_bound
-                               : pos2_query);
-        result->set_rate(cmp(pos1_query, endpos_lower_bound) == -1
-                             ? _interface->get_rate_lower_bound()
-                             : 0.0);
-      }
-      if (verbose) {
-        get_logstrm() << "\tchromosome beyond end of range, setting to "
-                      << gpos_interpolated << std::endl;
-      }
-      result->set_gpos(gpos_interpolated);
+      query_chromosome_final_row(pos1_query, pos2_query, verbose, result);
       return;
     } else if (query_vs_upper_bound == LESS_THAN) {
       // no estimate for relevant chromosome; set to 0?
@@ -239,53 +279,54 @@ void igp::genetic_map::query(const std::string &chr_query,
           "of RAM.");
     }
   }
+  // the loop may have advanced the window before stopping, so the
+  // chromosome comparisons are refreshed
+  chr_lower_bound = _interface->get_chr_lower_bound();
+  chr_upper_bound = _interface->get_chr_upper_bound();
+  query_vs_lower_bound = chromosome_compare(chr_query, chr_lower_bound);
   query_vs_upper_bound = chromosome_compare(chr_query, chr_upper_bound);
   if (_interface->eof()) {
-    if (query_vs_upper_bound == EQUAL) {
-      // For variants at the end of the chromosome's rate information,
-      // what is the correct course of action? This current value sets
-      // out-of-range recombination to 0; this may be swapped out for
-      // linear interpolation using the last known good rate of the
-      // chromosome, which might be more biological but violates the
-      // traditional convention of analyses extending beyond a model's
-      // estimation range.
-      mpf_class gpos_interpolated;
+    // once the final row of the map has been read, the window ending at
+    // it is still loaded, and only queries at or beyond the final row
+    // are answered from the final row itself
+    if (query_vs_lower_bound == EQUAL && query_vs_upper_bound != EQUAL) {
+      query_chromosome_final_row(pos1_query, pos2_query, verbose, result);
+      return;
+    } else if (query_vs_upper_bound == EQUAL) {
+      mpz_class startpos_lower_bound = _interface->get_startpos_lower_bound();
       mpz_class startpos_upper_bound = _interface->get_startpos_upper_bound();
-      mpz_class endpos_upper_bound = _interface->get_endpos_upper_bound();
-      // certain genetic maps terminate their regions with a non-zero rate
-      // window. for those situations, the extension needs to adjust for the end
-      // position's interpolation from the reported rate of the start position
-      // of the range.
-      if (cmp(endpos_upper_bound, 0) == -1) {
-        // there is no end position; the position is fixed
-        gpos_interpolated = _interface->get_gpos_upper_bound();
-        result->set_endpos(pos2_query);
-        result->set_rate(_interface->get_rate_upper_bound());
+      if (cmp(pos1_query, startpos_upper_bound) != -1) {
+        query_past_final_interval(pos1_query, pos2_query, verbose, result);
+      } else if (query_vs_lower_bound == EQUAL &&
+                 cmp(pos1_query, startpos_lower_bound) != -1) {
+        // interpolate within the final window
+        result->set_gpos(_interface->get_gpos_lower_bound() +
+                         (pos1_query - startpos_lower_bound) / mb_adjustment *
+                             _interface->get_rate_lower_bound());
+        if (verbose) {
+          get_logstrm() << "\tfinal window, interpolated: "
+                        << result->get_gpos() << std::endl;
+        }
+        result->set_endpos(cmp(pos2_query, startpos_upper_bound) < 0
+                               ? pos2_query
+                               : startpos_upper_bound);
+        result->set_rate(_interface->get_rate_lower_bound());
       } else {
-        // there is an end position; partial interpolation is required,
-        // though if the reported rate is 0, this will be the same
-        // as the above condition
-        gpos_interpolated =
-            _interface->get_gpos_upper_bound() +
-            ((cmp(pos1_query, endpos_upper_bound) == -1 ? pos1_query
-                                                        : endpos_upper_bound) -
-             startpos_upper_bound) /
-                mb_adjustment * _interface->get_rate_upper_bound();
-        result->set_endpos(cmp(pos1_query, endpos_upper_bound) == -1 &&
-                                   cmp(pos2_query, 0) >= 0 &&
-                                   cmp(pos2_query, endpos_upper_bound) != -1
-                               ? endpos_upper_bound
-                               : pos2_query);
-        result->set_rate(cmp(pos1_query, endpos_upper_bound) == -1
-                             ? _interface->get_rate_upper_bound()
-                             : 0.0);
-      }
-      if (verbose) {
-        get_logstrm()
-            << "\tfinal value, beyond boundary of loaded data; setting to "
-            << gpos_interpolated << std::endl;
+        // beginning of the final chromosome
+        const mpz_class &chromosome_start = query_vs_lower_bound == EQUAL
+                                                ? startpos_lower_bound
+                                                : startpos_upper_bound;
+        if (verbose) {
+          get_logstrm() << "\tbeginning of final chromosome, before rate "
+                           "estimates start; setting to 0"
+                        << std::endl;
+        }
+        result->set_gpos(0.0);
+        result->set_endpos(cmp(pos2_query, chromosome_start) < 0
+                               ? pos2_query
+                               : chromosome_start);
+        result->set_rate(0.0);
       }
-      result->set_gpos(gpos_interpolated);
       return;
     } else {
       // We may eventually want to let the user specify that this should
@@ -308,6 +349,114 @@ void igp::genetic_map::query(const std::string &chr_query,
         "handle this for you, at the cost of RAM.");
   }
 }
+void igp::genetic_map::query_chromosome_final_row(const mpz_class &pos1_query,
+                                                  const mpz_class &pos2_query,
+                                                  bool verbose,
+                                                  query_result *result) {
+  const mpf_class &mb_adjustment = _mb_adjustment;
+  mpz_class startpos_lower_bound = _interface->get_startpos_lower_bound();
+  if (cmp(pos1_query, startpos_lower_bound) == -1) {
+    // the final row is also the first row of the chromosome, and the
+    // query comes before it
+    if (verbose) {
+      get_logstrm() << "\tbeginning of chromosome, before rate estimates "
+                       "start; setting to 0"
+                    << std::endl;
+    }
+    result->set_gpos(0.0);
+    result->set_endpos(cmp(pos2_query, startpos_lower_bound) < 0
+                           ? pos2_query
+                           : startpos_lower_bound);
+    result->set_rate(0.0);
+    return;
+  }
+  // gpos extension beyond end of range
+  mpf_class gpos_interpolated;
+  // certain genetic maps terminate their regions with a non-zero rate
+  // window. for those situations, the extension needs to adjust for the end
+  // position's interpolation from the reported rate of the start position
+  // of the range.
+  mpz_class endpos_lower_bound = _interface->get_endpos_lower_bound();
+  if (cmp(endpos_lower_bound, 0) == -1) {
+    // there is no end position; the position is fixed
+    gpos_interpolated = _interface->get_gpos_lower_bound();
+    result->set_endpos(pos2_query);
+    result->set_rate(_interface->get_rate_lower_bound());
+  } else {
+    // there is an end position; partial interpolation is required,
+    // though if the reported rate is 0, this will be the same
+    // as the above condition
+    gpos_interpolated =
+        _interface->get_gpos_lower_bound() +
+        ((cmp(pos1_query, endpos_lower_bound) == -1 ? pos1_query
+                                                    : endpos_lower_bound) -
+         startpos_lower_bound) /
+            mb_adjustment * _interface->get_rate_lower_bound();
+    result->set_endpos(cmp(pos1_query, endpos_lower_bound) == -1 &&
+                               cmp(pos2_query, 0) >= 0 &&
+                               cmp(pos2_query, endpos_lower_bound) != -1
+                           ? endpos_lower_bound
+                           : pos2_query);
+    result->set_rate(cmp(pos1_query, endpos_lower_bound) == -1
+                         ? _interface->get_rate_lower_bound()
+                         : 0.0);
+  }
+  if (verbose) {
+    get_logstrm() << "\tchromosome beyond end of range, setting to "
+                  << gpos_interpolated << std::endl;
+  }
+  result->set_gpos(gpos_interpolated);
+}
+void igp::genetic_map::query_past_final_interval(const mpz_class &pos1_query,
+                                                 const mpz_class &pos2_query,
+                                                 bool verbose,
+                                                 query_result *result) {
+  const mpf_class &mb_adjustment = _mb_adjustment;
+  // For variants at the end of the chromosome's rate information,
+  // what is the correct course of action? This current value sets
+  // out-of-range recombination to 0; this may be swapped out for
+  // linear interpolation using the last known good rate of the
+  // chromosome, which might be more biological but violates the
+  // traditional convention of analyses extending beyond a model's
+  // estimation range.
+  mpf_class gpos_interpolated;
+  mpz_class startpos_upper_bound = _interface->get_startpos_upper_bound();
+  mpz_class endpos_upper_bound = _interface->get_endpos_upper_bound();
+  // certain genetic maps terminate their regions with a non-zero rate
+  // window. for those situations, the extension needs to adjust for the end
+  // position's interpolation from the reported rate of the start position
+  // of the range.
+  if (cmp(endpos_upper_bound, 0) == -1) {
+    // there is no end position; the position is fixed
+    gpos_interpolated = _interface->get_gpos_upper_bound();
+    result->set_endpos(pos2_query);
+    result->set_rate(_interface->get_rate_upper_bound());
+  } else {
+    // there is an end position; partial interpolation is required,
+    // though if the reported rate is 0, this will be the same
+    // as the above condition
+    gpos_interpolated =
+        _interface->get_gpos_upper_bound() +
+        ((cmp(pos1_query, endpos_upper_bound) == -1 ? pos1_query
+                                                    : endpos_upper_bound) -
+         startpos_upper_bound) /
+            mb_adjustment * _interface->get_rate_upper_bound();
+    result->set_endpos(cmp(pos1_query, endpos_upper_bound) == -1 &&
+                               cmp(pos2_query, 0) >= 0 &&
+                               cmp(pos2_query, endpos_upper_bound) != -1
+                           ? endpos_upper_bound
+                           : pos2_query);
+    result->set_rate(cmp(pos1_query, endpos_upper_bound) == -1
+                         ? _interface->get_rate_upper_bound()
+                         : 0.0);
+  }
+  if (verbose) {
+    get_logstrm()
+        << "\tfinal value, beyond boundary of loaded data; setting to "
+        << gpos_interpolated << std::endl;
+  }
+  result->set_gpos(gpos_interpolated);
+}
 
 std::ostream &igp::genetic_map::get_logstrm() const { return *_logstrm; }
 
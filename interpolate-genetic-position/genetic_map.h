@@ -13,6 +13,7 @@
 #include <zlib.h>
 
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -89,6 +90,33 @@ class genetic_map {
    */
   void query(const std::string &chr_query, const mpz_class &pos1_query,
              const mpz_class &pos2_query, bool verbose, query_result *results);
+  /*!
+   * \brief callback receiving each segment of a swept query
+   */
+  typedef std::function<void(const query_result &)> segment_callback;
+  /*!
+   * \brief walk a query region and the genetic map together,
+   * handing each segment of the region to a callback as soon as
+   * it is interpolated
+   * \param chr_query chromosome of query region as string
+   * \param pos1_query physical position of start of region,
+   * represented as mpz
+   * \param pos2_query physical position of end of region, or -1
+   * for a point query
+   * \param verbose whether to emit (extremely) verbose logging to std::cout
+   * \param emit callback receiving each segment in order. the result
+   * passed to it is reused, and is only valid for the duration of the call
+   *
+   * Segments are identical to those returned by the vector form of
+   * query(), but none are retained, so memory use does not grow with
+   * the number of map intervals a region spans. Once a segment ends on
+   * the next map breakpoint of the query chromosome, the following
+   * segment is read directly from the map window instead of being
+   * located again from scratch.
+   */
+  void sweep(const std::string &chr_query, const mpz_class &pos1_query,
+             const mpz_class &pos2_query, bool verbose,
+             const segment_callback &emit);
   /*!
    * \brief close any input connection
    */
@@ -105,8 +133,46 @@ class genetic_map {
   void set_logstrm(std::ostream *ptr);
 
  private:
+  /*!
+   * \brief continue a swept query from the map breakpoint that
+   * ended the previous segment
+   * \param chr_query chromosome of query region as string
+   * \param pos2_query physical position of end of region
+   * \param result pointer to previous segment, updated in place
+   * with the next segment
+   * \return whether the next segment was produced. if not, it must
+   * be found with query(); the map window may have advanced
+   * in preparation for that
+   */
+  bool sweep_next_interval(const std::string &chr_query,
+                           const mpz_class &pos2_query, query_result *result);
+  /*!
+   * \brief report a query against the final row of its own chromosome,
+   * while that row is the lower bound of the window
+   * \param pos1_query physical position of query
+   * \param pos2_query physical position of end of region, or -1
+   * \param verbose whether to emit (extremely) verbose logging
+   * \param result pointer to object that should contain interpolated results
+   */
+  void query_chromosome_final_row(const mpz_class &pos1_query,
+                                  const mpz_class &pos2_query, bool verbose,
+                                  query_result *result);
+  /*!
+   * \brief report a query that falls after the final loaded
+   * interval of its own chromosome, once the map is exhausted
+   * \param pos1_query physical position of query
+   * \param pos2_query physical position of end of region, or -1
+   * \param verbose whether to emit (extremely) verbose logging
+   * \param result pointer to object that should contain interpolated results
+   */
+  void query_past_final_interval(const mpz_class &pos1_query,
+                                 const mpz_class &pos2_query, bool verbose,
+                                 query_result *result);
   base_input_genetic_map_file *_interface;  //!< pointer to interface object
   std::ostream *_logstrm;  //!< pointer to stream for verbose logging
+  mpf_class _mb_adjustment;  //!< conversion from bases to megabases
+  query_result _sweep_result;  //!< reused storage for swept segments
+  mpz_class _sweep_pos;        //!< start of next swept segment
 };
 }  // namespace interpolate_genetic_position
 
@@ -0,0 +1,273 @@
+/*!
+ \file gmp_arena.cc
+ \brief implementation of per-thread GMP arena allocator
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/gmp_arena.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+const std::size_t arena_alignment = 16;
+const std::size_t chunk_size = 1 << 18;
+const std::size_t oversized_allocation = chunk_size / 8;
+const unsigned retained_idle_chunks = 4;
+
+class thread_arena;
+
+/*
+ * A chunk's reference count is the number of live allocations carved out
+ * of it, plus one held by the owning thread for as long as that thread
+ * exists. Whoever drops the count to zero frees the chunk.
+ */
+struct arena_chunk {
+  std::atomic<unsigned long> references;
+  thread_arena *owner;
+  arena_chunk *next;
+  std::size_t offset;
+};
+
+/*
+ * Every allocation handed to GMP is prefixed with a header recording the
+ * chunk it came from, or NULL for allocations passed through to malloc.
+ */
+struct allocation_header {
+  arena_chunk *chunk;
+  std::size_t size;
+};
+
+const std::size_t chunk_header_size =
+    (sizeof(arena_chunk) + arena_alignment - 1) & ~(arena_alignment - 1);
+const std::size_t allocation_header_size =
+    (sizeof(allocation_header) + arena_alignment - 1) & ~(arena_alignment - 1);
+
+std::atomic<bool> arena_installed(false);
+std::atomic<unsigned long long> system_allocations(0);
+std::atomic<unsigned long long> arena_allocations(0);
+std::atomic<long long> chunks_in_use(0);
+
+void *(*previous_gmp_alloc)(size_t) = NULL;
+void *(*previous_gmp_realloc)(void *, size_t, size_t) = NULL;
+void (*previous_gmp_free)(void *, size_t) = NULL;
+
+std::size_t round_up(std::size_t n) {
+  return (n + arena_alignment - 1) & ~(arena_alignment - 1);
+}
+
+char *chunk_data(arena_chunk *chunk) {
+  return reinterpret_cast<char *>(chunk) + chunk_header_size;
+}
+
+allocation_header *header_of(void *ptr) {
+  return reinterpret_cast<allocation_header *>(static_cast<char *>(ptr) -
+                                               allocation_header_size);
+}
+
+void release_chunk(arena_chunk *chunk) {
+  if (chunk->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    std::free(chunk);
+    chunks_in_use.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+class thread_arena {
+ public:
+  thread_arena() : _chunks(NULL), _current(NULL) {}
+  ~thread_arena() throw() {
+    arena_chunk *chunk = _chunks;
+    while (chunk) {
+      arena_chunk *next = chunk->next;
+      release_chunk(chunk);
+      chunk = next;
+    }
+  }
+  void *allocate(std::size_t n) {
+    std::size_t needed = allocation_header_size + round_up(n ? n : 1);
+    if (!_current || _current->offset + needed > chunk_size) {
+      _current = find_chunk(needed);
+    }
+    allocation_header *header = reinterpret_cast<allocation_header *>(
+        chunk_data(_current) + _current->offset);
+    _current->offset += needed;
+    _current->references.fetch_add(1, std::memory_order_relaxed);
+    header->chunk = _current;
+    header->size = n;
+    arena_allocations.fetch_add(1, std::memory_order_relaxed);
+    return reinterpret_cast<char *>(header) + allocation_header_size;
+  }
+  bool try_extend(allocation_header *header, std::size_t n) {
+    // only the most recent allocation in the current chunk can grow in place
+    arena_chunk *chunk = header->chunk;
+    if (chunk != _current || chunk->owner != this) return false;
+    char *end_of_allocation = reinterpret_cast<char *>(header) +
+                              allocation_header_size +
+                              round_up(header->size ? header->size : 1);
+    if (end_of_allocation != chunk_data(chunk) + chunk->offset) return false;
+    std::size_t new_offset =
+        static_cast<std::size_t>(reinterpret_cast<char *>(header) -
+                                 chunk_data(chunk)) +
+        allocation_header_size + round_up(n);
+    if (new_offset > chunk_size) return false;
+    chunk->offset = new_offset;
+    header->size = n;
+    return true;
+  }
+  void reset() {
+    arena_chunk **link = &_chunks;
+    unsigned idle = 0;
+    while (*link) {
+      arena_chunk *chunk = *link;
+      if (chunk->references.load(std::memory_order_acquire) == 1) {
+        if (idle >= retained_idle_chunks) {
+          *link = chunk->next;
+          release_chunk(chunk);
+          continue;
+        }
+        chunk->offset = 0;
+        ++idle;
+      }
+      link = &chunk->next;
+    }
+    _current = NULL;
+  }
+
+ private:
+  arena_chunk *find_chunk(std::size_t needed) {
+    for (arena_chunk *chunk = _chunks; chunk; chunk = chunk->next) {
+      if (chunk->references.load(std::memory_order_acquire) == 1) {
+        chunk->offset = 0;
+      }
+      if (chunk->offset + needed <= chunk_size) {
+        return chunk;
+      }
+    }
+    void *raw = std::malloc(chunk_header_size + chunk_size);
+    if (!raw) {
+      throw std::bad_alloc();
+    }
+    system_allocations.fetch_add(1, std::memory_order_relaxed);
+    chunks_in_use.fetch_add(1, std::memory_order_relaxed);
+    arena_chunk *chunk = new (raw) arena_chunk;
+    chunk->references.store(1, std::memory_order_relaxed);
+    chunk->owner = this;
+    chunk->offset = 0;
+    chunk->next = _chunks;
+    _chunks = chunk;
+    return chunk;
+  }
+  arena_chunk *_chunks;
+  arena_chunk *_current;
+};
+
+thread_local thread_arena local_arena;
+
+void *passthrough_allocate(std::size_t n) {
+  allocation_header *header = static_cast<allocation_header *>(
+      std::malloc(allocation_header_size + n));
+  if (!header) {
+    throw std::bad_alloc();
+  }
+  system_allocations.fetch_add(1, std::memory_order_relaxed);
+  header->chunk = NULL;
+  header->size = n;
+  return reinterpret_cast<char *>(header) + allocation_header_size;
+}
+
+void *arena_gmp_alloc(size_t n) {
+  if (n > oversized_allocation) {
+    return passthrough_allocate(n);
+  }
+  return local_arena.allocate(n);
+}
+
+void arena_gmp_free(void *ptr, size_t) {
+  if (!ptr) return;
+  allocation_header *header = header_of(ptr);
+  if (header->chunk) {
+    release_chunk(header->chunk);
+  } else {
+    std::free(header);
+  }
+}
+
+void *arena_gmp_realloc(void *ptr, size_t, size_t new_size) {
+  if (!ptr) {
+    return arena_gmp_alloc(new_size);
+  }
+  allocation_header *header = header_of(ptr);
+  if (!header->chunk) {
+    allocation_header *resized = static_cast<allocation_header *>(
+        std::realloc(header, allocation_header_size + new_size));
+    if (!resized) {
+      throw std::bad_alloc();
+    }
+    system_allocations.fetch_add(1, std::memory_order_relaxed);
+    resized->size = new_size;
+    return reinterpret_cast<char *>(resized) + allocation_header_size;
+  }
+  if (new_size <= header->size) {
+    return ptr;
+  }
+  if (new_size <= oversized_allocation &&
+      local_arena.try_extend(header, new_size)) {
+    return ptr;
+  }
+  void *moved = arena_gmp_alloc(new_size);
+  std::memcpy(moved, ptr, header->size);
+  arena_gmp_free(ptr, header->size);
+  return moved;
+}
+}  // namespace
+
+void igp::gmp_arena::install() {
+  if (installed()) return;
+  mp_get_memory_functions(&previous_gmp_alloc, &previous_gmp_realloc,
+                          &previous_gmp_free);
+  mp_set_memory_functions(arena_gmp_alloc, arena_gmp_realloc, arena_gmp_free);
+  arena_installed.store(true);
+}
+
+void igp::gmp_arena::uninstall() {
+  if (!installed()) return;
+  mp_set_memory_functions(previous_gmp_alloc, previous_gmp_realloc,
+                          previous_gmp_free);
+  arena_installed.store(false);
+  local_arena.reset();
+}
+
+bool igp::gmp_arena::installed() {
+  return arena_installed.load(std::memory_order_relaxed);
+}
+
+void igp::gmp_arena::reset() {
+  if (installed()) {
+    local_arena.reset();
+  }
+}
+
+unsigned long long igp::gmp_arena::get_system_allocations() {
+  return system_allocations.load();
+}
+
+unsigned long long igp::gmp_arena::get_arena_allocations() {
+  return arena_allocations.load();
+}
+
+unsigned long long igp::gmp_arena::get_chunks_in_use() {
+  long long chunks = chunks_in_use.load();
+  return chunks > 0 ? static_cast<unsigned long long>(chunks) : 0;
+}
+
+void igp::gmp_arena::report(std::ostream &out) {
+  out << "gmp arena: " << get_arena_allocations()
+      << " allocations served from chunks, " << get_system_allocations()
+      << " system allocations, " << get_chunks_in_use() << " chunks of "
+      << chunk_size << " bytes in use" << std::endl;
+}
@@ -0,0 +1,87 @@
+/*!
+ \file gmp_arena.h
+ \brief per-thread bump allocator backing GMP's memory functions
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_GMP_ARENA_H_
+#define INTERPOLATE_GENETIC_POSITION_GMP_ARENA_H_
+
+#include <gmp.h>
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+
+namespace interpolate_genetic_position {
+/*!
+ * \class gmp_arena
+ * \brief replace GMP's malloc/realloc/free with per-thread bump
+ * allocation out of large chunks.
+ *
+ * Every mpz_class/mpf_class temporary otherwise costs at least one
+ * malloc/free pair. With the arena installed, small GMP allocations are
+ * carved out of a chunk owned by the allocating thread, and frees only
+ * decrement the owning chunk's count of live allocations. Calling reset()
+ * once per batch of queries rewinds every chunk of the calling thread
+ * that no longer holds live allocations, so steady-state interpolation
+ * does not touch the system allocator at all.
+ *
+ * Chunks that still hold live allocations (for example, values cached
+ * across queries by the genetic map reader) are never rewound, and
+ * values may be freed from a thread other than the one that allocated
+ * them, so there is no lifetime restriction on GMP objects.
+ *
+ * \warning install() must be called before any GMP object exists, and
+ * uninstall() only after every GMP object created while installed has
+ * been destroyed.
+ */
+class gmp_arena {
+ public:
+  /*!
+   * \brief register the arena with mp_set_memory_functions
+   */
+  static void install();
+  /*!
+   * \brief restore the memory functions that were active before install()
+   */
+  static void uninstall();
+  /*!
+   * \brief determine whether the arena is backing GMP allocations
+   * \return whether the arena is backing GMP allocations
+   */
+  static bool installed();
+  /*!
+   * \brief rewind idle chunks owned by the calling thread, and release
+   * idle chunks beyond a small retained pool
+   *
+   * This is a no-op if the arena is not installed.
+   */
+  static void reset();
+  /*!
+   * \brief get the number of requests passed to the system allocator
+   * \return number of chunk and oversized allocations made with malloc
+   */
+  static unsigned long long get_system_allocations();
+  /*!
+   * \brief get the number of GMP allocations served from chunks
+   * \return number of GMP allocations served from chunks
+   */
+  static unsigned long long get_arena_allocations();
+  /*!
+   * \brief get the number of chunks currently held by all threads
+   * \return number of chunks currently held by all threads
+   */
+  static unsigned long long get_chunks_in_use();
+  /*!
+   * \brief emit a brief summary of arena activity
+   * \param out stream to which to write the summary
+   */
+  static void report(std::ostream &out);
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_GMP_ARENA_H_
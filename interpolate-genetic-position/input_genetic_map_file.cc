@@ -8,8 +8,43 @@
 
 #include "interpolate-genetic-position/input_genetic_map_file.h"
 
+#include <utility>
+
 namespace igp = interpolate_genetic_position;
 
+namespace {
+/*!
+ * \brief parse a base 10 integer token, as operator>> would
+ * \param token text of value
+ * \param value pointer to storage for parsed value
+ * \param scratch reused storage for a NUL-terminated copy of token
+ * \return whether the token was a valid integer
+ */
+bool parse_integer(std::string_view token, mpz_class *value,
+                   std::string *scratch) {
+  if (!token.empty() && token.front() == '+') {
+    token.remove_prefix(1);
+  }
+  scratch->assign(token);
+  return !mpz_set_str(value->get_mpz_t(), scratch->c_str(), 10);
+}
+/*!
+ * \brief parse a base 10 floating point token, as operator>> would
+ * \param token text of value
+ * \param value pointer to storage for parsed value
+ * \param scratch reused storage for a NUL-terminated copy of token
+ * \return whether the token was a valid floating point value
+ */
+bool parse_float(std::string_view token, mpf_class *value,
+                 std::string *scratch) {
+  if (!token.empty() && token.front() == '+') {
+    token.remove_prefix(1);
+  }
+  scratch->assign(token);
+  return !mpf_set_str(value->get_mpf_t(), scratch->c_str(), 10);
+}
+}  // namespace
+
 igp::base_input_genetic_map_file::base_input_genetic_map_file() {}
 igp::base_input_genetic_map_file::~base_input_genetic_map_file() throw() {}
 
@@ -18,6 +53,7 @@ igp::input_genetic_map_file::input_genetic_map_file() {
   _buffer = 0;
   _buffer_size = 1000;
   _ft = UNKNOWN;
+  _accumulate_gpos = true;
   _chr_lower_bound = "";
   _startpos_lower_bound = 0;
   _endpos_lower_bound = -1;
@@ -28,6 +64,14 @@ igp::input_genetic_map_file::input_genetic_map_file() {
   _endpos_upper_bound = -1;
   _gpos_upper_bound = 0.0;
   _rate_upper_bound = 0.0;
+  _queued_rows = 0;
+  _use_index = false;
+  _locator_lower_bound = 0;
+  _locator_upper_bound = 0;
+  _rows_read = 0;
+  _line_offset = 0;
+  _building_index = false;
+  _threads = 1;
 
   _buffer = new char[_buffer_size];
 }
@@ -35,27 +79,52 @@ igp::input_genetic_map_file::~input_genetic_map_file() throw() { close(); }
 void igp::input_genetic_map_file::open(const std::string &filename,
                                        format_type ft) {
   _ft = ft;
+  _line_offset = 0;
   // function must chomp the expected header line of bolt format files
   if (filename.rfind(".gz") == filename.size() - 3) {
-    _gzinput = gzopen(filename.c_str(), "rb");
-    if (!_gzinput) {
-      throw std::runtime_error("input_genetic_map_file: cannot read file \"" +
-                               filename + "\"");
-    }
-    if (_ft == BOLT) {
-      gzgets(_gzinput, _buffer, _buffer_size);
+    // indexed gzip maps are read such that decompression can restart
+    // partway through; anything else goes through gzread
+    _seekable_gzinput.set_record_access_points(_building_index);
+    _seekable_gzinput.set_threads(_threads);
+    if ((_use_index || _building_index) && _seekable_gzinput.open(filename)) {
+      // access points must be in place before the read-ahead thread
+      // starts pulling text
+      if (_use_index) {
+        load_index(filename);
+      }
+      std::string_view line;
+      if (_ft == BOLT && get_readahead()->getline(&line)) {
+        _line_offset = line.size() + 1;
+      }
+    } else {
+      _gzinput = gzopen(filename.c_str(), "rb");
+      if (!_gzinput) {
+        throw std::runtime_error(
+            "input_genetic_map_file: cannot read file \"" + filename + "\"");
+      }
+      if (_ft == BOLT) {
+        gzgets(_gzinput, _buffer, _buffer_size);
+      }
     }
   } else if (ft == BIGWIG) {
     _bwinput.open(filename);
   } else if (!filename.empty()) {
-    std::string line = "";
-    _input.open(filename.c_str());
-    if (!_input.is_open()) {
-      throw std::runtime_error("input_genetic_map_file: cannot read file \"" +
-                               filename + "\"");
-    }
-    if (_ft == BOLT) {
-      getline(_input, line);
+    // regular files are parsed in place; anything else is streamed
+    if (_mapped_input.open(filename)) {
+      std::string_view line;
+      if (_ft == BOLT) {
+        _mapped_input.getline(&line);
+      }
+    } else {
+      std::string line = "";
+      _input.open(filename.c_str());
+      if (!_input.is_open()) {
+        throw std::runtime_error(
+            "input_genetic_map_file: cannot read file \"" + filename + "\"");
+      }
+      if (_ft == BOLT) {
+        getline(_input, line);
+      }
     }
   } else {  // file is streamed from cin
     if (_ft == BOLT) {
@@ -65,8 +134,13 @@ void igp::input_genetic_map_file::open(const std::string &filename,
   }
   // Load the first two values, such that a valid range is available at the
   // beginning of iteration.
-  get();
-  get();
+  _queued_rows = 0;
+  _rows_read = 0;
+  if (get()) ++_queued_rows;
+  if (get()) ++_queued_rows;
+  if (_use_index && (_mapped_input.is_open() || _bwinput.is_open())) {
+    load_index(filename);
+  }
 }
 void igp::input_genetic_map_file::set_fallback_stream(std::istream *ptr) {
   _fallback = ptr;
@@ -79,27 +153,167 @@ std::istream *igp::input_genetic_map_file::get_fallback_stream() const {
   return _fallback;
 }
 bool igp::input_genetic_map_file::get() {
-  _chr_lower_bound = _chr_upper_bound;
-  _startpos_lower_bound = _startpos_upper_bound;
-  _endpos_lower_bound = _endpos_upper_bound;
-  _gpos_lower_bound = _gpos_upper_bound;
-  _rate_lower_bound = _rate_upper_bound;
-  std::string line = "", pos1 = "", gpos = "", rate = "";
-  if (_input.is_open()) {
-    if (_input.peek() == EOF) {
+  // the upper bound becomes the lower bound. swapping moves the values
+  // without copying; the stale lower bound values left in the upper
+  // bound slots are overwritten by the read below, or restored from
+  // the lower bound if there is nothing left to read.
+  _chr_lower_bound.swap(_chr_upper_bound);
+  _startpos_lower_bound.swap(_startpos_upper_bound);
+  _endpos_lower_bound.swap(_endpos_upper_bound);
+  _gpos_lower_bound.swap(_gpos_upper_bound);
+  _rate_lower_bound.swap(_rate_upper_bound);
+  std::swap(_locator_lower_bound, _locator_upper_bound);
+  if (!read_upper_bound()) {
+    _chr_upper_bound = _chr_lower_bound;
+    _startpos_upper_bound = _startpos_lower_bound;
+    _endpos_upper_bound = _endpos_lower_bound;
+    _gpos_upper_bound = _gpos_lower_bound;
+    _rate_upper_bound = _rate_lower_bound;
+    _locator_upper_bound = _locator_lower_bound;
+    return false;
+  }
+  ++_rows_read;
+  return true;
+}
+bool igp::input_genetic_map_file::get_block(map_block *block,
+                                            unsigned max_rows) {
+  block->clear();
+  while (_queued_rows && block->size() < max_rows) {
+    if (!block->empty() && block->get_chr().compare(_chr_lower_bound)) {
+      break;
+    }
+    block->append(_chr_lower_bound, _startpos_lower_bound, _endpos_lower_bound,
+                  _gpos_lower_bound, _rate_lower_bound);
+    // the emitted row leaves the window; a new one enters unless the
+    // input is exhausted
+    if (!get()) {
+      --_queued_rows;
+    }
+  }
+  return !block->empty();
+}
+bool igp::input_genetic_map_file::skip_to(const std::string &chr,
+                                          const mpz_class &pos) {
+  if (_index.empty()) {
+    return false;
+  }
+  const map_index::checkpoint *target = _index.find(chr, pos);
+  // only rows past the upper bound are worth jumping to
+  if (!target || target->row < _rows_read) {
+    return false;
+  }
+  if (_mapped_input.is_open()) {
+    _mapped_input.seek(target->locator);
+  } else if (_seekable_gzinput.is_open()) {
+    // short jumps are decompressed through, keeping the text already
+    // read ahead; longer ones restart the read-ahead layer from the
+    // nearest access point
+    uint64_t distance = target->locator - _line_offset;
+    if (distance >= index_gzip_skip_limit) {
+      _readahead.reset();
+      _seekable_gzinput.seek(target->locator);
+    } else if (!get_readahead()->skip(static_cast<size_t>(distance))) {
+      throw std::runtime_error(
+          "input_genetic_map_file::skip_to: genetic map does not match its "
+          "index");
+    }
+    _line_offset = target->locator;
+  } else if (!_bwinput.seek(chr, static_cast<unsigned>(target->locator))) {
+    throw std::runtime_error(
+        "input_genetic_map_file::skip_to: cannot load chromosome \"" + chr +
+        "\" from bigwig");
+  }
+  // the checkpoint row becomes the lower bound, as if reached by get()
+  if (!read_upper_bound() || cmp(_startpos_upper_bound, target->startpos) ||
+      chromosome_compare(chr, _chr_upper_bound) != EQUAL) {
+    throw std::runtime_error(
+        "input_genetic_map_file::skip_to: genetic map does not match its "
+        "index");
+  }
+  _rows_read = target->row + 1;
+  if ((_ft == BEDGRAPH || _ft == BIGWIG) && _accumulate_gpos) {
+    _gpos_upper_bound = target->gpos;
+  }
+  if (!get()) {
+    throw std::runtime_error(
+        "input_genetic_map_file::skip_to: genetic map does not match its "
+        "index");
+  }
+  _queued_rows = 2;
+  return true;
+}
+void igp::input_genetic_map_file::load_index(const std::string &filename) {
+  _index.clear();
+  std::vector<int64_t> header =
+      map_index::identify(filename, _ft, index_rows_per_checkpoint);
+  std::string index_filename = map_index::sidecar_filename(filename);
+  if (!header.empty() && !_index.restore(index_filename, header)) {
+    if (build_index(filename)) {
+      _index.save(index_filename, header);
+    } else {
+      _index.clear();
+    }
+  }
+  if (_seekable_gzinput.is_open()) {
+    _seekable_gzinput.set_access_points(_index.get_access_points());
+  }
+}
+bool igp::input_genetic_map_file::build_index(const std::string &filename) {
+  // rows are read through a second connection, exactly as this one would
+  // read them, so that stored genetic positions match to the last bit
+  input_genetic_map_file source;
+  source.set_accumulate_gpos(true);
+  // gzip access points are recorded on the same pass
+  source._building_index = true;
+  source.open(filename, _ft);
+  if (source._rows_read < 2) {
+    return true;
+  }
+  // the lower bound row is only recorded while it has a successor, so
+  // that a jump always lands on a complete range
+  uint64_t row = 0, rows_on_chromosome = 0;
+  std::string previous_chr = "";
+  do {
+    direction chr_order = chromosome_compare(source._chr_lower_bound,
+                                             source._chr_upper_bound);
+    if (chr_order == GREATER_THAN ||
+        (chr_order == EQUAL && cmp(source._startpos_lower_bound,
+                                   source._startpos_upper_bound) != -1)) {
+      return false;
+    }
+    if (!row || chromosome_compare(source._chr_lower_bound, previous_chr) !=
+                    EQUAL) {
+      rows_on_chromosome = 0;
+      previous_chr = source._chr_lower_bound;
+    }
+    if (rows_on_chromosome % index_rows_per_checkpoint == 0) {
+      _index.add(source._chr_lower_bound, source._startpos_lower_bound, row,
+                 source._locator_lower_bound, source._gpos_lower_bound);
+    }
+    ++row;
+    ++rows_on_chromosome;
+  } while (source.get());
+  _index.set_access_points(source._seekable_gzinput.get_access_points());
+  return true;
+}
+bool igp::input_genetic_map_file::read_upper_bound() {
+  std::string_view line;
+  if (_mapped_input.is_open()) {
+    _locator_upper_bound = _mapped_input.tell();
+    if (!_mapped_input.getline(&line)) {
       return false;
     }
-    getline(_input, line);
   } else if (_bwinput.is_open()) {
     mpz_class pos2;
     if (!_bwinput.get(&_chr_upper_bound, &_startpos_upper_bound,
                       &_endpos_upper_bound, &_rate_upper_bound)) {
       return false;
     }
+    _locator_upper_bound = _bwinput.tell() - 1;
     _startpos_upper_bound = _startpos_upper_bound + 1;
     _endpos_upper_bound = _endpos_upper_bound + 1;
     // as with bedgraph below, requires interpolation
-    if (_chr_upper_bound == _chr_lower_bound) {
+    if (_accumulate_gpos && _chr_upper_bound == _chr_lower_bound) {
       _gpos_upper_bound = _gpos_lower_bound +
                           _rate_lower_bound *
                               (_startpos_upper_bound - _startpos_lower_bound) /
@@ -110,42 +324,44 @@ bool igp::input_genetic_map_file::get() {
     // return immediately here, as string parsing is handled automatically
     // upstream
     return true;
-  } else if (_gzinput != NULL) {
-    if (gzgets(_gzinput, _buffer, _buffer_size) == Z_NULL) {
-      return false;
-    }
-    line = std::string(_buffer);
   } else {
-    if (get_fallback_stream()->peek() == EOF) {
+    // unmappable files, gzip streams and stdin
+    _locator_upper_bound = _line_offset;
+    if (!get_readahead()->getline(&line)) {
       return false;
     }
-    getline(*get_fallback_stream(), line);
+    _line_offset += line.size() + 1;
   }
-  std::istringstream strm1(line);
   if (_ft == BOLT) {
     // BOLT format includes a first column chromosome indicator,
     // without a "chr" prefix independent of genome build.
     // It includes 1-22 and X encoded as 23.
-    if (!(strm1 >> _chr_upper_bound >> _startpos_upper_bound >>
-          _rate_upper_bound >> _gpos_upper_bound)) {
+    if (!tokenize_line(line) ||
+        !parse_integer(_tokens[1], &_startpos_upper_bound, &_scratch) ||
+        !parse_float(_tokens[2], &_rate_upper_bound, &_scratch) ||
+        !parse_float(_tokens[3], &_gpos_upper_bound, &_scratch)) {
       throw std::runtime_error(
           "input_genetic_map_file::get: cannot parse BOLT ratefile line \"" +
-          line + "\"");
+          std::string(line) + "\"");
     }
+    _chr_upper_bound.assign(_tokens[0]);
   } else if (_ft == BEDGRAPH) {
     // bedgraph tracks from UCSC include rate but not genetic position itself.
     // Assuming the first position in a rate file is 0 genetic position, as is
     // conventional, we need to track the accumulated genetic position each
     // time we get a new entry from the file.
-    if (!(strm1 >> _chr_upper_bound >> _startpos_upper_bound >>
-          _endpos_upper_bound >> _rate_upper_bound)) {
+    if (!tokenize_line(line) ||
+        !parse_integer(_tokens[1], &_startpos_upper_bound, &_scratch) ||
+        !parse_integer(_tokens[2], &_endpos_upper_bound, &_scratch) ||
+        !parse_float(_tokens[3], &_rate_upper_bound, &_scratch)) {
       throw std::runtime_error(
-          "input_genetic_map_file::get: cannot parse bedgraph line \"" + line +
-          "\"");
+          "input_genetic_map_file::get: cannot parse bedgraph line \"" +
+          std::string(line) + "\"");
     }
+    _chr_upper_bound.assign(_tokens[0]);
     _startpos_upper_bound = _startpos_upper_bound + 1;
     _endpos_upper_bound = _endpos_upper_bound + 1;
-    if (_chr_upper_bound == _chr_lower_bound) {
+    if (_accumulate_gpos && _chr_upper_bound == _chr_lower_bound) {
       _gpos_upper_bound = _gpos_lower_bound +
                           _rate_lower_bound *
                               (_startpos_upper_bound - _startpos_lower_bound) /
@@ -162,10 +378,45 @@ bool igp::input_genetic_map_file::get() {
   }
   return true;
 }
+igp::readahead_line_reader *igp::input_genetic_map_file::get_readahead() {
+  if (!_readahead) {
+    if (_input.is_open()) {
+      _readahead.reset(new readahead_line_reader(&_input));
+    } else if (_gzinput) {
+      _readahead.reset(new readahead_line_reader(_gzinput));
+    } else if (_seekable_gzinput.is_open()) {
+      _readahead.reset(new readahead_line_reader(&_seekable_gzinput));
+    } else {
+      _readahead.reset(new readahead_line_reader(get_fallback_stream()));
+    }
+  }
+  return _readahead.get();
+}
+bool igp::input_genetic_map_file::tokenize_line(std::string_view line) {
+  const char *whitespace = " \t\n\v\f\r";
+  std::string_view::size_type start = 0, end = 0;
+  for (unsigned i = 0; i < n_map_tokens; ++i) {
+    start = line.find_first_not_of(whitespace, end);
+    if (start == std::string_view::npos) {
+      return false;
+    }
+    end = line.find_first_of(whitespace, start);
+    if (end == std::string_view::npos) {
+      end = line.size();
+    }
+    _tokens[i] = line.substr(start, end - start);
+  }
+  return true;
+}
 void igp::input_genetic_map_file::close() {
+  // the read-ahead thread must stop before its source is closed
+  _readahead.reset();
   if (_input.is_open()) {
     _input.close();
   }
+  _mapped_input.close();
+  _seekable_gzinput.close();
+  _index.clear();
   if (_gzinput) {
     gzclose(_gzinput);
     _gzinput = 0;
@@ -176,16 +427,13 @@ void igp::input_genetic_map_file::close() {
   }
 }
 bool igp::input_genetic_map_file::eof() {
-  if (_input.is_open()) {
-    return _input.peek() == EOF;
-  }
-  if (_gzinput) {
-    return gzeof(_gzinput);
+  if (_mapped_input.is_open()) {
+    return _mapped_input.eof();
   }
   if (_bwinput.is_open()) {
     return _bwinput.eof();
   }
-  return get_fallback_stream()->peek() == EOF;
+  return get_readahead()->eof();
 }
 std::string igp::input_genetic_map_file::get_chr_lower_bound() const {
   return _chr_lower_bound;
@@ -217,3 +465,17 @@ mpf_class igp::input_genetic_map_file::get_rate_lower_bound() const {
 mpf_class igp::input_genetic_map_file::get_rate_upper_bound() const {
   return _rate_upper_bound;
 }
+void igp::input_genetic_map_file::set_accumulate_gpos(bool accumulate) {
+  _accumulate_gpos = accumulate;
+}
+bool igp::input_genetic_map_file::get_accumulate_gpos() const {
+  return _accumulate_gpos;
+}
+void igp::input_genetic_map_file::set_use_index(bool use_index) {
+  _use_index = use_index;
+}
+bool igp::input_genetic_map_file::get_use_index() const { return _use_index; }
+void igp::input_genetic_map_file::set_threads(unsigned n_threads) {
+  _threads = n_threads;
+}
+unsigned igp::input_genetic_map_file::get_threads() const { return _threads; }
@@ -12,14 +12,22 @@
 #include <gmpxx.h>
 #include <zlib.h>
 
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "interpolate-genetic-position/bigwig_reader.h"
+#include "interpolate-genetic-position/map_block.h"
+#include "interpolate-genetic-position/map_index.h"
+#include "interpolate-genetic-position/mapped_line_reader.h"
+#include "interpolate-genetic-position/readahead_line_reader.h"
+#include "interpolate-genetic-position/seekable_gzip_reader.h"
 #include "interpolate-genetic-position/utilities.h"
 
 namespace interpolate_genetic_position {
@@ -127,6 +135,33 @@ class base_input_genetic_map_file {
    * cached range
    */
   virtual mpf_class get_rate_upper_bound() const = 0;
+  /*!
+   * \brief load the next run of map rows from a single chromosome
+   * \param block pointer to block to fill; existing contents are replaced
+   * \param max_rows maximum number of rows to load
+   * \return whether any rows were loaded. FALSE should indicate EOF.
+   *
+   * Starting from the lower bound row loaded by open(), each row of
+   * the map is delivered exactly once, in file order. A block ends
+   * early at a change of chromosome. This is an alternative to the
+   * get()/bound accessor cursor, and the two should not be mixed on
+   * one connection.
+   */
+  virtual bool get_block(map_block *block, unsigned max_rows) = 0;
+  /*!
+   * \brief advance the cursor toward a query without reading the map
+   * rows in between
+   * \param chr chromosome of the next query
+   * \param pos physical position of the next query
+   * \return whether the cursor moved
+   *
+   * The cursor only ever lands on a range that repeated calls to get()
+   * would have passed through before answering the query, so queries
+   * are answered identically either way. Sources that cannot jump ahead
+   * leave the cursor in place. Rows jumped over are not checked for
+   * sort order.
+   */
+  virtual bool skip_to(const std::string &chr, const mpz_class &pos) = 0;
 };
 
 /*!
@@ -231,15 +266,133 @@ class input_genetic_map_file : public base_input_genetic_map_file {
    * cached range
    */
   mpf_class get_rate_upper_bound() const;
+  /*!
+   * \brief load the next run of map rows from a single chromosome
+   * \param block pointer to block to fill; existing contents are replaced
+   * \param max_rows maximum number of rows to load
+   * \return whether any rows were loaded. FALSE should indicate EOF.
+   *
+   * Works identically for all supported map formats, as rows pass
+   * through the same parsing and genetic position accumulation as get().
+   */
+  bool get_block(map_block *block, unsigned max_rows);
+  /*!
+   * \brief advance the cursor toward a query without reading the map
+   * rows in between
+   * \param chr chromosome of the next query
+   * \param pos physical position of the next query
+   * \return whether the cursor moved
+   *
+   * Only possible with a map index; see set_use_index().
+   */
+  bool skip_to(const std::string &chr, const mpz_class &pos);
+  /*!
+   * \brief set whether a sidecar index is used to skip ahead in the map
+   * \param use_index whether to load, or else build, an index of the map
+   *
+   * Applies to text maps that are regular files, whether uncompressed
+   * or gzipped, and to bigwig maps. For gzipped maps, the index also
+   * records where decompression can restart partway through the file.
+   * The index is named after the map file with the suffix ".igpindex",
+   * and is only used if it was built from a map of the same format,
+   * size and modification time, at the same floating point precision,
+   * on a machine of the same byte order. Otherwise it is built by
+   * reading the map through once, and replaced; if it cannot be written,
+   * it is kept for this connection only. Maps that are not
+   * sorted are never indexed. Set before open().
+   */
+  void set_use_index(bool use_index);
+  /*!
+   * \brief get whether a sidecar index is used to skip ahead in the map
+   * \return whether a sidecar index is used
+   */
+  bool get_use_index() const;
+  /*!
+   * \brief set the number of threads decompressing an indexed gzip map
+   * \param n_threads number of threads; above 1, stretches of the map
+   * between index access points are decompressed ahead on worker threads
+   *
+   * Set before open().
+   */
+  void set_threads(unsigned n_threads);
+  /*!
+   * \brief get the number of threads decompressing an indexed gzip map
+   * \return number of threads
+   */
+  unsigned get_threads() const;
+  /*!
+   * \brief set whether rate-only formats accumulate genetic position
+   * \param accumulate whether genetic position is accumulated; if not,
+   * bedgraph and bigwig rows report genetic position 0
+   *
+   * Callers that compute genetic position from the rates themselves
+   * can skip the serial accumulation. Set before open().
+   */
+  void set_accumulate_gpos(bool accumulate);
+  /*!
+   * \brief get whether rate-only formats accumulate genetic position
+   * \return whether genetic position is accumulated
+   */
+  bool get_accumulate_gpos() const;
 
  private:
+  /*!
+   * \brief read the next map entry into the upper bound fields
+   * \return whether an entry was read
+   *
+   * Rate-only formats accumulate genetic position from the lower
+   * bound fields, which must already hold the previous entry.
+   */
+  bool read_upper_bound();
+  /*!
+   * \brief get the read-ahead layer for streamed input, starting it on
+   * first use
+   * \return read-ahead layer over the open stream, gzip stream, or
+   * fallback stream
+   *
+   * Starting lazily lets open() consume the header line directly.
+   */
+  readahead_line_reader *get_readahead();
+  /*!
+   * \brief split the leading columns of a map line on whitespace
+   * \param line line to split
+   * \return whether the line had enough columns
+   *
+   * Columns are stored as views into line; any beyond those used by
+   * the map formats are ignored.
+   */
+  bool tokenize_line(std::string_view line);
+  /*!
+   * \brief load the index of the open map, building it if needed
+   * \param filename name of map file
+   */
+  void load_index(const std::string &filename);
+  /*!
+   * \brief record checkpoints of a map by reading it through
+   * \param filename name of map file
+   * \return whether the map was sorted, and so could be indexed
+   */
+  bool build_index(const std::string &filename);
+  static const unsigned n_map_tokens = 4;  //!< columns used by map formats
+  static const unsigned index_rows_per_checkpoint =
+      1024;  //!< rows between index checkpoints on a chromosome
+  static const uint64_t index_gzip_skip_limit =
+      4u << 20;  //!< shortest jump in gzip text that restarts decompression
   std::ifstream _input;          //!< file connection for plaintext input
+  mapped_line_reader _mapped_input;  //!< memory-mapped plaintext input
+  std::unique_ptr<readahead_line_reader>
+      _readahead;  //!< background reader for streamed input
+  std::string_view _tokens[n_map_tokens];  //!< columns of current line
+  std::string _scratch;          //!< reused storage for numeric parsing
   gzFile _gzinput;               //!< file connection for gzipped input
+  seekable_gzip_reader
+      _seekable_gzinput;  //!< gzipped input with restart points
   std::istream *_fallback;       //!< pointer to fallback stream connection
   bigwig_reader _bwinput;        //!< file connection for bigwigs
-  char *_buffer;                 //!< character buffer for gzinput line reading
+  char *_buffer;                 //!< character buffer for gzip header line
   unsigned _buffer_size;         //!< size of gzinput buffer, in bytes
   format_type _ft;               //!< stored format of input filestream
+  bool _accumulate_gpos;  //!< whether rate-only formats accumulate gpos
   std::string _chr_lower_bound;  //!< chromosome of previous entry
   std::string _chr_upper_bound;  //!< chromosome of new entry
   mpz_class
@@ -253,6 +406,15 @@ class input_genetic_map_file : public base_input_genetic_map_file {
       _rate_lower_bound;  //!< point recombination rate change of previous entry
   mpf_class
       _rate_upper_bound;  //!< point recombination rate change of new entry
+  unsigned _queued_rows;  //!< rows in the bound window not yet in a block
+  bool _use_index;        //!< whether to skip ahead with a map index
+  map_index _index;       //!< checkpoints of the open map
+  uint64_t _locator_lower_bound;  //!< where the previous entry starts
+  uint64_t _locator_upper_bound;  //!< where the new entry starts
+  uint64_t _rows_read;            //!< entries read, including the new one
+  uint64_t _line_offset;  //!< offset of next streamed line in the text
+  bool _building_index;   //!< whether reading to index for another reader
+  unsigned _threads;      //!< threads decompressing indexed gzip input
 };
 }  // namespace interpolate_genetic_position
 
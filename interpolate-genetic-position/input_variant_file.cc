@@ -59,31 +59,42 @@ void igp::vardata::set_a2(const std::string &a2) { _a2 = a2; }
 
 igp::base_input_variant_file::base_input_variant_file() {}
 igp::base_input_variant_file::~base_input_variant_file() throw() {}
+unsigned igp::base_input_variant_file::next_batch(record_batch *batch,
+                                                  unsigned max_records) {
+  batch->clear();
+  while (batch->size() < max_records && get_variant()) {
+    unsigned row =
+        batch->append(get_chr(), get_pos1(), get_pos2(), get_line_contents(),
+                      get_varid(), get_a1(), get_a2());
+    if (batch->get_retain_vcf_records()) {
+      batch->set_vcf_record(row, get_vcf_record());
+    }
+    if (batch->get_retain_line_contents()) {
+      batch->set_line_contents(row, get_line_contents());
+    }
+  }
+  return batch->size();
+}
 
 igp::input_variant_file::input_variant_file()
     : igp::base_input_variant_file::base_input_variant_file(),
       _gzinput(0),
       _sr(0),
       _fallback(0),
-      _buffer(0),
-      _buffer_size(1000),
       _chr_index(0),
       _pos1_index(0),
       _pos2_index(-1),
       _gpos_index(0),
       _base0(false),
       _vcf_eof(false),
-      _buffer_full(false) {
-  _buffer = new char[_buffer_size];
-}
+      _buffer_full(false),
+      _threads(1),
+      _vcf_rid(-1),
+      _vcf_need_varid(true),
+      _vcf_need_alleles(true),
+      _has_pending_line(false) {}
 
-igp::input_variant_file::~input_variant_file() throw() {
-  close();
-  if (_buffer) {
-    delete[] _buffer;
-    _buffer = 0;
-  }
-}
+igp::input_variant_file::~input_variant_file() throw() { close(); }
 
 void igp::input_variant_file::open(const std::string &filename) {
   // catch vcfs
@@ -91,12 +102,20 @@ void igp::input_variant_file::open(const std::string &filename) {
       filename.rfind(".vcf") == filename.size() - 4 ||
       filename.rfind(".bcf") == filename.size() - 4) {
     _sr = bcf_sr_init();
+    if (_threads > 1 && bcf_sr_set_threads(_sr, static_cast<int>(_threads))) {
+      throw std::runtime_error(
+          "input_variant_file: unable to start htslib thread pool");
+    }
+    _vcf_rid = -1;
     hts_set_log_level(HTS_LOG_OFF);
     if (!bcf_sr_add_reader(_sr, filename.c_str())) {
       throw std::runtime_error("input_variant_file: " +
                                std::string(bcf_sr_strerror(_sr->errnum)));
     }
     hts_set_log_level(HTS_LOG_WARNING);
+  } else if (filename.size() > 4 &&
+             filename.rfind(".zst") == filename.size() - 4) {
+    _zstdinput.open(filename);
   } else if (filename.rfind(".gz") == filename.size() - 3) {
     _gzinput = gzopen(filename.c_str(), "rb");
     if (!_gzinput) {
@@ -104,15 +123,20 @@ void igp::input_variant_file::open(const std::string &filename) {
                                filename + "\"");
     }
   } else if (!filename.empty()) {
-    _input.open(filename.c_str());
-    if (!_input.is_open()) {
-      throw std::runtime_error("input_variant_file: cannot open file \"" +
-                               filename + "\"");
+    // regular files are parsed in place; anything else is streamed
+    if (!_mapped_input.open(filename)) {
+      _input.open(filename.c_str());
+      if (!_input.is_open()) {
+        throw std::runtime_error("input_variant_file: cannot open file \"" +
+                                 filename + "\"");
+      }
     }
   }  // otherwise, filename is empty, and the object will probe std::cin
 }
 
 void igp::input_variant_file::close() {
+  // the read-ahead thread must stop before its source is closed
+  _readahead.reset();
   if (_input.is_open()) {
     _input.close();
     _input.clear();
@@ -126,6 +150,9 @@ void igp::input_variant_file::close() {
     _sr = 0;
     _vcf_eof = false;
   }
+  _zstdinput.close();
+  _mapped_input.close();
+  _has_pending_line = false;
 }
 
 void igp::input_variant_file::set_fallback_stream(std::istream *ptr) {
@@ -152,7 +179,7 @@ void igp::input_variant_file::set_format_parameters(
 }
 
 bool igp::input_variant_file::get_variant() {
-  std::string line = "", catcher = "";
+  std::string_view line;
   // if the buffer has something in it, use that only
   if (_buffer_full) {
     _currentvar = _bufferedvar;
@@ -173,39 +200,38 @@ bool igp::input_variant_file::get_variant() {
     }
     // use htslib internal accessors, and skip downstream logic
     // for other filetypes
-    _currentvar.set_chr(std::string(
-        bcf_seqname_safe(bcf_sr_get_header(_sr, 0), bcf_sr_get_line(_sr, 0))));
-    bcf_unpack(bcf_sr_get_line(_sr, 0), BCF_UN_STR);
-    _currentvar.set_varid(std::string(bcf_sr_get_line(_sr, 0)->d.id));
-    _currentvar.set_a1(std::string(bcf_sr_get_line(_sr, 0)->d.allele[0]));
-    _currentvar.set_a2(std::string(bcf_sr_get_line(_sr, 0)->d.allele[1]));
-    _currentvar.set_pos1(bcf_sr_get_line(_sr, 0)->pos + 1);
+    bcf1_t *record = bcf_sr_get_line(_sr, 0);
+    // chromosome names only change at contig boundaries
+    if (record->rid != _vcf_rid) {
+      _vcf_rid = record->rid;
+      _currentvar.set_chr(
+          std::string(bcf_seqname_safe(bcf_sr_get_header(_sr, 0), record)));
+    }
+    // only decode identifiers and alleles if someone will look at them
+    if (_vcf_need_varid || _vcf_need_alleles) {
+      bcf_unpack(record, BCF_UN_STR);
+      if (_vcf_need_varid) {
+        _currentvar.set_varid(std::string(record->d.id));
+      }
+      if (_vcf_need_alleles) {
+        _currentvar.set_a1(std::string(record->d.allele[0]));
+        _currentvar.set_a2(std::string(record->d.allele[1]));
+      }
+    }
+    _currentvar.set_pos1(record->pos + 1);
     return true;
   }
 
   // other stream types are text line parsers of various kinds
-  if (_input.is_open()) {
-    getline(_input, line);
-  } else if (_gzinput) {
-    if (gzgets(_gzinput, _buffer, _buffer_size) == Z_NULL) {
-      return false;
-    }
-    line = std::string(_buffer);
-  } else {
-    getline(*get_fallback_stream(), line);
+  if (!read_line(&line)) {
+    return false;
   }
 
   // store whatever is in the current stored variant in the buffer
   _bufferedvar = _currentvar;
 
   // populate the current variant
-  std::istringstream strm1(line);
-  for (unsigned i = 0; i < _line_contents.size(); ++i) {
-    if (!(strm1 >> _line_contents.at(i))) {
-      throw std::runtime_error("get_variant: insufficient tokens: \"" + line +
-                               "\"");
-    }
-  }
+  tokenize_line(line);
   _currentvar.set_chr(_line_contents.at(_chr_index));
   _currentvar.set_pos1(mpz_class(_line_contents.at(_pos1_index)));
   if (_base0) {
@@ -237,6 +263,164 @@ bool igp::input_variant_file::get_variant() {
   return true;
 }
 
+unsigned igp::input_variant_file::next_batch(record_batch *batch,
+                                             unsigned max_records) {
+  batch->clear();
+  // vcf records have no buffering, so the per-marker path costs nothing
+  if (_sr) {
+    while (batch->size() < max_records &&
+           input_variant_file::get_variant()) {
+      unsigned row = batch->append(
+          _currentvar.get_chr(), _currentvar.get_pos1(),
+          _currentvar.get_pos2(), _line_contents, _currentvar.get_varid(),
+          _currentvar.get_a1(), _currentvar.get_a2());
+      // when writing vcf/bcf, the record itself is needed downstream
+      batch->set_vcf_record(row, bcf_sr_get_line(_sr, 0));
+    }
+    return batch->size();
+  }
+  // a region held back behind a gap-filling query by get_variant()
+  if (_buffer_full && max_records) {
+    _currentvar = _bufferedvar;
+    _buffer_full = false;
+    batch->append(_currentvar.get_chr(), _currentvar.get_pos1(),
+                  _currentvar.get_pos2(), _line_contents,
+                  _currentvar.get_varid(), _currentvar.get_a1(),
+                  _currentvar.get_a2());
+  }
+  unsigned slots_per_line = _pos2_index >= 0 ? 2 : 1;
+  std::string_view line;
+  while (batch->size() + slots_per_line <= max_records && !eof() &&
+         read_line(&line)) {
+    tokenize_line(line);
+    const std::string &chr = _line_contents.at(_chr_index);
+    parse_position(_line_contents.at(_pos1_index), &_batch_pos1);
+    if (_pos2_index >= 0) {
+      parse_position(_line_contents.at(static_cast<unsigned>(_pos2_index)),
+                     &_batch_pos2);
+      // fill the gap after the previous region on the same chromosome,
+      // exactly as get_variant() does
+      bool has_previous = !batch->empty();
+      const std::string &previous_chr =
+          has_previous ? batch->get_chr(batch->size() - 1)
+                       : _currentvar.get_chr();
+      const mpz_class &previous_pos2 =
+          has_previous ? batch->get_pos2(batch->size() - 1)
+                       : _currentvar.get_pos2();
+      if (!chr.compare(previous_chr) && cmp(_batch_pos1, previous_pos2) != 0) {
+        _breakpoint = previous_pos2;
+        batch->append(chr, _breakpoint, _batch_pos1, _line_contents,
+                      _currentvar.get_varid(), _currentvar.get_a1(),
+                      _currentvar.get_a2());
+      }
+    } else {
+      _batch_pos2 = -1;
+    }
+    unsigned row = batch->append(chr, _batch_pos1, _batch_pos2,
+                                 _line_contents, _currentvar.get_varid(),
+                                 _currentvar.get_a1(), _currentvar.get_a2());
+    // when writing pvar, every input column is needed downstream
+    batch->set_line_contents(row, _line_contents);
+  }
+  // leave the last marker where get_variant() would have, so that the
+  // two interfaces can be mixed
+  if (!batch->empty()) {
+    unsigned last = batch->size() - 1;
+    _currentvar.set_chr(batch->get_chr(last));
+    _currentvar.set_pos1(batch->get_pos1(last));
+    _currentvar.set_pos2(batch->get_pos2(last));
+  }
+  return batch->size();
+}
+
+void igp::input_variant_file::read_header(const std::string &prefix,
+                                          std::vector<std::string> *lines) {
+  lines->clear();
+  // vcf headers are consumed by htslib
+  if (_sr) {
+    return;
+  }
+  std::string_view line;
+  while (!eof() && read_line(&line)) {
+    // gzgets keeps line endings
+    while (!line.empty() &&
+           (line.back() == '\n' || line.back() == '\r')) {
+      line.remove_suffix(1);
+    }
+    if (line.compare(0, prefix.size(), prefix)) {
+      // first data line: hold it for the next read
+      _pending_line.assign(line);
+      _has_pending_line = true;
+      return;
+    }
+    lines->push_back(std::string(line));
+  }
+}
+
+bool igp::input_variant_file::read_line(std::string_view *line) {
+  if (_has_pending_line) {
+    _line.swap(_pending_line);
+    _has_pending_line = false;
+    *line = _line;
+    return true;
+  }
+  if (_mapped_input.is_open()) {
+    return _mapped_input.getline(line);
+  }
+  if (_zstdinput.is_open()) {
+    if (!_zstdinput.getline(&_line)) {
+      return false;
+    }
+    *line = _line;
+    return true;
+  }
+  // unmappable files, gzip streams and stdin
+  return get_readahead()->getline(line);
+}
+
+igp::readahead_line_reader *igp::input_variant_file::get_readahead() {
+  if (!_readahead) {
+    if (_input.is_open()) {
+      _readahead.reset(new readahead_line_reader(&_input));
+    } else if (_gzinput) {
+      _readahead.reset(new readahead_line_reader(_gzinput));
+    } else {
+      _readahead.reset(new readahead_line_reader(get_fallback_stream()));
+    }
+  }
+  return _readahead.get();
+}
+
+void igp::input_variant_file::tokenize_line(std::string_view line) {
+  // equivalent to repeated extraction with operator>>, without
+  // constructing a stream per line
+  const char *whitespace = " \t\n\v\f\r";
+  std::string::size_type start = 0, end = 0;
+  for (unsigned i = 0; i < _line_contents.size(); ++i) {
+    start = line.find_first_not_of(whitespace, end);
+    if (start == std::string::npos) {
+      throw std::runtime_error("get_variant: insufficient tokens: \"" +
+                               std::string(line) + "\"");
+    }
+    end = line.find_first_of(whitespace, start);
+    if (end == std::string::npos) {
+      end = line.size();
+    }
+    _line_contents.at(i).assign(line.substr(start, end - start));
+  }
+}
+
+void igp::input_variant_file::parse_position(const std::string &token,
+                                             mpz_class *pos) const {
+  // same parse as the mpz_class string constructor
+  if (mpz_set_str(pos->get_mpz_t(), token.c_str(), 0)) {
+    throw std::invalid_argument("mpz_set_str");
+  }
+  if (_base0) {
+    *pos += 1;
+  }
+}
+
 const std::string &igp::input_variant_file::get_chr() const {
   return _currentvar.get_chr();
 }
@@ -261,20 +445,42 @@ const std::string &igp::input_variant_file::get_a2() const {
   return _currentvar.get_a2();
 }
 
+const bcf_hdr_t *igp::input_variant_file::get_vcf_header() const {
+  return _sr ? bcf_sr_get_header(_sr, 0) : NULL;
+}
+bcf1_t *igp::input_variant_file::get_vcf_record() const {
+  return _sr ? bcf_sr_get_line(_sr, 0) : NULL;
+}
+void igp::input_variant_file::set_vcf_fields(bool need_varid, bool need_alleles,
+                                             bool need_record) {
+  _vcf_need_varid = need_varid;
+  _vcf_need_alleles = need_alleles;
+  if (_sr) {
+    // records are allocated with this setting on first read
+    _sr->max_unpack = need_record ? 0 : BCF_UN_STR;
+  }
+}
+void igp::input_variant_file::set_threads(unsigned n_threads) {
+  _threads = n_threads;
+}
+unsigned igp::input_variant_file::get_threads() const { return _threads; }
 const std::vector<std::string> &igp::input_variant_file::get_line_contents()
     const {
   return _line_contents;
 }
 
 bool igp::input_variant_file::eof() {
-  if (_input.is_open()) {
-    return _input.peek() == EOF;
+  if (_has_pending_line) {
+    return false;
   }
-  if (_gzinput) {
-    return gzeof(_gzinput);
+  if (_mapped_input.is_open()) {
+    return _mapped_input.eof();
   }
   if (_sr) {
     return _vcf_eof;
   }
-  return get_fallback_stream()->peek() == EOF;
+  if (_zstdinput.is_open()) {
+    return _zstdinput.eof();
+  }
+  return get_readahead()->eof();
 }
@@ -14,13 +14,19 @@
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "htslib/synced_bcf_reader.h"
+#include "interpolate-genetic-position/mapped_line_reader.h"
+#include "interpolate-genetic-position/readahead_line_reader.h"
+#include "interpolate-genetic-position/record_batch.h"
 #include "interpolate-genetic-position/utilities.h"
+#include "interpolate-genetic-position/zstd_line_reader.h"
 
 namespace interpolate_genetic_position {
 /*!
@@ -220,12 +226,61 @@ class base_input_variant_file {
    * \return vector containing tokenized representation of current line
    */
   virtual const std::vector<std::string> &get_line_contents() const = 0;
+  /*!
+   * \brief get header of vcf input
+   * \return header of vcf input, or NULL if input is not vcf/bcf
+   */
+  virtual const bcf_hdr_t *get_vcf_header() const = 0;
+  /*!
+   * \brief get htslib record of currently loaded marker
+   * \return htslib record of currently loaded marker, or NULL if input
+   * is not vcf/bcf. the record is owned by the reader, and only valid
+   * until the next marker is loaded
+   */
+  virtual bcf1_t *get_vcf_record() const = 0;
+  /*!
+   * \brief declare which parts of vcf records are used downstream
+   * \param need_varid whether get_varid() will be used
+   * \param need_alleles whether get_a1() and get_a2() will be used
+   * \param need_record whether get_vcf_record() will be used, beyond
+   * the site-level fields
+   *
+   * At time of writing, only used for vcfs. By default, everything is
+   * assumed to be needed; declaring fields unused lets readers skip
+   * decoding and copying them.
+   */
+  virtual void set_vcf_fields(bool need_varid, bool need_alleles,
+                              bool need_record) = 0;
+  /*!
+   * \brief consume header lines from the start of text input
+   * \param prefix leading characters that mark a header line
+   * \param lines pointer to storage for header lines, in file order,
+   * without line endings
+   *
+   * Must be called after open() and before the first marker is loaded.
+   * The first line that does not begin with prefix is left as the first
+   * marker. vcf headers are handled by htslib, so for vcf/bcf input no
+   * lines are returned.
+   */
+  virtual void read_header(const std::string &prefix,
+                           std::vector<std::string> *lines) = 0;
   /*!
    * \brief test input connection for EOF
    * \return whether input connection has encountered (or will encounter
    * as next character) EOF
    */
   virtual bool eof() = 0;
+  /*!
+   * \brief load up to a fixed number of markers into a batch
+   * \param batch pointer to batch to fill; existing contents are replaced.
+   * passthrough fields are taken as configured in the batch
+   * \param max_records maximum number of markers to load
+   * \return number of markers loaded. 0 should indicate EOF.
+   *
+   * The default implementation is built on get_variant() and the
+   * per-marker accessors, so that mocks inherit working behavior.
+   */
+  virtual unsigned next_batch(record_batch *batch, unsigned max_records);
 };
 
 /*!
@@ -327,21 +382,117 @@ class input_variant_file : public base_input_variant_file {
    * \return vector containing tokenized representation of current line
    */
   const std::vector<std::string> &get_line_contents() const;
+  /*!
+   * \brief get header of vcf input
+   * \return header of vcf input, or NULL if input is not vcf/bcf
+   */
+  const bcf_hdr_t *get_vcf_header() const;
+  /*!
+   * \brief get htslib record of currently loaded marker
+   * \return htslib record of currently loaded marker, or NULL if input
+   * is not vcf/bcf
+   */
+  bcf1_t *get_vcf_record() const;
+  /*!
+   * \brief declare which parts of vcf records are used downstream
+   * \param need_varid whether get_varid() will be used
+   * \param need_alleles whether get_a1() and get_a2() will be used
+   * \param need_record whether get_vcf_record() will be used, beyond
+   * the site-level fields
+   *
+   * Unused identifiers and alleles are neither unpacked nor copied.
+   * If the full record is not needed, text vcf parsing stops after the
+   * ALT column. Must be called after open() and before the first marker
+   * is loaded for the latter to take effect.
+   */
+  void set_vcf_fields(bool need_varid, bool need_alleles, bool need_record);
+  /*!
+   * \brief consume header lines from the start of text input
+   * \param prefix leading characters that mark a header line
+   * \param lines pointer to storage for header lines, in file order,
+   * without line endings
+   *
+   * The first line that does not begin with prefix is held back and
+   * returned by the next read.
+   */
+  void read_header(const std::string &prefix, std::vector<std::string> *lines);
+  /*!
+   * \brief set number of threads htslib may use to decompress vcf/bcf
+   * input
+   * \param n_threads number of threads; 1 decompresses on the
+   * reading thread
+   *
+   * Must be called before open() to take effect.
+   */
+  void set_threads(unsigned n_threads);
+  /*!
+   * \brief get number of threads htslib may use to decompress vcf/bcf
+   * input
+   * \return number of threads htslib may use to decompress vcf/bcf input
+   */
+  unsigned get_threads() const;
   /*!
    * \brief test input connection for EOF
    * \return whether input connection has encountered (or will encounter
    * as next character) EOF
    */
   bool eof();
+  /*!
+   * \brief load up to a fixed number of markers into a batch
+   * \param batch pointer to batch to fill; existing contents are replaced.
+   * passthrough fields are taken as configured in the batch
+   * \param max_records maximum number of markers to load
+   * \return number of markers loaded. 0 should indicate EOF.
+   *
+   * Text input is parsed straight into the batch, without staging
+   * each marker in the current/buffered variant slots. For region
+   * input, a batch stops one short of max_records rather than split
+   * a gap-filling query from the region that follows it.
+   */
+  unsigned next_batch(record_batch *batch, unsigned max_records);
 
  private:
+  /*!
+   * \brief read the next line of a text input connection
+   * \param line pointer to storage for a view of the line, valid until
+   * the next read
+   * \return whether a line was read
+   *
+   * Mapped input hands out views into the mapping itself; other input
+   * is read ahead on a background thread.
+   */
+  bool read_line(std::string_view *line);
+  /*!
+   * \brief get the read-ahead layer for streamed input, starting it on
+   * first use
+   * \return read-ahead layer over the open stream, gzip stream, or
+   * fallback stream
+   *
+   * Starting lazily leaves the fallback stream settable after open().
+   */
+  readahead_line_reader *get_readahead();
+  /*!
+   * \brief split a line on whitespace into the tokenized line buffer
+   * \param line line to split
+   *
+   * Tokens beyond the configured number are ignored.
+   */
+  void tokenize_line(std::string_view line);
+  /*!
+   * \brief parse a physical position token, respecting base 0 input
+   * \param token text of position
+   * \param pos pointer to storage for parsed position
+   */
+  void parse_position(const std::string &token, mpz_class *pos) const;
   std::ifstream _input;                     //!< input uncompressed file stream
   gzFile _gzinput;                          //!< input gzipped file pointer
+  zstd_line_reader _zstdinput;              //!< input zstd-compressed file
+  mapped_line_reader _mapped_input;         //!< input memory-mapped file
+  std::unique_ptr<readahead_line_reader>
+      _readahead;  //!< background reader for streamed input
   bcf_srs_t *_sr;                           //!< synced reader for input vcfs
   std::istream *_fallback;                  //!< fallback input stream
-  char *_buffer;                            //!< character buffer for zlib reads
   std::vector<std::string> _line_contents;  //!< tokenized input line
-  unsigned _buffer_size;                    //!< size of allocated buffer
   unsigned _chr_index;                      //!< index of chromosome in line
   unsigned _pos1_index;  //!< index of physical position in line
   int _pos2_index;       //!< for e.g. bedfiles, index of end position of region
@@ -351,6 +502,16 @@ class input_variant_file : public base_input_variant_file {
   bool _base0;           //!< whether physical position is base 0
   bool _vcf_eof;         //!< track whether vcf eof has been encountered
   bool _buffer_full;     //!< track whether there is a buffered variant
+  std::string _line;     //!< reused storage for streamed input lines
+  mpz_class _batch_pos1;  //!< reused storage for batch query position
+  mpz_class _batch_pos2;  //!< reused storage for batch query end position
+  mpz_class _breakpoint;  //!< reused storage for batch gap start position
+  unsigned _threads;      //!< number of htslib decompression threads
+  int _vcf_rid;           //!< header contig id of current vcf marker
+  bool _vcf_need_varid;   //!< whether vcf identifiers are used downstream
+  bool _vcf_need_alleles;  //!< whether vcf alleles are used downstream
+  std::string _pending_line;  //!< line read past the end of a header
+  bool _has_pending_line;     //!< whether a line is held back for reading
 };
 
 }  // namespace interpolate_genetic_position
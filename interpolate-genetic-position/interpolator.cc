@@ -10,7 +10,14 @@
 
 namespace igp = interpolate_genetic_position;
 
-igp::interpolator::interpolator() {}
+igp::interpolator::interpolator()
+    : _pipelined(false),
+      _output_cm_rate(false),
+      _output_bigwig_rate(false),
+      _output_per_chromosome(false),
+      _map_index(false),
+      _threads(1),
+      _jobs(1) {}
 igp::interpolator::~interpolator() throw() {}
 void igp::interpolator::interpolate(
     const std::string &input_filename, const std::string &preset,
@@ -18,27 +25,477 @@ void igp::interpolator::interpolate(
     const std::string &output_filename, const std::string &output_format,
     bool output_morgans, const double &step_interval,
     unsigned fixed_output_width, bool verbose) const {
-  input_variant_file input_variant_interface;
-  input_genetic_map_file genetic_map_interface;
-  output_variant_file output_variant_interface;
-  input_variant_interface.set_fallback_stream(&std::cin);
-  output_variant_interface.output_morgans(output_morgans);
-  output_variant_interface.set_fixed_width(fixed_output_width);
-  genetic_map_interface.set_fallback_stream(&std::cin);
-  genetic_map gm(&genetic_map_interface);
   format_type map_ft = string_to_format_type(map_format);
+  std::unique_ptr<base_input_genetic_map_file> genetic_map_interface(
+      new_genetic_map_interface(map_ft));
+  genetic_map gm(genetic_map_interface.get());
+  gm.open(genetic_map_filename, map_ft);
+  interpolate_query_file(
+      input_filename, string_to_format_type(preset),
+      std::vector<genetic_map *>(1, &gm),
+      std::vector<std::string>(1, output_filename),
+      std::vector<format_type>(1, string_to_format_type(output_format)),
+      std::vector<unsigned>(1, 0), output_morgans, step_interval,
+      fixed_output_width, verbose);
+}
+void igp::interpolator::interpolate_outputs(
+    const std::string &input_filename, const std::string &preset,
+    const std::string &genetic_map_filename, const std::string &map_format,
+    const std::vector<std::string> &output_filenames,
+    const std::vector<std::string> &output_formats, bool output_morgans,
+    const double &step_interval, unsigned fixed_output_width,
+    bool verbose) const {
+  if (output_filenames.empty() ||
+      output_filenames.size() != output_formats.size()) {
+    throw std::runtime_error(
+        "interpolator::interpolate_outputs: each output file requires "
+        "exactly one output format");
+  }
+  std::vector<format_type> output_fts;
+  for (unsigned i = 0; i < output_filenames.size(); ++i) {
+    if (output_filenames.size() > 1 && output_filenames.at(i).empty()) {
+      throw std::runtime_error(
+          "interpolator::interpolate_outputs: with several output files, "
+          "none can be written to stdout");
+    }
+    for (unsigned j = 0; j < i; ++j) {
+      if (!output_filenames.at(i).compare(output_filenames.at(j))) {
+        throw std::runtime_error(
+            "interpolator::interpolate_outputs: output file \"" +
+            output_filenames.at(i) + "\" is requested more than once");
+      }
+    }
+    output_fts.push_back(string_to_format_type(output_formats.at(i)));
+  }
+  format_type map_ft = string_to_format_type(map_format);
+  std::unique_ptr<base_input_genetic_map_file> genetic_map_interface(
+      new_genetic_map_interface(map_ft));
+  genetic_map gm(genetic_map_interface.get());
   gm.open(genetic_map_filename, map_ft);
-  query_file qf(&input_variant_interface, &output_variant_interface);
+  // every output reports the same interpolations of the one map
+  interpolate_query_file(input_filename, string_to_format_type(preset),
+                         std::vector<genetic_map *>(1, &gm), output_filenames,
+                         output_fts,
+                         std::vector<unsigned>(output_filenames.size(), 0),
+                         output_morgans, step_interval, fixed_output_width,
+                         verbose);
+}
+void igp::interpolator::interpolate_maps(
+    const std::string &input_filename, const std::string &preset,
+    const std::vector<std::string> &genetic_map_filenames,
+    const std::vector<std::string> &map_formats,
+    const std::vector<std::string> &output_filenames,
+    const std::string &output_format, bool output_morgans,
+    const double &step_interval, unsigned fixed_output_width,
+    bool verbose) const {
+  if (genetic_map_filenames.empty() ||
+      genetic_map_filenames.size() != map_formats.size() ||
+      genetic_map_filenames.size() != output_filenames.size()) {
+    throw std::runtime_error(
+        "interpolator::interpolate_maps: each genetic map requires exactly "
+        "one map format and one output file");
+  }
+  for (unsigned i = 0; i < genetic_map_filenames.size(); ++i) {
+    if (genetic_map_filenames.size() > 1 &&
+        (genetic_map_filenames.at(i).empty() ||
+         output_filenames.at(i).empty())) {
+      throw std::runtime_error(
+          "interpolator::interpolate_maps: with several genetic maps, "
+          "neither maps nor output can use stdin/stdout");
+    }
+    for (unsigned j = 0; j < i; ++j) {
+      if (!output_filenames.at(i).compare(output_filenames.at(j))) {
+        throw std::runtime_error(
+            "interpolator::interpolate_maps: genetic maps \"" +
+            genetic_map_filenames.at(j) + "\" and \"" +
+            genetic_map_filenames.at(i) + "\" would both write \"" +
+            output_filenames.at(i) + "\"");
+      }
+    }
+  }
+  std::vector<std::unique_ptr<base_input_genetic_map_file> >
+      genetic_map_interfaces;
+  std::vector<std::unique_ptr<genetic_map> > genetic_maps;
+  std::vector<genetic_map *> gms;
+  std::vector<unsigned> output_maps;
+  for (unsigned i = 0; i < genetic_map_filenames.size(); ++i) {
+    format_type map_ft = string_to_format_type(map_formats.at(i));
+    genetic_map_interfaces.emplace_back(new_genetic_map_interface(map_ft));
+    genetic_maps.emplace_back(
+        new genetic_map(genetic_map_interfaces.back().get()));
+    genetic_maps.back()->open(genetic_map_filenames.at(i), map_ft);
+    gms.push_back(genetic_maps.back().get());
+    output_maps.push_back(i);
+  }
+  std::vector<format_type> output_fts(gms.size(),
+                                      string_to_format_type(output_format));
+  interpolate_query_file(input_filename, string_to_format_type(preset), gms,
+                         output_filenames, output_fts, output_maps,
+                         output_morgans, step_interval, fixed_output_width,
+                         verbose);
+}
+igp::base_input_genetic_map_file *
+igp::interpolator::new_genetic_map_interface(format_type map_ft) const {
+  // with threads to spare, bigwig chromosomes are decoded concurrently
+  // up front rather than streamed one at a time
+  base_input_genetic_map_file *genetic_map_interface = NULL;
+  if (map_ft == BIGWIG && get_threads() > 1) {
+    parallel_bigwig_map_file *bigwig_interface = new parallel_bigwig_map_file;
+    genetic_map_interface = bigwig_interface;
+    bigwig_interface->set_threads(get_threads());
+  } else {
+    input_genetic_map_file *file_interface = new input_genetic_map_file;
+    genetic_map_interface = file_interface;
+    file_interface->set_use_index(get_map_index());
+    file_interface->set_threads(get_threads());
+  }
+  genetic_map_interface->set_fallback_stream(&std::cin);
+  return genetic_map_interface;
+}
+void igp::interpolator::interpolate_files(
+    const std::vector<std::string> &input_filenames, const std::string &preset,
+    const std::string &genetic_map_filename, const std::string &map_format,
+    const std::vector<std::string> &output_filenames,
+    const std::string &output_format, bool output_morgans,
+    const double &step_interval, unsigned fixed_output_width,
+    bool verbose) const {
+  if (input_filenames.size() != output_filenames.size()) {
+    throw std::runtime_error(
+        "interpolator::interpolate_files: each input file requires exactly "
+        "one output file");
+  }
+  for (unsigned i = 0; i < input_filenames.size(); ++i) {
+    if (input_filenames.at(i).empty() || output_filenames.at(i).empty()) {
+      throw std::runtime_error(
+          "interpolator::interpolate_files: with several input files, "
+          "neither input nor output can use stdin/stdout");
+    }
+    for (unsigned j = 0; j < i; ++j) {
+      if (!output_filenames.at(i).compare(output_filenames.at(j))) {
+        throw std::runtime_error(
+            "interpolator::interpolate_files: input files \"" +
+            input_filenames.at(j) + "\" and \"" + input_filenames.at(i) +
+            "\" would both write \"" + output_filenames.at(i) + "\"");
+      }
+    }
+  }
   format_type query_ft = string_to_format_type(preset);
   format_type output_ft = string_to_format_type(output_format);
-  qf.open(input_filename, query_ft);
-  qf.initialize_output(output_filename, output_ft);
-  qf.set_step_interval(step_interval);
-  mpf_class gpos_interpolated;
-  std::vector<query_result> results;
-  while (qf.get()) {
-    gm.query(qf.get_chr(), qf.get_pos1(), qf.get_pos2(), verbose, &results);
-    qf.report(results);
-  }
-  qf.close();
+  // the map is parsed once; every file gets its own reader over the
+  // same rows, so files can be processed in any order
+  shared_genetic_map_file shared_map;
+  shared_map.set_fallback_stream(&std::cin);
+  shared_map.set_threads(get_threads());
+  shared_map.open(genetic_map_filename, string_to_format_type(map_format));
+  unsigned n_workers = std::min(
+      get_jobs(), static_cast<unsigned>(input_filenames.size()));
+  std::atomic<unsigned> next(0);
+  std::atomic<bool> abort(false);
+  std::vector<std::exception_ptr> errors(input_filenames.size());
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < n_workers; ++i) {
+    workers.push_back(std::thread([&]() {
+      for (unsigned j = next++; j < input_filenames.size() && !abort;
+           j = next++) {
+        try {
+          shared_genetic_map_file genetic_map_interface;
+          genetic_map_interface.share(shared_map);
+          genetic_map gm(&genetic_map_interface);
+          interpolate_query_file(
+              input_filenames.at(j), query_ft,
+              std::vector<genetic_map *>(1, &gm),
+              std::vector<std::string>(1, output_filenames.at(j)),
+              std::vector<format_type>(1, output_ft),
+              std::vector<unsigned>(1, 0), output_morgans, step_interval,
+              fixed_output_width, verbose);
+        } catch (...) {
+          errors.at(j) = std::current_exception();
+          abort = true;
+        }
+        gmp_arena::reset();
+      }
+    }));
+  }
+  for (unsigned i = 0; i < workers.size(); ++i) {
+    workers.at(i).join();
+  }
+  for (unsigned i = 0; i < errors.size(); ++i) {
+    if (errors.at(i)) {
+      std::rethrow_exception(errors.at(i));
+    }
+  }
+}
+void igp::interpolator::interpolate_query_file(
+    const std::string &input_filename, format_type query_ft,
+    const std::vector<genetic_map *> &gms,
+    const std::vector<std::string> &output_filenames,
+    const std::vector<format_type> &output_fts,
+    const std::vector<unsigned> &output_maps, bool output_morgans,
+    const double &step_interval, unsigned fixed_output_width,
+    bool verbose) const {
+  input_variant_file input_variant_interface;
+  input_variant_interface.set_fallback_stream(&std::cin);
+  input_variant_interface.set_threads(get_threads());
+  // each output has its own query_file; the first reads the input, and
+  // the others share what it has read
+  std::vector<std::unique_ptr<output_variant_file> > output_variant_interfaces;
+  std::vector<std::unique_ptr<query_file> > query_files;
+  std::vector<std::unique_ptr<base_format_pipeline> > pipelines;
+  std::vector<query_file *> qfs;
+  for (unsigned i = 0; i < output_filenames.size(); ++i) {
+    output_variant_interfaces.emplace_back(new output_variant_file);
+    output_variant_file *output_variant_interface =
+        output_variant_interfaces.back().get();
+    output_variant_interface->output_morgans(output_morgans);
+    output_variant_interface->set_fixed_width(fixed_output_width);
+    output_variant_interface->output_cm_rate(get_output_cm_rate());
+    output_variant_interface->output_bigwig_rate(get_output_bigwig_rate());
+    output_variant_interface->set_threads(get_threads());
+    output_variant_interface->output_per_chromosome(
+        get_output_per_chromosome());
+    query_files.emplace_back(
+        new query_file(&input_variant_interface, output_variant_interface));
+    query_file *qf = query_files.back().get();
+    if (i) {
+      qf->share_input(*qfs.front());
+    } else {
+      qf->open(input_filename, query_ft);
+    }
+    qf->initialize_output(output_filenames.at(i), output_fts.at(i));
+    // the format pair is fixed from here on, so select its reporting
+    // specialization once rather than dispatching on format per result
+    pipelines.emplace_back(make_format_pipeline(query_ft, output_fts.at(i),
+                                                output_variant_interface));
+    qf->set_format_pipeline(pipelines.back().get());
+    qf->set_step_interval(step_interval);
+    qf->set_result_set(output_maps.at(i));
+    qfs.push_back(qf);
+  }
+  for (unsigned i = 1; i < qfs.size(); ++i) {
+    qfs.front()->add_batch_reporter(*qfs.at(i));
+  }
+  // a bed region can span any number of map intervals, so its segments
+  // are streamed to output rather than collected per query. sweeping
+  // advances the map, so this needs a map per output.
+  bool sweep_regions = query_ft == BED && qfs.size() == gms.size();
+  if (get_pipelined()) {
+    run_pipelined(qfs, gms, output_maps, sweep_regions, verbose);
+  } else {
+    run_sequential(qfs, gms, output_maps, sweep_regions, verbose);
+  }
+  memory_profiler::stage_guard guard(STAGE_WRITE);
+  for (unsigned i = 0; i < qfs.size(); ++i) {
+    qfs.at(i)->close();
+  }
+}
+void igp::interpolator::set_pipelined(bool pipelined) {
+  _pipelined = pipelined;
+}
+bool igp::interpolator::get_pipelined() const { return _pipelined; }
+void igp::interpolator::set_output_cm_rate(bool use_rate) {
+  _output_cm_rate = use_rate;
+}
+bool igp::interpolator::get_output_cm_rate() const { return _output_cm_rate; }
+void igp::interpolator::set_output_bigwig_rate(bool use_rate) {
+  _output_bigwig_rate = use_rate;
+}
+bool igp::interpolator::get_output_bigwig_rate() const {
+  return _output_bigwig_rate;
+}
+void igp::interpolator::set_output_per_chromosome(bool per_chromosome) {
+  _output_per_chromosome = per_chromosome;
+}
+bool igp::interpolator::get_output_per_chromosome() const {
+  return _output_per_chromosome;
+}
+void igp::interpolator::set_map_index(bool use_index) {
+  _map_index = use_index;
+}
+bool igp::interpolator::get_map_index() const { return _map_index; }
+void igp::interpolator::set_threads(unsigned n_threads) {
+  _threads = n_threads;
+}
+unsigned igp::interpolator::get_threads() const { return _threads; }
+void igp::interpolator::set_jobs(unsigned n_jobs) {
+  if (!n_jobs) {
+    throw std::runtime_error(
+        "interpolator::set_jobs: at least one job is required");
+  }
+  _jobs = n_jobs;
+}
+unsigned igp::interpolator::get_jobs() const { return _jobs; }
+void igp::interpolator::run_sequential(
+    const std::vector<query_file *> &qfs, const std::vector<genetic_map *> &gms,
+    const std::vector<unsigned> &output_maps, bool sweep_regions,
+    bool verbose) const {
+  // verbose query logging is interleaved with output one query at a time
+  unsigned batch_size = verbose ? 1 : sequential_batch_size;
+  record_batch batch;
+  batch.set_result_sets(gms.size());
+  while (true) {
+    {
+      memory_profiler::stage_guard guard(STAGE_READ);
+      if (!qfs.front()->get_batch(&batch, batch_size)) {
+        break;
+      }
+    }
+    for (unsigned i = 0; i < batch.size(); ++i) {
+      memory_profiler::record_row();
+    }
+    if (sweep_regions) {
+      // interpolation and writing are interleaved segment by segment
+      memory_profiler::stage_guard guard(STAGE_INTERPOLATE);
+      for (unsigned k = 0; k < qfs.size(); ++k) {
+        qfs.at(k)->report_sweep(batch, gms.at(output_maps.at(k)), verbose);
+      }
+      gmp_arena::reset();
+      continue;
+    }
+    {
+      memory_profiler::stage_guard guard(STAGE_INTERPOLATE);
+      for (unsigned k = 0; k < gms.size(); ++k) {
+        for (unsigned i = 0; i < batch.size(); ++i) {
+          gms.at(k)->query(batch.get_chr(i), batch.get_pos1(i),
+                           batch.get_pos2(i), verbose,
+                           batch.get_mutable_results(i, k));
+        }
+      }
+    }
+    {
+      memory_profiler::stage_guard guard(STAGE_WRITE);
+      for (unsigned k = 0; k < qfs.size(); ++k) {
+        qfs.at(k)->report(batch);
+      }
+    }
+    // temporaries from this batch have all been released, so the
+    // arena can hand their storage out again from the top
+    gmp_arena::reset();
+  }
+}
+void igp::interpolator::run_pipelined(
+    const std::vector<query_file *> &qfs, const std::vector<genetic_map *> &gms,
+    const std::vector<unsigned> &output_maps, bool sweep_regions,
+    bool verbose) const {
+  /*
+   * batches circulate reader -> compute -> writers -> reader, with one
+   * writer thread per output. the number of batches is fixed, so a
+   * stage that gets ahead of its successor stalls on an empty queue
+   * instead of buffering without bound. every writer sees every batch
+   * in input order, so the reader reuses a batch once it has come back
+   * from each of them. a NULL batch marks end of input. when sweeping
+   * regions, batches pass through the compute stage untouched, and
+   * each writer interpolates each region as it writes it.
+   */
+  std::vector<record_batch> batches(pipeline_batches_in_flight);
+  spsc_ring_buffer<record_batch *> read_batches(pipeline_batches_in_flight +
+                                                1);
+  std::vector<std::unique_ptr<spsc_ring_buffer<record_batch *> > >
+      computed_batches, written_batches;
+  for (unsigned k = 0; k < qfs.size(); ++k) {
+    computed_batches.emplace_back(
+        new spsc_ring_buffer<record_batch *>(pipeline_batches_in_flight + 1));
+    written_batches.emplace_back(
+        new spsc_ring_buffer<record_batch *>(pipeline_batches_in_flight));
+  }
+  for (std::vector<record_batch>::iterator iter = batches.begin();
+       iter != batches.end(); ++iter) {
+    iter->set_result_sets(gms.size());
+    for (unsigned k = 0; k < qfs.size(); ++k) {
+      written_batches.at(k)->try_push(&(*iter));
+    }
+  }
+  std::atomic<bool> abort(false);
+  std::exception_ptr reader_error, compute_error;
+  std::vector<std::exception_ptr> writer_errors(qfs.size());
+  std::thread reader([&]() {
+    try {
+      memory_profiler::stage_guard guard(STAGE_READ);
+      record_batch *batch = NULL;
+      while (true) {
+        for (unsigned k = 0; k < written_batches.size(); ++k) {
+          if (!written_batches.at(k)->pop(&batch, abort)) {
+            return;
+          }
+        }
+        if (!qfs.front()->get_batch(batch, pipeline_batch_size)) {
+          read_batches.push(NULL, abort);
+          return;
+        }
+        for (unsigned i = 0; i < batch->size(); ++i) {
+          memory_profiler::record_row();
+        }
+        if (!read_batches.push(batch, abort)) {
+          return;
+        }
+        gmp_arena::reset();
+      }
+    } catch (...) {
+      reader_error = std::current_exception();
+      abort = true;
+    }
+  });
+  std::thread compute([&]() {
+    try {
+      memory_profiler::stage_guard guard(STAGE_INTERPOLATE);
+      record_batch *batch = NULL;
+      while (read_batches.pop(&batch, abort)) {
+        for (unsigned k = 0; batch && !sweep_regions && k < gms.size();
+             ++k) {
+          for (unsigned i = 0; i < batch->size(); ++i) {
+            gms.at(k)->query(batch->get_chr(i), batch->get_pos1(i),
+                             batch->get_pos2(i), verbose,
+                             batch->get_mutable_results(i, k));
+          }
+        }
+        for (unsigned k = 0; k < computed_batches.size(); ++k) {
+          if (!computed_batches.at(k)->push(batch, abort)) {
+            return;
+          }
+        }
+        if (!batch) {
+          return;
+        }
+        gmp_arena::reset();
+      }
+    } catch (...) {
+      compute_error = std::current_exception();
+      abort = true;
+    }
+  });
+  std::vector<std::thread> writers;
+  for (unsigned k = 0; k < qfs.size(); ++k) {
+    writers.push_back(std::thread([&, k]() {
+      try {
+        memory_profiler::stage_guard guard(STAGE_WRITE);
+        record_batch *batch = NULL;
+        while (computed_batches.at(k)->pop(&batch, abort) && batch) {
+          if (sweep_regions) {
+            qfs.at(k)->report_sweep(*batch, gms.at(output_maps.at(k)),
+                                    verbose);
+          } else {
+            qfs.at(k)->report(*batch);
+          }
+          if (!written_batches.at(k)->push(batch, abort)) {
+            return;
+          }
+          gmp_arena::reset();
+        }
+      } catch (...) {
+        writer_errors.at(k) = std::current_exception();
+        abort = true;
+      }
+    }));
+  }
+  reader.join();
+  compute.join();
+  for (unsigned k = 0; k < writers.size(); ++k) {
+    writers.at(k).join();
+  }
+  // report the earliest failing stage, as later stages may only have
+  // stopped because of it
+  if (reader_error) std::rethrow_exception(reader_error);
+  if (compute_error) std::rethrow_exception(compute_error);
+  for (unsigned k = 0; k < writer_errors.size(); ++k) {
+    if (writer_errors.at(k)) std::rethrow_exception(writer_errors.at(k));
+  }
 }
@@ -13,20 +13,46 @@
 #include <gmpxx.h>
 #include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "interpolate-genetic-position/format_pipeline.h"
 #include "interpolate-genetic-position/genetic_map.h"
+#include "interpolate-genetic-position/gmp_arena.h"
 #include "interpolate-genetic-position/input_genetic_map_file.h"
 #include "interpolate-genetic-position/input_variant_file.h"
+#include "interpolate-genetic-position/memory_profiler.h"
+#include "interpolate-genetic-position/parallel_bigwig_map_file.h"
 #include "interpolate-genetic-position/query_file.h"
+#include "interpolate-genetic-position/record_batch.h"
+#include "interpolate-genetic-position/ring_buffer.h"
+#include "interpolate-genetic-position/shared_genetic_map_file.h"
 #include "interpolate-genetic-position/utilities.h"
 
 namespace interpolate_genetic_position {
+/*!
+ * \brief number of queries per batch in sequential mode; the GMP arena
+ * is reset between batches
+ */
+const unsigned sequential_batch_size = 4096;
+/*!
+ * \brief number of queries per batch passed between pipeline stages
+ */
+const unsigned pipeline_batch_size = 1024;
+/*!
+ * \brief number of batches circulating between pipeline stages; this
+ * bounds the number of queries held in memory in pipelined mode
+ */
+const unsigned pipeline_batches_in_flight = 8;
 /*!
  * \class interpolator
  * \brief primary interpolation controller. needs to be its own
@@ -70,6 +96,260 @@ class interpolator {
                    const std::string &output_format, bool output_morgans,
                    const double &step_interval, unsigned fixed_output_width,
                    bool verbose) const;
+  /*!
+   * \brief run interpolation on several input files against one map
+   * \param input_filenames names of input variant query files
+   * \param preset descriptor of format of all input query files
+   * \param genetic_map name of input recombination map file
+   * \param map_format descriptor of genetic map format
+   * \param output_filenames names of output results files, one per
+   * input file
+   * \param output_format descriptor of output results files
+   * \param output_morgans whether genetic position should be output
+   * in morgans, as opposed to the default centimorgans
+   * \param step_interval fixed genetic distance to add to boundary
+   * between successive query regions in an input bedfile
+   * \param fixed_output_width number of digits to print after
+   * decimal for output floating point values, or 0 for dynamic width
+   * \param verbose whether to emit (extremely) verbose logging to std::cout
+   *
+   * The map is read into memory once, and each input file is then
+   * processed exactly as interpolate() would, with up to get_jobs()
+   * files at a time. Input files cannot be streamed from stdin, nor
+   * output written to stdout. If any file fails, no further files are
+   * started, and the error of the first failing file in input order is
+   * rethrown once the files in progress have finished.
+   */
+  void interpolate_files(const std::vector<std::string> &input_filenames,
+                         const std::string &preset,
+                         const std::string &genetic_map_filename,
+                         const std::string &map_format,
+                         const std::vector<std::string> &output_filenames,
+                         const std::string &output_format,
+                         bool output_morgans, const double &step_interval,
+                         unsigned fixed_output_width, bool verbose) const;
+  /*!
+   * \brief run interpolation of one input file into several outputs
+   * \param input_filename name of input variant query file
+   * \param preset descriptor of format of input query file
+   * \param genetic_map_filename name of input recombination map file
+   * \param map_format descriptor of genetic map format
+   * \param output_filenames names of output results files
+   * \param output_formats descriptors of output results files, one per
+   * output file
+   * \param output_morgans whether genetic position should be output
+   * in morgans, as opposed to the default centimorgans
+   * \param step_interval fixed genetic distance to add to boundary
+   * between successive query regions in an input bedfile
+   * \param fixed_output_width number of digits to print after
+   * decimal for output floating point values, or 0 for dynamic width
+   * \param verbose whether to emit (extremely) verbose logging to std::cout
+   *
+   * The input is read and interpolated once, and every batch of results
+   * is reported to each output, which matches what interpolate() writes
+   * in that format alone. In pipelined mode, each output is formatted
+   * and written on its own thread. With several outputs, none can be
+   * written to stdout.
+   */
+  void interpolate_outputs(const std::string &input_filename,
+                           const std::string &preset,
+                           const std::string &genetic_map_filename,
+                           const std::string &map_format,
+                           const std::vector<std::string> &output_filenames,
+                           const std::vector<std::string> &output_formats,
+                           bool output_morgans, const double &step_interval,
+                           unsigned fixed_output_width, bool verbose) const;
+  /*!
+   * \brief run interpolation of one input file against several maps
+   * \param input_filename name of input variant query file
+   * \param preset descriptor of format of input query file
+   * \param genetic_map_filenames names of input recombination map files
+   * \param map_formats descriptors of genetic map formats, one per map
+   * \param output_filenames names of output results files, one per map
+   * \param output_format descriptor of output results files
+   * \param output_morgans whether genetic position should be output
+   * in morgans, as opposed to the default centimorgans
+   * \param step_interval fixed genetic distance to add to boundary
+   * between successive query regions in an input bedfile
+   * \param fixed_output_width number of digits to print after
+   * decimal for output floating point values, or 0 for dynamic width
+   * \param verbose whether to emit (extremely) verbose logging to std::cout
+   *
+   * The input is read and parsed once. Each batch of queries is
+   * interpolated against every map in turn, and reported to each map's
+   * own output file, which matches what interpolate() writes for that
+   * map alone. With several maps, neither maps nor output can use
+   * stdin/stdout.
+   */
+  void interpolate_maps(const std::string &input_filename,
+                        const std::string &preset,
+                        const std::vector<std::string> &genetic_map_filenames,
+                        const std::vector<std::string> &map_formats,
+                        const std::vector<std::string> &output_filenames,
+                        const std::string &output_format, bool output_morgans,
+                        const double &step_interval,
+                        unsigned fixed_output_width, bool verbose) const;
+  /*!
+   * \brief set the number of input files processed at once by
+   * interpolate_files()
+   * \param n_jobs number of input files processed at once
+   */
+  void set_jobs(unsigned n_jobs);
+  /*!
+   * \brief get the number of input files processed at once by
+   * interpolate_files()
+   * \return number of input files processed at once
+   */
+  unsigned get_jobs() const;
+  /*!
+   * \brief set whether to run reading, interpolation and writing
+   * concurrently on dedicated threads
+   * \param pipelined whether to run reading, interpolation and writing
+   * concurrently on dedicated threads
+   *
+   * Pipelined mode produces output identical to the default sequential
+   * mode; queries are still reported in input order.
+   */
+  void set_pipelined(bool pipelined);
+  /*!
+   * \brief get whether reading, interpolation and writing run
+   * concurrently on dedicated threads
+   * \return whether reading, interpolation and writing run
+   * concurrently on dedicated threads
+   */
+  bool get_pipelined() const;
+  /*!
+   * \brief set whether vcf/bcf output should include recombination
+   * rate as INFO/CM_RATE
+   * \param use_rate whether vcf/bcf output should include INFO/CM_RATE
+   */
+  void set_output_cm_rate(bool use_rate);
+  /*!
+   * \brief get whether vcf/bcf output includes INFO/CM_RATE
+   * \return whether vcf/bcf output includes INFO/CM_RATE
+   */
+  bool get_output_cm_rate() const;
+  /*!
+   * \brief set whether bigwig output should be the recombination rate
+   * track instead of genetic position
+   * \param use_rate whether bigwig output should be the rate track
+   */
+  void set_output_bigwig_rate(bool use_rate);
+  /*!
+   * \brief get whether bigwig output is the recombination rate track
+   * \return whether bigwig output is the rate track
+   */
+  bool get_output_bigwig_rate() const;
+  /*!
+   * \brief set whether each chromosome is written to its own file
+   * \param per_chromosome whether each chromosome is written to its
+   * own file, in which case output file names are prefixes
+   *
+   * See output_variant_file::output_per_chromosome().
+   */
+  void set_output_per_chromosome(bool per_chromosome);
+  /*!
+   * \brief get whether each chromosome is written to its own file
+   * \return whether each chromosome is written to its own file
+   */
+  bool get_output_per_chromosome() const;
+  /*!
+   * \brief set whether genetic maps are read with a sidecar index that
+   * lets sparse queries skip over the map rows between them
+   * \param use_index whether genetic maps are read with an index
+   *
+   * See input_genetic_map_file::set_use_index(). Results are identical
+   * either way.
+   */
+  void set_map_index(bool use_index);
+  /*!
+   * \brief get whether genetic maps are read with a sidecar index
+   * \return whether genetic maps are read with a sidecar index
+   */
+  bool get_map_index() const;
+  /*!
+   * \brief set number of threads available to htslib
+   * \param n_threads number of threads available to htslib, for each
+   * of vcf/bcf input decompression and output compression; also the
+   * number of bigwig map chromosomes decoded at once, if above 1
+   */
+  void set_threads(unsigned n_threads);
+  /*!
+   * \brief get number of threads available to htslib
+   * \return number of threads available to htslib
+   */
+  unsigned get_threads() const;
+
+ private:
+  /*!
+   * \brief create the reader of a genetic map
+   * \param map_ft format of genetic map
+   * \return newly allocated reader, owned by the caller
+   */
+  base_input_genetic_map_file *new_genetic_map_interface(
+      format_type map_ft) const;
+  /*!
+   * \brief interpolate one query file against opened genetic maps
+   * \param input_filename name of input variant query file
+   * \param query_ft format of input query file
+   * \param gms pointers to opened genetic maps, positioned at their start
+   * \param output_filenames names of output results files
+   * \param output_fts formats of output results files
+   * \param output_maps index in gms of the map reported by each output
+   * \param output_morgans whether genetic position should be output
+   * in morgans
+   * \param step_interval genetic distance added between bed regions
+   * \param fixed_output_width number of digits after decimal, or 0
+   * \param verbose whether to emit (extremely) verbose logging
+   */
+  void interpolate_query_file(const std::string &input_filename,
+                              format_type query_ft,
+                              const std::vector<genetic_map *> &gms,
+                              const std::vector<std::string> &output_filenames,
+                              const std::vector<format_type> &output_fts,
+                              const std::vector<unsigned> &output_maps,
+                              bool output_morgans, const double &step_interval,
+                              unsigned fixed_output_width,
+                              bool verbose) const;
+  /*!
+   * \brief process all queries in batches on the calling thread
+   * \param qfs pointers to query files, one per output; the first reads
+   * the input, and the others share it
+   * \param gms pointers to opened genetic maps
+   * \param output_maps index in gms of the map reported by each output
+   * \param sweep_regions whether to stream each query's segments to
+   * output as they are interpolated, rather than collecting them first;
+   * requires one map per output
+   * \param verbose whether to emit (extremely) verbose logging
+   */
+  void run_sequential(const std::vector<query_file *> &qfs,
+                      const std::vector<genetic_map *> &gms,
+                      const std::vector<unsigned> &output_maps,
+                      bool sweep_regions, bool verbose) const;
+  /*!
+   * \brief process all queries in batches with a reader thread, an
+   * interpolation thread and one writer thread per output, connected by
+   * ring buffers
+   * \param qfs pointers to query files, one per output; the first reads
+   * the input, and the others share it
+   * \param gms pointers to opened genetic maps
+   * \param output_maps index in gms of the map reported by each output
+   * \param sweep_regions whether to stream each query's segments to
+   * output as they are interpolated; if so, interpolation moves to
+   * the writer threads, and one map per output is required
+   * \param verbose whether to emit (extremely) verbose logging
+   */
+  void run_pipelined(const std::vector<query_file *> &qfs,
+                     const std::vector<genetic_map *> &gms,
+                     const std::vector<unsigned> &output_maps,
+                     bool sweep_regions, bool verbose) const;
+  bool _pipelined;       //!< whether to run stages on dedicated threads
+  bool _output_cm_rate;  //!< whether vcf/bcf output includes INFO/CM_RATE
+  bool _output_bigwig_rate;  //!< whether bigwig output is the rate track
+  bool _output_per_chromosome;  //!< whether each chromosome has a file
+  bool _map_index;       //!< whether genetic maps are read with an index
+  unsigned _threads;     //!< number of threads available to htslib
+  unsigned _jobs;        //!< number of input files processed at once
 };
 }  // namespace interpolate_genetic_position
 
@@ -17,8 +17,11 @@
 #include <utility>
 #include <vector>
 
+#include "boost/filesystem.hpp"
 #include "interpolate-genetic-position/cargs.h"
+#include "interpolate-genetic-position/gmp_arena.h"
 #include "interpolate-genetic-position/interpolator.h"
+#include "interpolate-genetic-position/memory_profiler.h"
 
 namespace igp = interpolate_genetic_position;
 
@@ -42,32 +45,172 @@ int main(int argc, const char** const argv) {
     return 0;
   }
 
+  // GMP memory functions must be swapped before any GMP objects exist.
+  // the profiler wraps whatever is installed, so the arena goes first.
+  if (!ap.disable_gmp_arena()) {
+    igp::gmp_arena::install();
+  }
+  bool profile_memory = ap.profile_memory();
+  if (profile_memory) {
+    igp::memory_profiler::enable();
+  }
+
   mpf_set_default_prec(ap.get_mpf_precision());
 
-  std::string input = ap.get_input_filename();
+  std::vector<std::string> inputs = ap.get_input_filenames();
+  std::string input_list = ap.get_input_list();
+  if (!input_list.empty()) {
+    std::vector<std::string> listed = igp::read_filename_list(input_list);
+    inputs.insert(inputs.end(), listed.begin(), listed.end());
+  }
+  // several inputs, or any list of them, are processed against one
+  // load of the map, with -o naming a directory
+  bool several_inputs = inputs.size() > 1 || !input_list.empty();
+  std::string input = inputs.empty() ? "" : inputs.at(0);
   std::string preset = ap.get_input_preset();
-  std::string genetic_map = ap.get_recombination_map();
-  std::string map_format = ap.get_map_format();
+  std::vector<std::string> genetic_maps = ap.get_recombination_maps();
+  std::vector<std::string> map_formats = ap.get_map_formats();
+  if (genetic_maps.empty()) {
+    // no -g means a single map read from stdin
+    genetic_maps.push_back("");
+  }
+  // a single map format applies to every map
+  if (map_formats.size() == 1) {
+    map_formats.resize(genetic_maps.size(), map_formats.at(0));
+  }
+  if (map_formats.size() != genetic_maps.size()) {
+    throw std::runtime_error(
+        "-m must be given either once, or once per -g genetic map");
+  }
+  bool several_maps = genetic_maps.size() > 1;
+  std::string genetic_map = genetic_maps.at(0);
+  std::string map_format = map_formats.at(0);
+  std::vector<std::string> output_filenames = ap.get_output_filenames();
+  std::vector<std::string> output_formats = ap.get_output_formats();
+  // several -f fan the same results out to several -o, paired in order
+  bool several_formats = output_formats.size() > 1;
+  if (several_formats && output_filenames.size() != output_formats.size()) {
+    throw std::runtime_error("-o must be given once per -f output format");
+  }
+  if (!several_formats && output_filenames.size() > 1) {
+    throw std::runtime_error(
+        "-f must be given once per -o output file, when there are several");
+  }
   std::string output = ap.get_output_filename();
-  std::string output_format = ap.get_output_format();
+  // with output per chromosome, the prefix takes the place of -o
+  std::string chromosome_prefix = ap.get_output_per_chromosome();
+  bool per_chromosome = !chromosome_prefix.empty();
+  if (per_chromosome) {
+    if (!output_filenames.empty()) {
+      throw std::runtime_error(
+          "--output-per-chromosome cannot be combined with -o");
+    }
+    if (several_inputs || several_maps || several_formats) {
+      throw std::runtime_error(
+          "--output-per-chromosome needs a single input file, genetic map "
+          "and output format");
+    }
+    output = chromosome_prefix;
+  }
+  std::string output_format = output_formats.at(0);
   bool verbose = ap.verbose();
   bool output_morgans = ap.output_morgans();
   double step_interval = ap.get_region_step_interval();
   unsigned fixed_output_width = ap.get_fixed_output_width();
-  if (input.empty() && genetic_map.empty()) {
+  if (several_formats && (several_inputs || several_maps)) {
+    throw std::runtime_error(
+        "several output formats cannot be combined with several input files "
+        "or several genetic maps");
+  }
+  if (several_inputs && several_maps) {
+    throw std::runtime_error(
+        "several input files cannot be combined with several genetic maps");
+  }
+  if (several_maps && output.empty()) {
+    throw std::runtime_error(
+        "with several genetic maps, -o must name an output file");
+  }
+  if (several_inputs && output.empty()) {
+    throw std::runtime_error(
+        "with several input files, -o must name an output directory");
+  }
+  if (!several_inputs && !several_maps && input.empty() &&
+      genetic_map.empty()) {
     throw std::runtime_error("only one of -i and -g can be read from stdin");
   }
-  igp::check_io_combinations(preset, output_format);
+  bool any_bigwig_output = false, any_pvar_output = false;
+  for (unsigned i = 0; i < output_formats.size(); ++i) {
+    igp::check_io_combinations(preset, output_formats.at(i));
+    igp::format_type ft = igp::string_to_format_type(output_formats.at(i));
+    any_bigwig_output = any_bigwig_output || ft == igp::BIGWIG;
+    any_pvar_output = any_pvar_output || ft == igp::PVAR;
+  }
   if (igp::string_to_format_type(preset) != igp::BED &&
       fabs(step_interval) > DBL_EPSILON) {
     std::cerr << "warning: step interval parameter is only respected "
               << "with bedfile (range) input" << std::endl;
     step_interval = 0.0;
   }
+  if (!any_bigwig_output && ap.output_bigwig_rate()) {
+    std::cerr << "warning: --bigwig-rate-track is only respected "
+              << "with bigwig output" << std::endl;
+  }
+  if (any_pvar_output && output_morgans && several_formats) {
+    throw std::runtime_error(
+        "pvar CM columns are always in centimorgans, so --output-morgans "
+        "cannot be combined with pvar among several outputs");
+  }
+  if (any_pvar_output && output_morgans) {
+    std::cerr << "warning: pvar CM columns are always in centimorgans; "
+              << "--output-morgans is ignored" << std::endl;
+    output_morgans = false;
+  }
 
   igp::interpolator ip;
-  ip.interpolate(input, preset, genetic_map, map_format, output, output_format,
-                 output_morgans, step_interval, fixed_output_width, verbose);
+  ip.set_pipelined(ap.pipeline());
+  ip.set_output_cm_rate(ap.output_cm_rate());
+  ip.set_output_bigwig_rate(ap.output_bigwig_rate());
+  ip.set_output_per_chromosome(per_chromosome);
+  ip.set_map_index(ap.map_index());
+  ip.set_threads(ap.get_threads());
+  ip.set_jobs(ap.get_jobs());
+  if (several_inputs) {
+    boost::filesystem::create_directories(output);
+    std::vector<std::string> outputs;
+    for (unsigned i = 0; i < inputs.size(); ++i) {
+      outputs.push_back(
+          igp::derive_output_filename(inputs.at(i), output, output_format));
+    }
+    ip.interpolate_files(inputs, preset, genetic_map, map_format, outputs,
+                         output_format, output_morgans, step_interval,
+                         fixed_output_width, verbose);
+  } else if (several_formats) {
+    ip.interpolate_outputs(input, preset, genetic_map, map_format,
+                           output_filenames, output_formats, output_morgans,
+                           step_interval, fixed_output_width, verbose);
+  } else if (several_maps) {
+    // each map writes its own output, named after the map
+    std::vector<std::string> outputs;
+    for (unsigned i = 0; i < genetic_maps.size(); ++i) {
+      outputs.push_back(
+          igp::derive_map_output_filename(output, genetic_maps.at(i)));
+    }
+    ip.interpolate_maps(input, preset, genetic_maps, map_formats, outputs,
+                        output_format, output_morgans, step_interval,
+                        fixed_output_width, verbose);
+  } else {
+    ip.interpolate(input, preset, genetic_map, map_format, output,
+                   output_format, output_morgans, step_interval,
+                   fixed_output_width, verbose);
+  }
+
+  if (profile_memory) {
+    igp::memory_profiler::report(std::cerr);
+    if (igp::gmp_arena::installed()) {
+      igp::gmp_arena::report(std::cerr);
+    }
+    igp::memory_profiler::disable();
+  }
 
   if (verbose) {
     std::cout << "all done woo!" << std::endl;
@@ -0,0 +1,87 @@
+/*!
+ \file map_block.cc
+ \brief implementation of contiguous genetic map block
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/map_block.h"
+
+namespace igp = interpolate_genetic_position;
+
+igp::map_block::map_block() : _size(0), _chr("") {}
+igp::map_block::~map_block() throw() {}
+void igp::map_block::clear() {
+  _size = 0;
+  _chr.clear();
+}
+unsigned igp::map_block::size() const { return _size; }
+bool igp::map_block::empty() const { return !_size; }
+void igp::map_block::append(const std::string &chr, const mpz_class &startpos,
+                            const mpz_class &endpos, const mpf_class &gpos,
+                            const mpf_class &rate) {
+  if (!_size) {
+    _chr = chr;
+  } else if (_chr.compare(chr)) {
+    throw std::runtime_error("map_block::append: block for chromosome \"" +
+                             _chr + "\" cannot hold row from \"" + chr + "\"");
+  }
+  if (_size == _startpos.size()) {
+    _startpos.push_back(startpos);
+    _endpos.push_back(endpos);
+    _gpos.push_back(gpos);
+    _rate.push_back(rate);
+  } else {
+    _startpos.at(_size) = startpos;
+    _endpos.at(_size) = endpos;
+    _gpos.at(_size) = gpos;
+    _rate.at(_size) = rate;
+  }
+  ++_size;
+}
+const std::string &igp::map_block::get_chr() const { return _chr; }
+void igp::map_block::check_index(unsigned i) const {
+  if (i >= _size) {
+    throw std::runtime_error("map_block: row index out of range");
+  }
+}
+const mpz_class &igp::map_block::get_startpos(unsigned i) const {
+  check_index(i);
+  return _startpos.at(i);
+}
+const mpz_class &igp::map_block::get_endpos(unsigned i) const {
+  check_index(i);
+  return _endpos.at(i);
+}
+const mpf_class &igp::map_block::get_gpos(unsigned i) const {
+  check_index(i);
+  return _gpos.at(i);
+}
+const mpf_class &igp::map_block::get_rate(unsigned i) const {
+  check_index(i);
+  return _rate.at(i);
+}
+unsigned igp::map_block::upper_bound(const mpz_class &pos) const {
+  unsigned lower = 0, upper = _size;
+  while (lower < upper) {
+    unsigned middle = lower + (upper - lower) / 2;
+    if (cmp(_startpos[middle], pos) <= 0) {
+      lower = middle + 1;
+    } else {
+      upper = middle;
+    }
+  }
+  return lower;
+}
+void igp::map_block::upper_bounds(const std::vector<mpz_class> &positions,
+                                  std::vector<unsigned> *results) const {
+  results->resize(positions.size());
+  unsigned row = 0;
+  for (unsigned i = 0; i < positions.size(); ++i) {
+    while (row < _size && cmp(_startpos[row], positions[i]) <= 0) {
+      ++row;
+    }
+    results->at(i) = row;
+  }
+}
@@ -0,0 +1,132 @@
+/*!
+ \file map_block.h
+ \brief contiguous run of genetic map breakpoints from one chromosome
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_MAP_BLOCK_H_
+#define INTERPOLATE_GENETIC_POSITION_MAP_BLOCK_H_
+
+#include <gmpxx.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace interpolate_genetic_position {
+/*!
+ * \class map_block
+ * \brief a segment of consecutive genetic map rows, all from the same
+ * chromosome, stored as parallel arrays.
+ *
+ * Each row holds the values that input_genetic_map_file reports for a
+ * single map entry: 1-based start position, end position (or -1 for
+ * formats without one), genetic position in cM, and rate in cM/Mb.
+ * Blocks are recycled: clear() keeps allocated storage, so refilling a
+ * block overwrites existing GMP values in place.
+ */
+class map_block {
+ public:
+  /*!
+   * \brief default constructor
+   */
+  map_block();
+  /*!
+   * \brief destructor
+   */
+  ~map_block() throw();
+  /*!
+   * \brief remove all rows, retaining allocated storage
+   */
+  void clear();
+  /*!
+   * \brief get the number of rows in the block
+   * \return the number of rows in the block
+   */
+  unsigned size() const;
+  /*!
+   * \brief determine whether the block holds no rows
+   * \return whether the block holds no rows
+   */
+  bool empty() const;
+  /*!
+   * \brief add a row to the end of the block
+   * \param chr chromosome of row; must match any rows already present
+   * \param startpos start position of row
+   * \param endpos end position of row, or -1 if not applicable
+   * \param gpos genetic position of row
+   * \param rate recombination rate of row
+   *
+   * Rows are expected in increasing start position order; this is
+   * not checked here, as it is enforced where map data are consumed.
+   */
+  void append(const std::string &chr, const mpz_class &startpos,
+              const mpz_class &endpos, const mpf_class &gpos,
+              const mpf_class &rate);
+  /*!
+   * \brief get chromosome shared by all rows
+   * \return chromosome shared by all rows, or empty string if empty
+   */
+  const std::string &get_chr() const;
+  /*!
+   * \brief get start position of a row
+   * \param i index of row
+   * \return start position of row
+   */
+  const mpz_class &get_startpos(unsigned i) const;
+  /*!
+   * \brief get end position of a row
+   * \param i index of row
+   * \return end position of row, or -1 if not applicable
+   */
+  const mpz_class &get_endpos(unsigned i) const;
+  /*!
+   * \brief get genetic position of a row
+   * \param i index of row
+   * \return genetic position of row
+   */
+  const mpf_class &get_gpos(unsigned i) const;
+  /*!
+   * \brief get recombination rate of a row
+   * \param i index of row
+   * \return recombination rate of row
+   */
+  const mpf_class &get_rate(unsigned i) const;
+  /*!
+   * \brief count the rows starting at or before a physical position
+   * \param pos query physical position
+   * \return number of rows with start position <= pos. the interval
+   * containing pos, if any, begins at the row before this index
+   *
+   * Binary search over the start position array.
+   */
+  unsigned upper_bound(const mpz_class &pos) const;
+  /*!
+   * \brief find upper_bound() for each of a sorted set of positions
+   * \param positions query physical positions, in nondecreasing order
+   * \param results pointer to storage for results, one per position
+   *
+   * Single merge pass over the block and the queries, for when a batch
+   * of sorted queries falls within the same block.
+   */
+  void upper_bounds(const std::vector<mpz_class> &positions,
+                    std::vector<unsigned> *results) const;
+
+ private:
+  /*!
+   * \brief throw if a row index is out of range
+   * \param i index of row
+   */
+  void check_index(unsigned i) const;
+  unsigned _size;                    //!< number of rows in block
+  std::string _chr;                  //!< chromosome shared by all rows
+  std::vector<mpz_class> _startpos;  //!< per-row start position
+  std::vector<mpz_class> _endpos;    //!< per-row end position
+  std::vector<mpf_class> _gpos;      //!< per-row genetic position
+  std::vector<mpf_class> _rate;      //!< per-row recombination rate
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_MAP_BLOCK_H_
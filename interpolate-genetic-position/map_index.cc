@@ -0,0 +1,270 @@
+/*!
+ \file map_index.cc
+ \brief implementation of genetic map sidecar index
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/map_index.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+/*!
+ * \brief write a value to a binary stream in native byte order
+ * \param out output stream
+ * \param value value to write
+ */
+template <class value_type>
+void write_value(std::ostream &out, const value_type &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value_type));
+}
+/*!
+ * \brief read an array from a binary stream in native byte order
+ * \param in input stream
+ * \param n number of values to read
+ * \param values pointer to array to fill
+ * \return whether all values were read
+ */
+template <class value_type>
+bool read_array(std::istream &in, size_t n, std::vector<value_type> *values) {
+  values->resize(n);
+  in.read(reinterpret_cast<char *>(values->data()),
+          static_cast<std::streamsize>(n * sizeof(value_type)));
+  return static_cast<bool>(in);
+}
+/*!
+ * \brief leading bytes of a map index
+ */
+const char index_magic[8] = {'i', 'g', 'p', 'i', 'n', 'd', 'e', 'x'};
+/*!
+ * \brief version of map index layout
+ */
+const int64_t index_version = 2;
+/*!
+ * \brief marker to reject indices written with another byte order
+ */
+const int64_t index_byte_order = 0x0102030405060708;
+/*!
+ * \brief number of fixed-width values stored per checkpoint
+ */
+const size_t checkpoint_values = 6;
+/*!
+ * \brief number of fixed-width values stored per access point
+ */
+const size_t access_point_values = 4;
+/*!
+ * \brief longest window an access point can carry
+ */
+const int64_t max_window = 32768;
+}  // namespace
+
+igp::map_index::map_index() : _next(0) {}
+igp::map_index::map_index(const map_index &obj) : _next(0) {
+  throw std::runtime_error(
+      "map_index: copy constructor operation is invalid for this class");
+}
+igp::map_index::~map_index() throw() {}
+std::string igp::map_index::sidecar_filename(const std::string &map_filename) {
+  return map_filename + ".igpindex";
+}
+std::vector<int64_t> igp::map_index::identify(const std::string &map_filename,
+                                              format_type ft,
+                                              unsigned rows_per_checkpoint) {
+  std::vector<int64_t> header;
+  struct stat info;
+  if (map_filename.empty() || stat(map_filename.c_str(), &info) ||
+      !S_ISREG(info.st_mode)) {
+    return header;
+  }
+  header.push_back(static_cast<int64_t>(ft));
+  header.push_back(static_cast<int64_t>(info.st_size));
+  header.push_back(static_cast<int64_t>(info.st_mtime));
+  header.push_back(static_cast<int64_t>(mpf_get_default_prec()));
+  header.push_back(static_cast<int64_t>(GMP_NUMB_BITS));
+  header.push_back(static_cast<int64_t>(rows_per_checkpoint));
+  return header;
+}
+void igp::map_index::clear() {
+  _checkpoints.clear();
+  _next = 0;
+  _access_points.clear();
+}
+bool igp::map_index::empty() const { return _checkpoints.empty(); }
+size_t igp::map_index::size() const { return _checkpoints.size(); }
+void igp::map_index::add(const std::string &chr, const mpz_class &startpos,
+                         uint64_t row, uint64_t locator,
+                         const mpf_class &gpos) {
+  // unrecognized names share a code, matching chromosome_compare
+  int code = 0;
+  chromosome_to_integer(chr, &code);
+  _checkpoints.push_back({code, startpos.get_si(), row, locator, gpos});
+}
+const igp::map_index::checkpoint &igp::map_index::at(size_t i) const {
+  return _checkpoints.at(i);
+}
+const igp::map_index::checkpoint *igp::map_index::find(
+    const std::string &chr, const mpz_class &pos) {
+  int code = 0;
+  chromosome_to_integer(chr, &code);
+  const checkpoint *res = NULL;
+  while (_next < _checkpoints.size()) {
+    const checkpoint &candidate = _checkpoints[_next];
+    if (candidate.chr > code ||
+        (candidate.chr == code && cmp(pos, candidate.startpos) < 0)) {
+      break;
+    }
+    if (candidate.chr == code) {
+      res = &candidate;
+    }
+    ++_next;
+  }
+  return res;
+}
+void igp::map_index::set_access_points(
+    const std::vector<seekable_gzip_reader::access_point> &points) {
+  _access_points = points;
+}
+const std::vector<igp::seekable_gzip_reader::access_point> &
+igp::map_index::get_access_points() const {
+  return _access_points;
+}
+bool igp::map_index::save(const std::string &filename,
+                          const std::vector<int64_t> &header) const {
+  // written in full under a temporary name, so readers never see a
+  // partial index
+  std::string tmp_filename = filename + ".tmp";
+  std::ofstream output(tmp_filename.c_str(), std::ios::binary);
+  if (!output.is_open()) {
+    return false;
+  }
+  output.write(index_magic, sizeof(index_magic));
+  write_value(output, index_version);
+  write_value(output, index_byte_order);
+  for (unsigned i = 0; i < header.size(); ++i) {
+    write_value(output, header.at(i));
+  }
+  write_value(output, static_cast<int64_t>(_checkpoints.size()));
+  for (size_t i = 0; i < _checkpoints.size(); ++i) {
+    const checkpoint &entry = _checkpoints[i];
+    // genetic positions are stored as their raw limbs, as no string
+    // conversion reproduces every bit of the value
+    const __mpf_struct *gpos = entry.gpos.get_mpf_t();
+    write_value(output, static_cast<int64_t>(entry.chr));
+    write_value(output, entry.startpos);
+    write_value(output, static_cast<int64_t>(entry.row));
+    write_value(output, static_cast<int64_t>(entry.locator));
+    write_value(output, static_cast<int64_t>(gpos->_mp_size));
+    write_value(output, static_cast<int64_t>(gpos->_mp_exp));
+    output.write(reinterpret_cast<const char *>(gpos->_mp_d),
+                 static_cast<std::streamsize>(std::abs(gpos->_mp_size) *
+                                              sizeof(mp_limb_t)));
+  }
+  write_value(output, static_cast<int64_t>(_access_points.size()));
+  for (size_t i = 0; i < _access_points.size(); ++i) {
+    const seekable_gzip_reader::access_point &point = _access_points[i];
+    write_value(output, static_cast<int64_t>(point.out));
+    write_value(output, static_cast<int64_t>(point.in));
+    write_value(output, static_cast<int64_t>(point.bits));
+    write_value(output, static_cast<int64_t>(point.window.size()));
+    output.write(reinterpret_cast<const char *>(point.window.data()),
+                 static_cast<std::streamsize>(point.window.size()));
+  }
+  output.close();
+  if (!output || std::rename(tmp_filename.c_str(), filename.c_str())) {
+    std::remove(tmp_filename.c_str());
+    return false;
+  }
+  return true;
+}
+bool igp::map_index::restore(const std::string &filename,
+                             const std::vector<int64_t> &header) {
+  std::ifstream input(filename.c_str(), std::ios::binary);
+  if (!input.is_open()) {
+    return false;
+  }
+  char magic[sizeof(index_magic)];
+  std::vector<int64_t> expected, observed;
+  expected.push_back(index_version);
+  expected.push_back(index_byte_order);
+  expected.insert(expected.end(), header.begin(), header.end());
+  input.read(magic, sizeof(magic));
+  if (!input || !std::equal(magic, magic + sizeof(magic), index_magic) ||
+      !read_array(input, expected.size(), &observed) ||
+      observed != expected) {
+    return false;
+  }
+  // the file size bounds the counts a truncated or damaged index can
+  // claim
+  input.seekg(0, std::ios::end);
+  int64_t remaining = static_cast<int64_t>(input.tellg());
+  input.seekg(static_cast<std::streamoff>(sizeof(magic) +
+                                          expected.size() * sizeof(int64_t)));
+  std::vector<int64_t> count;
+  if (!read_array(input, 1, &count) || count.at(0) < 0 ||
+      count.at(0) >
+          remaining / static_cast<int64_t>(checkpoint_values *
+                                           sizeof(int64_t))) {
+    return false;
+  }
+  // limbs beyond the working precision could not have been written by
+  // a run at this precision
+  int64_t max_limbs = static_cast<int64_t>(mpf_get_default_prec() /
+                                               GMP_NUMB_BITS +
+                                           2);
+  std::vector<checkpoint> checkpoints;
+  checkpoints.reserve(static_cast<size_t>(count.at(0)));
+  std::vector<int64_t> values;
+  std::vector<mp_limb_t> limbs;
+  for (int64_t i = 0; i < count.at(0); ++i) {
+    if (!read_array(input, checkpoint_values, &values) ||
+        std::abs(values.at(4)) > max_limbs ||
+        !read_array(input, static_cast<size_t>(std::abs(values.at(4))),
+                    &limbs)) {
+      return false;
+    }
+    checkpoint entry = {static_cast<int>(values.at(0)), values.at(1),
+                        static_cast<uint64_t>(values.at(2)),
+                        static_cast<uint64_t>(values.at(3)), mpf_class()};
+    // a read-only view of the stored limbs is copied into place
+    __mpf_struct view;
+    view._mp_prec = static_cast<int>(limbs.size());
+    view._mp_size = static_cast<int>(values.at(4));
+    view._mp_exp = static_cast<mp_exp_t>(values.at(5));
+    view._mp_d = limbs.data();
+    mpf_set(entry.gpos.get_mpf_t(), &view);
+    checkpoints.push_back(entry);
+  }
+  if (!read_array(input, 1, &count) || count.at(0) < 0 ||
+      count.at(0) >
+          remaining / static_cast<int64_t>(access_point_values *
+                                           sizeof(int64_t))) {
+    return false;
+  }
+  std::vector<seekable_gzip_reader::access_point> access_points(
+      static_cast<size_t>(count.at(0)));
+  for (size_t i = 0; i < access_points.size(); ++i) {
+    seekable_gzip_reader::access_point &point = access_points[i];
+    if (!read_array(input, access_point_values, &values) ||
+        values.at(2) < 0 || values.at(2) > 7 || values.at(3) < 0 ||
+        values.at(3) > max_window ||
+        !read_array(input, static_cast<size_t>(values.at(3)), &point.window)) {
+      return false;
+    }
+    point.out = static_cast<uint64_t>(values.at(0));
+    point.in = static_cast<uint64_t>(values.at(1));
+    point.bits = static_cast<int>(values.at(2));
+  }
+  _checkpoints.swap(checkpoints);
+  _access_points.swap(access_points);
+  _next = 0;
+  return true;
+}
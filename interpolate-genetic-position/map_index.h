@@ -0,0 +1,171 @@
+/*!
+ \file map_index.h
+ \brief sidecar index of checkpoint rows in a genetic map file
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_MAP_INDEX_H_
+#define INTERPOLATE_GENETIC_POSITION_MAP_INDEX_H_
+
+#include <gmpxx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "interpolate-genetic-position/seekable_gzip_reader.h"
+#include "interpolate-genetic-position/utilities.h"
+
+namespace interpolate_genetic_position {
+/*!
+ * \class map_index
+ * \brief positions of checkpoint rows of a genetic map, so that a map
+ * reader can jump over the rows between sparse queries.
+ *
+ * A checkpoint is kept at the first row of each chromosome and at every
+ * so many rows after that. Each records where its row starts in the map
+ * file, along with the row's genetic position, which rate-only maps can
+ * otherwise only obtain by summing every row before it. Genetic
+ * positions are stored exactly as computed, limb for limb, and so an
+ * index only matches runs at the floating point precision it was built
+ * with.
+ *
+ * Chromosomes are matched by their numeric code, as elsewhere in this
+ * program.
+ *
+ * For gzip maps, locators are offsets in the decompressed text, and the
+ * index also carries the access points from which decompression can
+ * restart partway through the file.
+ */
+class map_index {
+ public:
+  /*!
+   * \struct checkpoint
+   * \brief location and contents of one checkpoint row
+   */
+  struct checkpoint {
+    int chr;           //!< numeric code of row chromosome
+    int64_t startpos;  //!< start physical position of row
+    uint64_t row;      //!< index of row in map, counting from 0
+    uint64_t locator;  //!< where the row starts, in terms of the reader
+    mpf_class gpos;    //!< genetic position of row
+  };
+  /*!
+   * \brief default constructor
+   */
+  map_index();
+  /*!
+   * \brief copy constructor
+   * \param obj existing map_index
+   *
+   * Copy constructor is disabled, as indices hold reader state.
+   */
+  map_index(const map_index &obj);
+  /*!
+   * \brief destructor
+   */
+  ~map_index() throw();
+  /*!
+   * \brief get the name of the index file kept next to a map file
+   * \param map_filename name of map file
+   * \return name of index file
+   */
+  static std::string sidecar_filename(const std::string &map_filename);
+  /*!
+   * \brief describe a map file and index layout, for matching an index
+   * file against the map it was built from
+   * \param map_filename name of map file
+   * \param ft format of map file
+   * \param rows_per_checkpoint rows between checkpoints on a chromosome
+   * \return format, size and modification time of the map file, with the
+   * floating point precision and checkpoint spacing; empty if the map is
+   * not a regular file
+   */
+  static std::vector<int64_t> identify(const std::string &map_filename,
+                                       format_type ft,
+                                       unsigned rows_per_checkpoint);
+  /*!
+   * \brief remove all checkpoints and access points
+   */
+  void clear();
+  /*!
+   * \brief determine whether there are any checkpoints
+   * \return whether there are any checkpoints
+   */
+  bool empty() const;
+  /*!
+   * \brief get the number of checkpoints
+   * \return the number of checkpoints
+   */
+  size_t size() const;
+  /*!
+   * \brief add a checkpoint after all existing ones
+   * \param chr chromosome of row
+   * \param startpos start physical position of row
+   * \param row index of row in map
+   * \param locator where the row starts, in terms of the reader
+   * \param gpos genetic position of row
+   */
+  void add(const std::string &chr, const mpz_class &startpos, uint64_t row,
+           uint64_t locator, const mpf_class &gpos);
+  /*!
+   * \brief get a checkpoint
+   * \param i index of checkpoint
+   * \return checkpoint at index
+   */
+  const checkpoint &at(size_t i) const;
+  /*!
+   * \brief find the last checkpoint at or before a query
+   * \param chr chromosome of query
+   * \param pos physical position of query
+   * \return the last checkpoint on the query chromosome starting at or
+   * before the query position, or NULL if there is none past those
+   * returned for earlier queries
+   *
+   * Queries are expected in sorted order, as the search resumes where
+   * the previous one left off. Checkpoints on other chromosomes are only
+   * passed over while they sort before the query chromosome.
+   */
+  const checkpoint *find(const std::string &chr, const mpz_class &pos);
+  /*!
+   * \brief set the gzip access points of the map
+   * \param points access points, in file order
+   */
+  void set_access_points(
+      const std::vector<seekable_gzip_reader::access_point> &points);
+  /*!
+   * \brief get the gzip access points of the map
+   * \return access points, in file order; empty unless the map is gzipped
+   */
+  const std::vector<seekable_gzip_reader::access_point> &get_access_points()
+      const;
+  /*!
+   * \brief write the checkpoints and access points to an index file
+   * \param filename name of index file
+   * \param header identity of the map file, from identify()
+   * \return whether the index was written
+   */
+  bool save(const std::string &filename,
+            const std::vector<int64_t> &header) const;
+  /*!
+   * \brief load the checkpoints and access points from an index file
+   * \param filename name of index file
+   * \param header identity the map file must match, from identify()
+   * \return whether the index matched and was loaded
+   */
+  bool restore(const std::string &filename,
+               const std::vector<int64_t> &header);
+
+ private:
+  std::vector<checkpoint> _checkpoints;  //!< checkpoints in file order
+  size_t _next;  //!< first checkpoint not yet passed by find()
+  std::vector<seekable_gzip_reader::access_point>
+      _access_points;  //!< gzip access points in file order
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_MAP_INDEX_H_
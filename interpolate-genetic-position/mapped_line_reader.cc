@@ -0,0 +1,86 @@
+/*!
+ \file mapped_line_reader.cc
+ \brief implementation of memory-mapped line reader
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/mapped_line_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace igp = interpolate_genetic_position;
+
+igp::mapped_line_reader::mapped_line_reader()
+    : _data(NULL), _size(0), _pos(0), _open(false) {}
+igp::mapped_line_reader::mapped_line_reader(const mapped_line_reader &obj) {
+  throw std::runtime_error(
+      "mapped_line_reader: copy constructor operation is invalid for this "
+      "class");
+}
+igp::mapped_line_reader::~mapped_line_reader() throw() { close(); }
+bool igp::mapped_line_reader::open(const std::string &filename) {
+  close();
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) || !S_ISREG(info.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+  _size = static_cast<size_t>(info.st_size);
+  // zero-length mappings are invalid, but an empty file is still readable
+  if (_size) {
+    void *mapping = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      ::close(fd);
+      _size = 0;
+      return false;
+    }
+    _data = static_cast<const char *>(mapping);
+    // these are only hints; failure is harmless
+    madvise(mapping, _size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    madvise(mapping, _size, MADV_HUGEPAGE);
+#endif
+  }
+  // the mapping holds its own reference to the file
+  ::close(fd);
+  _pos = 0;
+  _open = true;
+  return true;
+}
+void igp::mapped_line_reader::close() {
+  if (_data) {
+    munmap(const_cast<char *>(_data), _size);
+    _data = NULL;
+  }
+  _size = _pos = 0;
+  _open = false;
+}
+bool igp::mapped_line_reader::is_open() const { return _open; }
+bool igp::mapped_line_reader::getline(std::string_view *line) {
+  if (_pos >= _size) {
+    return false;
+  }
+  const char *start = _data + _pos;
+  const char *newline =
+      static_cast<const char *>(memchr(start, '\n', _size - _pos));
+  size_t length = newline ? static_cast<size_t>(newline - start) : _size - _pos;
+  *line = std::string_view(start, length);
+  _pos += newline ? length + 1 : length;
+  return true;
+}
+bool igp::mapped_line_reader::eof() const { return _pos >= _size; }
+size_t igp::mapped_line_reader::tell() const { return _pos; }
+void igp::mapped_line_reader::seek(size_t offset) {
+  _pos = offset < _size ? offset : _size;
+}
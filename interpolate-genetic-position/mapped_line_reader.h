@@ -0,0 +1,94 @@
+/*!
+ \file mapped_line_reader.h
+ \brief zero-copy line reader for memory-mapped uncompressed files
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_MAPPED_LINE_READER_H_
+#define INTERPOLATE_GENETIC_POSITION_MAPPED_LINE_READER_H_
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace interpolate_genetic_position {
+/*!
+ * \class mapped_line_reader
+ * \brief read newline-delimited text from a regular file by mapping
+ * it into memory, handing out lines as views into the mapping.
+ *
+ * Lines are never copied by the reader. The kernel is advised that
+ * the mapping will be read sequentially, so that readahead is
+ * aggressive and pages behind the read position can be dropped.
+ * Anything that cannot be mapped (pipes, terminals, special files) is
+ * refused by open(), so that callers can fall back to streaming.
+ */
+class mapped_line_reader {
+ public:
+  /*!
+   * \brief default constructor
+   */
+  mapped_line_reader();
+  /*!
+   * \brief copy constructor
+   *
+   * Copy constructor is disabled due to owned mapping.
+   */
+  mapped_line_reader(const mapped_line_reader &obj);
+  /*!
+   * \brief destructor
+   */
+  ~mapped_line_reader() throw();
+  /*!
+   * \brief map a file into memory
+   * \param filename name of file to map
+   * \return whether the file was mapped. false if the file cannot be
+   * opened, is not a regular file, or cannot be mapped
+   */
+  bool open(const std::string &filename);
+  /*!
+   * \brief release any mapped file
+   */
+  void close();
+  /*!
+   * \brief determine whether a file is mapped
+   * \return whether a file is mapped
+   */
+  bool is_open() const;
+  /*!
+   * \brief get the next line of the file
+   * \param line pointer to storage for a view of the line, without its
+   * newline. the view is valid until close()
+   * \return whether a line was read
+   */
+  bool getline(std::string_view *line);
+  /*!
+   * \brief determine whether all lines have been read
+   * \return whether all lines have been read
+   */
+  bool eof() const;
+  /*!
+   * \brief get the offset of the next line to be read
+   * \return offset of the next line, in bytes from the start of the file
+   */
+  size_t tell() const;
+  /*!
+   * \brief move to the start of a line
+   * \param offset offset of the line, as reported by tell()
+   *
+   * Offsets past the end of the file leave the reader at EOF.
+   */
+  void seek(size_t offset);
+
+ private:
+  const char *_data;  //!< start of mapping, or NULL for an empty file
+  size_t _size;       //!< length of mapped file, in bytes
+  size_t _pos;        //!< read position in mapping
+  bool _open;         //!< whether a file is mapped
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_MAPPED_LINE_READER_H_
@@ -0,0 +1,183 @@
+/*!
+ \file memory_profiler.cc
+ \brief implementation of allocation instrumentation
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/memory_profiler.h"
+
+#include <iomanip>
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+std::atomic<bool> profiler_enabled(false);
+std::atomic<unsigned long long> rows_processed(0);
+std::atomic<unsigned long long> new_allocations[igp::N_PROFILE_STAGES];
+std::atomic<unsigned long long> new_bytes[igp::N_PROFILE_STAGES];
+std::atomic<unsigned long long> gmp_allocations[igp::N_PROFILE_STAGES];
+std::atomic<unsigned long long> gmp_bytes[igp::N_PROFILE_STAGES];
+thread_local igp::profile_stage current_stage = igp::STAGE_SETUP;
+
+void *(*previous_gmp_alloc)(size_t) = NULL;
+void *(*previous_gmp_realloc)(void *, size_t, size_t) = NULL;
+void (*previous_gmp_free)(void *, size_t) = NULL;
+
+void *counting_gmp_alloc(size_t n) {
+  igp::memory_profiler::record_allocation(n, true);
+  return previous_gmp_alloc(n);
+}
+void *counting_gmp_realloc(void *ptr, size_t old_size, size_t new_size) {
+  igp::memory_profiler::record_allocation(new_size, true);
+  return previous_gmp_realloc(ptr, old_size, new_size);
+}
+void counting_gmp_free(void *ptr, size_t n) { previous_gmp_free(ptr, n); }
+}  // namespace
+
+std::string igp::profile_stage_to_string(profile_stage stage) {
+  if (stage == STAGE_SETUP) return "setup";
+  if (stage == STAGE_READ) return "read";
+  if (stage == STAGE_INTERPOLATE) return "interpolate";
+  if (stage == STAGE_WRITE) return "write";
+  throw std::runtime_error("profile_stage_to_string: unrecognized stage");
+}
+
+igp::memory_profiler::stage_guard::stage_guard(profile_stage stage)
+    : _previous(current_stage) {
+  current_stage = stage;
+}
+
+igp::memory_profiler::stage_guard::~stage_guard() throw() {
+  current_stage = _previous;
+}
+
+void igp::memory_profiler::enable() {
+  if (enabled()) return;
+  mp_get_memory_functions(&previous_gmp_alloc, &previous_gmp_realloc,
+                          &previous_gmp_free);
+  mp_set_memory_functions(counting_gmp_alloc, counting_gmp_realloc,
+                          counting_gmp_free);
+  reset();
+  profiler_enabled.store(true);
+}
+
+void igp::memory_profiler::disable() {
+  if (!enabled()) return;
+  profiler_enabled.store(false);
+  mp_set_memory_functions(previous_gmp_alloc, previous_gmp_realloc,
+                          previous_gmp_free);
+}
+
+bool igp::memory_profiler::enabled() {
+  return profiler_enabled.load(std::memory_order_relaxed);
+}
+
+void igp::memory_profiler::reset() {
+  rows_processed.store(0);
+  for (unsigned i = 0; i < N_PROFILE_STAGES; ++i) {
+    new_allocations[i].store(0);
+    new_bytes[i].store(0);
+    gmp_allocations[i].store(0);
+    gmp_bytes[i].store(0);
+  }
+}
+
+void igp::memory_profiler::record_row() {
+  if (enabled()) {
+    rows_processed.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void igp::memory_profiler::record_allocation(std::size_t bytes, bool gmp) {
+  if (!enabled()) return;
+  if (gmp) {
+    gmp_allocations[current_stage].fetch_add(1, std::memory_order_relaxed);
+    gmp_bytes[current_stage].fetch_add(bytes, std::memory_order_relaxed);
+  } else {
+    new_allocations[current_stage].fetch_add(1, std::memory_order_relaxed);
+    new_bytes[current_stage].fetch_add(bytes, std::memory_order_relaxed);
+  }
+}
+
+unsigned long long igp::memory_profiler::get_rows() {
+  return rows_processed.load();
+}
+
+unsigned long long igp::memory_profiler::get_allocations(profile_stage stage) {
+  return new_allocations[stage].load();
+}
+
+unsigned long long igp::memory_profiler::get_bytes(profile_stage stage) {
+  return new_bytes[stage].load();
+}
+
+unsigned long long igp::memory_profiler::get_gmp_allocations(
+    profile_stage stage) {
+  return gmp_allocations[stage].load();
+}
+
+unsigned long long igp::memory_profiler::get_gmp_bytes(profile_stage stage) {
+  return gmp_bytes[stage].load();
+}
+
+long igp::memory_profiler::get_peak_rss_kb() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) {
+    throw std::runtime_error("memory_profiler: getrusage failed");
+  }
+  // linux reports ru_maxrss in kilobytes
+  return usage.ru_maxrss;
+}
+
+igp::profile_stage igp::memory_profiler::get_current_stage() {
+  return current_stage;
+}
+
+void igp::memory_profiler::report(std::ostream &out) {
+  std::ios_base::fmtflags previous_flags = out.flags();
+  std::streamsize previous_precision = out.precision();
+  unsigned long long rows = get_rows();
+  unsigned long long total_allocations = 0, total_bytes = 0,
+                     total_gmp_allocations = 0, total_gmp_bytes = 0;
+  out << "memory profile: " << rows << " rows processed, peak RSS "
+      << get_peak_rss_kb() << " kB\n";
+  out << std::left << std::setw(12) << "stage" << std::right << std::setw(14)
+      << "new_allocs" << std::setw(16) << "new_bytes" << std::setw(14)
+      << "gmp_allocs" << std::setw(16) << "gmp_bytes" << std::setw(14)
+      << "allocs/row" << '\n';
+  for (unsigned i = 0; i <= N_PROFILE_STAGES; ++i) {
+    unsigned long long allocations = 0, bytes = 0, gmp_allocs = 0,
+                       gmp_allocated_bytes = 0;
+    std::string label = "total";
+    if (i < N_PROFILE_STAGES) {
+      profile_stage stage = static_cast<profile_stage>(i);
+      label = profile_stage_to_string(stage);
+      allocations = get_allocations(stage);
+      bytes = get_bytes(stage);
+      gmp_allocs = get_gmp_allocations(stage);
+      gmp_allocated_bytes = get_gmp_bytes(stage);
+      total_allocations += allocations;
+      total_bytes += bytes;
+      total_gmp_allocations += gmp_allocs;
+      total_gmp_bytes += gmp_allocated_bytes;
+    } else {
+      allocations = total_allocations;
+      bytes = total_bytes;
+      gmp_allocs = total_gmp_allocations;
+      gmp_allocated_bytes = total_gmp_bytes;
+    }
+    out << std::left << std::setw(12) << label << std::right << std::setw(14)
+        << allocations << std::setw(16) << bytes << std::setw(14)
+        << gmp_allocs << std::setw(16) << gmp_allocated_bytes << std::setw(14)
+        << std::fixed << std::setprecision(2)
+        << (rows ? static_cast<double>(allocations + gmp_allocs) /
+                       static_cast<double>(rows)
+                 : 0.0)
+        << '\n';
+  }
+  out.flags(previous_flags);
+  out.precision(previous_precision);
+  out.flush();
+}
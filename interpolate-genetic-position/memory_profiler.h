@@ -0,0 +1,151 @@
+/*!
+ \file memory_profiler.h
+ \brief diagnostic instrumentation of heap and GMP allocations
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_MEMORY_PROFILER_H_
+#define INTERPOLATE_GENETIC_POSITION_MEMORY_PROFILER_H_
+
+#include <gmp.h>
+#include <sys/resource.h>
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace interpolate_genetic_position {
+/*!
+ * \brief processing stages that allocations can be attributed to
+ */
+typedef enum {
+  STAGE_SETUP,
+  STAGE_READ,
+  STAGE_INTERPOLATE,
+  STAGE_WRITE,
+  N_PROFILE_STAGES
+} profile_stage;
+/*!
+ * \brief translate a processing stage into a label for reporting
+ * \param stage processing stage
+ * \return human-readable label for the stage
+ */
+std::string profile_stage_to_string(profile_stage stage);
+/*!
+ * \class memory_profiler
+ * \brief count allocations made through global operator new and through
+ * GMP's memory functions, attributed to the processing stage active on the
+ * calling thread.
+ *
+ * The hooks only count while the profiler is enabled. The replacement
+ * operator new is linked into the command line program alone, in
+ * memory_profiler_new.cc, so that the test programs and the python
+ * module keep the standard allocator; there, only GMP allocations and
+ * those passed to record_allocation() are counted. In the command line
+ * program, each allocation pays a single relaxed atomic load while the
+ * profiler is disabled.
+ * GMP's hooks forward to whatever memory functions were installed when the
+ * profiler was enabled, so enabling it does not change which allocator
+ * backs GMP objects.
+ */
+class memory_profiler {
+ public:
+  /*!
+   * \class stage_guard
+   * \brief RAII helper that attributes allocations on the current
+   * thread to a stage for the lifetime of the guard
+   */
+  class stage_guard {
+   public:
+    /*!
+     * \brief set the current thread's stage
+     * \param stage stage to attribute allocations to
+     */
+    explicit stage_guard(profile_stage stage);
+    /*!
+     * \brief restore the current thread's previous stage
+     */
+    ~stage_guard() throw();
+
+   private:
+    profile_stage _previous;  //!< stage active before this guard
+  };
+  /*!
+   * \brief install GMP hooks, reset counters, and begin counting
+   */
+  static void enable();
+  /*!
+   * \brief stop counting and restore GMP's previous memory functions
+   */
+  static void disable();
+  /*!
+   * \brief determine whether allocations are currently being counted
+   * \return whether allocations are currently being counted
+   */
+  static bool enabled();
+  /*!
+   * \brief zero all counters
+   */
+  static void reset();
+  /*!
+   * \brief record that one query row has been processed
+   */
+  static void record_row();
+  /*!
+   * \brief record an allocation against the current thread's stage
+   * \param bytes number of bytes requested
+   * \param gmp whether the allocation came through GMP
+   */
+  static void record_allocation(std::size_t bytes, bool gmp);
+  /*!
+   * \brief get number of processed query rows
+   * \return number of processed query rows
+   */
+  static unsigned long long get_rows();
+  /*!
+   * \brief get number of operator new allocations in a stage
+   * \param stage stage of interest
+   * \return number of allocations
+   */
+  static unsigned long long get_allocations(profile_stage stage);
+  /*!
+   * \brief get bytes requested through operator new in a stage
+   * \param stage stage of interest
+   * \return number of bytes
+   */
+  static unsigned long long get_bytes(profile_stage stage);
+  /*!
+   * \brief get number of GMP allocations and reallocations in a stage
+   * \param stage stage of interest
+   * \return number of allocations
+   */
+  static unsigned long long get_gmp_allocations(profile_stage stage);
+  /*!
+   * \brief get bytes requested through GMP in a stage
+   * \param stage stage of interest
+   * \return number of bytes
+   */
+  static unsigned long long get_gmp_bytes(profile_stage stage);
+  /*!
+   * \brief get peak resident set size of the process
+   * \return peak resident set size, in kilobytes
+   */
+  static long get_peak_rss_kb();
+  /*!
+   * \brief get the stage active on the calling thread
+   * \return the stage active on the calling thread
+   */
+  static profile_stage get_current_stage();
+  /*!
+   * \brief emit a summary table of counted allocations
+   * \param out stream to which to write the summary
+   */
+  static void report(std::ostream &out);
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_MEMORY_PROFILER_H_
@@ -0,0 +1,44 @@
+/*!
+ \file memory_profiler_new.cc
+ \brief replacement global operator new that reports to the memory profiler
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+
+ This file is linked into the command line program only, as replacing
+ the global allocation functions affects every library and host process
+ sharing the binary.
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "interpolate-genetic-position/memory_profiler.h"
+
+namespace igp = interpolate_genetic_position;
+
+/*
+ * Replacement global allocation functions. These must be defined at global
+ * scope, and must themselves never allocate through operator new.
+ */
+void *operator new(std::size_t n) {
+  igp::memory_profiler::record_allocation(n, false);
+  // as the standard allocator does, give any installed new handler the
+  // chance to free memory before giving up
+  while (true) {
+    void *ptr = std::malloc(n ? n : 1);
+    if (ptr) {
+      return ptr;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+void *operator new[](std::size_t n) { return ::operator new(n); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
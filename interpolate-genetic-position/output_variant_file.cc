@@ -24,21 +24,70 @@ igp::output_variant_file::output_variant_file()
       _last_rate(0.0),
       _step_interval(0.0),
       _index_on_chromosome(0),
-      _fixed_width(0) {}
+      _fixed_width(0),
+      _adjusted_gpos(0.0),
+      _output_gpos(0.0),
+      _hundred("100"),
+      _vcf_template(NULL),
+      _vcf_header(NULL),
+      _vcf_output(NULL),
+      _threads(1),
+      _output_cm_rate(false),
+      _vcf_info_value(0.0f),
+      _pvar_cm_column(-1),
+      _output_bigwig_rate(false),
+      _output_per_chromosome(false),
+      _chromosome_prefix(""),
+      _finishing_failed(false) {
+  _thread_pool.pool = NULL;
+  _thread_pool.qsize = 0;
+}
 
 igp::output_variant_file::~output_variant_file() throw() { close(); }
 
 void igp::output_variant_file::open(const std::string &filename,
                                     format_type ft) {
-  std::string bolt_header =
-      "chr\tposition\tCOMBINED_rate(cM/Mb)\tGenetic_Map(cM)\n";
   // set output format
   _ft = ft;
+  // with output per chromosome, files are opened as their chromosomes
+  // are reached
+  if (_output_per_chromosome) {
+    if (filename.empty()) {
+      throw std::runtime_error(
+          "output_variant_file: output per chromosome requires a file name "
+          "prefix");
+    }
+    _chromosome_prefix = filename;
+    _chromosome_files.clear();
+    _finishing_failed = false;
+    return;
+  }
+  // vcf/bcf output is handled entirely by htslib
+  if (_ft == VCF || _ft == BCF) {
+    open_vcf(filename);
+    return;
+  }
+  // bigwig output is written to its file by libBigWig on close
+  if (_ft == BIGWIG) {
+    _bigwig_output.open(filename);
+    return;
+  }
+  open_stream(filename);
+}
+
+void igp::output_variant_file::open_stream(const std::string &filename) {
+  std::string bolt_header =
+      "chr\tposition\tCOMBINED_rate(cM/Mb)\tGenetic_Map(cM)\n";
   // this needs to be updated to catch vcfs
   if (filename.rfind(".gz") == filename.size() - 3) {
     throw std::runtime_error("output gzipped files not yet supported");
+  } else if (filename.size() > 4 &&
+             filename.rfind(".zst") == filename.size() - 4) {
+    throw std::runtime_error("output zstd-compressed files not yet supported");
   } else if (!filename.empty()) {
-    _output.open(filename.c_str());
+    _output.open(filename.c_str(),
+                 _ft == ARROW ? std::ios::out | std::ios::binary
+                              : std::ios::out);
     if (!_output.is_open()) {
       throw std::runtime_error("output_variant_file: cannot open file \"" +
                                filename + "\"");
@@ -52,9 +101,170 @@ void igp::output_variant_file::open(const std::string &filename,
       std::cout << bolt_header;
     }
   }
+  if (_ft == PVAR) {
+    write_pvar_header(get_stream());
+  } else if (_ft == ARROW) {
+    _arrow_output.open(&get_stream());
+  }
+}
+
+void igp::output_variant_file::start_chromosome_file(const std::string &chr) {
+  if (!_chromosome_files.insert(chr).second) {
+    throw std::runtime_error(
+        "output_variant_file: results for chromosome \"" + chr +
+        "\" are not contiguous, so cannot be written to a file per "
+        "chromosome");
+  }
+  std::string filename =
+      _chromosome_prefix + chr + "." + output_file_extension(_ft);
+  if (_ft == VCF || _ft == BCF) {
+    if (_vcf_output) {
+      // compression of the rest of the file, and its index block, are
+      // finished while the next chromosome is written
+      htsFile *finished = _vcf_output;
+      bcf_hdr_t *finished_header = _vcf_header;
+      _vcf_output = NULL;
+      _vcf_header = NULL;
+      _finishing_files.push_back(std::thread([this, finished,
+                                              finished_header]() {
+        if (hts_close(finished)) {
+          _finishing_failed = true;
+        }
+        bcf_hdr_destroy(finished_header);
+      }));
+    }
+    open_vcf(_ft == VCF ? filename + ".gz" : filename);
+    return;
+  }
+  // libBigWig keeps global state, so bigwig files are finished in turn
+  if (_ft == BIGWIG) {
+    _bigwig_output.close();
+    _bigwig_output.open(filename);
+    return;
+  }
+  if (_arrow_output.is_open()) {
+    _arrow_output.close();
+  }
+  if (_output.is_open()) {
+    // the stream object itself stays in place, as callers hold on to it;
+    // only its open file, with whatever is still buffered, moves out
+    std::unique_ptr<std::filebuf> finished(new std::filebuf);
+    finished->swap(*_output.rdbuf());
+    _finishing_files.push_back(
+        std::thread([this, buffer = std::move(finished)]() {
+          if (!buffer->close()) {
+            _finishing_failed = true;
+          }
+        }));
+  }
+  _output.clear();
+  open_stream(filename);
+}
+
+bool igp::output_variant_file::finish_chromosome_files() {
+  for (unsigned i = 0; i < _finishing_files.size(); ++i) {
+    _finishing_files.at(i).join();
+  }
+  _finishing_files.clear();
+  return !_finishing_failed;
+}
+
+void igp::output_variant_file::write_pvar_header(std::ostream &target) {
+  if (_pvar_header.empty()) {
+    throw std::runtime_error(
+        "output_variant_file: pvar output requires pvar input");
+  }
+  for (unsigned i = 0; i + 1 < _pvar_header.size(); ++i) {
+    target << _pvar_header.at(i) << '\n';
+  }
+  target << _pvar_header.back();
+  if (_pvar_cm_column < 0) {
+    target << "\tCM";
+  }
+  target << '\n';
+  if (_output.is_open() && !_output) {
+    throw std::runtime_error(
+        "output_variant_file: cannot write pvar header to file");
+  }
+}
+
+void igp::output_variant_file::open_vcf(const std::string &filename) {
+  if (!_vcf_template) {
+    throw std::runtime_error(
+        "output_variant_file: vcf/bcf output requires vcf/bcf input");
+  }
+  // bcf is always bgzipped; vcf is bgzipped if so named
+  const char *mode = "w";
+  if (_ft == BCF) {
+    mode = "wb";
+  } else if (filename.size() >= 3 &&
+             filename.rfind(".gz") == filename.size() - 3) {
+    mode = "wz";
+  }
+  std::string target = filename.empty() ? "-" : filename;
+  _vcf_output = hts_open(target.c_str(), mode);
+  if (!_vcf_output) {
+    throw std::runtime_error("output_variant_file: cannot open file \"" +
+                             filename + "\"");
+  }
+  // with output per chromosome, every file shares one pool
+  if (_threads > 1) {
+    if (!_thread_pool.pool) {
+      _thread_pool.pool = hts_tpool_init(static_cast<int>(_threads));
+    }
+    if (!_thread_pool.pool ||
+        hts_set_thread_pool(_vcf_output, &_thread_pool)) {
+      throw std::runtime_error(
+          "output_variant_file: unable to start htslib thread pool");
+    }
+  }
+  _vcf_header = bcf_hdr_dup(_vcf_template);
+  if (!_vcf_header) {
+    throw std::runtime_error("output_variant_file: unable to copy vcf header");
+  }
+  std::string gpos_line =
+      output_morgans()
+          ? "##INFO=<ID=MORGANS,Number=1,Type=Float,Description=\"Genetic "
+            "position in morgans\">"
+          : "##INFO=<ID=CM,Number=1,Type=Float,Description=\"Genetic "
+            "position in centimorgans\">";
+  if (bcf_hdr_append(_vcf_header, gpos_line.c_str()) ||
+      (output_cm_rate() &&
+       bcf_hdr_append(_vcf_header,
+                      "##INFO=<ID=CM_RATE,Number=1,Type=Float,"
+                      "Description=\"Recombination rate in cM/Mb\">")) ||
+      bcf_hdr_sync(_vcf_header)) {
+    throw std::runtime_error(
+        "output_variant_file: unable to add INFO fields to vcf header");
+  }
+  if (bcf_hdr_write(_vcf_output, _vcf_header)) {
+    throw std::runtime_error(
+        "output_variant_file: cannot write header to file \"" + filename +
+        "\"");
+  }
 }
 
 void igp::output_variant_file::close() {
+  if (_vcf_output) {
+    int res = hts_close(_vcf_output);
+    _vcf_output = NULL;
+    if (_vcf_header) {
+      bcf_hdr_destroy(_vcf_header);
+      _vcf_header = NULL;
+    }
+    if (res) {
+      finish_chromosome_files();
+      destroy_thread_pool();
+      throw std::runtime_error(
+          "output_variant_file::close: unable to finish vcf/bcf output");
+    }
+  }
+  if (_arrow_output.is_open()) {
+    _arrow_output.close();
+  }
+  if (_bigwig_output.is_open()) {
+    _bigwig_output.close();
+  }
   if (_output.is_open()) {
     // only for BOLT output: make sure the end of the last chromosome has
     // a placeholder entry with 0 rate
@@ -77,82 +287,192 @@ void igp::output_variant_file::close() {
     _output.close();
     _output.clear();
   }
+  // files of earlier chromosomes may still use the htslib pool
+  bool finished = finish_chromosome_files();
+  destroy_thread_pool();
+  if (!finished) {
+    throw std::runtime_error(
+        "output_variant_file::close: unable to finish the file of a "
+        "chromosome");
+  }
+}
+
+void igp::output_variant_file::destroy_thread_pool() {
+  if (_thread_pool.pool) {
+    hts_tpool_destroy(_thread_pool.pool);
+    _thread_pool.pool = NULL;
+  }
 }
 
 void igp::output_variant_file::write(
     const std::string &chr, const mpz_class &pos1, const mpz_class &pos2,
     const std::string &id, const mpf_class &gpos, const mpf_class &rate,
     const std::string &a1, const std::string &a2) {
-  // the idea is: format an output line, then emit it to appropriate target
-  std::ostringstream out;
-  // set fixed width if a non-zero width has been specified
-  if (get_fixed_width()) {
-    out.precision(get_fixed_width());
-    out << std::fixed;
-  }
+  std::ostream &target = get_stream();
+  output_format_guard guard(target, get_fixed_width());
   format_type ft = get_format();
+  if (ft == BIM) {
+    write_record<BIM>(target, chr, pos1, pos2, id, gpos, rate, a1, a2);
+  } else if (ft == MAP) {
+    write_record<MAP>(target, chr, pos1, pos2, id, gpos, rate, a1, a2);
+  } else if (ft == SNP) {
+    write_record<SNP>(target, chr, pos1, pos2, id, gpos, rate, a1, a2);
+  } else if (ft == BOLT) {
+    write_record<BOLT>(target, chr, pos1, pos2, id, gpos, rate, a1, a2);
+  } else if (ft == ARROW) {
+    write_record<ARROW>(target, chr, pos1, pos2, id, gpos, rate, a1, a2);
+  } else if (ft == BIGWIG) {
+    write_record<BIGWIG>(target, chr, pos1, pos2, id, gpos, rate, a1, a2);
+  } else {
+    throw std::runtime_error(
+        "output_variant_file::write: format not supported");
+  }
+}
 
-  mpf_class step_interval = get_step_interval();
-  mpf_class adjusted_gpos = gpos;
+void igp::output_variant_file::write_pvar(
+    const std::vector<std::string> &line_contents, const std::string &chr,
+    const mpf_class &gpos) {
+  std::ostream &target = get_stream();
+  output_format_guard guard(target, get_fixed_width());
+  write_pvar_record(target, line_contents, chr, gpos);
+}
 
-  if (pos2 > 0 && !get_last_chr().compare(chr)) {
-    adjusted_gpos = adjusted_gpos + step_interval * get_index_on_chromosome();
+void igp::output_variant_file::write_pvar_record(
+    std::ostream &target, const std::vector<std::string> &line_contents,
+    const std::string &chr, const mpf_class &gpos) {
+  // the pvar CM column is always centimorgans
+  if (_last_chr.compare(chr)) {
+    if (_output_per_chromosome) {
+      start_chromosome_file(chr);
+    }
+    _last_chr = chr;
+    _index_on_chromosome = 0;
+  } else if (cmp(_last_gpos, gpos) > 0) {
+    throw_precision_error();
   }
-  mpf_class output_gpos =
-      output_morgans() ? adjusted_gpos / mpf_class("100") : adjusted_gpos;
-
-  // track when a result is on a different chromosome than the previous ones
-  if (get_last_chr().compare(chr)) {
-    // for bolt output only, emit dummy results at the end of a chromosome
-    if (ft == BOLT && pos2 > 0 && !get_last_chr().empty()) {
-      out << get_last_chr() << '\t' << get_last_pos2() << '\t' << "0\t"
-          << (get_last_gpos() +
-              get_last_rate() * (get_last_pos2() - get_last_pos1()) /
-                  mpf_class(1000000.0) +
-              step_interval)
-          << '\n';
+  _last_gpos = gpos;
+  for (unsigned i = 0; i < line_contents.size(); ++i) {
+    if (i) {
+      target << '\t';
     }
-    set_last_chr(chr);
-    set_index_on_chromosome(0);
-  } else {
-    // as a last resort, check uncontrolled precision errors in output
-    if (cmp(get_last_gpos(), output_gpos) > 0) {
-      throw std::runtime_error(
-          "write: an output genetic position is smaller than the position "
-          "of a previous output for the same chromosome. This is probably "
-          "caused by uncontrolled precision errors, either in one of the "
-          "inputs or in the logic of this program. The most likely way to "
-          "solve this error is to try increasing --precision and "
-          "--fixed-output-width in combination until sufficient precision "
-          "is preserved for the results to remain internally consistent.");
+    if (static_cast<int>(i) == _pvar_cm_column) {
+      target << gpos;
+    } else {
+      target << line_contents[i];
     }
   }
-  set_last_pos1(pos1);
-  set_last_pos2(pos2);
-  set_last_gpos(output_gpos);
-  set_last_rate(rate);
-  if (ft == BIM || ft == MAP) {
-    out << chr << '\t' << id << '\t' << output_gpos << '\t' << pos1;
-    if (ft == BIM) {
-      out << '\t' << a1 << '\t' << a2;
-    }
-  } else if (ft == SNP) {
-    out << id << '\t' << chr << '\t' << output_gpos << '\t' << pos1;
-  } else if (ft == BOLT) {
-    out << chr << '\t' << pos1 << '\t' << rate << '\t' << output_gpos;
-  } else {
+  if (_pvar_cm_column < 0) {
+    target << '\t' << gpos;
+  }
+  target << '\n';
+  if (_output.is_open() && !_output) {
     throw std::runtime_error(
-        "output_variant_file::write: format not supported");
+        "output_variant_file::write_pvar: cannot write to file");
   }
+}
 
-  if (_output.is_open()) {
-    if (!(_output << out.str() << '\n')) {
-      throw std::runtime_error(
-          "output_variant_file::write: cannot write to file");
+void igp::output_variant_file::set_pvar_header(
+    const std::vector<std::string> &header_lines, int cm_column) {
+  _pvar_header = header_lines;
+  _pvar_cm_column = cm_column;
+}
+
+void igp::output_variant_file::throw_precision_error() const {
+  throw std::runtime_error(
+      "write: an output genetic position is smaller than the position "
+      "of a previous output for the same chromosome. This is probably "
+      "caused by uncontrolled precision errors, either in one of the "
+      "inputs or in the logic of this program. The most likely way to "
+      "solve this error is to try increasing --precision and "
+      "--fixed-output-width in combination until sufficient precision "
+      "is preserved for the results to remain internally consistent.");
+}
+
+void igp::output_variant_file::write_vcf(bcf1_t *record, const mpf_class &gpos,
+                                         const mpf_class &rate) {
+  const char *chr = bcf_hdr_id2name(_vcf_template, record->rid);
+  if (_last_chr.compare(chr)) {
+    if (_output_per_chromosome) {
+      start_chromosome_file(chr);
     }
+    _last_chr = chr;
+    _index_on_chromosome = 0;
+  } else if (cmp(_last_gpos, gpos) > 0) {
+    throw_precision_error();
+  }
+  _last_gpos = gpos;
+  if (!_vcf_output) {
+    throw std::runtime_error(
+        "output_variant_file::write_vcf: vcf/bcf output is not open");
+  }
+  if (output_morgans()) {
+    _output_gpos = gpos / _hundred;
+    update_vcf_info(record, "MORGANS", _output_gpos);
   } else {
-    std::cout << out.str() << '\n';
+    update_vcf_info(record, "CM", gpos);
+  }
+  if (output_cm_rate()) {
+    update_vcf_info(record, "CM_RATE", rate);
+  }
+  if (bcf_write(_vcf_output, _vcf_header, record)) {
+    throw std::runtime_error(
+        "output_variant_file::write_vcf: cannot write to file");
+  }
+}
+
+void igp::output_variant_file::update_vcf_info(bcf1_t *record,
+                                               const char *key,
+                                               const mpf_class &value) {
+  // INFO is declared Float, so values are stored in 32 bits whatever
+  // the requested precision or output width
+  _vcf_info_value = static_cast<float>(mpf_to_double(value));
+  if (bcf_update_info_float(_vcf_header, record, key, &_vcf_info_value, 1)) {
+    throw std::runtime_error(
+        "output_variant_file::write_vcf: unable to set INFO/" +
+        std::string(key));
+  }
+}
+
+void igp::output_variant_file::set_vcf_header(const bcf_hdr_t *header) {
+  _vcf_template = header;
+}
+
+void igp::output_variant_file::output_cm_rate(bool use_rate) {
+  _output_cm_rate = use_rate;
+}
+
+bool igp::output_variant_file::output_cm_rate() const {
+  return _output_cm_rate;
+}
+
+void igp::output_variant_file::output_bigwig_rate(bool use_rate) {
+  _output_bigwig_rate = use_rate;
+}
+
+bool igp::output_variant_file::output_bigwig_rate() const {
+  return _output_bigwig_rate;
+}
+
+void igp::output_variant_file::set_threads(unsigned n_threads) {
+  _threads = n_threads;
+}
+
+unsigned igp::output_variant_file::get_threads() const { return _threads; }
+
+void igp::output_variant_file::output_per_chromosome(bool per_chromosome) {
+  _output_per_chromosome = per_chromosome;
+}
+
+bool igp::output_variant_file::output_per_chromosome() const {
+  return _output_per_chromosome;
+}
+
+std::ostream &igp::output_variant_file::get_stream() {
+  // with output per chromosome, files come and go behind one stream
+  if (_output.is_open() || _output_per_chromosome) {
+    return _output;
   }
+  return std::cout;
 }
 
 igp::format_type igp::output_variant_file::get_format() const { return _ft; }
@@ -12,13 +12,21 @@
 #include <gmpxx.h>
 #include <zlib.h>
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "htslib/hts.h"
+#include "htslib/vcf.h"
+#include "interpolate-genetic-position/arrow_writer.h"
+#include "interpolate-genetic-position/bigwig_writer.h"
 #include "interpolate-genetic-position/utilities.h"
 
 namespace interpolate_genetic_position {
@@ -54,6 +62,40 @@ class base_output_variant_file {
                      const mpz_class &pos2, const std::string &id,
                      const mpf_class &gpos, const mpf_class &rate,
                      const std::string &a1, const std::string &a2) = 0;
+  /*!
+   * \brief annotate a vcf record with output data and write it
+   * \param record input record, which will be modified
+   * \param gpos genetic position of record
+   * \param rate recombination rate of record
+   */
+  virtual void write_vcf(bcf1_t *record, const mpf_class &gpos,
+                         const mpf_class &rate) = 0;
+  /*!
+   * \brief provide the header of the vcf being annotated
+   * \param header header of input vcf
+   *
+   * This must be called before opening vcf/bcf output.
+   */
+  virtual void set_vcf_header(const bcf_hdr_t *header) = 0;
+  /*!
+   * \brief report a pvar record with its CM column set
+   * \param line_contents all columns of the input record
+   * \param chr chromosome of record
+   * \param gpos genetic position of record
+   */
+  virtual void write_pvar(const std::vector<std::string> &line_contents,
+                          const std::string &chr, const mpf_class &gpos) = 0;
+  /*!
+   * \brief provide the header of the pvar being annotated
+   * \param header_lines header lines of input pvar, ending with the
+   * #CHROM line
+   * \param cm_column base 0 index of the CM column in the input, or -1
+   * if the input has none
+   *
+   * This must be called before opening pvar output.
+   */
+  virtual void set_pvar_header(const std::vector<std::string> &header_lines,
+                               int cm_column) = 0;
   /*!
    * \brief get descriptor of format of output file
    * \return output file format
@@ -175,6 +217,46 @@ class base_output_variant_file {
   virtual unsigned get_fixed_width() const = 0;
 };
 
+/*!
+ * \class output_format_guard
+ * \brief format floating point output on a stream as a freshly
+ * constructed stream would, optionally with fixed width, for the
+ * lifetime of the guard, then restore the stream's previous format
+ */
+class output_format_guard {
+ public:
+  /*!
+   * \brief apply output formatting to a stream
+   * \param target stream to format
+   * \param fixed_width number of digits to print after decimal for
+   * floating point values, or 0 for default formatting
+   */
+  output_format_guard(std::ostream &target, unsigned fixed_width)
+      : _target(target),
+        _flags(target.flags()),
+        _precision(target.precision()) {
+    if (fixed_width) {
+      _target.precision(fixed_width);
+      _target.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    } else {
+      _target.precision(6);
+      _target.unsetf(std::ios_base::floatfield);
+    }
+  }
+  /*!
+   * \brief restore previous stream format
+   */
+  ~output_format_guard() throw() {
+    _target.flags(_flags);
+    _target.precision(_precision);
+  }
+
+ private:
+  std::ostream &_target;           //!< formatted stream
+  std::ios_base::fmtflags _flags;  //!< previous format flags
+  std::streamsize _precision;      //!< previous precision
+};
+
 /*!
  * \class output_variant_file
  * \brief the base class for these file interfaces needs to be purely virtual
@@ -193,14 +275,38 @@ class output_variant_file : public base_output_variant_file {
   ~output_variant_file() throw();
   /*!
    * \brief open file connection
-   * \param filename name of input file to open
+   * \param filename name of input file to open; with output per
+   * chromosome, the prefix of every file name
    * \param ft format of output file
    */
   void open(const std::string &filename, format_type ft);
   /*!
    * \brief close file connection
+   *
+   * With output per chromosome, this also waits for the files of
+   * earlier chromosomes to be flushed.
    */
   void close();
+  /*!
+   * \brief set whether each chromosome is written to its own file
+   * \param per_chromosome whether each chromosome is written to its
+   * own file
+   *
+   * This must be called before open(), whose file name then becomes a
+   * prefix: results on chromosome CHR go to PREFIXCHR.EXT, where EXT is
+   * output_file_extension() of the format, and vcf files are bgzipped
+   * as PREFIXCHR.vcf.gz. Each file is what the single output would hold
+   * for its chromosome, with its own header. A file is opened when its
+   * chromosome is first reported, and once the next chromosome starts,
+   * it is flushed and closed on a thread of its own. Results of a
+   * chromosome must be contiguous.
+   */
+  void output_per_chromosome(bool per_chromosome);
+  /*!
+   * \brief determine whether each chromosome is written to its own file
+   * \return whether each chromosome is written to its own file
+   */
+  bool output_per_chromosome() const;
   /*!
    * \brief report output data to appropriate target
    */
@@ -208,6 +314,121 @@ class output_variant_file : public base_output_variant_file {
              const mpz_class &pos2, const std::string &id,
              const mpf_class &gpos, const mpf_class &rate,
              const std::string &a1, const std::string &a2);
+  /*!
+   * \brief report output data for a format fixed at compile time
+   * \tparam ft format of output file; must match get_format()
+   * \param target stream returned by get_stream(), with formatting
+   * applied by an output_format_guard
+   * \param chr chromosome of result
+   * \param pos1 start position of result
+   * \param pos2 end position of result, or -1 if not applicable
+   * \param id variant identifier of result
+   * \param gpos genetic position of result
+   * \param rate recombination rate of result
+   * \param a1 first allele of result
+   * \param a2 second allele of result
+   *
+   * This is the body of write() without its per-call format dispatch
+   * and stream setup, for callers that write many results in a row.
+   * Arrow output buffers the result as a row of typed columns instead
+   * of writing it to target, and bigwig output as an interval of the
+   * track.
+   */
+  template <format_type ft>
+  void write_record(std::ostream &target, const std::string &chr,
+                    const mpz_class &pos1, const mpz_class &pos2,
+                    const std::string &id, const mpf_class &gpos,
+                    const mpf_class &rate, const std::string &a1,
+                    const std::string &a2);
+  /*!
+   * \brief get stream to which results are written
+   * \return the output file stream if open, otherwise std::cout
+   */
+  std::ostream &get_stream();
+  /*!
+   * \brief annotate a vcf record with output data and write it
+   * \param record input record, which will be modified
+   * \param gpos genetic position of record
+   * \param rate recombination rate of record
+   *
+   * Genetic position is added to INFO as CM, or as MORGANS if output
+   * is requested in morgans. Rate is added as CM_RATE if requested.
+   * These INFO fields are 32-bit floats, so --precision and
+   * --fixed-output-width do not apply to them. Genotype data are never
+   * unpacked.
+   */
+  void write_vcf(bcf1_t *record, const mpf_class &gpos,
+                 const mpf_class &rate);
+  /*!
+   * \brief provide the header of the vcf being annotated
+   * \param header header of input vcf; must outlive open()
+   */
+  void set_vcf_header(const bcf_hdr_t *header);
+  /*!
+   * \brief report a pvar record with its CM column set
+   * \param line_contents all columns of the input record
+   * \param chr chromosome of record
+   * \param gpos genetic position of record
+   *
+   * Every other column is written as it was read.
+   */
+  void write_pvar(const std::vector<std::string> &line_contents,
+                  const std::string &chr, const mpf_class &gpos);
+  /*!
+   * \brief report a pvar record without per-call stream setup
+   * \param target stream returned by get_stream(), with formatting
+   * applied by an output_format_guard
+   * \param line_contents all columns of the input record
+   * \param chr chromosome of record
+   * \param gpos genetic position of record
+   */
+  void write_pvar_record(std::ostream &target,
+                         const std::vector<std::string> &line_contents,
+                         const std::string &chr, const mpf_class &gpos);
+  /*!
+   * \brief provide the header of the pvar being annotated
+   * \param header_lines header lines of input pvar, ending with the
+   * #CHROM line
+   * \param cm_column base 0 index of the CM column in the input, or -1
+   * if the input has none, in which case one is appended
+   */
+  void set_pvar_header(const std::vector<std::string> &header_lines,
+                       int cm_column);
+  /*!
+   * \brief set whether vcf/bcf output should include INFO/CM_RATE
+   * \param use_rate whether vcf/bcf output should include INFO/CM_RATE
+   */
+  void output_cm_rate(bool use_rate);
+  /*!
+   * \brief determine whether vcf/bcf output includes INFO/CM_RATE
+   * \return whether vcf/bcf output includes INFO/CM_RATE
+   */
+  bool output_cm_rate() const;
+  /*!
+   * \brief set whether bigwig output should report the local
+   * recombination rate instead of genetic position
+   * \param use_rate whether bigwig output should report the rate track
+   */
+  void output_bigwig_rate(bool use_rate);
+  /*!
+   * \brief determine whether bigwig output reports the local
+   * recombination rate instead of genetic position
+   * \return whether bigwig output reports the rate track
+   */
+  bool output_bigwig_rate() const;
+  /*!
+   * \brief set number of threads htslib may use for compression
+   * \param n_threads number of threads; 1 compresses on the
+   * writing thread
+   *
+   * This must be called before opening vcf/bcf output.
+   */
+  void set_threads(unsigned n_threads);
+  /*!
+   * \brief get number of threads htslib may use for compression
+   * \return number of threads htslib may use for compression
+   */
+  unsigned get_threads() const;
   /*!
    * \brief get descriptor of format of output file
    * \return output file format
@@ -329,6 +550,48 @@ class output_variant_file : public base_output_variant_file {
   unsigned get_fixed_width() const;
 
  private:
+  /*!
+   * \brief open vcf/bcf output with htslib and write its header
+   * \param filename name of output file, or empty for stdout
+   */
+  void open_vcf(const std::string &filename);
+  /*!
+   * \brief set a single float INFO value on a vcf record
+   * \param record record to modify
+   * \param key INFO key, which must be declared in the output header
+   * \param value value to set
+   */
+  void update_vcf_info(bcf1_t *record, const char *key, const mpf_class &value);
+  /*!
+   * \brief write the header of pvar output, adding a CM column if needed
+   * \param target stream to which output is written
+   */
+  void write_pvar_header(std::ostream &target);
+  /*!
+   * \brief open the output stream and write the header of its format
+   * \param filename name of output file, or empty for stdout
+   */
+  void open_stream(const std::string &filename);
+  /*!
+   * \brief with output per chromosome, move on to the file of a new
+   * chromosome, handing the previous file to a thread that finishes it
+   * \param chr chromosome of the next result
+   */
+  void start_chromosome_file(const std::string &chr);
+  /*!
+   * \brief wait for the files of earlier chromosomes to be finished
+   * \return whether every file was finished successfully
+   */
+  bool finish_chromosome_files();
+  /*!
+   * \brief stop the htslib pool used for bgzf compression, if any
+   */
+  void destroy_thread_pool();
+  /*!
+   * \brief report that genetic positions have decreased along a
+   * chromosome
+   */
+  void throw_precision_error() const;
   std::ofstream _output;     //!< output uncompressed file stream
   format_type _ft;           //!< format of output file
   bool _output_morgans;      //!< whether to emit genetic position as morgans
@@ -341,7 +604,97 @@ class output_variant_file : public base_output_variant_file {
   unsigned _index_on_chromosome;  //!< how many queries have been returned on
                                   //!< this chromosome
   unsigned _fixed_width;          //!< fixed width of output decimal values
+  mpf_class _adjusted_gpos;       //!< reused storage for incremented gpos
+  mpf_class _output_gpos;         //!< reused storage for gpos in morgans
+  mpf_class _hundred;             //!< conversion factor from cM to M
+  const bcf_hdr_t *_vcf_template;  //!< header of vcf being annotated
+  bcf_hdr_t *_vcf_header;          //!< header of vcf/bcf output
+  htsFile *_vcf_output;            //!< vcf/bcf output file handle
+  htsThreadPool _thread_pool;      //!< htslib pool for bgzf compression
+  unsigned _threads;               //!< number of htslib compression threads
+  bool _output_cm_rate;            //!< whether to emit INFO/CM_RATE
+  float _vcf_info_value;           //!< reused storage for INFO values
+  std::vector<std::string> _pvar_header;  //!< header lines of input pvar
+  int _pvar_cm_column;  //!< index of CM column in input pvar, or -1
+  arrow_writer _arrow_output;  //!< arrow output encoder
+  bigwig_writer _bigwig_output;  //!< bigwig output track
+  bool _output_bigwig_rate;      //!< whether bigwig output reports rate
+  bool _output_per_chromosome;   //!< whether each chromosome has a file
+  std::string _chromosome_prefix;  //!< file name prefix per chromosome
+  std::set<std::string> _chromosome_files;  //!< chromosomes given a file
+  std::vector<std::thread> _finishing_files;  //!< threads finishing files
+  std::atomic<bool> _finishing_failed;  //!< whether finishing a file failed
 };
+
+template <format_type ft>
+void output_variant_file::write_record(
+    std::ostream &target, const std::string &chr, const mpz_class &pos1,
+    const mpz_class &pos2, const std::string &id, const mpf_class &gpos,
+    const mpf_class &rate, const std::string &a1, const std::string &a2) {
+  static_assert(ft == BIM || ft == MAP || ft == SNP || ft == BOLT ||
+                    ft == ARROW || ft == BIGWIG,
+                "output_variant_file::write_record: format not supported");
+  bool same_chr = !_last_chr.compare(chr);
+  _adjusted_gpos = gpos;
+  if (pos2 > 0 && same_chr) {
+    _adjusted_gpos = _adjusted_gpos + _step_interval * _index_on_chromosome;
+  }
+  if (_output_morgans) {
+    _output_gpos = _adjusted_gpos / _hundred;
+  }
+  const mpf_class &output_gpos =
+      _output_morgans ? _output_gpos : _adjusted_gpos;
+
+  // track when a result is on a different chromosome than the previous ones
+  if (!same_chr) {
+    // for bolt output only, emit dummy results at the end of a chromosome
+    if constexpr (ft == BOLT) {
+      if (pos2 > 0 && !_last_chr.empty()) {
+        target << _last_chr << '\t' << _last_pos2 << '\t' << "0\t"
+               << (_last_gpos + _last_rate * (_last_pos2 - _last_pos1) /
+                                    mpf_class(1000000.0) +
+                   _step_interval)
+               << '\n';
+      }
+    }
+    if (_output_per_chromosome) {
+      start_chromosome_file(chr);
+    }
+    _last_chr = chr;
+    _index_on_chromosome = 0;
+  } else {
+    // as a last resort, check uncontrolled precision errors in output
+    if (cmp(_last_gpos, output_gpos) > 0) {
+      throw_precision_error();
+    }
+  }
+  _last_pos1 = pos1;
+  _last_pos2 = pos2;
+  _last_gpos = output_gpos;
+  _last_rate = rate;
+  if constexpr (ft == ARROW) {
+    _arrow_output.append(chr, pos1, pos2, id, output_gpos, rate, a1, a2);
+    return;
+  } else if constexpr (ft == BIGWIG) {
+    _bigwig_output.append(
+        chr, pos1, pos2,
+        output_bigwig_rate() ? rate.get_d() : output_gpos.get_d());
+    return;
+  } else if constexpr (ft == BIM || ft == MAP) {
+    target << chr << '\t' << id << '\t' << output_gpos << '\t' << pos1;
+    if constexpr (ft == BIM) {
+      target << '\t' << a1 << '\t' << a2;
+    }
+  } else if constexpr (ft == SNP) {
+    target << id << '\t' << chr << '\t' << output_gpos << '\t' << pos1;
+  } else {
+    target << chr << '\t' << pos1 << '\t' << rate << '\t' << output_gpos;
+  }
+  target << '\n';
+  if (_output.is_open() && !_output) {
+    throw std::runtime_error("output_variant_file::write: cannot write to file");
+  }
+}
 }  // namespace interpolate_genetic_position
 
 #endif  // INTERPOLATE_GENETIC_POSITION_OUTPUT_VARIANT_FILE_H_
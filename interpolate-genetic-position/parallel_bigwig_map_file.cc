@@ -0,0 +1,276 @@
+/*!
+ \file parallel_bigwig_map_file.cc
+ \brief implementation of parallel bigwig genetic map decoding
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/parallel_bigwig_map_file.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace igp = interpolate_genetic_position;
+
+igp::parallel_bigwig_map_file::parallel_bigwig_map_file()
+    : base_input_genetic_map_file(),
+      _fallback(NULL),
+      _threads(1),
+      _accumulate_gpos(true),
+      _block_index(0),
+      _row_index(0),
+      _eof(false),
+      _chr_lower_bound(""),
+      _chr_upper_bound(""),
+      _startpos_lower_bound(0),
+      _startpos_upper_bound(0),
+      _endpos_lower_bound(-1),
+      _endpos_upper_bound(-1),
+      _gpos_lower_bound(0.0),
+      _gpos_upper_bound(0.0),
+      _rate_lower_bound(0.0),
+      _rate_upper_bound(0.0),
+      _queued_rows(0) {}
+igp::parallel_bigwig_map_file::parallel_bigwig_map_file(
+    const parallel_bigwig_map_file &obj)
+    : base_input_genetic_map_file() {
+  throw std::runtime_error(
+      "parallel_bigwig_map_file: copy constructor operation is invalid for "
+      "this class");
+}
+igp::parallel_bigwig_map_file::~parallel_bigwig_map_file() throw() {
+  close();
+}
+void igp::parallel_bigwig_map_file::open(const std::string &filename,
+                                         format_type ft) {
+  if (ft != BIGWIG) {
+    throw std::runtime_error(
+        "parallel_bigwig_map_file::open: only bigwig maps are supported");
+  }
+  close();
+  if (!bwIsBigWig(filename.c_str(), NULL)) {
+    throw std::runtime_error(
+        "parallel_bigwig_map_file: input file is not bigwig: \"" + filename +
+        "\"");
+  }
+  if (bwInit(1 << 17)) {
+    throw std::runtime_error("parallel_bigwig_map_file: unable to bwInit");
+  }
+  bigWigFile_t *header = bwOpen(filename.c_str(), NULL, "r");
+  if (!header) {
+    throw std::runtime_error("parallel_bigwig_map_file: cannot open \"" +
+                             filename + "\"");
+  }
+  _chromosomes = bigwig_reader::list_chromosomes(header);
+  bwClose(header);
+  if (_chromosomes.empty()) {
+    throw std::runtime_error(
+        "parallel_bigwig_map_file: min chromosome not recognized");
+  }
+  _blocks.resize(_chromosomes.size());
+  // workers claim chromosomes in map order, so the largest leading
+  // chromosomes start first
+  unsigned n_workers =
+      std::min(_threads, static_cast<unsigned>(_chromosomes.size()));
+  std::atomic<unsigned> next(0);
+  std::vector<std::exception_ptr> errors(n_workers);
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < n_workers; ++i) {
+    workers.push_back(std::thread(&parallel_bigwig_map_file::decode_chromosomes,
+                                  this, filename, &next, &errors.at(i)));
+  }
+  for (unsigned i = 0; i < workers.size(); ++i) {
+    workers.at(i).join();
+  }
+  for (unsigned i = 0; i < errors.size(); ++i) {
+    if (errors.at(i)) {
+      close();
+      std::rethrow_exception(errors.at(i));
+    }
+  }
+  // Load the first two values, such that a valid range is available at the
+  // beginning of iteration.
+  _queued_rows = 0;
+  if (get()) ++_queued_rows;
+  if (get()) ++_queued_rows;
+}
+void igp::parallel_bigwig_map_file::decode_chromosomes(
+    const std::string &filename, std::atomic<unsigned> *next,
+    std::exception_ptr *error) {
+  bigWigFile_t *input = NULL;
+  try {
+    input = bwOpen(filename.c_str(), NULL, "r");
+    if (!input) {
+      throw std::runtime_error("parallel_bigwig_map_file: cannot open \"" +
+                               filename + "\"");
+    }
+    for (unsigned i = (*next)++; i < _chromosomes.size(); i = (*next)++) {
+      decode_chromosome(input, _chromosomes.at(i), &_blocks.at(i));
+    }
+  } catch (...) {
+    *error = std::current_exception();
+  }
+  if (input) {
+    bwClose(input);
+  }
+}
+void igp::parallel_bigwig_map_file::decode_chromosome(bigWigFile_t *input,
+                                                      const std::string &chr,
+                                                      map_block *block) const {
+  block->clear();
+  bwOverlappingIntervals_t *intervals =
+      bwGetOverlappingIntervals(input, chr.c_str(), 0, 1000000000);
+  if (!intervals) {
+    return;
+  }
+  mpz_class startpos_lower = 0, startpos_upper = 0, endpos = 0;
+  mpf_class gpos_lower = 0.0, gpos_upper = 0.0, rate_lower = 0.0,
+            rate_upper = 0.0;
+  for (uint32_t i = 0; i < intervals->l; ++i) {
+    // matches bigwig_reader followed by input_genetic_map_file::get
+    startpos_upper = intervals->start[i];
+    endpos = intervals->end[i];
+    rate_upper = intervals->value[i];
+    startpos_upper = startpos_upper + 1;
+    endpos = endpos + 1;
+    if (i && _accumulate_gpos) {
+      gpos_upper = gpos_lower + rate_lower * (startpos_upper - startpos_lower) /
+                                    mpf_class(1000000.0);
+    } else {
+      gpos_upper = mpf_class("0.0");
+    }
+    block->append(chr, startpos_upper, endpos, gpos_upper, rate_upper);
+    startpos_lower.swap(startpos_upper);
+    gpos_lower.swap(gpos_upper);
+    rate_lower.swap(rate_upper);
+  }
+  bwDestroyOverlappingIntervals(intervals);
+}
+void igp::parallel_bigwig_map_file::set_fallback_stream(std::istream *ptr) {
+  _fallback = ptr;
+}
+std::istream *igp::parallel_bigwig_map_file::get_fallback_stream() const {
+  if (!_fallback) {
+    throw std::runtime_error(
+        "pbmf::get_fallback_stream: called on NULL pointer");
+  }
+  return _fallback;
+}
+bool igp::parallel_bigwig_map_file::get() {
+  _chr_lower_bound.swap(_chr_upper_bound);
+  _startpos_lower_bound.swap(_startpos_upper_bound);
+  _endpos_lower_bound.swap(_endpos_upper_bound);
+  _gpos_lower_bound.swap(_gpos_upper_bound);
+  _rate_lower_bound.swap(_rate_upper_bound);
+  if (!read_upper_bound()) {
+    _chr_upper_bound = _chr_lower_bound;
+    _startpos_upper_bound = _startpos_lower_bound;
+    _endpos_upper_bound = _endpos_lower_bound;
+    _gpos_upper_bound = _gpos_lower_bound;
+    _rate_upper_bound = _rate_lower_bound;
+    return false;
+  }
+  return true;
+}
+bool igp::parallel_bigwig_map_file::read_upper_bound() {
+  if (_eof) return false;
+  // chromosomes without any intervals are skipped
+  while (_block_index < _blocks.size() &&
+         _row_index == _blocks.at(_block_index).size()) {
+    ++_block_index;
+    _row_index = 0;
+  }
+  if (_block_index == _blocks.size()) {
+    _eof = true;
+    return false;
+  }
+  const map_block &block = _blocks.at(_block_index);
+  _chr_upper_bound = block.get_chr();
+  _startpos_upper_bound = block.get_startpos(_row_index);
+  _endpos_upper_bound = block.get_endpos(_row_index);
+  _gpos_upper_bound = block.get_gpos(_row_index);
+  _rate_upper_bound = block.get_rate(_row_index);
+  ++_row_index;
+  return true;
+}
+bool igp::parallel_bigwig_map_file::skip_to(const std::string &chr,
+                                            const mpz_class &pos) {
+  return false;
+}
+bool igp::parallel_bigwig_map_file::get_block(map_block *block,
+                                              unsigned max_rows) {
+  block->clear();
+  while (_queued_rows && block->size() < max_rows) {
+    if (!block->empty() && block->get_chr().compare(_chr_lower_bound)) {
+      break;
+    }
+    block->append(_chr_lower_bound, _startpos_lower_bound, _endpos_lower_bound,
+                  _gpos_lower_bound, _rate_lower_bound);
+    // the emitted row leaves the window; a new one enters unless the
+    // map is exhausted
+    if (!get()) {
+      --_queued_rows;
+    }
+  }
+  return !block->empty();
+}
+void igp::parallel_bigwig_map_file::close() {
+  if (!_chromosomes.empty()) {
+    bwCleanup();
+  }
+  _chromosomes.clear();
+  _blocks.clear();
+  _block_index = 0;
+  _row_index = 0;
+  _eof = false;
+  _queued_rows = 0;
+}
+bool igp::parallel_bigwig_map_file::eof() { return _eof; }
+std::string igp::parallel_bigwig_map_file::get_chr_lower_bound() const {
+  return _chr_lower_bound;
+}
+std::string igp::parallel_bigwig_map_file::get_chr_upper_bound() const {
+  return _chr_upper_bound;
+}
+mpz_class igp::parallel_bigwig_map_file::get_startpos_lower_bound() const {
+  return _startpos_lower_bound;
+}
+mpz_class igp::parallel_bigwig_map_file::get_startpos_upper_bound() const {
+  return _startpos_upper_bound;
+}
+mpz_class igp::parallel_bigwig_map_file::get_endpos_lower_bound() const {
+  return _endpos_lower_bound;
+}
+mpz_class igp::parallel_bigwig_map_file::get_endpos_upper_bound() const {
+  return _endpos_upper_bound;
+}
+mpf_class igp::parallel_bigwig_map_file::get_gpos_lower_bound() const {
+  return _gpos_lower_bound;
+}
+mpf_class igp::parallel_bigwig_map_file::get_gpos_upper_bound() const {
+  return _gpos_upper_bound;
+}
+mpf_class igp::parallel_bigwig_map_file::get_rate_lower_bound() const {
+  return _rate_lower_bound;
+}
+mpf_class igp::parallel_bigwig_map_file::get_rate_upper_bound() const {
+  return _rate_upper_bound;
+}
+void igp::parallel_bigwig_map_file::set_threads(unsigned n_threads) {
+  if (!n_threads) {
+    throw std::runtime_error(
+        "parallel_bigwig_map_file::set_threads: at least one thread is "
+        "required");
+  }
+  _threads = n_threads;
+}
+unsigned igp::parallel_bigwig_map_file::get_threads() const {
+  return _threads;
+}
+void igp::parallel_bigwig_map_file::set_accumulate_gpos(bool accumulate) {
+  _accumulate_gpos = accumulate;
+}
+bool igp::parallel_bigwig_map_file::get_accumulate_gpos() const {
+  return _accumulate_gpos;
+}
@@ -0,0 +1,233 @@
+/*!
+ \file parallel_bigwig_map_file.h
+ \brief bigwig genetic map decoded in parallel into memory
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_PARALLEL_BIGWIG_MAP_FILE_H_
+#define INTERPOLATE_GENETIC_POSITION_PARALLEL_BIGWIG_MAP_FILE_H_
+
+#include <bigWig.h>
+#include <gmpxx.h>
+
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "interpolate-genetic-position/bigwig_reader.h"
+#include "interpolate-genetic-position/input_genetic_map_file.h"
+#include "interpolate-genetic-position/map_block.h"
+#include "interpolate-genetic-position/utilities.h"
+
+namespace interpolate_genetic_position {
+/*!
+ * \class parallel_bigwig_map_file
+ * \brief bigwig genetic map input that decodes every chromosome up
+ * front, several at a time, and then serves rows from memory.
+ *
+ * libBigWig handles cannot be shared between threads, so each worker
+ * opens its own handle to the file and claims chromosomes from the
+ * header until none are left. Workers also accumulate the genetic
+ * position of each row, which restarts at 0 on every chromosome, with
+ * the same GMP arithmetic as input_genetic_map_file. Rows, bounds and
+ * eof() therefore match input_genetic_map_file on the same bigwig
+ * exactly; the cost is holding the whole map in memory.
+ */
+class parallel_bigwig_map_file : public base_input_genetic_map_file {
+ public:
+  /*!
+   * \brief basic constructor
+   */
+  parallel_bigwig_map_file();
+  /*!
+   * \brief copy constructor
+   * \param obj existing parallel_bigwig_map_file
+   *
+   * Copy constructor is disabled, as the decoded map can be very large.
+   */
+  parallel_bigwig_map_file(const parallel_bigwig_map_file &obj);
+  /*!
+   * \brief destructor
+   */
+  ~parallel_bigwig_map_file() throw();
+  /*!
+   * \brief decode a bigwig map into memory
+   * \param filename name of bigwig file to open
+   * \param ft format of input genetic map; must be BIGWIG
+   */
+  void open(const std::string &filename, format_type ft);
+  /*!
+   * \brief set the fallback stream for data
+   * \param ptr pointer to the fallback stream
+   *
+   * Bigwigs cannot be streamed, so this is only stored for the interface.
+   */
+  void set_fallback_stream(std::istream *ptr);
+  /*!
+   * \brief get the fallback stream for data
+   * \return pointer to the fallback stream
+   */
+  std::istream *get_fallback_stream() const;
+  /*!
+   * \brief get the next genetic map entry and store it in internal buffer
+   * \return boolean indicating whether a new entry was successfully
+   * loaded. FALSE should indicate EOF.
+   */
+  bool get();
+  /*!
+   * \brief release the decoded map
+   */
+  void close();
+  /*!
+   * \brief test for EOF
+   * \return whether an attempt to read past the final row has been made
+   */
+  bool eof();
+  /*!
+   * \brief get chromosome of lower boundary of cached range
+   * \return chromosome of lower boundary of cached range
+   */
+  std::string get_chr_lower_bound() const;
+  /*!
+   * \brief get chromosome of upper boundary of cached range
+   * \return chromosome of upper boundary of cached range
+   */
+  std::string get_chr_upper_bound() const;
+  /*!
+   * \brief get start physical position of lower boundary of cached range
+   * \return start physical position of lower boundary of cached range
+   */
+  mpz_class get_startpos_lower_bound() const;
+  /*!
+   * \brief get start physical position of upper boundary of cached range
+   * \return start physical position of upper boundary of cached range
+   */
+  mpz_class get_startpos_upper_bound() const;
+  /*!
+   * \brief get end physical position of lower boundary of cached range
+   * \return end physical position of lower boundary of cached range
+   */
+  mpz_class get_endpos_lower_bound() const;
+  /*!
+   * \brief get end physical position of upper boundary of cached range
+   * \return end physical position of upper boundary of cached range
+   */
+  mpz_class get_endpos_upper_bound() const;
+  /*!
+   * \brief get genetic position of lower boundary of cached range
+   * \return genetic position of lower boundary of cached range
+   */
+  mpf_class get_gpos_lower_bound() const;
+  /*!
+   * \brief get genetic position of upper boundary of cached range
+   * \return genetic position of upper boundary of cached range
+   */
+  mpf_class get_gpos_upper_bound() const;
+  /*!
+   * \brief get rate of change of genetic distance at lower boundary of cached
+   * range \return rate of change of genetic distance at lower boundary of
+   * cached range
+   */
+  mpf_class get_rate_lower_bound() const;
+  /*!
+   * \brief get rate of change of genetic distance at upper boundary of cached
+   * range \return rate of change of genetic distance at upper boundary of
+   * cached range
+   */
+  mpf_class get_rate_upper_bound() const;
+  /*!
+   * \brief load the next run of map rows from a single chromosome
+   * \param block pointer to block to fill; existing contents are replaced
+   * \param max_rows maximum number of rows to load
+   * \return whether any rows were loaded. FALSE should indicate EOF.
+   */
+  bool get_block(map_block *block, unsigned max_rows);
+  /*!
+   * \brief advance the cursor toward a query without reading the map
+   * rows in between
+   * \param chr chromosome of the next query
+   * \param pos physical position of the next query
+   * \return false
+   *
+   * Decoded chromosomes are walked in order, so the cursor stays in
+   * place.
+   */
+  bool skip_to(const std::string &chr, const mpz_class &pos);
+  /*!
+   * \brief set the number of chromosomes decoded at once
+   * \param n_threads number of worker threads, each with its own handle
+   */
+  void set_threads(unsigned n_threads);
+  /*!
+   * \brief get the number of chromosomes decoded at once
+   * \return number of worker threads, each with its own handle
+   */
+  unsigned get_threads() const;
+  /*!
+   * \brief set whether genetic position is accumulated while decoding
+   * \param accumulate whether genetic position is accumulated; if not,
+   * every row reports genetic position 0
+   *
+   * Set before open().
+   */
+  void set_accumulate_gpos(bool accumulate);
+  /*!
+   * \brief get whether genetic position is accumulated while decoding
+   * \return whether genetic position is accumulated
+   */
+  bool get_accumulate_gpos() const;
+
+ private:
+  /*!
+   * \brief decode one chromosome from a bigwig handle
+   * \param input open bigwig handle, used only by the calling thread
+   * \param chr name of chromosome in bigwig header
+   * \param block pointer to block to fill with every row of chr
+   */
+  void decode_chromosome(bigWigFile_t *input, const std::string &chr,
+                         map_block *block) const;
+  /*!
+   * \brief body of a worker thread
+   * \param filename name of bigwig file
+   * \param next pointer to index of next unclaimed chromosome
+   * \param error pointer to storage for any failure of the worker
+   */
+  void decode_chromosomes(const std::string &filename,
+                          std::atomic<unsigned> *next,
+                          std::exception_ptr *error);
+  /*!
+   * \brief read the next decoded row into the upper bound fields
+   * \return whether a row was read
+   */
+  bool read_upper_bound();
+  std::istream *_fallback;              //!< pointer to fallback stream
+  unsigned _threads;                    //!< number of worker threads
+  bool _accumulate_gpos;                //!< whether gpos is accumulated
+  std::vector<std::string> _chromosomes;  //!< chromosomes, in map order
+  std::vector<map_block> _blocks;       //!< decoded rows per chromosome
+  unsigned _block_index;                //!< block of next row to read
+  unsigned _row_index;                  //!< index of next row in block
+  bool _eof;                            //!< whether rows are exhausted
+  std::string _chr_lower_bound;         //!< chromosome of previous entry
+  std::string _chr_upper_bound;         //!< chromosome of new entry
+  mpz_class
+      _startpos_lower_bound;  //!< start physical position of previous entry
+  mpz_class _startpos_upper_bound;  //!< start physical position of new entry
+  mpz_class _endpos_lower_bound;    //!< end physical position of previous entry
+  mpz_class _endpos_upper_bound;    //!< end physical position of new entry
+  mpf_class _gpos_lower_bound;      //!< genetic position of previous entry
+  mpf_class _gpos_upper_bound;      //!< genetic position of new entry
+  mpf_class
+      _rate_lower_bound;  //!< point recombination rate change of previous entry
+  mpf_class
+      _rate_upper_bound;  //!< point recombination rate change of new entry
+  unsigned _queued_rows;  //!< rows in the bound window not yet in a block
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_PARALLEL_BIGWIG_MAP_FILE_H_
@@ -23,16 +23,34 @@ igp::query_file::query_file(base_input_variant_file *inptr,
       _ft(UNKNOWN),
       _output(outptr),
       _previous_chromosome(""),
-      _previous_bed_label("") {}
+      _previous_bed_label(""),
+      _id_column(passthrough_absent),
+      _a1_column(passthrough_absent),
+      _a2_column(passthrough_absent),
+      _label_column(3),
+      _pipeline(NULL),
+      _vcf_output(false),
+      _pvar_cm_column(-1),
+      _pvar_output(false),
+      _owns_input(true),
+      _retain_vcf_records(false),
+      _retain_line_contents(false),
+      _result_set(0) {}
 igp::query_file::~query_file() throw() {}
 void igp::query_file::open(const std::string &filename, format_type ft) {
   _ft = ft;
+  _owns_input = true;
   _interface->open(filename);
   // handle file formats
+  _id_column = _a1_column = _a2_column = passthrough_absent;
   if (_ft == BIM) {
     _interface->set_format_parameters(0, 3, -1, 2, false, 6);
+    _id_column = 1;
+    _a1_column = 4;
+    _a2_column = 5;
   } else if (_ft == MAP) {
     _interface->set_format_parameters(0, 3, -1, 2, false, 4);
+    _id_column = 1;
   } else if (_ft == BED) {
     _interface->set_format_parameters(0, 1, 2, 4, true, 4);
   } else if (_ft == SNP) {
@@ -40,10 +58,127 @@ void igp::query_file::open(const std::string &filename, format_type ft) {
   } else if (_ft == VCF) {
     // these are ignored due to use of htslib
     _interface->set_format_parameters(0, 1, -1, -1, false, 9);
+    _id_column = _a1_column = _a2_column = passthrough_from_variant;
+  } else if (_ft == PVAR) {
+    open_pvar();
   }
 }
+void igp::query_file::share_input(const query_file &source) {
+  if (source._ft == UNKNOWN) {
+    throw std::runtime_error(
+        "query_file::share_input: source input is not open");
+  }
+  _interface = source._interface;
+  _ft = source._ft;
+  _id_column = source._id_column;
+  _a1_column = source._a1_column;
+  _a2_column = source._a2_column;
+  _label_column = source._label_column;
+  _pvar_header = source._pvar_header;
+  _pvar_cm_column = source._pvar_cm_column;
+  _owns_input = false;
+}
+void igp::query_file::add_batch_reporter(const query_file &reporter) {
+  if (reporter._interface != _interface) {
+    throw std::runtime_error(
+        "query_file::add_batch_reporter: reporter does not share this input");
+  }
+  _retain_vcf_records = _retain_vcf_records || reporter._retain_vcf_records;
+  _retain_line_contents =
+      _retain_line_contents || reporter._retain_line_contents;
+  if (_ft == VCF) {
+    // decode the vcf fields that any of the outputs reports
+    if (reporter._id_column == passthrough_from_variant) {
+      _id_column = passthrough_from_variant;
+    }
+    if (reporter._a1_column == passthrough_from_variant) {
+      _a1_column = _a2_column = passthrough_from_variant;
+    }
+    _interface->set_vcf_fields(_id_column == passthrough_from_variant,
+                               _a1_column == passthrough_from_variant,
+                               _retain_vcf_records);
+  }
+}
+void igp::query_file::open_pvar() {
+  _interface->read_header("#", &_pvar_header);
+  if (_pvar_header.empty() || _pvar_header.back().find("#CHROM") != 0) {
+    throw std::runtime_error(
+        "query_file::open: pvar input must have a header ending with a "
+        "#CHROM line; for headerless pvar files, use the bim preset");
+  }
+  // the column layout is declared by the header
+  std::istringstream strm1(_pvar_header.back().substr(1));
+  std::vector<std::string> columns;
+  std::string column = "";
+  while (strm1 >> column) {
+    columns.push_back(column);
+  }
+  int chr_index = -1, pos_index = -1, id_index = -1, ref_index = -1,
+      alt_index = -1;
+  _pvar_cm_column = -1;
+  for (unsigned i = 0; i < columns.size(); ++i) {
+    const std::string &name = columns.at(i);
+    if (!name.compare("CHROM")) {
+      chr_index = i;
+    } else if (!name.compare("POS")) {
+      pos_index = i;
+    } else if (!name.compare("ID")) {
+      id_index = i;
+    } else if (!name.compare("REF")) {
+      ref_index = i;
+    } else if (!name.compare("ALT")) {
+      alt_index = i;
+    } else if (!name.compare("CM")) {
+      _pvar_cm_column = i;
+    }
+  }
+  if (chr_index < 0 || pos_index < 0 || id_index < 0 || ref_index < 0 ||
+      alt_index < 0) {
+    throw std::runtime_error(
+        "query_file::open: pvar header is missing one of the required "
+        "columns CHROM, POS, ID, REF, ALT");
+  }
+  _interface->set_format_parameters(
+      chr_index, pos_index, -1, _pvar_cm_column < 0 ? 0 : _pvar_cm_column,
+      false, columns.size());
+  // allele order matches plink's conversion of pvar to bim
+  _id_column = id_index;
+  _a1_column = alt_index;
+  _a2_column = ref_index;
+}
 void igp::query_file::initialize_output(const std::string &filename,
                                         format_type ft) {
+  // vcf/bcf output annotates the input records themselves
+  _vcf_output = ft == VCF || ft == BCF;
+  // pvar output rewrites the input lines themselves
+  _pvar_output = ft == PVAR;
+  _retain_vcf_records = _vcf_output;
+  _retain_line_contents = _pvar_output;
+  if (_pvar_output) {
+    if (_ft != PVAR) {
+      throw std::runtime_error(
+          "query_file::initialize_output: pvar output requires pvar input");
+    }
+    _output->set_pvar_header(_pvar_header, _pvar_cm_column);
+  }
+  if (_ft == VCF) {
+    // only decode the vcf fields that the output format reports
+    bool need_varid = ft == BIM || ft == MAP || ft == SNP || ft == ARROW;
+    bool need_alleles = ft == BIM || ft == ARROW;
+    _id_column = need_varid ? passthrough_from_variant : passthrough_absent;
+    _a1_column = _a2_column =
+        need_alleles ? passthrough_from_variant : passthrough_absent;
+    _interface->set_vcf_fields(need_varid, need_alleles, _vcf_output);
+  }
+  if (_vcf_output) {
+    const bcf_hdr_t *header = _interface->get_vcf_header();
+    if (!header) {
+      throw std::runtime_error(
+          "query_file::initialize_output: vcf/bcf output requires vcf/bcf "
+          "input");
+    }
+    _output->set_vcf_header(header);
+  }
   _output->open(filename, ft);
 }
 bool igp::query_file::get() { return _interface->get_variant(); }
@@ -57,12 +192,136 @@ const mpz_class &igp::query_file::get_pos2() const {
   return _interface->get_pos2();
 }
 void igp::query_file::close() {
-  _interface->close();
+  if (_owns_input) {
+    _interface->close();
+  }
   _output->close();
 }
 bool igp::query_file::eof() { return _interface->eof(); }
 void igp::query_file::report(const std::vector<query_result> &results) {
+  if (_vcf_output) {
+    _output->write_vcf(_interface->get_vcf_record(),
+                       results.begin()->get_gpos(),
+                       results.begin()->get_rate());
+    return;
+  }
+  if (_pvar_output) {
+    _output->write_pvar(_interface->get_line_contents(),
+                        results.begin()->get_chr(),
+                        results.begin()->get_gpos());
+    return;
+  }
   std::string id = "", a1 = "", a2 = "";
+  fill_passthrough_fields(&id, &a1, &a2);
+  report(results, id, a1, a2,
+         _interface->get_line_contents().at(
+             static_cast<unsigned>(_label_column)));
+}
+unsigned igp::query_file::get_batch(record_batch *batch, unsigned max_records) {
+  batch->set_passthrough_columns(_id_column, _a1_column, _a2_column,
+                                 _label_column);
+  batch->set_retain_vcf_records(_retain_vcf_records);
+  batch->set_retain_line_contents(_retain_line_contents);
+  return _interface->next_batch(batch, max_records);
+}
+void igp::query_file::report(const record_batch &batch) {
+  if (_pipeline) {
+    if (!batch.empty()) {
+      _pipeline->report(batch, _result_set);
+      unsigned last = batch.size() - 1;
+      set_previous_chromosome(
+          batch.get_results(last, _result_set).begin()->get_chr());
+      set_previous_bed_label(batch.get_label(last));
+    }
+    return;
+  }
+  for (unsigned i = 0; i < batch.size(); ++i) {
+    if (_vcf_output) {
+      const std::vector<query_result> &results =
+          batch.get_results(i, _result_set);
+      _output->write_vcf(batch.get_vcf_record(i),
+                         results.begin()->get_gpos(),
+                         results.begin()->get_rate());
+      continue;
+    }
+    if (_pvar_output) {
+      const std::vector<query_result> &results =
+          batch.get_results(i, _result_set);
+      _output->write_pvar(batch.get_line_contents(i),
+                          results.begin()->get_chr(),
+                          results.begin()->get_gpos());
+      continue;
+    }
+    report(batch.get_results(i, _result_set), batch.get_id(i),
+           batch.get_a1(i), batch.get_a2(i), batch.get_label(i));
+  }
+}
+void igp::query_file::report_sweep(const record_batch &batch, genetic_map *gm,
+                                   bool verbose) {
+  if (_vcf_output || _pvar_output) {
+    throw std::runtime_error(
+        "query_file::report_sweep: output rewriting input records cannot be "
+        "streamed");
+  }
+  if (_pipeline) {
+    if (!batch.empty()) {
+      _pipeline->report_sweep(batch, gm, verbose);
+      unsigned last = batch.size() - 1;
+      set_previous_chromosome(batch.get_chr(last));
+      set_previous_bed_label(batch.get_label(last));
+    }
+    return;
+  }
+  for (unsigned i = 0; i < batch.size(); ++i) {
+    const std::string &label = batch.get_label(i);
+    set_previous_chromosome(batch.get_chr(i));
+    if (_ft == BED && get_previous_bed_label().compare(label) &&
+        !get_previous_bed_label().empty()) {
+      _output->set_index_on_chromosome(_output->get_index_on_chromosome() + 1);
+    }
+    const std::string &id = batch.get_id(i);
+    const std::string &a1 = batch.get_a1(i);
+    const std::string &a2 = batch.get_a2(i);
+    gm->sweep(batch.get_chr(i), batch.get_pos1(i), batch.get_pos2(i), verbose,
+              [&](const query_result &result) {
+                _output->write(result.get_chr(), result.get_startpos(),
+                               result.get_endpos(), id, result.get_gpos(),
+                               result.get_rate(), a1, a2);
+              });
+    set_previous_bed_label(label);
+  }
+}
+void igp::query_file::set_result_set(unsigned result_set) {
+  _result_set = result_set;
+}
+void igp::query_file::set_format_pipeline(base_format_pipeline *pipeline) {
+  _pipeline = pipeline;
+}
+void igp::query_file::fill_passthrough_fields(std::string *id, std::string *a1,
+                                              std::string *a2) const {
+  // vcf readers parse fields themselves, and have no tokenized line
+  if (_id_column == passthrough_from_variant) {
+    *id = _interface->get_varid();
+  } else if (_id_column >= 0) {
+    *id = _interface->get_line_contents().at(
+        static_cast<unsigned>(_id_column));
+  }
+  if (_a1_column == passthrough_from_variant) {
+    *a1 = _interface->get_a1();
+  } else if (_a1_column >= 0) {
+    *a1 = _interface->get_line_contents().at(
+        static_cast<unsigned>(_a1_column));
+  }
+  if (_a2_column == passthrough_from_variant) {
+    *a2 = _interface->get_a2();
+  } else if (_a2_column >= 0) {
+    *a2 = _interface->get_line_contents().at(
+        static_cast<unsigned>(_a2_column));
+  }
+}
+void igp::query_file::report(const std::vector<query_result> &results,
+                             const std::string &id, const std::string &a1,
+                             const std::string &a2, const std::string &label) {
   if (get_previous_chromosome().compare(results.begin()->get_chr())) {
     set_previous_chromosome(results.begin()->get_chr());
   }
@@ -71,29 +330,16 @@ void igp::query_file::report(const std::vector<query_result> &results) {
    * of whether the query should be considered part of a different unit
    * than the previous query, with respect to fixed value increments.
    */
-  if (_ft == BED &&
-      get_previous_bed_label().compare(_interface->get_line_contents().at(3)) &&
+  if (_ft == BED && get_previous_bed_label().compare(label) &&
       !get_previous_bed_label().empty()) {
     _output->set_index_on_chromosome(_output->get_index_on_chromosome() + 1);
   }
   for (std::vector<query_result>::const_iterator iter = results.begin();
        iter != results.end(); ++iter) {
-    if (_ft == BIM || _ft == MAP) {
-      id = _interface->get_line_contents().at(1);
-    }
-    if (_ft == BIM) {
-      a1 = _interface->get_line_contents().at(4);
-      a2 = _interface->get_line_contents().at(5);
-    }
-    if (_ft == VCF) {
-      id = _interface->get_varid();
-      a1 = _interface->get_a1();
-      a2 = _interface->get_a2();
-    }
     _output->write(iter->get_chr(), iter->get_startpos(), iter->get_endpos(),
                    id, iter->get_gpos(), iter->get_rate(), a1, a2);
   }
-  set_previous_bed_label(_interface->get_line_contents().at(3));
+  set_previous_bed_label(label);
 }
 const mpf_class &igp::query_file::get_step_interval() const {
   if (_output) {
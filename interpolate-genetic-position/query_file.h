@@ -19,8 +19,11 @@
 #include <string>
 #include <vector>
 
+#include "interpolate-genetic-position/format_pipeline.h"
+#include "interpolate-genetic-position/genetic_map.h"
 #include "interpolate-genetic-position/input_variant_file.h"
 #include "interpolate-genetic-position/output_variant_file.h"
+#include "interpolate-genetic-position/record_batch.h"
 #include "interpolate-genetic-position/utilities.h"
 
 namespace interpolate_genetic_position {
@@ -65,12 +68,35 @@ class query_file {
    * \param ft descriptor of query file format
    */
   void open(const std::string &filename, format_type ft);
+  /*!
+   * \brief report queries read through another query_file
+   * \param source query_file whose input is already open
+   *
+   * The input format and column layout are taken from source. Batches
+   * read by source can then be reported through this object's own
+   * output; this object never reads input, and close() leaves the
+   * shared input to source.
+   */
+  void share_input(const query_file &source);
+  /*!
+   * \brief keep in each batch whatever another query_file sharing this
+   * input needs to report it
+   * \param reporter query_file whose input is shared from this object,
+   * with its output already initialized
+   *
+   * Batches read by get_batch() then carry the union of the fields
+   * needed by this object's output and by reporter's.
+   */
+  void add_batch_reporter(const query_file &reporter);
   /*!
    * \brief initialize output file connection
    * \param filename name of output file. if an empty string,
    * the output is assumed to go to cout, and logic skips
    * opening the stream but otherwise proceeds as usual
    * \param ft descriptor of output file format
+   *
+   * vcf/bcf output annotates the input records, so for those formats
+   * the input must already be open, and must itself be vcf/bcf.
    */
   void initialize_output(const std::string &filename, format_type ft);
   /*!
@@ -127,7 +153,8 @@ class query_file {
    */
   void set_previous_bed_label(const std::string &label);
   /*!
-   * \brief close any input connection
+   * \brief close any input connection, unless it is shared from another
+   * query_file, and the output connection
    */
   void close();
   /*!
@@ -144,13 +171,103 @@ class query_file {
    * \param results a vector of results corresponding to an input query
    */
   void report(const std::vector<query_result> &results);
+  /*!
+   * \brief load up to a fixed number of queries from file into a batch
+   * \param batch pointer to batch to fill; existing contents are replaced
+   * \param max_records maximum number of queries to load
+   * \return number of queries loaded. 0 should indicate EOF.
+   *
+   * Everything report() needs from the input line is copied into the
+   * batch, so the batch can be reported after further input is read,
+   * potentially from a different thread than the one reading input.
+   * Parsing is delegated to the input interface's next_batch(). For
+   * vcf/bcf output, the input records themselves are copied as well.
+   */
+  unsigned get_batch(record_batch *batch, unsigned max_records);
+  /*!
+   * \brief report the interpolated results of every query in a batch,
+   * in order
+   * \param batch batch of queries with results filled in
+   *
+   * If a format pipeline has been set, reporting is delegated to it.
+   */
+  void report(const record_batch &batch);
+  /*!
+   * \brief interpolate and report every query in a batch, in order,
+   * writing each segment of a query as soon as it is interpolated
+   * \param batch batch of queries; results are not filled in
+   * \param gm pointer to opened genetic map
+   * \param verbose whether to emit (extremely) verbose logging
+   *
+   * Intended for bed input, where a single region may span a very
+   * large number of map intervals. If a format pipeline has been set,
+   * reporting is delegated to it.
+   */
+  void report_sweep(const record_batch &batch, genetic_map *gm,
+                    bool verbose);
+  /*!
+   * \brief set which result set of each batch report() writes
+   * \param result_set index of result set
+   */
+  void set_result_set(unsigned result_set);
+  /*!
+   * \brief set a format-specialized pipeline for batch reporting
+   * \param pipeline pipeline matching the query and output formats of
+   * this object, or NULL to report through the output interface
+   *
+   * The pipeline is not owned by this object, and must outlive its use.
+   */
+  void set_format_pipeline(base_format_pipeline *pipeline);
 
  private:
+  /*!
+   * \brief configure the input column layout from a pvar header
+   *
+   * Consumes the header, which must end with a #CHROM line naming the
+   * columns; at least CHROM, POS, ID, REF and ALT are required.
+   */
+  void open_pvar();
+  /*!
+   * \brief extract the fields of the current input line that are
+   * passed through to output unchanged
+   * \param id pointer to storage for variant identifier
+   * \param a1 pointer to storage for first allele
+   * \param a2 pointer to storage for second allele
+   *
+   * Fields that the input format does not provide are left unmodified.
+   * Sources of each field are the same as those get_batch() configures.
+   */
+  void fill_passthrough_fields(std::string *id, std::string *a1,
+                               std::string *a2) const;
+  /*!
+   * \brief report results of a single query
+   * \param results a vector of results corresponding to an input query
+   * \param id variant identifier of query
+   * \param a1 first allele of query
+   * \param a2 second allele of query
+   * \param label bed-style region label of query
+   */
+  void report(const std::vector<query_result> &results, const std::string &id,
+              const std::string &a1, const std::string &a2,
+              const std::string &label);
   base_input_variant_file *_interface;  //!< input file handler
   format_type _ft;                      //!< stored format of input filestream
   base_output_variant_file *_output;    //!< interface class to output
   std::string _previous_chromosome;     //!< name of chromosome for prior output
   std::string _previous_bed_label;      //!< label of previous bed format query
+  int _id_column;     //!< passthrough source of variant identifier
+  int _a1_column;     //!< passthrough source of first allele
+  int _a2_column;     //!< passthrough source of second allele
+  int _label_column;  //!< passthrough source of bed-style region label
+  base_format_pipeline *_pipeline;  //!< optional batch reporting pipeline
+  bool _vcf_output;  //!< whether output annotates input vcf records
+  std::vector<std::string> _pvar_header;  //!< header lines of pvar input
+  int _pvar_cm_column;  //!< index of CM column of pvar input, or -1
+  bool _pvar_output;    //!< whether output rewrites input pvar lines
+  bool _owns_input;     //!< whether close() closes the input
+  bool _retain_vcf_records;    //!< whether batches keep input vcf records
+  bool _retain_line_contents;  //!< whether batches keep input lines
+  unsigned _result_set;        //!< result set of batches to report
 };
 }  // namespace interpolate_genetic_position
 
@@ -0,0 +1,198 @@
+/*!
+ \file readahead_line_reader.cc
+ \brief implementation of background read-ahead line reader
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/readahead_line_reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace igp = interpolate_genetic_position;
+
+igp::readahead_line_reader::readahead_line_reader(gzFile source,
+                                                  unsigned chunk_size)
+    : _gzsource(source),
+      _stream_source(NULL),
+      _seekable_source(NULL),
+      _filled(2),
+      _consumed(2),
+      _abort(false),
+      _current(NULL),
+      _pos(0),
+      _finished(false) {
+  if (!_gzsource) {
+    throw std::runtime_error("readahead_line_reader: source is NULL");
+  }
+  start(chunk_size);
+}
+igp::readahead_line_reader::readahead_line_reader(std::istream *source,
+                                                  unsigned chunk_size)
+    : _gzsource(NULL),
+      _stream_source(source),
+      _seekable_source(NULL),
+      _filled(2),
+      _consumed(2),
+      _abort(false),
+      _current(NULL),
+      _pos(0),
+      _finished(false) {
+  if (!_stream_source) {
+    throw std::runtime_error("readahead_line_reader: source is NULL");
+  }
+  start(chunk_size);
+}
+igp::readahead_line_reader::readahead_line_reader(
+    seekable_gzip_reader *source, unsigned chunk_size)
+    : _gzsource(NULL),
+      _stream_source(NULL),
+      _seekable_source(source),
+      _filled(2),
+      _consumed(2),
+      _abort(false),
+      _current(NULL),
+      _pos(0),
+      _finished(false) {
+  if (!_seekable_source) {
+    throw std::runtime_error("readahead_line_reader: source is NULL");
+  }
+  start(chunk_size);
+}
+igp::readahead_line_reader::readahead_line_reader(
+    const readahead_line_reader &obj)
+    : _filled(2), _consumed(2) {
+  throw std::runtime_error(
+      "readahead_line_reader: copy constructor operation is invalid for "
+      "this class");
+}
+igp::readahead_line_reader::~readahead_line_reader() throw() {
+  _abort.store(true);
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+void igp::readahead_line_reader::start(unsigned chunk_size) {
+  if (!chunk_size) {
+    throw std::runtime_error(
+        "readahead_line_reader: chunk size must be nonzero");
+  }
+  for (unsigned i = 0; i < 2; ++i) {
+    _chunks[i].data.resize(chunk_size);
+    _chunks[i].size = 0;
+    _chunks[i].last = false;
+    _consumed.try_push(&_chunks[i]);
+  }
+  _thread = std::thread(&readahead_line_reader::read_chunks, this);
+}
+void igp::readahead_line_reader::read_chunks() {
+  chunk *target = NULL;
+  while (_consumed.pop(&target, _abort)) {
+    try {
+      fill(target);
+    } catch (...) {
+      // handed to the caller along with an end of input marker
+      _error = std::current_exception();
+      target->size = 0;
+      target->last = true;
+    }
+    if (!_filled.push(target, _abort) || target->last) {
+      return;
+    }
+  }
+}
+void igp::readahead_line_reader::fill(chunk *target) {
+  target->size = 0;
+  target->last = false;
+  if (_gzsource) {
+    int n_read = gzread(_gzsource, target->data.data(),
+                        static_cast<unsigned>(target->data.size()));
+    if (n_read < 0) {
+      int errnum = 0;
+      throw std::runtime_error("readahead_line_reader: cannot read gzfile: " +
+                               std::string(gzerror(_gzsource, &errnum)));
+    }
+    target->size = static_cast<size_t>(n_read);
+  } else if (_seekable_source) {
+    target->size =
+        _seekable_source->read(target->data.data(), target->data.size());
+  } else {
+    _stream_source->read(target->data.data(),
+                         static_cast<std::streamsize>(target->data.size()));
+    if (_stream_source->bad()) {
+      throw std::runtime_error("readahead_line_reader: cannot read stream");
+    }
+    target->size = static_cast<size_t>(_stream_source->gcount());
+  }
+  target->last = target->size == 0;
+}
+bool igp::readahead_line_reader::advance() {
+  while (!_current || _pos == _current->size) {
+    if (_finished) {
+      return false;
+    }
+    if (_current) {
+      // capacity matches the number of chunks, so this cannot fail
+      _consumed.try_push(_current);
+      _current = NULL;
+    }
+    chunk *next = NULL;
+    // the reader thread always delivers a final chunk, so this cannot
+    // wait forever
+    _filled.pop(&next, _abort);
+    if (next->last) {
+      _finished = true;
+      if (_error) {
+        std::rethrow_exception(_error);
+      }
+      return false;
+    }
+    _current = next;
+    _pos = 0;
+  }
+  return true;
+}
+bool igp::readahead_line_reader::getline(std::string_view *line) {
+  bool spilled = false;
+  while (advance()) {
+    const char *start = _current->data.data() + _pos;
+    size_t available = _current->size - _pos;
+    const char *newline =
+        static_cast<const char *>(memchr(start, '\n', available));
+    if (newline) {
+      size_t length = static_cast<size_t>(newline - start);
+      _pos += length + 1;
+      if (spilled) {
+        _spill.append(start, length);
+        *line = _spill;
+      } else {
+        *line = std::string_view(start, length);
+      }
+      return true;
+    }
+    // the line continues into the next chunk
+    if (!spilled) {
+      _spill.clear();
+      spilled = true;
+    }
+    _spill.append(start, available);
+    _pos = _current->size;
+  }
+  // a final line without a trailing newline
+  if (spilled) {
+    *line = _spill;
+    return true;
+  }
+  return false;
+}
+bool igp::readahead_line_reader::skip(size_t n) {
+  while (n && advance()) {
+    size_t step = std::min(n, _current->size - _pos);
+    _pos += step;
+    n -= step;
+  }
+  return !n;
+}
+bool igp::readahead_line_reader::eof() { return !advance(); }
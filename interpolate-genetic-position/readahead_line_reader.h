@@ -0,0 +1,148 @@
+/*!
+ \file readahead_line_reader.h
+ \brief line reader that fills buffers on a background thread
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_READAHEAD_LINE_READER_H_
+#define INTERPOLATE_GENETIC_POSITION_READAHEAD_LINE_READER_H_
+
+#include <zlib.h>
+
+#include <atomic>
+#include <exception>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "interpolate-genetic-position/ring_buffer.h"
+#include "interpolate-genetic-position/seekable_gzip_reader.h"
+
+namespace interpolate_genetic_position {
+/*!
+ * \class readahead_line_reader
+ * \brief read newline-delimited text from a gzip stream, a seekable
+ * gzip reader or an input stream, with a background thread reading the next chunk while the
+ * caller parses the current one.
+ *
+ * Two chunks are in flight at once, handed between the threads through
+ * a pair of ring buffers: one carrying filled chunks to the caller, one
+ * returning consumed chunks to the reader thread for reuse. A storage
+ * stall therefore only blocks the caller once both chunks are consumed.
+ *
+ * The source must not be touched by anything else for the lifetime of
+ * this object, and must outlive it.
+ */
+class readahead_line_reader {
+ public:
+  /*!
+   * \brief read ahead from a gzip stream
+   * \param source open gzip stream, positioned where reading should start
+   * \param chunk_size number of bytes requested from the source at once
+   */
+  explicit readahead_line_reader(gzFile source,
+                                 unsigned chunk_size = default_chunk_size);
+  /*!
+   * \brief read ahead from an input stream
+   * \param source open input stream, positioned where reading should start
+   * \param chunk_size number of bytes requested from the source at once
+   */
+  explicit readahead_line_reader(std::istream *source,
+                                 unsigned chunk_size = default_chunk_size);
+  /*!
+   * \brief read ahead from a seekable gzip reader
+   * \param source open reader, positioned where reading should start
+   * \param chunk_size number of bytes requested from the source at once
+   */
+  explicit readahead_line_reader(seekable_gzip_reader *source,
+                                 unsigned chunk_size = default_chunk_size);
+  /*!
+   * \brief copy constructor
+   *
+   * Copy constructor is disabled due to owned thread.
+   */
+  readahead_line_reader(const readahead_line_reader &obj);
+  /*!
+   * \brief destructor; stops the reader thread
+   */
+  ~readahead_line_reader() throw();
+  /*!
+   * \brief get the next line of text
+   * \param line pointer to storage for a view of the line, without its
+   * newline. the view is valid until the next call
+   * \return whether a line was read
+   *
+   * Waits for the reader thread if the next chunk is not ready yet.
+   * Errors encountered by the reader thread are rethrown here.
+   */
+  bool getline(std::string_view *line);
+  /*!
+   * \brief drop text without splitting it into lines
+   * \param n number of bytes to drop
+   * \return whether all n bytes were dropped; false at end of input
+   *
+   * Meant for moving from the start of one line to the start of a later
+   * one. Waits for the reader thread as getline() does.
+   */
+  bool skip(size_t n);
+  /*!
+   * \brief determine whether all text has been read
+   * \return whether all text has been read
+   *
+   * Waits for the reader thread if the next chunk is not ready yet.
+   */
+  bool eof();
+  static const unsigned default_chunk_size = 1u << 20;  //!< 1 MiB chunks
+
+ private:
+  /*!
+   * \struct chunk
+   * \brief a buffer of raw text passed between threads
+   */
+  struct chunk {
+    std::vector<char> data;  //!< chunk storage
+    size_t size;             //!< number of valid bytes in data
+    bool last;               //!< whether the source is exhausted
+  };
+  /*!
+   * \brief allocate chunks and start the reader thread
+   * \param chunk_size size of each chunk, in bytes
+   */
+  void start(unsigned chunk_size);
+  /*!
+   * \brief body of the reader thread
+   */
+  void read_chunks();
+  /*!
+   * \brief fill a chunk from the source
+   * \param target chunk to fill
+   */
+  void fill(chunk *target);
+  /*!
+   * \brief make sure the current chunk has unread bytes, returning
+   * consumed chunks to the reader thread and waiting for the next one
+   * \return whether unread bytes are available; false at end of input
+   */
+  bool advance();
+  gzFile _gzsource;                     //!< gzip source, if any
+  std::istream *_stream_source;         //!< stream source, if any
+  seekable_gzip_reader *_seekable_source;  //!< seekable source, if any
+  chunk _chunks[2];                     //!< storage for in-flight chunks
+  spsc_ring_buffer<chunk *> _filled;    //!< chunks ready for the caller
+  spsc_ring_buffer<chunk *> _consumed;  //!< chunks ready for refilling
+  std::atomic<bool> _abort;             //!< stops the reader thread
+  std::exception_ptr _error;            //!< failure in the reader thread
+  std::thread _thread;                  //!< reader thread
+  chunk *_current;                      //!< chunk being parsed, if any
+  size_t _pos;                          //!< parse position in current chunk
+  bool _finished;                       //!< whether end of input was seen
+  std::string _spill;                   //!< line spanning a chunk boundary
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_READAHEAD_LINE_READER_H_
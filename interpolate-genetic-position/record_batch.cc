@@ -0,0 +1,235 @@
+/*!
+ \file record_batch.cc
+ \brief implementation of reusable block of query records
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/record_batch.h"
+
+namespace igp = interpolate_genetic_position;
+
+igp::record_batch::record_batch()
+    : _size(0),
+      _n_chr_names(0),
+      _results(1),
+      _id_column(passthrough_absent),
+      _a1_column(passthrough_absent),
+      _a2_column(passthrough_absent),
+      _label_column(passthrough_absent),
+      _empty(""),
+      _retain_vcf_records(false),
+      _retain_line_contents(false) {}
+igp::record_batch::record_batch(const record_batch &obj) {
+  throw std::runtime_error(
+      "record_batch: copy constructor operation is invalid for this class");
+}
+igp::record_batch::~record_batch() throw() {
+  for (std::vector<bcf1_t *>::iterator iter = _vcf_records.begin();
+       iter != _vcf_records.end(); ++iter) {
+    bcf_destroy(*iter);
+  }
+}
+void igp::record_batch::clear() {
+  _size = 0;
+  _n_chr_names = 0;
+}
+unsigned igp::record_batch::size() const { return _size; }
+bool igp::record_batch::empty() const { return !_size; }
+unsigned igp::record_batch::append(const std::string &chr,
+                                   const mpz_class &pos1,
+                                   const mpz_class &pos2,
+                                   const std::string &id,
+                                   const std::string &a1,
+                                   const std::string &a2,
+                                   const std::string &label) {
+  unsigned chr_index = intern_chr(chr);
+  if (_size == _chr.size()) {
+    _chr.push_back(chr_index);
+    _pos1.push_back(pos1);
+    _pos2.push_back(pos2);
+    _id.push_back(id);
+    _a1.push_back(a1);
+    _a2.push_back(a2);
+    _label.push_back(label);
+    for (unsigned set = 0; set < _results.size(); ++set) {
+      _results.at(set).push_back(std::vector<query_result>());
+    }
+  } else {
+    _chr.at(_size) = chr_index;
+    _pos1.at(_size) = pos1;
+    _pos2.at(_size) = pos2;
+    _id.at(_size) = id;
+    _a1.at(_size) = a1;
+    _a2.at(_size) = a2;
+    _label.at(_size) = label;
+  }
+  return _size++;
+}
+unsigned igp::record_batch::append(
+    const std::string &chr, const mpz_class &pos1, const mpz_class &pos2,
+    const std::vector<std::string> &line_contents, const std::string &id,
+    const std::string &a1, const std::string &a2) {
+  return append(chr, pos1, pos2, passthrough(_id_column, line_contents, id),
+                passthrough(_a1_column, line_contents, a1),
+                passthrough(_a2_column, line_contents, a2),
+                passthrough(_label_column, line_contents, _empty));
+}
+void igp::record_batch::set_passthrough_columns(int id_column, int a1_column,
+                                                int a2_column,
+                                                int label_column) {
+  _id_column = id_column;
+  _a1_column = a1_column;
+  _a2_column = a2_column;
+  _label_column = label_column;
+}
+const std::string &igp::record_batch::passthrough(
+    int column, const std::vector<std::string> &line_contents,
+    const std::string &from_variant) const {
+  if (column == passthrough_from_variant) {
+    return from_variant;
+  }
+  if (column < 0) {
+    return _empty;
+  }
+  return line_contents.at(static_cast<unsigned>(column));
+}
+unsigned igp::record_batch::intern_chr(const std::string &chr) {
+  // search from the most recent name, which is almost always the match
+  for (unsigned i = _n_chr_names; i > 0; --i) {
+    if (!_chr_names.at(i - 1).compare(chr)) {
+      return i - 1;
+    }
+  }
+  if (_n_chr_names == _chr_names.size()) {
+    _chr_names.push_back(chr);
+  } else {
+    _chr_names.at(_n_chr_names) = chr;
+  }
+  return _n_chr_names++;
+}
+void igp::record_batch::check_index(unsigned i) const {
+  if (i >= _size) {
+    throw std::runtime_error("record_batch: record index out of range");
+  }
+}
+void igp::record_batch::check_result_set(unsigned set) const {
+  if (set >= _results.size()) {
+    throw std::runtime_error("record_batch: result set index out of range");
+  }
+}
+unsigned igp::record_batch::get_chr_index(unsigned i) const {
+  check_index(i);
+  return _chr.at(i);
+}
+const std::string &igp::record_batch::get_chr(unsigned i) const {
+  return _chr_names.at(get_chr_index(i));
+}
+const mpz_class &igp::record_batch::get_pos1(unsigned i) const {
+  check_index(i);
+  return _pos1.at(i);
+}
+const mpz_class &igp::record_batch::get_pos2(unsigned i) const {
+  check_index(i);
+  return _pos2.at(i);
+}
+const std::string &igp::record_batch::get_id(unsigned i) const {
+  check_index(i);
+  return _id.at(i);
+}
+const std::string &igp::record_batch::get_a1(unsigned i) const {
+  check_index(i);
+  return _a1.at(i);
+}
+const std::string &igp::record_batch::get_a2(unsigned i) const {
+  check_index(i);
+  return _a2.at(i);
+}
+const std::string &igp::record_batch::get_label(unsigned i) const {
+  check_index(i);
+  return _label.at(i);
+}
+const std::vector<igp::query_result> &igp::record_batch::get_results(
+    unsigned i, unsigned set) const {
+  check_index(i);
+  check_result_set(set);
+  return _results.at(set).at(i);
+}
+std::vector<igp::query_result> *igp::record_batch::get_mutable_results(
+    unsigned i, unsigned set) {
+  check_index(i);
+  check_result_set(set);
+  return &_results.at(set).at(i);
+}
+void igp::record_batch::set_result_sets(unsigned n) {
+  if (!n) {
+    throw std::runtime_error(
+        "record_batch::set_result_sets: at least one result set is required");
+  }
+  _results.resize(n, std::vector<std::vector<query_result> >(_chr.size()));
+}
+unsigned igp::record_batch::get_result_sets() const {
+  return static_cast<unsigned>(_results.size());
+}
+void igp::record_batch::set_retain_vcf_records(bool retain) {
+  _retain_vcf_records = retain;
+}
+bool igp::record_batch::get_retain_vcf_records() const {
+  return _retain_vcf_records;
+}
+void igp::record_batch::set_vcf_record(unsigned i, bcf1_t *record) {
+  if (!_retain_vcf_records) {
+    return;
+  }
+  check_index(i);
+  if (!record) {
+    throw std::runtime_error("record_batch::set_vcf_record: record is NULL");
+  }
+  while (_vcf_records.size() <= i) {
+    bcf1_t *storage = bcf_init();
+    if (!storage) {
+      throw std::bad_alloc();
+    }
+    _vcf_records.push_back(storage);
+  }
+  if (!bcf_copy(_vcf_records.at(i), record)) {
+    throw std::runtime_error(
+        "record_batch::set_vcf_record: unable to copy record");
+  }
+}
+bcf1_t *igp::record_batch::get_vcf_record(unsigned i) const {
+  check_index(i);
+  if (!_retain_vcf_records || i >= _vcf_records.size()) {
+    throw std::runtime_error(
+        "record_batch::get_vcf_record: no vcf record stored");
+  }
+  return _vcf_records.at(i);
+}
+void igp::record_batch::set_retain_line_contents(bool retain) {
+  _retain_line_contents = retain;
+}
+bool igp::record_batch::get_retain_line_contents() const {
+  return _retain_line_contents;
+}
+void igp::record_batch::set_line_contents(
+    unsigned i, const std::vector<std::string> &line_contents) {
+  if (!_retain_line_contents) {
+    return;
+  }
+  check_index(i);
+  if (_line_contents.size() <= i) {
+    _line_contents.resize(i + 1);
+  }
+  // element-wise assignment reuses the storage of earlier batches
+  _line_contents.at(i) = line_contents;
+}
+const std::vector<std::string> &igp::record_batch::get_line_contents(
+    unsigned i) const {
+  check_index(i);
+  if (!_retain_line_contents || i >= _line_contents.size()) {
+    throw std::runtime_error(
+        "record_batch::get_line_contents: no input line stored");
+  }
+  return _line_contents.at(i);
+}
@@ -0,0 +1,319 @@
+/*!
+ \file record_batch.h
+ \brief reusable block of query records passed between pipeline stages
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_RECORD_BATCH_H_
+#define INTERPOLATE_GENETIC_POSITION_RECORD_BATCH_H_
+
+#include <gmpxx.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "htslib/vcf.h"
+#include "interpolate-genetic-position/utilities.h"
+
+namespace interpolate_genetic_position {
+/*!
+ * \brief passthrough column code for a field the input format lacks
+ */
+const int passthrough_absent = -1;
+/*!
+ * \brief passthrough column code for a field parsed by the reader itself
+ * rather than taken from a column of the tokenized line (e.g. vcf)
+ */
+const int passthrough_from_variant = -2;
+/*!
+ * \class record_batch
+ * \brief a block of query records, stored column by column, along with
+ * the interpolation results for each record.
+ *
+ * Batches are recycled: clear() only resets the logical size, so the
+ * strings, GMP values and result vectors of earlier rows keep their
+ * storage and are overwritten in place when the batch is refilled.
+ * Chromosome names are interned into a small per-batch table, as a
+ * batch usually spans only one or two chromosomes.
+ *
+ * Results can be kept for several genetic maps at once, one result set
+ * per map. Result sets are addressed explicitly rather than selected,
+ * so that several threads can report different sets of one batch.
+ *
+ * When the output is itself vcf/bcf, the batch can additionally keep a
+ * copy of each input record, so the record can be annotated and written
+ * once the reader has moved on. Likewise, when the output is pvar, the
+ * batch can keep every column of each tokenized input line.
+ */
+class record_batch {
+ public:
+  /*!
+   * \brief default constructor
+   */
+  record_batch();
+  /*!
+   * \brief copy constructor
+   *
+   * Copy constructor is disabled due to owned htslib records.
+   */
+  record_batch(const record_batch &obj);
+  /*!
+   * \brief destructor
+   */
+  ~record_batch() throw();
+  /*!
+   * \brief remove all records, retaining allocated storage
+   */
+  void clear();
+  /*!
+   * \brief get the number of records in the batch
+   * \return the number of records in the batch
+   */
+  unsigned size() const;
+  /*!
+   * \brief determine whether the batch holds no records
+   * \return whether the batch holds no records
+   */
+  bool empty() const;
+  /*!
+   * \brief add a record to the end of the batch
+   * \param chr chromosome of query
+   * \param pos1 position of query
+   * \param pos2 end position of query, or -1 if not applicable
+   * \param id variant identifier to report, if any
+   * \param a1 first allele to report, if any
+   * \param a2 second allele to report, if any
+   * \param label bed-style region label of query, if any
+   * \return index of the new record
+   */
+  unsigned append(const std::string &chr, const mpz_class &pos1,
+                  const mpz_class &pos2, const std::string &id,
+                  const std::string &a1, const std::string &a2,
+                  const std::string &label);
+  /*!
+   * \brief add a record to the end of the batch, taking passthrough
+   * fields from a tokenized input line as configured with
+   * set_passthrough_columns()
+   * \param chr chromosome of query
+   * \param pos1 position of query
+   * \param pos2 end position of query, or -1 if not applicable
+   * \param line_contents tokenized input line of query
+   * \param id variant identifier parsed by the reader, used for
+   * passthrough_from_variant
+   * \param a1 first allele parsed by the reader, used for
+   * passthrough_from_variant
+   * \param a2 second allele parsed by the reader, used for
+   * passthrough_from_variant
+   * \return index of the new record
+   */
+  unsigned append(const std::string &chr, const mpz_class &pos1,
+                  const mpz_class &pos2,
+                  const std::vector<std::string> &line_contents,
+                  const std::string &id, const std::string &a1,
+                  const std::string &a2);
+  /*!
+   * \brief configure where passthrough fields come from when records
+   * are appended from tokenized input lines
+   * \param id_column base 0 column of variant identifier,
+   * passthrough_absent, or passthrough_from_variant
+   * \param a1_column base 0 column of first allele,
+   * passthrough_absent, or passthrough_from_variant
+   * \param a2_column base 0 column of second allele,
+   * passthrough_absent, or passthrough_from_variant
+   * \param label_column base 0 column of region label, or
+   * passthrough_absent
+   *
+   * This setting survives clear().
+   */
+  void set_passthrough_columns(int id_column, int a1_column, int a2_column,
+                               int label_column);
+  /*!
+   * \brief get the interned chromosome index of a record
+   * \param i index of record
+   * \return index into the batch chromosome table
+   */
+  unsigned get_chr_index(unsigned i) const;
+  /*!
+   * \brief get chromosome of a record
+   * \param i index of record
+   * \return chromosome of record
+   */
+  const std::string &get_chr(unsigned i) const;
+  /*!
+   * \brief get position of a record
+   * \param i index of record
+   * \return position of record
+   */
+  const mpz_class &get_pos1(unsigned i) const;
+  /*!
+   * \brief get end position of a record
+   * \param i index of record
+   * \return end position of record, or -1 if not applicable
+   */
+  const mpz_class &get_pos2(unsigned i) const;
+  /*!
+   * \brief get variant identifier of a record
+   * \param i index of record
+   * \return variant identifier of record
+   */
+  const std::string &get_id(unsigned i) const;
+  /*!
+   * \brief get first allele of a record
+   * \param i index of record
+   * \return first allele of record
+   */
+  const std::string &get_a1(unsigned i) const;
+  /*!
+   * \brief get second allele of a record
+   * \param i index of record
+   * \return second allele of record
+   */
+  const std::string &get_a2(unsigned i) const;
+  /*!
+   * \brief get bed-style region label of a record
+   * \param i index of record
+   * \return region label of record
+   */
+  const std::string &get_label(unsigned i) const;
+  /*!
+   * \brief get interpolation results of a record
+   * \param i index of record
+   * \param set index of result set
+   * \return interpolation results of record
+   */
+  const std::vector<query_result> &get_results(unsigned i,
+                                               unsigned set = 0) const;
+  /*!
+   * \brief get modifiable interpolation results of a record
+   * \param i index of record
+   * \param set index of result set
+   * \return pointer to interpolation results of record
+   */
+  std::vector<query_result> *get_mutable_results(unsigned i,
+                                                 unsigned set = 0);
+  /*!
+   * \brief set the number of result sets kept per record
+   * \param n number of result sets, at least 1
+   *
+   * This setting is retained by clear().
+   */
+  void set_result_sets(unsigned n);
+  /*!
+   * \brief get the number of result sets kept per record
+   * \return number of result sets
+   */
+  unsigned get_result_sets() const;
+  /*!
+   * \brief set whether input vcf records should be kept alongside
+   * parsed fields
+   * \param retain whether set_vcf_record() should store records
+   *
+   * This setting is retained by clear().
+   */
+  void set_retain_vcf_records(bool retain);
+  /*!
+   * \brief determine whether input vcf records are kept
+   * \return whether input vcf records are kept
+   */
+  bool get_retain_vcf_records() const;
+  /*!
+   * \brief store a copy of the input vcf record of a record
+   * \param i index of record
+   * \param record htslib record from which record i was parsed
+   *
+   * Does nothing unless records are being retained. Storage for the
+   * copy is recycled between batches.
+   */
+  void set_vcf_record(unsigned i, bcf1_t *record);
+  /*!
+   * \brief get the stored copy of the input vcf record of a record
+   * \param i index of record
+   * \return stored copy, which the caller may modify
+   */
+  bcf1_t *get_vcf_record(unsigned i) const;
+  /*!
+   * \brief set whether full tokenized input lines should be kept
+   * alongside parsed fields
+   * \param retain whether set_line_contents() should store lines
+   *
+   * This setting is retained by clear().
+   */
+  void set_retain_line_contents(bool retain);
+  /*!
+   * \brief determine whether full tokenized input lines are kept
+   * \return whether full tokenized input lines are kept
+   */
+  bool get_retain_line_contents() const;
+  /*!
+   * \brief store a copy of the tokenized input line of a record
+   * \param i index of record
+   * \param line_contents tokenized line from which record i was parsed
+   *
+   * Does nothing unless lines are being retained. Storage for the
+   * copy is recycled between batches.
+   */
+  void set_line_contents(unsigned i,
+                         const std::vector<std::string> &line_contents);
+  /*!
+   * \brief get the stored tokenized input line of a record
+   * \param i index of record
+   * \return stored tokenized input line
+   */
+  const std::vector<std::string> &get_line_contents(unsigned i) const;
+
+ private:
+  /*!
+   * \brief find or add a chromosome in the batch chromosome table
+   * \param chr chromosome name
+   * \return index of chromosome in table
+   */
+  unsigned intern_chr(const std::string &chr);
+  /*!
+   * \brief throw if a record index is out of range
+   * \param i index of record
+   */
+  void check_index(unsigned i) const;
+  /*!
+   * \brief throw if a result set index is out of range
+   * \param set index of result set
+   */
+  void check_result_set(unsigned set) const;
+  /*!
+   * \brief resolve a passthrough field of a tokenized line
+   * \param column configured column code for the field
+   * \param line_contents tokenized input line
+   * \param from_variant value parsed by the reader
+   * \return resolved field value
+   */
+  const std::string &passthrough(int column,
+                                 const std::vector<std::string> &line_contents,
+                                 const std::string &from_variant) const;
+  unsigned _size;                       //!< number of records in batch
+  std::vector<std::string> _chr_names;  //!< interned chromosome names
+  unsigned _n_chr_names;                //!< number of valid interned names
+  std::vector<unsigned> _chr;           //!< per-record chromosome index
+  std::vector<mpz_class> _pos1;         //!< per-record query position
+  std::vector<mpz_class> _pos2;         //!< per-record query end position
+  std::vector<std::string> _id;         //!< per-record variant identifier
+  std::vector<std::string> _a1;         //!< per-record first allele
+  std::vector<std::string> _a2;         //!< per-record second allele
+  std::vector<std::string> _label;      //!< per-record region label
+  std::vector<std::vector<std::vector<query_result> > >
+      _results;  //!< per-set, per-record results
+  int _id_column;                       //!< passthrough source of identifier
+  int _a1_column;                       //!< passthrough source of first allele
+  int _a2_column;                       //!< passthrough source of second allele
+  int _label_column;                    //!< passthrough source of region label
+  std::string _empty;                   //!< value of absent passthrough fields
+  bool _retain_vcf_records;             //!< whether vcf records are kept
+  std::vector<bcf1_t *> _vcf_records;   //!< per-record copy of vcf record
+  bool _retain_line_contents;           //!< whether input lines are kept
+  std::vector<std::vector<std::string> >
+      _line_contents;  //!< per-record copy of tokenized input line
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_RECORD_BATCH_H_
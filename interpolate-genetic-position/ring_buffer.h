@@ -0,0 +1,144 @@
+/*!
+ \file ring_buffer.h
+ \brief bounded lock-free single-producer/single-consumer queue
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_RING_BUFFER_H_
+#define INTERPOLATE_GENETIC_POSITION_RING_BUFFER_H_
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace interpolate_genetic_position {
+/*!
+ * \class spsc_ring_buffer
+ * \brief fixed-capacity ring buffer connecting exactly one producer
+ * thread to exactly one consumer thread.
+ * \tparam value_type type of stored element; intended to be a pointer
+ * to a preallocated object, so that elements are cheap to copy
+ *
+ * try_push/try_pop never block and never take a lock. push/pop wait
+ * for space/data, which is what provides back-pressure between pipeline
+ * stages, and give up if a shared abort flag is raised so that a failure
+ * in one stage cannot leave its neighbors waiting forever.
+ */
+template <class value_type>
+class spsc_ring_buffer {
+ public:
+  /*!
+   * \brief construct an empty ring buffer
+   * \param capacity maximum number of elements held at once
+   */
+  explicit spsc_ring_buffer(unsigned capacity)
+      : _slots(capacity + 1), _head(0), _tail(0) {
+    if (!capacity) {
+      throw std::runtime_error("spsc_ring_buffer: capacity must be nonzero");
+    }
+  }
+  /*!
+   * \brief attempt to append an element without waiting
+   * \param value element to append
+   * \return whether the element was appended; false if the buffer is full
+   *
+   * Must only be called from the producer thread.
+   */
+  bool try_push(const value_type &value) {
+    unsigned tail = _tail.load(std::memory_order_relaxed);
+    unsigned next = advance(tail);
+    if (next == _head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    _slots[tail] = value;
+    _tail.store(next, std::memory_order_release);
+    return true;
+  }
+  /*!
+   * \brief attempt to remove the oldest element without waiting
+   * \param value pointer to storage for the removed element
+   * \return whether an element was removed; false if the buffer is empty
+   *
+   * Must only be called from the consumer thread.
+   */
+  bool try_pop(value_type *value) {
+    unsigned head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    *value = _slots[head];
+    _head.store(advance(head), std::memory_order_release);
+    return true;
+  }
+  /*!
+   * \brief append an element, waiting for space if the buffer is full
+   * \param value element to append
+   * \param abort flag that, once raised, causes waiting to stop
+   * \return whether the element was appended
+   */
+  bool push(const value_type &value, const std::atomic<bool> &abort) {
+    unsigned attempts = 0;
+    while (!try_push(value)) {
+      if (abort.load(std::memory_order_relaxed)) {
+        return false;
+      }
+      backoff(&attempts);
+    }
+    return true;
+  }
+  /*!
+   * \brief remove the oldest element, waiting for one if the buffer is empty
+   * \param value pointer to storage for the removed element
+   * \param abort flag that, once raised, causes waiting to stop
+   * \return whether an element was removed
+   */
+  bool pop(value_type *value, const std::atomic<bool> &abort) {
+    unsigned attempts = 0;
+    while (!try_pop(value)) {
+      if (abort.load(std::memory_order_relaxed)) {
+        return false;
+      }
+      backoff(&attempts);
+    }
+    return true;
+  }
+  /*!
+   * \brief get the maximum number of elements held at once
+   * \return the maximum number of elements held at once
+   */
+  unsigned capacity() const { return _slots.size() - 1; }
+
+ private:
+  /*!
+   * \brief get the slot following a given slot
+   * \param index current slot
+   * \return following slot, wrapping around at the end of storage
+   */
+  unsigned advance(unsigned index) const {
+    return index + 1 == _slots.size() ? 0 : index + 1;
+  }
+  /*!
+   * \brief wait a little before retrying a full/empty buffer
+   * \param attempts number of consecutive failed attempts so far
+   *
+   * Yielding keeps handoff latency low when stages are well balanced;
+   * a stage that is starved for longer sleeps instead of burning a core.
+   */
+  static void backoff(unsigned *attempts) {
+    if (++*attempts < 64) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+  std::vector<value_type> _slots;           //!< element storage
+  alignas(64) std::atomic<unsigned> _head;  //!< next slot to pop
+  alignas(64) std::atomic<unsigned> _tail;  //!< next slot to push
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_RING_BUFFER_H_
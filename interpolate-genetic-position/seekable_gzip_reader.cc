@@ -0,0 +1,526 @@
+/*!
+ \file seekable_gzip_reader.cc
+ \brief implementation of gzip decompression from access points
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/seekable_gzip_reader.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+/*!
+ * \brief longest distance a deflate block can refer back to
+ */
+const size_t window_size = 32768;
+/*!
+ * \brief bytes of compressed input read at once
+ */
+const size_t input_size = 1u << 16;
+/*!
+ * \brief order access points by their offset in decompressed text
+ * \param point access point
+ * \param offset offset in decompressed text
+ * \return whether the point comes before the offset
+ */
+bool point_before(const igp::seekable_gzip_reader::access_point &point,
+                  uint64_t offset) {
+  return point.out < offset;
+}
+}  // namespace
+
+/*!
+ * \class interpolate_genetic_position::seekable_gzip_reader::decoder
+ * \brief one inflate stream over its own handle of a gzip file,
+ * starting either at the beginning of the file or at an access point
+ */
+class igp::seekable_gzip_reader::decoder {
+ public:
+  /*!
+   * \brief start decoding a file
+   * \param filename name of file
+   * \param point access point to start from, or NULL for the beginning
+   */
+  decoder(const std::string &filename, const access_point *point)
+      : _file(NULL),
+        _stream_open(false),
+        _in(input_size),
+        _in_offset(0),
+        _out(0),
+        _raw(false),
+        _finished(false),
+        _window(window_size),
+        _window_pos(0),
+        _window_fill(0),
+        _filename(filename) {
+    memset(&_stream, 0, sizeof(_stream));
+    _file = fopen(filename.c_str(), "rb");
+    if (!_file) {
+      throw std::runtime_error("seekable_gzip_reader: cannot open file \"" +
+                               filename + "\"");
+    }
+    if (!point) {
+      // gzip header and all
+      if (inflateInit2(&_stream, 31) != Z_OK) {
+        close();
+        throw std::runtime_error(
+            "seekable_gzip_reader: unable to initialize decompression");
+      }
+      _stream_open = true;
+      return;
+    }
+    // a block may start partway through a byte, in which case the
+    // remaining bits of that byte are primed by hand
+    _in_offset = point->in - (point->bits ? 1 : 0);
+    if (point->bits < 0 || point->bits > 7 ||
+        point->window.size() > window_size ||
+        fseeko(_file, static_cast<off_t>(_in_offset), SEEK_SET)) {
+      close();
+      throw std::runtime_error(
+          "seekable_gzip_reader: cannot seek to access point in \"" +
+          filename + "\"");
+    }
+    if (inflateInit2(&_stream, -15) != Z_OK) {
+      close();
+      throw std::runtime_error(
+          "seekable_gzip_reader: unable to initialize decompression");
+    }
+    _stream_open = true;
+    _raw = true;
+    if (point->bits) {
+      int c = fgetc(_file);
+      if (c == EOF) {
+        close();
+        throw std::runtime_error("seekable_gzip_reader: file \"" + filename +
+                                 "\" is truncated");
+      }
+      ++_in_offset;
+      inflatePrime(&_stream, point->bits, c >> (8 - point->bits));
+    }
+    if (!point->window.empty() &&
+        inflateSetDictionary(&_stream, point->window.data(),
+                             static_cast<uInt>(point->window.size())) !=
+            Z_OK) {
+      close();
+      throw std::runtime_error(
+          "seekable_gzip_reader: cannot restore access point in \"" +
+          filename + "\"");
+    }
+    _out = point->out;
+  }
+  /*!
+   * \brief copy constructor
+   *
+   * Copy constructor is disabled due to owned file and stream handles.
+   */
+  decoder(const decoder &obj) : _file(NULL), _stream_open(false) {
+    throw std::runtime_error(
+        "seekable_gzip_reader::decoder: copy constructor operation is "
+        "invalid for this class");
+  }
+  /*!
+   * \brief destructor
+   */
+  ~decoder() throw() { close(); }
+  /*!
+   * \brief decode text
+   * \param buffer pointer to storage for text
+   * \param n maximum number of bytes to decode
+   * \param points if not NULL, storage for access points recorded on the
+   * way, which must hold those recorded since the start of the file
+   * \return number of bytes decoded; fewer than n only at the end of text
+   */
+  size_t read(char *buffer, size_t n, std::vector<access_point> *points) {
+    size_t produced = 0;
+    while (produced < n && !_finished) {
+      if (!_stream.avail_in && !refill()) {
+        throw std::runtime_error("seekable_gzip_reader: file \"" + _filename +
+                                 "\" is truncated");
+      }
+      size_t wanted = std::min(n - produced, static_cast<size_t>(1u << 30));
+      _stream.next_out = reinterpret_cast<Bytef *>(buffer + produced);
+      _stream.avail_out = static_cast<uInt>(wanted);
+      // stopping at each block boundary exposes the places where
+      // decoding can later restart
+      int res = inflate(&_stream, points ? Z_BLOCK : Z_NO_FLUSH);
+      if (res == Z_NEED_DICT || res == Z_DATA_ERROR || res == Z_MEM_ERROR ||
+          res == Z_STREAM_ERROR) {
+        throw std::runtime_error(
+            "seekable_gzip_reader: error decompressing \"" + _filename +
+            "\"");
+      }
+      size_t made = wanted - _stream.avail_out;
+      if (points && made) {
+        remember(buffer + produced, made);
+      }
+      produced += made;
+      _out += made;
+      if (res == Z_STREAM_END) {
+        _finished = !next_member();
+      } else if (points && (_stream.data_type & 128) &&
+                 !(_stream.data_type & 64) &&
+                 (points->empty() ||
+                  _out - points->back().out >= access_point_span)) {
+        access_point point = {_out, _in_offset - _stream.avail_in,
+                              _stream.data_type & 7,
+                              std::vector<unsigned char>()};
+        window(&point.window);
+        points->push_back(point);
+      }
+    }
+    return produced;
+  }
+
+ private:
+  /*!
+   * \brief read more compressed input, keeping any not yet consumed
+   * \return whether any input was read
+   */
+  bool refill() {
+    size_t kept = _stream.avail_in;
+    if (kept && _stream.next_in != _in.data()) {
+      memmove(_in.data(), _stream.next_in, kept);
+    }
+    size_t n_read = fread(_in.data() + kept, 1, _in.size() - kept, _file);
+    if (!n_read && ferror(_file)) {
+      throw std::runtime_error("seekable_gzip_reader: cannot read file \"" +
+                               _filename + "\"");
+    }
+    _in_offset += n_read;
+    _stream.next_in = _in.data();
+    _stream.avail_in = static_cast<uInt>(kept + n_read);
+    return n_read > 0;
+  }
+  /*!
+   * \brief move on to the next gzip member after the end of one
+   * \return whether another member follows
+   */
+  bool next_member() {
+    if (_raw) {
+      // a raw stream stops short of the member trailer
+      for (unsigned skipped = 0; skipped < 8;) {
+        if (!_stream.avail_in && !refill()) {
+          throw std::runtime_error("seekable_gzip_reader: file \"" +
+                                   _filename + "\" is truncated");
+        }
+        unsigned step = std::min(_stream.avail_in, 8 - skipped);
+        _stream.next_in += step;
+        _stream.avail_in -= step;
+        skipped += step;
+      }
+    }
+    while (_stream.avail_in < 2 && refill()) {
+    }
+    if (_stream.avail_in < 2 || _stream.next_in[0] != 0x1f ||
+        _stream.next_in[1] != 0x8b) {
+      return false;
+    }
+    if (inflateReset2(&_stream, 31) != Z_OK) {
+      throw std::runtime_error(
+          "seekable_gzip_reader: unable to initialize decompression");
+    }
+    _raw = false;
+    return true;
+  }
+  /*!
+   * \brief keep the most recent text in the window
+   * \param text pointer to text
+   * \param n number of bytes of text
+   */
+  void remember(const char *text, size_t n) {
+    if (n >= window_size) {
+      memcpy(_window.data(), text + n - window_size, window_size);
+      _window_pos = 0;
+      _window_fill = window_size;
+      return;
+    }
+    size_t first = std::min(n, window_size - _window_pos);
+    memcpy(_window.data() + _window_pos, text, first);
+    memcpy(_window.data(), text + first, n - first);
+    _window_pos = (_window_pos + n) % window_size;
+    _window_fill = std::min(window_size, _window_fill + n);
+  }
+  /*!
+   * \brief copy out the window in text order
+   * \param target pointer to storage for window
+   */
+  void window(std::vector<unsigned char> *target) const {
+    if (_window_fill < window_size) {
+      target->assign(_window.begin(), _window.begin() + _window_fill);
+    } else {
+      target->assign(_window.begin() + _window_pos, _window.end());
+      target->insert(target->end(), _window.begin(),
+                     _window.begin() + _window_pos);
+    }
+  }
+  /*!
+   * \brief release the file and stream handles
+   */
+  void close() {
+    if (_stream_open) {
+      inflateEnd(&_stream);
+      _stream_open = false;
+    }
+    if (_file) {
+      fclose(_file);
+      _file = NULL;
+    }
+  }
+  FILE *_file;                        //!< compressed input file
+  z_stream _stream;                   //!< inflate state
+  bool _stream_open;                  //!< whether inflate state is live
+  std::vector<unsigned char> _in;     //!< compressed input buffer
+  uint64_t _in_offset;                //!< bytes of file read so far
+  uint64_t _out;                      //!< offset of next decoded byte
+  bool _raw;                          //!< whether decoding without header
+  bool _finished;                     //!< whether the text has ended
+  std::vector<unsigned char> _window;  //!< most recent text, circular
+  size_t _window_pos;                 //!< next write position in window
+  size_t _window_fill;                //!< valid bytes in window
+  std::string _filename;              //!< name of file, for error messages
+};
+
+const uint64_t igp::seekable_gzip_reader::access_point_span;
+
+igp::seekable_gzip_reader::seekable_gzip_reader()
+    : _filename(""),
+      _open(false),
+      _record(false),
+      _recording(false),
+      _threads(1),
+      _out(0),
+      _spans(false),
+      _next_span(0),
+      _span_pos(0) {}
+igp::seekable_gzip_reader::seekable_gzip_reader(
+    const seekable_gzip_reader &obj) {
+  throw std::runtime_error(
+      "seekable_gzip_reader: copy constructor operation is invalid for this "
+      "class");
+}
+igp::seekable_gzip_reader::~seekable_gzip_reader() throw() { close(); }
+bool igp::seekable_gzip_reader::open(const std::string &filename) {
+  close();
+  FILE *input = fopen(filename.c_str(), "rb");
+  if (!input) {
+    return false;
+  }
+  unsigned char magic[2] = {0, 0};
+  size_t n_read = fread(magic, 1, 2, input);
+  fclose(input);
+  if (n_read != 2 || magic[0] != 0x1f || magic[1] != 0x8b) {
+    return false;
+  }
+  _decoder.reset(new decoder(filename, NULL));
+  _filename = filename;
+  _open = true;
+  _recording = _record;
+  _out = 0;
+  return true;
+}
+void igp::seekable_gzip_reader::close() {
+  // workers hold pointers into the access points
+  _pending.clear();
+  _spans = false;
+  _span.clear();
+  _span_pos = 0;
+  _decoder.reset();
+  _points.clear();
+  _recording = false;
+  _open = false;
+  _out = 0;
+}
+bool igp::seekable_gzip_reader::is_open() const { return _open; }
+size_t igp::seekable_gzip_reader::read(char *buffer, size_t n) {
+  if (!_open) {
+    return 0;
+  }
+  size_t produced = 0;
+  while (produced < n) {
+    size_t made = 0;
+    if (_spans) {
+      made = read_spans(buffer + produced, n - produced);
+    } else {
+      size_t limit = n - produced;
+      if (spans_possible()) {
+        // this thread decodes up to the next access point, from which
+        // workers can take over
+        std::vector<access_point>::const_iterator next =
+            std::lower_bound(_points.begin(), _points.end(), _out,
+                             point_before);
+        if (next != _points.end() && next->out == _out) {
+          start_spans(static_cast<size_t>(next - _points.begin()));
+          continue;
+        }
+        if (next != _points.end()) {
+          limit = static_cast<size_t>(
+              std::min(static_cast<uint64_t>(limit), next->out - _out));
+        }
+      }
+      made = _decoder->read(buffer + produced, limit,
+                            _recording ? &_points : NULL);
+    }
+    if (!made) {
+      break;
+    }
+    produced += made;
+    _out += made;
+  }
+  return produced;
+}
+uint64_t igp::seekable_gzip_reader::tell() const { return _out; }
+void igp::seekable_gzip_reader::seek(uint64_t offset) {
+  if (!_open) {
+    return;
+  }
+  // reading on is cheaper than restarting, until an access point lies
+  // in between, or, with workers, until past the spans already queued
+  uint64_t reach = UINT64_MAX;
+  if (_spans) {
+    if (_next_span < _points.size()) {
+      reach = _points.at(_next_span).out;
+    }
+  } else {
+    std::vector<access_point>::const_iterator next = std::lower_bound(
+        _points.begin(), _points.end(), _out + 1, point_before);
+    if (next != _points.end()) {
+      reach = next->out - 1;
+    }
+  }
+  if (offset >= _out && offset <= reach) {
+    discard(offset - _out);
+    return;
+  }
+  std::vector<access_point>::const_iterator start =
+      std::lower_bound(_points.begin(), _points.end(), offset + 1,
+                       point_before);
+  _pending.clear();
+  _spans = false;
+  _span.clear();
+  _span_pos = 0;
+  _recording = false;
+  if (start == _points.begin()) {
+    _decoder.reset(new decoder(_filename, NULL));
+    _out = 0;
+  } else {
+    --start;
+    if (spans_possible()) {
+      start_spans(static_cast<size_t>(start - _points.begin()));
+    } else {
+      _decoder.reset(new decoder(_filename, &*start));
+    }
+    _out = start->out;
+  }
+  discard(offset - _out);
+}
+void igp::seekable_gzip_reader::set_record_access_points(bool record) {
+  _record = record;
+}
+bool igp::seekable_gzip_reader::get_record_access_points() const {
+  return _record;
+}
+const std::vector<igp::seekable_gzip_reader::access_point> &
+igp::seekable_gzip_reader::get_access_points() const {
+  return _points;
+}
+void igp::seekable_gzip_reader::set_access_points(
+    const std::vector<access_point> &points) {
+  if (_spans) {
+    // workers are decoding from the old points; restart from the
+    // current position on this thread
+    uint64_t offset = _out;
+    _pending.clear();
+    _spans = false;
+    _span.clear();
+    _span_pos = 0;
+    _points.clear();
+    _decoder.reset(new decoder(_filename, NULL));
+    _out = 0;
+    discard(offset);
+  }
+  _points = points;
+  _recording = false;
+}
+void igp::seekable_gzip_reader::set_threads(unsigned n_threads) {
+  _threads = n_threads;
+}
+unsigned igp::seekable_gzip_reader::get_threads() const { return _threads; }
+bool igp::seekable_gzip_reader::spans_possible() const {
+  return _threads > 1 && !_recording && !_points.empty();
+}
+void igp::seekable_gzip_reader::start_spans(size_t first) {
+  _pending.clear();
+  _decoder.reset();
+  _span.clear();
+  _span_pos = 0;
+  _next_span = first;
+  _spans = true;
+  queue_spans();
+}
+void igp::seekable_gzip_reader::queue_spans() {
+  while (_pending.size() < _threads && _next_span < _points.size()) {
+    const access_point *point = &_points.at(_next_span);
+    // the last span runs to the end of text
+    uint64_t length = _next_span + 1 < _points.size()
+                          ? _points.at(_next_span + 1).out - point->out
+                          : UINT64_MAX;
+    std::string filename = _filename;
+    _pending.push_back(
+        std::async(std::launch::async, [filename, point, length]() {
+          decoder source(filename, point);
+          std::string text;
+          if (length != UINT64_MAX) {
+            text.resize(static_cast<size_t>(length));
+            if (source.read(&text[0], text.size(), NULL) != text.size()) {
+              throw std::runtime_error("seekable_gzip_reader: file \"" +
+                                       filename + "\" is truncated");
+            }
+            return text;
+          }
+          std::vector<char> buffer(input_size);
+          size_t made = 0;
+          while ((made = source.read(buffer.data(), buffer.size(), NULL))) {
+            text.append(buffer.data(), made);
+          }
+          return text;
+        }));
+    ++_next_span;
+  }
+}
+size_t igp::seekable_gzip_reader::read_spans(char *buffer, size_t n) {
+  while (_span_pos == _span.size()) {
+    if (_pending.empty()) {
+      return 0;
+    }
+    std::future<std::string> next = std::move(_pending.front());
+    _pending.pop_front();
+    _span = next.get();
+    _span_pos = 0;
+    queue_spans();
+  }
+  size_t made = std::min(n, _span.size() - _span_pos);
+  memcpy(buffer, _span.data() + _span_pos, made);
+  _span_pos += made;
+  return made;
+}
+void igp::seekable_gzip_reader::discard(uint64_t n) {
+  std::vector<char> buffer(static_cast<size_t>(
+      std::min(n, static_cast<uint64_t>(input_size))));
+  while (n) {
+    size_t made = read(buffer.data(), static_cast<size_t>(std::min(
+                                          n, static_cast<uint64_t>(
+                                                 buffer.size()))));
+    if (!made) {
+      return;
+    }
+    n -= made;
+  }
+}
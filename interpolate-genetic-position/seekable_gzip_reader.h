@@ -0,0 +1,193 @@
+/*!
+ \file seekable_gzip_reader.h
+ \brief gzip decompression that can start from recorded access points
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_SEEKABLE_GZIP_READER_H_
+#define INTERPOLATE_GENETIC_POSITION_SEEKABLE_GZIP_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace interpolate_genetic_position {
+/*!
+ * \class seekable_gzip_reader
+ * \brief read the decompressed text of an ordinary gzip file, with
+ * random access through access points recorded on an earlier pass.
+ *
+ * Deflate streams can only be decoded from the start, unless the state
+ * of the decoder is known: the bit at which a block starts, and the
+ * 32 KiB of text before it, which later blocks may refer back to. An
+ * access point records exactly that, so that decoding can restart from
+ * it. Access points are recorded while reading a file through from the
+ * start, roughly every access_point_span bytes of text, and are then
+ * meant to be stored elsewhere and handed back to later readers.
+ *
+ * With access points in place and more than one thread, the text
+ * between consecutive access points is decoded on worker threads ahead
+ * of the read position, each with its own file handle.
+ *
+ * Files of several concatenated gzip members, including BGZF files,
+ * are read as one stream. As with gzread, anything after a member that
+ * is not another gzip member is ignored.
+ */
+class seekable_gzip_reader {
+ public:
+  /*!
+   * \struct access_point
+   * \brief decoder state at the start of a deflate block
+   */
+  struct access_point {
+    uint64_t out;  //!< offset of block in decompressed text
+    uint64_t in;   //!< offset of first whole byte of block in file
+    int bits;      //!< bits of the byte before in that belong to block
+    std::vector<unsigned char> window;  //!< text before block, to 32 KiB
+  };
+  /*!
+   * \brief default constructor
+   */
+  seekable_gzip_reader();
+  /*!
+   * \brief copy constructor
+   *
+   * Copy constructor is disabled due to owned file handles and threads.
+   */
+  seekable_gzip_reader(const seekable_gzip_reader &obj);
+  /*!
+   * \brief destructor
+   */
+  ~seekable_gzip_reader() throw();
+  /*!
+   * \brief open a gzip file
+   * \param filename name of file to open
+   * \return whether the file was opened. false if the file cannot be
+   * opened or does not start with a gzip header, so that callers can
+   * fall back to gzread
+   */
+  bool open(const std::string &filename);
+  /*!
+   * \brief close any open file, and forget its access points
+   */
+  void close();
+  /*!
+   * \brief determine whether a file is open
+   * \return whether a file is open
+   */
+  bool is_open() const;
+  /*!
+   * \brief read decompressed text
+   * \param buffer pointer to storage for text
+   * \param n maximum number of bytes to read
+   * \return number of bytes read; fewer than n only at the end of text
+   */
+  size_t read(char *buffer, size_t n);
+  /*!
+   * \brief get the read position
+   * \return offset of the next byte to be read, in decompressed text
+   */
+  uint64_t tell() const;
+  /*!
+   * \brief move the read position
+   * \param offset offset in decompressed text, as reported by tell()
+   *
+   * Decoding restarts from the last access point at or before the
+   * offset, unless reading on from the current position gets there
+   * without passing one. Offsets past the end of text leave the reader
+   * at the end.
+   */
+  void seek(uint64_t offset);
+  /*!
+   * \brief set whether access points are recorded while reading
+   * \param record whether to record access points
+   *
+   * Recording stops at the first seek that is not a plain read forward,
+   * so a complete list needs the file read through from the start.
+   * Set before open().
+   */
+  void set_record_access_points(bool record);
+  /*!
+   * \brief get whether access points are recorded while reading
+   * \return whether access points are recorded
+   */
+  bool get_record_access_points() const;
+  /*!
+   * \brief get the access points recorded or set so far
+   * \return access points, in file order
+   */
+  const std::vector<access_point> &get_access_points() const;
+  /*!
+   * \brief replace the access points of the open file
+   * \param points access points recorded from this file, in file order
+   *
+   * Points from another file are not detected, and produce garbage or
+   * a decompression error. Ends any recording.
+   */
+  void set_access_points(const std::vector<access_point> &points);
+  /*!
+   * \brief set the number of threads decoding text at once
+   * \param n_threads number of threads; above 1, text between access
+   * points is decoded on worker threads
+   */
+  void set_threads(unsigned n_threads);
+  /*!
+   * \brief get the number of threads decoding text at once
+   * \return number of threads
+   */
+  unsigned get_threads() const;
+  static const uint64_t access_point_span =
+      1u << 20;  //!< minimum text between recorded access points
+
+ private:
+  class decoder;
+  /*!
+   * \brief determine whether spans can be decoded on worker threads
+   * \return whether spans can be decoded on worker threads
+   */
+  bool spans_possible() const;
+  /*!
+   * \brief switch to decoding spans on worker threads
+   * \param first index of access point starting the first span
+   */
+  void start_spans(size_t first);
+  /*!
+   * \brief launch workers on upcoming spans, up to the thread count
+   */
+  void queue_spans();
+  /*!
+   * \brief read text from spans decoded by workers
+   * \param buffer pointer to storage for text
+   * \param n maximum number of bytes to read
+   * \return number of bytes read; 0 at the end of text
+   */
+  size_t read_spans(char *buffer, size_t n);
+  /*!
+   * \brief drop text ahead of the read position
+   * \param n number of bytes to drop
+   */
+  void discard(uint64_t n);
+  std::string _filename;                   //!< name of open file
+  bool _open;                              //!< whether a file is open
+  std::unique_ptr<decoder> _decoder;       //!< decoder on this thread
+  std::vector<access_point> _points;       //!< access points of file
+  bool _record;                            //!< whether to record points
+  bool _recording;                         //!< whether still recording
+  unsigned _threads;                       //!< threads decoding text
+  uint64_t _out;                           //!< read position in text
+  bool _spans;                             //!< whether workers decode text
+  std::deque<std::future<std::string>> _pending;  //!< spans in progress
+  size_t _next_span;                       //!< next span to be launched
+  std::string _span;                       //!< span being read
+  size_t _span_pos;                        //!< read position in span
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_SEEKABLE_GZIP_READER_H_
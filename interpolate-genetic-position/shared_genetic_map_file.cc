@@ -0,0 +1,210 @@
+/*!
+ \file shared_genetic_map_file.cc
+ \brief implementation of genetic map shared between readers
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/shared_genetic_map_file.h"
+
+namespace igp = interpolate_genetic_position;
+
+igp::shared_genetic_map_file::shared_genetic_map_file()
+    : base_input_genetic_map_file(),
+      _fallback(NULL),
+      _threads(1),
+      _block_index(0),
+      _row_index(0),
+      _eof(false),
+      _chr_lower_bound(""),
+      _chr_upper_bound(""),
+      _startpos_lower_bound(0),
+      _startpos_upper_bound(0),
+      _endpos_lower_bound(-1),
+      _endpos_upper_bound(-1),
+      _gpos_lower_bound(0.0),
+      _gpos_upper_bound(0.0),
+      _rate_lower_bound(0.0),
+      _rate_upper_bound(0.0),
+      _queued_rows(0) {}
+igp::shared_genetic_map_file::shared_genetic_map_file(
+    const shared_genetic_map_file &obj)
+    : base_input_genetic_map_file() {
+  throw std::runtime_error(
+      "shared_genetic_map_file: copy constructor operation is invalid for "
+      "this class");
+}
+igp::shared_genetic_map_file::~shared_genetic_map_file() throw() {}
+void igp::shared_genetic_map_file::open(const std::string &filename,
+                                        format_type ft) {
+  std::unique_ptr<base_input_genetic_map_file> source;
+  if (ft == BIGWIG && _threads > 1) {
+    parallel_bigwig_map_file *bigwig_source = new parallel_bigwig_map_file;
+    source.reset(bigwig_source);
+    bigwig_source->set_threads(_threads);
+  } else {
+    source.reset(new input_genetic_map_file);
+    source->set_fallback_stream(_fallback);
+  }
+  source->open(filename, ft);
+  std::shared_ptr<map_rows> rows(new map_rows);
+  rows->size = 0;
+  rows->lookahead_eof = ft != BIGWIG;
+  rows->blocks.push_back(map_block());
+  while (source->get_block(&rows->blocks.back(), 65536)) {
+    rows->size += rows->blocks.back().size();
+    rows->blocks.push_back(map_block());
+  }
+  rows->blocks.pop_back();
+  source->close();
+  _rows = rows;
+  rewind();
+}
+void igp::shared_genetic_map_file::share(
+    const shared_genetic_map_file &source) {
+  if (!source._rows) {
+    throw std::runtime_error(
+        "shared_genetic_map_file::share: source map is not open");
+  }
+  _rows = source._rows;
+  rewind();
+}
+void igp::shared_genetic_map_file::rewind() {
+  _block_index = 0;
+  _row_index = 0;
+  _eof = false;
+  _chr_upper_bound = "";
+  _startpos_upper_bound = 0;
+  _endpos_upper_bound = -1;
+  _gpos_upper_bound = 0.0;
+  _rate_upper_bound = 0.0;
+  // Load the first two values, such that a valid range is available at the
+  // beginning of iteration.
+  _queued_rows = 0;
+  if (get()) ++_queued_rows;
+  if (get()) ++_queued_rows;
+}
+void igp::shared_genetic_map_file::set_fallback_stream(std::istream *ptr) {
+  _fallback = ptr;
+}
+std::istream *igp::shared_genetic_map_file::get_fallback_stream() const {
+  if (!_fallback) {
+    throw std::runtime_error(
+        "sgmf::get_fallback_stream: called on NULL pointer");
+  }
+  return _fallback;
+}
+bool igp::shared_genetic_map_file::get() {
+  _chr_lower_bound.swap(_chr_upper_bound);
+  _startpos_lower_bound.swap(_startpos_upper_bound);
+  _endpos_lower_bound.swap(_endpos_upper_bound);
+  _gpos_lower_bound.swap(_gpos_upper_bound);
+  _rate_lower_bound.swap(_rate_upper_bound);
+  if (!read_upper_bound()) {
+    _chr_upper_bound = _chr_lower_bound;
+    _startpos_upper_bound = _startpos_lower_bound;
+    _endpos_upper_bound = _endpos_lower_bound;
+    _gpos_upper_bound = _gpos_lower_bound;
+    _rate_upper_bound = _rate_lower_bound;
+    return false;
+  }
+  return true;
+}
+bool igp::shared_genetic_map_file::read_upper_bound() {
+  if (!_rows || _block_index == _rows->blocks.size()) {
+    _eof = true;
+    return false;
+  }
+  const map_block &block = _rows->blocks.at(_block_index);
+  _chr_upper_bound = block.get_chr();
+  _startpos_upper_bound = block.get_startpos(_row_index);
+  _endpos_upper_bound = block.get_endpos(_row_index);
+  _gpos_upper_bound = block.get_gpos(_row_index);
+  _rate_upper_bound = block.get_rate(_row_index);
+  // blocks are never empty, so the indices always point at the next
+  // row, or past the last block
+  if (++_row_index == block.size()) {
+    ++_block_index;
+    _row_index = 0;
+  }
+  return true;
+}
+bool igp::shared_genetic_map_file::skip_to(const std::string &chr,
+                                           const mpz_class &pos) {
+  return false;
+}
+bool igp::shared_genetic_map_file::get_block(map_block *block,
+                                             unsigned max_rows) {
+  block->clear();
+  while (_queued_rows && block->size() < max_rows) {
+    if (!block->empty() && block->get_chr().compare(_chr_lower_bound)) {
+      break;
+    }
+    block->append(_chr_lower_bound, _startpos_lower_bound, _endpos_lower_bound,
+                  _gpos_lower_bound, _rate_lower_bound);
+    // the emitted row leaves the window; a new one enters unless the
+    // map is exhausted
+    if (!get()) {
+      --_queued_rows;
+    }
+  }
+  return !block->empty();
+}
+void igp::shared_genetic_map_file::close() {
+  _rows.reset();
+  _block_index = 0;
+  _row_index = 0;
+  _eof = false;
+  _queued_rows = 0;
+}
+bool igp::shared_genetic_map_file::eof() {
+  if (!_rows || _rows->lookahead_eof) {
+    return !_rows || _block_index == _rows->blocks.size();
+  }
+  return _eof;
+}
+std::string igp::shared_genetic_map_file::get_chr_lower_bound() const {
+  return _chr_lower_bound;
+}
+std::string igp::shared_genetic_map_file::get_chr_upper_bound() const {
+  return _chr_upper_bound;
+}
+mpz_class igp::shared_genetic_map_file::get_startpos_lower_bound() const {
+  return _startpos_lower_bound;
+}
+mpz_class igp::shared_genetic_map_file::get_startpos_upper_bound() const {
+  return _startpos_upper_bound;
+}
+mpz_class igp::shared_genetic_map_file::get_endpos_lower_bound() const {
+  return _endpos_lower_bound;
+}
+mpz_class igp::shared_genetic_map_file::get_endpos_upper_bound() const {
+  return _endpos_upper_bound;
+}
+mpf_class igp::shared_genetic_map_file::get_gpos_lower_bound() const {
+  return _gpos_lower_bound;
+}
+mpf_class igp::shared_genetic_map_file::get_gpos_upper_bound() const {
+  return _gpos_upper_bound;
+}
+mpf_class igp::shared_genetic_map_file::get_rate_lower_bound() const {
+  return _rate_lower_bound;
+}
+mpf_class igp::shared_genetic_map_file::get_rate_upper_bound() const {
+  return _rate_upper_bound;
+}
+void igp::shared_genetic_map_file::set_threads(unsigned n_threads) {
+  if (!n_threads) {
+    throw std::runtime_error(
+        "shared_genetic_map_file::set_threads: at least one thread is "
+        "required");
+  }
+  _threads = n_threads;
+}
+unsigned igp::shared_genetic_map_file::get_threads() const {
+  return _threads;
+}
+size_t igp::shared_genetic_map_file::size() const {
+  return _rows ? _rows->size : 0;
+}
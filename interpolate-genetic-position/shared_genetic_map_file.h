@@ -0,0 +1,228 @@
+/*!
+ \file shared_genetic_map_file.h
+ \brief genetic map read once into memory and served to several readers
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_SHARED_GENETIC_MAP_FILE_H_
+#define INTERPOLATE_GENETIC_POSITION_SHARED_GENETIC_MAP_FILE_H_
+
+#include <gmpxx.h>
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "interpolate-genetic-position/input_genetic_map_file.h"
+#include "interpolate-genetic-position/map_block.h"
+#include "interpolate-genetic-position/parallel_bigwig_map_file.h"
+#include "interpolate-genetic-position/utilities.h"
+
+namespace interpolate_genetic_position {
+/*!
+ * \class shared_genetic_map_file
+ * \brief genetic map input that reads an entire map into memory once,
+ * after which any number of readers can each iterate over it
+ * independently.
+ *
+ * open() parses the map with input_genetic_map_file, or with
+ * parallel_bigwig_map_file for bigwig maps when more than one thread is
+ * set, and keeps every row. share() starts a further reader over the
+ * rows of an opened instance, without copying them; the rows are
+ * released once no reader holds them. Readers never modify the rows, so
+ * each may run on its own thread.
+ *
+ * Rows, bounds and eof() match the streamed map exactly, including the
+ * difference between text maps, which report eof() once their last row
+ * has been read, and bigwig maps, which only do after a read past it.
+ */
+class shared_genetic_map_file : public base_input_genetic_map_file {
+ public:
+  /*!
+   * \brief basic constructor
+   */
+  shared_genetic_map_file();
+  /*!
+   * \brief copy constructor
+   * \param obj existing shared_genetic_map_file
+   *
+   * Copy constructor is disabled; use share() to read the same rows.
+   */
+  shared_genetic_map_file(const shared_genetic_map_file &obj);
+  /*!
+   * \brief destructor
+   */
+  ~shared_genetic_map_file() throw();
+  /*!
+   * \brief read an entire genetic map into memory
+   * \param filename name of input file to open, or empty for the
+   * fallback stream
+   * \param ft format of input genetic map
+   */
+  void open(const std::string &filename, format_type ft);
+  /*!
+   * \brief read the rows of another instance from the beginning
+   * \param source opened instance whose rows are shared
+   */
+  void share(const shared_genetic_map_file &source);
+  /*!
+   * \brief set the fallback stream for data
+   * \param ptr pointer to the fallback stream
+   *
+   * This is intended to be cin, but is exposed for testing
+   */
+  void set_fallback_stream(std::istream *ptr);
+  /*!
+   * \brief get the fallback stream for data
+   * \return pointer to the fallback stream
+   */
+  std::istream *get_fallback_stream() const;
+  /*!
+   * \brief get the next genetic map entry and store it in internal buffer
+   * \return boolean indicating whether a new entry was successfully
+   * loaded. FALSE should indicate EOF.
+   */
+  bool get();
+  /*!
+   * \brief stop reading, releasing this reader's hold on the rows
+   */
+  void close();
+  /*!
+   * \brief test for EOF
+   * \return whether the end of the map has been reached, as the
+   * streamed map would report it
+   */
+  bool eof();
+  /*!
+   * \brief get chromosome of lower boundary of cached range
+   * \return chromosome of lower boundary of cached range
+   */
+  std::string get_chr_lower_bound() const;
+  /*!
+   * \brief get chromosome of upper boundary of cached range
+   * \return chromosome of upper boundary of cached range
+   */
+  std::string get_chr_upper_bound() const;
+  /*!
+   * \brief get start physical position of lower boundary of cached range
+   * \return start physical position of lower boundary of cached range
+   */
+  mpz_class get_startpos_lower_bound() const;
+  /*!
+   * \brief get start physical position of upper boundary of cached range
+   * \return start physical position of upper boundary of cached range
+   */
+  mpz_class get_startpos_upper_bound() const;
+  /*!
+   * \brief get end physical position of lower boundary of cached range
+   * \return end physical position of lower boundary of cached range
+   */
+  mpz_class get_endpos_lower_bound() const;
+  /*!
+   * \brief get end physical position of upper boundary of cached range
+   * \return end physical position of upper boundary of cached range
+   */
+  mpz_class get_endpos_upper_bound() const;
+  /*!
+   * \brief get genetic position of lower boundary of cached range
+   * \return genetic position of lower boundary of cached range
+   */
+  mpf_class get_gpos_lower_bound() const;
+  /*!
+   * \brief get genetic position of upper boundary of cached range
+   * \return genetic position of upper boundary of cached range
+   */
+  mpf_class get_gpos_upper_bound() const;
+  /*!
+   * \brief get rate of change of genetic distance at lower boundary of cached
+   * range \return rate of change of genetic distance at lower boundary of
+   * cached range
+   */
+  mpf_class get_rate_lower_bound() const;
+  /*!
+   * \brief get rate of change of genetic distance at upper boundary of cached
+   * range \return rate of change of genetic distance at upper boundary of
+   * cached range
+   */
+  mpf_class get_rate_upper_bound() const;
+  /*!
+   * \brief load the next run of map rows from a single chromosome
+   * \param block pointer to block to fill; existing contents are replaced
+   * \param max_rows maximum number of rows to load
+   * \return whether any rows were loaded. FALSE should indicate EOF.
+   */
+  bool get_block(map_block *block, unsigned max_rows);
+  /*!
+   * \brief advance the cursor toward a query without reading the map
+   * rows in between
+   * \param chr chromosome of the next query
+   * \param pos physical position of the next query
+   * \return false
+   *
+   * Shared rows are walked in order, so the cursor stays in place.
+   */
+  bool skip_to(const std::string &chr, const mpz_class &pos);
+  /*!
+   * \brief set the number of threads used to decode bigwig maps
+   * \param n_threads number of bigwig chromosomes decoded at once
+   */
+  void set_threads(unsigned n_threads);
+  /*!
+   * \brief get the number of threads used to decode bigwig maps
+   * \return number of bigwig chromosomes decoded at once
+   */
+  unsigned get_threads() const;
+  /*!
+   * \brief get the number of rows read from the map
+   * \return the number of rows read from the map
+   */
+  size_t size() const;
+
+ private:
+  /*!
+   * \struct map_rows
+   * \brief every row of a map, as shared between readers
+   */
+  struct map_rows {
+    std::vector<map_block> blocks;  //!< rows in map order
+    size_t size;                    //!< total number of rows
+    bool lookahead_eof;  //!< whether eof() is reported at the last row
+  };
+  /*!
+   * \brief return to the first row and load the first two values
+   */
+  void rewind();
+  /*!
+   * \brief read the next row into the upper bound fields
+   * \return whether a row was read
+   */
+  bool read_upper_bound();
+  std::istream *_fallback;                  //!< pointer to fallback stream
+  unsigned _threads;                        //!< bigwig decoding threads
+  std::shared_ptr<const map_rows> _rows;    //!< rows of the map
+  size_t _block_index;                      //!< block of next row to read
+  unsigned _row_index;                      //!< index of next row in block
+  bool _eof;                    //!< whether a read past the end was made
+  std::string _chr_lower_bound;  //!< chromosome of previous entry
+  std::string _chr_upper_bound;  //!< chromosome of new entry
+  mpz_class
+      _startpos_lower_bound;  //!< start physical position of previous entry
+  mpz_class _startpos_upper_bound;  //!< start physical position of new entry
+  mpz_class _endpos_lower_bound;    //!< end physical position of previous entry
+  mpz_class _endpos_upper_bound;    //!< end physical position of new entry
+  mpf_class _gpos_lower_bound;      //!< genetic position of previous entry
+  mpf_class _gpos_upper_bound;      //!< genetic position of new entry
+  mpf_class
+      _rate_lower_bound;  //!< point recombination rate change of previous entry
+  mpf_class
+      _rate_upper_bound;  //!< point recombination rate change of new entry
+  unsigned _queued_rows;  //!< rows in the bound window not yet in a block
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_SHARED_GENETIC_MAP_FILE_H_
@@ -8,6 +8,12 @@
 
 #include "interpolate-genetic-position/utilities.h"
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
 namespace igp = interpolate_genetic_position;
 
 igp::format_type igp::string_to_format_type(const std::string &name) {
@@ -19,11 +25,27 @@ igp::format_type igp::string_to_format_type(const std::string &name) {
   if (!name.compare("bed")) return BED;
   if (!name.compare("snp")) return SNP;
   if (!name.compare("vcf")) return VCF;
+  if (!name.compare("bcf")) return BCF;
+  if (!name.compare("pvar")) return PVAR;
+  if (!name.compare("arrow")) return ARROW;
   throw std::runtime_error(
       "string_to_format_type: unrecognized type "
       "descriptor: \"" +
       name + "\"");
 }
+std::string igp::output_file_extension(format_type ft) {
+  if (ft == BOLT) return "bolt";
+  if (ft == BIGWIG) return "bw";
+  if (ft == BIM) return "bim";
+  if (ft == MAP) return "map";
+  if (ft == SNP) return "snp";
+  if (ft == VCF) return "vcf";
+  if (ft == BCF) return "bcf";
+  if (ft == PVAR) return "pvar";
+  if (ft == ARROW) return "arrow";
+  throw std::runtime_error(
+      "output_file_extension: format is not an output format");
+}
 bool igp::chromosome_to_integer(const std::string &chr, int *res) {
   std::string stripped_chr = chr;
   if (stripped_chr.find("chr") == 0) {
@@ -108,22 +130,153 @@ void igp::check_io_combinations(const std::string &informat_str,
                                 const std::string &outformat_str) {
   format_type informat = string_to_format_type(informat_str);
   format_type outformat = string_to_format_type(outformat_str);
-  if (informat == SNP || informat == BIM || informat == VCF) {
-    if (outformat != MAP && outformat != SNP && outformat != BIM) {
-      throw std::domain_error("for input format " + informat_str +
-                              ", valid output formats are: bim, map, snp");
+  if (informat == VCF) {
+    if (outformat != MAP && outformat != SNP && outformat != BIM &&
+        outformat != VCF && outformat != BCF && outformat != ARROW &&
+        outformat != BIGWIG) {
+      throw std::domain_error(
+          "for input format " + informat_str +
+          ", valid output formats are: bim, map, snp, vcf, bcf, arrow, "
+          "bigwig");
+    }
+  } else if (informat == SNP || informat == BIM) {
+    if (outformat != MAP && outformat != SNP && outformat != BIM &&
+        outformat != ARROW && outformat != BIGWIG) {
+      throw std::domain_error(
+          "for input format " + informat_str +
+          ", valid output formats are: bim, map, snp, arrow, bigwig");
+    }
+  } else if (informat == PVAR) {
+    if (outformat != MAP && outformat != SNP && outformat != BIM &&
+        outformat != PVAR && outformat != ARROW && outformat != BIGWIG) {
+      throw std::domain_error(
+          "for input format " + informat_str +
+          ", valid output formats are: bim, map, snp, pvar, arrow, bigwig");
     }
   } else if (informat == MAP) {
-    if (outformat != MAP) {
-      throw std::domain_error("for input format " + informat_str +
-                              ", valid output format is map");
+    if (outformat != MAP && outformat != ARROW && outformat != BIGWIG) {
+      throw std::domain_error(
+          "for input format " + informat_str +
+          ", valid output formats are: map, arrow, bigwig");
     }
   } else if (informat == BED) {
-    if (outformat != BOLT) {
-      throw std::domain_error("for input format " + informat_str +
-                              ", valid output format is bolt");
+    if (outformat != BOLT && outformat != ARROW && outformat != BIGWIG) {
+      throw std::domain_error(
+          "for input format " + informat_str +
+          ", valid output formats are: bolt, arrow, bigwig");
     }
   } else {
     throw std::domain_error("unrecognized input format: " + informat_str);
   }
 }
+std::vector<std::string> igp::read_filename_list(const std::string &filename) {
+  std::ifstream input(filename.c_str());
+  if (!input.is_open()) {
+    throw std::runtime_error("read_filename_list: cannot read file \"" +
+                             filename + "\"");
+  }
+  std::vector<std::string> res;
+  std::string line = "";
+  const char *whitespace = " \t\r\n";
+  while (getline(input, line)) {
+    std::string::size_type start = line.find_first_not_of(whitespace);
+    if (start == std::string::npos || line.at(start) == '#') {
+      continue;
+    }
+    res.push_back(
+        line.substr(start, line.find_last_not_of(whitespace) - start + 1));
+  }
+  return res;
+}
+namespace {
+/*!
+ * \brief find the length of a file name without any compression suffix
+ * \param filename name of file
+ * \return length of file name without any .gz/.bgz/.zst suffix
+ */
+std::string::size_type uncompressed_length(const std::string &filename) {
+  const char *compression_suffixes[] = {".gz", ".bgz", ".zst"};
+  for (unsigned i = 0; i < 3; ++i) {
+    std::string suffix = compression_suffixes[i];
+    if (filename.size() > suffix.size() &&
+        !filename.compare(filename.size() - suffix.size(), suffix.size(),
+                          suffix)) {
+      return filename.size() - suffix.size();
+    }
+  }
+  return filename.size();
+}
+/*!
+ * \brief find the start of the final extension of a file name
+ * \param filename name of file
+ * \param length length of file name to consider
+ * \return index of the dot starting the extension, or length if none
+ */
+std::string::size_type extension_start(const std::string &filename,
+                                       std::string::size_type length) {
+  std::string::size_type base = filename.rfind('/', length ? length - 1 : 0);
+  base = base == std::string::npos ? 0 : base + 1;
+  std::string::size_type dot = filename.rfind('.', length ? length - 1 : 0);
+  // a leading dot names a hidden file rather than starting an extension
+  if (dot == std::string::npos || dot <= base || dot >= length) {
+    return length;
+  }
+  return dot;
+}
+}  // namespace
+std::string igp::filename_stem(const std::string &filename) {
+  std::string::size_type base = filename.rfind('/');
+  base = base == std::string::npos ? 0 : base + 1;
+  std::string::size_type end =
+      extension_start(filename, uncompressed_length(filename));
+  return filename.substr(base, end - base);
+}
+std::string igp::derive_output_filename(const std::string &input_filename,
+                                        const std::string &output_directory,
+                                        const std::string &outformat_str) {
+  std::string extension =
+      output_file_extension(string_to_format_type(outformat_str));
+  std::string directory = output_directory;
+  if (!directory.empty() && directory.back() != '/') {
+    directory += "/";
+  }
+  return directory + filename_stem(input_filename) + "." + extension;
+}
+std::string igp::derive_map_output_filename(const std::string &output_filename,
+                                            const std::string &map_filename) {
+  std::string::size_type insert = extension_start(
+      output_filename, uncompressed_length(output_filename));
+  std::string res = output_filename;
+  return res.insert(insert, "." + filename_stem(map_filename));
+}
+double igp::mpf_to_double(const mpf_class &value) {
+  double res = value.get_d();
+  // the residual is held at more than the value's own precision, so
+  // that both it and the gap below are exact
+  mp_bitcnt_t precision = value.get_prec() + 64;
+  mpf_class residual(0, precision);
+  residual = value - res;
+  if (!sgn(residual)) {
+    return res;
+  }
+  double next = std::nextafter(
+      res, sgn(residual) > 0 ? std::numeric_limits<double>::infinity()
+                             : -std::numeric_limits<double>::infinity());
+  if (!std::isfinite(next)) {
+    return res;
+  }
+  mpf_class half_gap(0, precision);
+  half_gap = mpf_class(next, precision) - res;
+  half_gap /= 2;
+  int order = cmp(abs(residual), abs(half_gap));
+  if (order > 0) {
+    return next;
+  }
+  if (order == 0) {
+    // ties go to the double with an even last mantissa bit
+    uint64_t bits = 0;
+    memcpy(&bits, &res, sizeof(bits));
+    return bits & 1 ? next : res;
+  }
+  return res;
+}
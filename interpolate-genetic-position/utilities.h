@@ -14,6 +14,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace interpolate_genetic_position {
 typedef enum {
@@ -25,10 +26,19 @@ typedef enum {
   MAP,
   SNP,
   BED,
-  VCF
+  VCF,
+  BCF,
+  PVAR,
+  ARROW
 } format_type;
 typedef enum { LESS_THAN, EQUAL, GREATER_THAN } direction;
 format_type string_to_format_type(const std::string &name);
+/*!
+ * \brief get the file name extension of an output format
+ * \param ft output format
+ * \return the format's name, or "bw" for bigwig
+ */
+std::string output_file_extension(format_type ft);
 /*!
  * \brief translate an assortment of chromosome representations
  * into simple integers for sort comparison.
@@ -89,6 +99,58 @@ std::string next_chromosome(const std::string &current_chr);
  */
 void check_io_combinations(const std::string &informat_str,
                            const std::string &outformat_str);
+/*!
+ * \brief read a list of file names, one per line
+ * @param filename name of list file
+ * \return names listed in the file, in order
+ *
+ * Leading and trailing whitespace is removed from each line, and empty
+ * lines and lines starting with '#' are skipped.
+ */
+std::vector<std::string> read_filename_list(const std::string &filename);
+/*!
+ * \brief get the name of a file without its directory, any .gz/.bgz/.zst
+ * suffix, and its final extension
+ * @param filename name of file
+ * \return stem of file name; a leading dot is kept, as it names a
+ * hidden file rather than starting an extension
+ */
+std::string filename_stem(const std::string &filename);
+/*!
+ * \brief name the output file of one of several input files
+ * @param input_filename name of input query file
+ * @param output_directory directory that receives output files
+ * @param outformat_str string representation of output format
+ * \return output_directory/stem.extension, where stem is the
+ * filename_stem() of the input file, and extension is the output format
+ * name ("bw" for bigwig)
+ */
+std::string derive_output_filename(const std::string &input_filename,
+                                   const std::string &output_directory,
+                                   const std::string &outformat_str);
+/*!
+ * \brief name the output file of one of several genetic maps
+ * @param output_filename name of output file requested by user
+ * @param map_filename name of genetic map
+ * \return output file name with the filename_stem() of the map
+ * inserted before its extension, such that "out.bim" and
+ * "maps/male.txt.gz" give "out.male.bim". Any .gz/.bgz/.zst suffix of
+ * the output stays last; without an extension, the stem is appended.
+ */
+std::string derive_map_output_filename(const std::string &output_filename,
+                                       const std::string &map_filename);
+/*!
+ * \brief convert a floating point value to the nearest double
+ * @param value value to convert
+ * \return value rounded to nearest, ties to even
+ *
+ * mpf_get_d truncates toward zero, so a value such as 0.05 would come
+ * out one unit in the last place low. This steps the truncated result
+ * away from zero when the value lies past the midpoint to the next
+ * double. Values beyond the range of double are returned as mpf_get_d
+ * gives them.
+ */
+double mpf_to_double(const mpf_class &value);
 /*!
  * \class query_result
  * \brief store information required to represent the result
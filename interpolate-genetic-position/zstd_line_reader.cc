@@ -0,0 +1,132 @@
+/*!
+ \file zstd_line_reader.cc
+ \brief implementation of streaming zstd line reader
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/zstd_line_reader.h"
+
+#include <cstring>
+
+namespace igp = interpolate_genetic_position;
+
+igp::zstd_line_reader::zstd_line_reader()
+    : _file(NULL),
+      _stream(NULL),
+      _out_pos(0),
+      _out_size(0),
+      _file_eof(false),
+      _flush_pending(false),
+      _frame_remaining(0),
+      _filename("") {
+  _in_buffer.src = NULL;
+  _in_buffer.size = 0;
+  _in_buffer.pos = 0;
+}
+igp::zstd_line_reader::zstd_line_reader(const zstd_line_reader &obj) {
+  throw std::runtime_error(
+      "zstd_line_reader: copy constructor operation is invalid for this "
+      "class");
+}
+igp::zstd_line_reader::~zstd_line_reader() throw() { close(); }
+void igp::zstd_line_reader::open(const std::string &filename) {
+  close();
+  _file = fopen(filename.c_str(), "rb");
+  if (!_file) {
+    throw std::runtime_error("zstd_line_reader: cannot open file \"" +
+                             filename + "\"");
+  }
+  _stream = ZSTD_createDStream();
+  if (!_stream || ZSTD_isError(ZSTD_initDStream(_stream))) {
+    close();
+    throw std::runtime_error(
+        "zstd_line_reader: unable to initialize decompression");
+  }
+  _in.resize(ZSTD_DStreamInSize());
+  _out.resize(ZSTD_DStreamOutSize());
+  _in_buffer.src = _in.data();
+  _in_buffer.size = 0;
+  _in_buffer.pos = 0;
+  _out_pos = _out_size = 0;
+  _file_eof = _flush_pending = false;
+  _frame_remaining = 0;
+  _filename = filename;
+}
+void igp::zstd_line_reader::close() {
+  if (_stream) {
+    ZSTD_freeDStream(_stream);
+    _stream = NULL;
+  }
+  if (_file) {
+    fclose(_file);
+    _file = NULL;
+  }
+}
+bool igp::zstd_line_reader::is_open() const { return _file != NULL; }
+bool igp::zstd_line_reader::fill() {
+  _out_pos = _out_size = 0;
+  while (true) {
+    // only read more input once the decoder has emptied its own buffers
+    if (_in_buffer.pos == _in_buffer.size && !_flush_pending) {
+      if (_file_eof) {
+        if (_frame_remaining) {
+          throw std::runtime_error("zstd_line_reader: file \"" + _filename +
+                                   "\" is truncated");
+        }
+        return false;
+      }
+      size_t n_read = fread(_in.data(), 1, _in.size(), _file);
+      if (!n_read) {
+        if (ferror(_file)) {
+          throw std::runtime_error("zstd_line_reader: cannot read file \"" +
+                                   _filename + "\"");
+        }
+        _file_eof = true;
+        continue;
+      }
+      _in_buffer.size = n_read;
+      _in_buffer.pos = 0;
+    }
+    ZSTD_outBuffer out_buffer = {_out.data(), _out.size(), 0};
+    size_t res = ZSTD_decompressStream(_stream, &out_buffer, &_in_buffer);
+    if (ZSTD_isError(res)) {
+      throw std::runtime_error("zstd_line_reader: error decompressing \"" +
+                               _filename +
+                               "\": " + std::string(ZSTD_getErrorName(res)));
+    }
+    _frame_remaining = res;
+    _flush_pending = out_buffer.pos == out_buffer.size;
+    if (out_buffer.pos) {
+      _out_size = out_buffer.pos;
+      return true;
+    }
+  }
+}
+bool igp::zstd_line_reader::getline(std::string *line) {
+  line->clear();
+  bool found_text = false;
+  while (true) {
+    if (_out_pos == _out_size && !fill()) {
+      return found_text;
+    }
+    found_text = true;
+    const char *start = _out.data() + _out_pos;
+    const char *newline = static_cast<const char *>(
+        memchr(start, '\n', _out_size - _out_pos));
+    if (newline) {
+      line->append(start, newline - start);
+      _out_pos += newline - start + 1;
+      return true;
+    }
+    line->append(start, _out_size - _out_pos);
+    _out_pos = _out_size;
+  }
+}
+bool igp::zstd_line_reader::eof() {
+  if (!_file) {
+    return true;
+  }
+  return _out_pos == _out_size && !fill();
+}
@@ -0,0 +1,93 @@
+/*!
+ \file zstd_line_reader.h
+ \brief streaming line reader for zstd-compressed text files
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#ifndef INTERPOLATE_GENETIC_POSITION_ZSTD_LINE_READER_H_
+#define INTERPOLATE_GENETIC_POSITION_ZSTD_LINE_READER_H_
+
+#include <zstd.h>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace interpolate_genetic_position {
+/*!
+ * \class zstd_line_reader
+ * \brief read newline-delimited text from a zstd-compressed file,
+ * decompressing a block at a time.
+ *
+ * Memory use is bounded by zstd's recommended streaming buffer sizes,
+ * regardless of the size of the file. Concatenated zstd frames, as
+ * produced by e.g. `cat a.zst b.zst`, are read as one stream.
+ */
+class zstd_line_reader {
+ public:
+  /*!
+   * \brief default constructor
+   */
+  zstd_line_reader();
+  /*!
+   * \brief copy constructor
+   *
+   * Copy constructor is disabled due to owned file and stream handles.
+   */
+  zstd_line_reader(const zstd_line_reader &obj);
+  /*!
+   * \brief destructor
+   */
+  ~zstd_line_reader() throw();
+  /*!
+   * \brief open a compressed file
+   * \param filename name of file to open
+   */
+  void open(const std::string &filename);
+  /*!
+   * \brief close any open file
+   */
+  void close();
+  /*!
+   * \brief determine whether a file is open
+   * \return whether a file is open
+   */
+  bool is_open() const;
+  /*!
+   * \brief read the next line of decompressed text
+   * \param line pointer to storage for the line, without its newline
+   * \return whether a line was read
+   */
+  bool getline(std::string *line);
+  /*!
+   * \brief determine whether all decompressed text has been read
+   * \return whether all decompressed text has been read
+   *
+   * This may decompress the next block to find out.
+   */
+  bool eof();
+
+ private:
+  /*!
+   * \brief decompress the next block of text into the output buffer
+   * \return whether any text was produced. false indicates end of file
+   */
+  bool fill();
+  FILE *_file;                 //!< compressed input file
+  ZSTD_DStream *_stream;       //!< zstd decompression state
+  std::vector<char> _in;       //!< compressed input buffer
+  std::vector<char> _out;      //!< decompressed output buffer
+  ZSTD_inBuffer _in_buffer;    //!< unconsumed range of input buffer
+  size_t _out_pos;             //!< read position in output buffer
+  size_t _out_size;            //!< valid bytes in output buffer
+  bool _file_eof;              //!< whether the input file is exhausted
+  bool _flush_pending;         //!< whether the decoder may hold more output
+  size_t _frame_remaining;     //!< last zstd hint; 0 at frame boundaries
+  std::string _filename;       //!< name of open file, for error messages
+};
+}  // namespace interpolate_genetic_position
+
+#endif  // INTERPOLATE_GENETIC_POSITION_ZSTD_LINE_READER_H_
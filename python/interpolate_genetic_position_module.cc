@@ -0,0 +1,103 @@
+/*!
+ \file interpolate_genetic_position_module.cc
+ \brief Python bindings for batch interpolation of NumPy arrays
+ \author Lightning Auriga
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <cstdint>
+#include <string>
+
+#include "interpolate-genetic-position/compiled_genetic_map.h"
+#include "interpolate-genetic-position/utilities.h"
+
+namespace igp = interpolate_genetic_position;
+namespace py = pybind11;
+
+namespace {
+/*!
+ * \brief load a genetic map for Python callers
+ * \param filename name of map file
+ * \param format name of map format, as accepted by --map-format
+ * \param threads number of threads used to load the map
+ * \param cache whether to keep a cache of the loaded map next to it
+ * \return loaded map
+ */
+igp::compiled_genetic_map *load_map(const std::string &filename,
+                                    const std::string &format,
+                                    unsigned threads, bool cache) {
+  igp::format_type ft = igp::string_to_format_type(format);
+  if (ft != igp::BOLT && ft != igp::BEDGRAPH && ft != igp::BIGWIG) {
+    throw py::value_error("unsupported genetic map format \"" + format + "\"");
+  }
+  if (!threads) {
+    throw py::value_error("at least one thread is required");
+  }
+  igp::compiled_genetic_map *map = new igp::compiled_genetic_map;
+  try {
+    py::gil_scoped_release release;
+    map->open(filename, ft, threads, cache);
+  } catch (...) {
+    delete map;
+    throw;
+  }
+  return map;
+}
+
+/*!
+ * \brief interpolate a NumPy array of positions on one chromosome
+ * \param map loaded map
+ * \param chr chromosome of all positions
+ * \param positions one-dimensional array of physical positions
+ * \return tuple of genetic position and rate arrays
+ *
+ * Contiguous int64 input is read in place; anything else is converted
+ * by NumPy first. The results are written directly into the returned
+ * arrays.
+ */
+py::tuple interpolate(
+    const igp::compiled_genetic_map &map, const std::string &chr,
+    py::array_t<int64_t, py::array::c_style | py::array::forcecast>
+        positions) {
+  if (positions.ndim() != 1) {
+    throw py::value_error("positions must be a one-dimensional array");
+  }
+  py::ssize_t n = positions.shape(0);
+  py::array_t<double> gpos(n);
+  py::array_t<double> rate(n);
+  const int64_t *positions_ptr = positions.data();
+  double *gpos_ptr = gpos.mutable_data();
+  double *rate_ptr = rate.mutable_data();
+  {
+    py::gil_scoped_release release;
+    map.interpolate(chr, positions_ptr, static_cast<size_t>(n), gpos_ptr,
+                    rate_ptr);
+  }
+  return py::make_tuple(gpos, rate);
+}
+}  // namespace
+
+PYBIND11_MODULE(interpolate_genetic_position, m) {
+  m.doc() = "interpolate genetic position from physical position";
+  py::class_<igp::compiled_genetic_map>(m, "GeneticMap")
+      .def(py::init(&load_map), py::arg("filename"),
+           py::arg("format") = "bolt", py::arg("threads") = 1,
+           py::arg("cache") = false,
+           "Load a genetic map in bolt, bedgraph, or bigwig format. Bigwig "
+           "chromosomes are decoded, and the genetic positions of bedgraph "
+           "and bigwig maps summed, on up to `threads` threads at once. "
+           "With `cache`, the loaded map is saved next to the map file as "
+           "FILENAME.igpcache and reused while the map is unchanged.")
+      .def("has_chromosome", &igp::compiled_genetic_map::has_chromosome,
+           py::arg("chrom"))
+      .def("__len__", &igp::compiled_genetic_map::size)
+      .def("interpolate", &interpolate, py::arg("chrom"),
+           py::arg("positions"),
+           "Interpolate genetic position (cM) and rate (cM/Mb) for an array "
+           "of 1-based physical positions on one chromosome. Returns a "
+           "tuple of two float64 arrays.");
+}
@@ -0,0 +1,104 @@
+/*!
+ \file arrow_writer_test.cc
+ \brief test of Arrow IPC file output.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/arrow_writer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+/*!
+ * \brief read a little-endian 32-bit integer from a byte string
+ */
+int32_t read_int32(const std::string &data, size_t offset) {
+  uint32_t value = 0;
+  for (unsigned i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(static_cast<unsigned char>(
+                 data.at(offset + i)))
+             << (8 * i);
+  }
+  return static_cast<int32_t>(value);
+}
+}  // namespace
+
+TEST(arrowWriterTest, writesFramedFile) {
+  std::ostringstream target;
+  igp::arrow_writer writer;
+  EXPECT_FALSE(writer.is_open());
+  writer.open(&target, 2);
+  EXPECT_TRUE(writer.is_open());
+  writer.append("chr1", 100, -1, "rs1", 0.5, 1.25, "A", "C");
+  writer.append("chr1", 200, -1, "rs2", 0.75, 1.25, "G", "T");
+  writer.append("chr2", 300, 400, "rs3", 1.0, 0.0, "A", "G");
+  writer.close();
+  EXPECT_FALSE(writer.is_open());
+  std::string data = target.str();
+  ASSERT_GT(data.size(), 18u);
+  EXPECT_EQ(data.substr(0, 8), std::string("ARROW1\0\0", 8));
+  EXPECT_EQ(data.substr(data.size() - 6), "ARROW1");
+  // the schema message follows the leading magic
+  EXPECT_EQ(read_int32(data, 8), -1);
+  EXPECT_EQ(read_int32(data, 12) % 8, 0);
+  // the footer is preceded by the end of stream marker
+  int32_t footer_length = read_int32(data, data.size() - 10);
+  ASSERT_GT(footer_length, 0);
+  size_t footer_start = data.size() - 10 - footer_length;
+  EXPECT_EQ(read_int32(data, footer_start - 8), -1);
+  EXPECT_EQ(read_int32(data, footer_start - 4), 0);
+  // string columns are stored contiguously within each batch, and
+  // chromosome names once in the dictionary
+  EXPECT_NE(data.find("rs1rs2"), std::string::npos);
+  EXPECT_EQ(data.find("rs2rs3"), std::string::npos);
+  EXPECT_NE(data.find("chr1chr2"), std::string::npos);
+}
+
+TEST(arrowWriterTest, roundsFloatingPointColumnsToNearest) {
+  std::ostringstream target;
+  igp::arrow_writer writer;
+  writer.open(&target);
+  // mpf_get_d would truncate these one unit in the last place low
+  writer.append("chr1", 100, -1, "rs1", mpf_class("0.05"), mpf_class("0.1"),
+                "A", "C");
+  writer.close();
+  std::string data = target.str();
+  const double expected[] = {0.05, 0.1};
+  for (unsigned i = 0; i < 2; ++i) {
+    std::string bytes(reinterpret_cast<const char *>(&expected[i]),
+                      sizeof(double));
+    double truncated = std::nextafter(expected[i], 0.0);
+    std::string truncated_bytes(reinterpret_cast<const char *>(&truncated),
+                                sizeof(double));
+    EXPECT_NE(data.find(bytes), std::string::npos);
+    EXPECT_EQ(data.find(truncated_bytes), std::string::npos);
+  }
+}
+
+TEST(arrowWriterTest, writesEmptyFile) {
+  std::ostringstream target;
+  igp::arrow_writer writer;
+  writer.open(&target);
+  writer.close();
+  std::string data = target.str();
+  EXPECT_EQ(data.substr(0, 6), "ARROW1");
+  EXPECT_EQ(data.substr(data.size() - 6), "ARROW1");
+}
+
+TEST(arrowWriterTest, rejectsInvalidUse) {
+  igp::arrow_writer writer;
+  EXPECT_THROW(writer.open(NULL), std::runtime_error);
+  std::ostringstream target;
+  EXPECT_THROW(writer.open(&target, 0), std::runtime_error);
+  EXPECT_THROW(writer.append("chr1", 100, -1, "rs1", 0.5, 1.25, "A", "C"),
+               std::runtime_error);
+  EXPECT_THROW(igp::arrow_writer copy(writer), std::runtime_error);
+}
@@ -5,11 +5,17 @@
  Copyright 2023 Lightning Auriga
  */
 
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "unit_tests/genetic_map_test.h"
 #include "unit_tests/input_genetic_map_file_test.h"
 
+using ::testing::_;
 using ::testing::AnyNumber;
 using ::testing::AtLeast;
 using ::testing::Return;
@@ -21,6 +27,9 @@ TEST_F(geneticMapTest, bedfileQuery1) {
   igp::mock_input_genetic_map_file mockfile;
   igp::genetic_map gm(&mockfile);
   EXPECT_CALL(mockfile, close()).Times(AnyNumber());
+  EXPECT_CALL(mockfile, skip_to(_, _))
+      .Times(AnyNumber())
+      .WillRepeatedly(Return(false));
   EXPECT_CALL(mockfile, eof()).Times(1).WillOnce(Return(false));
   EXPECT_CALL(mockfile, get_chr_lower_bound())
       .Times(AnyNumber())
@@ -65,6 +74,9 @@ TEST_F(geneticMapTest, bedfileQuery2) {
   igp::mock_input_genetic_map_file mockfile;
   igp::genetic_map gm(&mockfile);
   EXPECT_CALL(mockfile, close()).Times(AnyNumber());
+  EXPECT_CALL(mockfile, skip_to(_, _))
+      .Times(AnyNumber())
+      .WillRepeatedly(Return(false));
   EXPECT_CALL(mockfile, eof()).Times(1).WillOnce(Return(false));
   EXPECT_CALL(mockfile, get_chr_lower_bound())
       .Times(AnyNumber())
@@ -108,6 +120,9 @@ TEST_F(geneticMapTest, bedfileQuery3) {
   igp::mock_input_genetic_map_file mockfile;
   igp::genetic_map gm(&mockfile);
   EXPECT_CALL(mockfile, close()).Times(AnyNumber());
+  EXPECT_CALL(mockfile, skip_to(_, _))
+      .Times(AnyNumber())
+      .WillRepeatedly(Return(false));
   EXPECT_CALL(mockfile, eof()).Times(4).WillRepeatedly(Return(false));
   EXPECT_CALL(mockfile, get_chr_lower_bound())
       .Times(AnyNumber())
@@ -159,3 +174,47 @@ TEST_F(geneticMapTest, bedfileQuery3) {
   EXPECT_EQ(results.at(2).get_rate(), mpf_class(4.43));
   EXPECT_EQ(results.at(2).get_gpos(), mpf_class(3.32));
 }
+
+// sweeping a region reports the same segments as the segmented query,
+// including across chromosome boundaries and beyond the end of the map
+TEST_F(geneticMapTest, sweepMatchesSegmentedQuery) {
+  std::string filename = boost::filesystem::unique_path().native();
+  std::ofstream output(filename.c_str());
+  for (unsigned i = 0; i < 10; ++i) {
+    output << "chr1\t" << i * 100 << '\t' << (i + 1) * 100 << '\t'
+           << 0.5 + i * 0.25 << '\n';
+  }
+  output << "chr2\t500\t600\t1.5\nchr2\t600\t700\t2.5\n"
+         << "chr3\t100\t200\t0.75\n";
+  output.close();
+  std::vector<std::string> chrs = {"1", "1", "1", "2", "2", "3", "3", "4"};
+  std::vector<int> starts = {0, 50, 250, 100, 550, 0, 150, 10};
+  std::vector<int> ends = {30, 150, 1200, 650, 900, 300, 175, 20};
+  igp::input_genetic_map_file segmented_file, swept_file;
+  igp::genetic_map segmented(&segmented_file), swept(&swept_file);
+  segmented.open(filename, igp::BEDGRAPH);
+  swept.open(filename, igp::BEDGRAPH);
+  std::vector<igp::query_result> expected, observed;
+  for (unsigned i = 0; i < chrs.size(); ++i) {
+    segmented.query(chrs.at(i), starts.at(i), ends.at(i), false, &expected);
+    observed.clear();
+    swept.sweep(chrs.at(i), starts.at(i), ends.at(i), false,
+                [&](const igp::query_result &result) {
+                  observed.push_back(result);
+                });
+    ASSERT_EQ(observed.size(), expected.size());
+    // the region reaching past the end of chromosome 1 is split at
+    // every remaining breakpoint
+    if (i == 2) {
+      EXPECT_EQ(observed.size(), 9u);
+    }
+    for (unsigned j = 0; j < expected.size(); ++j) {
+      EXPECT_EQ(observed.at(j).get_chr(), expected.at(j).get_chr());
+      EXPECT_EQ(observed.at(j).get_startpos(), expected.at(j).get_startpos());
+      EXPECT_EQ(observed.at(j).get_endpos(), expected.at(j).get_endpos());
+      EXPECT_EQ(observed.at(j).get_gpos(), expected.at(j).get_gpos());
+      EXPECT_EQ(observed.at(j).get_rate(), expected.at(j).get_rate());
+    }
+  }
+  boost::filesystem::remove(filename);
+}
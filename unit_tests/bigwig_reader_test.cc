@@ -7,6 +7,7 @@
 
 #include "interpolate-genetic-position/bigwig_reader.h"
 
+#include "boost/filesystem.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "unit_tests/bigwig_reader_test.h"
@@ -93,3 +94,48 @@ TEST_F(bigwigReaderTest, canProcessTestBigwig) {
   EXPECT_TRUE(bw.eof());
   EXPECT_NO_THROW(bw.close());
 }
+
+TEST_F(bigwigReaderTest, iteratesHeaderChromosomesInOrder) {
+  // lexicographic header, with a chromosome that has no intervals
+  std::string filename = boost::filesystem::unique_path().native();
+  const char *chroms[] = {"chr10", "chr2", "chr3"};
+  const char *chroms_use[] = {"chr10", "chr2", "chr2"};
+  uint32_t lengths[] = {133797422, 242193529, 198295559};
+  uint32_t starts[] = {100, 200, 300};
+  uint32_t ends[] = {200, 300, 400};
+  float values[] = {1.0f, 2.0f, 3.0f};
+  ASSERT_EQ(bwInit(1 << 17), 0);
+  bigWigFile_t *fp = bwOpen(filename.c_str(), NULL, "w");
+  ASSERT_TRUE(fp);
+  EXPECT_EQ(bwCreateHdr(fp, 10), 0);
+  fp->cl = bwCreateChromList(chroms, lengths, 3);
+  EXPECT_EQ(bwWriteHdr(fp), 0);
+  EXPECT_EQ(bwAddIntervals(fp, chroms_use, starts, ends, values, 1), 0);
+  EXPECT_EQ(bwAddIntervals(fp, chroms_use + 1, starts + 1, ends + 1,
+                           values + 1, 2),
+            0);
+  bwClose(fp);
+  bwCleanup();
+  igp::bigwig_reader bw;
+  std::string chr = "";
+  mpz_class pos1, pos2;
+  mpf_class rate;
+  EXPECT_NO_THROW(bw.open(filename));
+  EXPECT_EQ(bw.get_loaded_chr(), "chr2");
+  EXPECT_TRUE(bw.get(&chr, &pos1, &pos2, &rate));
+  EXPECT_EQ(chr, "chr2");
+  EXPECT_EQ(pos1, mpz_class(200));
+  EXPECT_TRUE(bw.get(&chr, &pos1, &pos2, &rate));
+  EXPECT_EQ(chr, "chr2");
+  EXPECT_EQ(pos1, mpz_class(300));
+  EXPECT_TRUE(bw.get(&chr, &pos1, &pos2, &rate));
+  EXPECT_EQ(chr, "chr10");
+  EXPECT_EQ(pos1, mpz_class(100));
+  EXPECT_EQ(pos2, mpz_class(200));
+  EXPECT_EQ(rate, mpf_class("1.0"));
+  EXPECT_FALSE(bw.eof());
+  EXPECT_FALSE(bw.get(&chr, &pos1, &pos2, &rate));
+  EXPECT_TRUE(bw.eof());
+  EXPECT_NO_THROW(bw.close());
+  boost::filesystem::remove(filename);
+}
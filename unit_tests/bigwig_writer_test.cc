@@ -0,0 +1,80 @@
+/*!
+ \file bigwig_writer_test.cc
+ \brief test of bigwig track output.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/bigwig_writer.h"
+
+#include <string>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+#include "interpolate-genetic-position/bigwig_reader.h"
+
+namespace igp = interpolate_genetic_position;
+
+TEST(bigwigWriterTest, writesIntervalsBetweenResults) {
+  std::string filename = boost::filesystem::unique_path().native();
+  igp::bigwig_writer writer;
+  writer.open(filename);
+  EXPECT_TRUE(writer.is_open());
+  writer.append("chr1", mpz_class(100), mpz_class(-1), 0.5);
+  writer.append("chr1", mpz_class(200), mpz_class(-1), 1.0);
+  // of several results at a position, the last is kept
+  writer.append("chr1", mpz_class(200), mpz_class(-1), 1.5);
+  writer.append("chr1", mpz_class(500), mpz_class(-1), 2.0);
+  // regions extend to their end
+  writer.append("chr2", mpz_class(1000), mpz_class(2000), 0.25);
+  writer.close();
+  EXPECT_FALSE(writer.is_open());
+  igp::bigwig_reader reader;
+  std::string chr = "";
+  mpz_class pos1, pos2;
+  mpf_class value;
+  reader.open(filename);
+  EXPECT_TRUE(reader.get(&chr, &pos1, &pos2, &value));
+  EXPECT_EQ(chr, "chr1");
+  EXPECT_EQ(pos1, mpz_class(99));
+  EXPECT_EQ(pos2, mpz_class(199));
+  EXPECT_EQ(value, mpf_class(0.5));
+  EXPECT_TRUE(reader.get(&chr, &pos1, &pos2, &value));
+  EXPECT_EQ(pos1, mpz_class(199));
+  EXPECT_EQ(pos2, mpz_class(499));
+  EXPECT_EQ(value, mpf_class(1.5));
+  EXPECT_TRUE(reader.get(&chr, &pos1, &pos2, &value));
+  EXPECT_EQ(pos1, mpz_class(499));
+  EXPECT_EQ(pos2, mpz_class(500));
+  EXPECT_EQ(value, mpf_class(2.0));
+  EXPECT_TRUE(reader.get(&chr, &pos1, &pos2, &value));
+  EXPECT_EQ(chr, "chr2");
+  EXPECT_EQ(pos1, mpz_class(999));
+  EXPECT_EQ(pos2, mpz_class(1999));
+  EXPECT_EQ(value, mpf_class(0.25));
+  EXPECT_FALSE(reader.get(&chr, &pos1, &pos2, &value));
+  reader.close();
+  boost::filesystem::remove(filename);
+}
+
+TEST(bigwigWriterTest, rejectsInvalidUse) {
+  igp::bigwig_writer writer;
+  EXPECT_THROW(writer.open(""), std::runtime_error);
+  EXPECT_THROW(writer.append("chr1", mpz_class(1), mpz_class(-1), 0.0),
+               std::runtime_error);
+  std::string filename = boost::filesystem::unique_path().native();
+  writer.open(filename);
+  EXPECT_THROW(writer.append("chr1", mpz_class(0), mpz_class(-1), 0.0),
+               std::runtime_error);
+  writer.append("chr1", mpz_class(100), mpz_class(-1), 0.0);
+  EXPECT_THROW(writer.append("chr1", mpz_class(50), mpz_class(-1), 0.0),
+               std::runtime_error);
+  writer.append("chr2", mpz_class(100), mpz_class(-1), 0.0);
+  EXPECT_THROW(writer.append("chr1", mpz_class(200), mpz_class(-1), 0.0),
+               std::runtime_error);
+  igp::bigwig_writer empty;
+  empty.open(filename);
+  EXPECT_THROW(empty.close(), std::runtime_error);
+  EXPECT_FALSE(boost::filesystem::exists(filename));
+  EXPECT_THROW(igp::bigwig_writer copy(writer), std::runtime_error);
+}
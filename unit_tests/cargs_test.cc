@@ -27,7 +27,8 @@ cargsTest::cargsTest()
   populate(test2, &_argvec2, &_argv2);
   std::string test3 = "progname -i fn1 -p bim -g fn2 -m bedgraph -o fn3 -v";
   populate(test3, &_argvec3, &_argv3);
-  std::string test4 = "progname -i fn1 -p bedgraph -g fn2 -m map -o fn3 -f vcf";
+  std::string test4 =
+      "progname -i fn1 -p bedgraph -g fn2 -m map -o fn3 -f bedgraph";
   populate(test4, &_argvec4, &_argv4);
   std::string test5 = "progname --version --precision 68";
   populate(test5, &_argvec5, &_argv5);
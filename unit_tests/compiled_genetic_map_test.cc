@@ -0,0 +1,282 @@
+/*!
+ \file compiled_genetic_map_test.cc
+ \brief test of in-memory genetic map for batch interpolation.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/compiled_genetic_map.h"
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+/*!
+ * \brief load a compiled map from text
+ * \param content text of map file
+ * \param ft format of map file
+ * \param map pointer to map to load
+ */
+void load_map(const std::string &content, igp::format_type ft,
+              igp::compiled_genetic_map *map) {
+  std::istringstream strm(content);
+  igp::input_genetic_map_file mapfile;
+  mapfile.set_fallback_stream(&strm);
+  mapfile.open("", ft);
+  map->load(&mapfile);
+}
+
+/*!
+ * \brief write a bedgraph map long enough to span several blocks of
+ * the prefix sum
+ * \param filename name of file to write
+ * \param seed seed of rates
+ */
+void write_long_bedgraph(const std::string &filename, unsigned seed) {
+  std::ofstream output(filename.c_str());
+  const char *chromosomes[] = {"chr1", "chr2"};
+  for (unsigned c = 0; c < 2; ++c) {
+    unsigned state = seed + c;
+    int64_t start = 100;
+    for (unsigned i = 0; i < 150000; ++i) {
+      state = state * 1103515245u + 12345u;
+      int64_t width = 1 + (state >> 8) % 5000;
+      state = state * 1103515245u + 12345u;
+      output << chromosomes[c] << '\t' << start << '\t' << start + width
+             << "\t0." << (state >> 4) % 1000000 << '\n';
+      start += width;
+    }
+  }
+}
+
+/*!
+ * \brief get the genetic position of every row of a map, with GMP
+ * arithmetic at high precision
+ * \param filename name of bedgraph map
+ * \param chr chromosome of rows
+ * \param startpos pointer to storage for start positions of rows
+ * \param gpos pointer to storage for genetic positions of rows
+ */
+void read_reference(const std::string &filename, const std::string &chr,
+                    std::vector<int64_t> *startpos,
+                    std::vector<double> *gpos) {
+  mp_bitcnt_t default_prec = mpf_get_default_prec();
+  mpf_set_default_prec(512);
+  {
+    igp::input_genetic_map_file mapfile;
+    mapfile.open(filename, igp::BEDGRAPH);
+    igp::map_block block;
+    while (mapfile.get_block(&block, 65536)) {
+      if (block.get_chr().compare(chr)) continue;
+      for (unsigned i = 0; i < block.size(); ++i) {
+        startpos->push_back(block.get_startpos(i).get_si());
+        gpos->push_back(igp::mpf_to_double(block.get_gpos(i)));
+      }
+    }
+  }
+  mpf_set_default_prec(default_prec);
+}
+}  // namespace
+
+TEST(compiledGeneticMapTest, interpolatesPointQueries) {
+  igp::compiled_genetic_map map;
+  load_map(
+      "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n"
+      "1 1000000 0.1 0\n"
+      "1 2000000 0.2 0.1\n"
+      "1 3000000 0.0 0.3\n"
+      "2 500000 1.0 0\n"
+      "2 1500000 0.0 1.0\n",
+      igp::BOLT, &map);
+  EXPECT_EQ(map.size(), 5u);
+  EXPECT_TRUE(map.has_chromosome("chr1"));
+  EXPECT_TRUE(map.has_chromosome("2"));
+  EXPECT_FALSE(map.has_chromosome("3"));
+  std::vector<int64_t> positions = {1, 1000000, 1500000, 2500000, 3000000,
+                                    4000000};
+  std::vector<double> gpos(positions.size(), -1.0),
+      rate(positions.size(), -1.0);
+  map.interpolate("1", positions.data(), positions.size(), gpos.data(),
+                  rate.data());
+  EXPECT_DOUBLE_EQ(gpos.at(0), 0.0);
+  EXPECT_DOUBLE_EQ(rate.at(0), 0.0);
+  EXPECT_DOUBLE_EQ(gpos.at(1), 0.0);
+  EXPECT_DOUBLE_EQ(rate.at(1), 0.1);
+  EXPECT_DOUBLE_EQ(gpos.at(2), 0.05);
+  EXPECT_DOUBLE_EQ(gpos.at(3), 0.2);
+  EXPECT_DOUBLE_EQ(rate.at(3), 0.2);
+  EXPECT_DOUBLE_EQ(gpos.at(4), 0.3);
+  // without end positions, the final row is reported as is
+  EXPECT_DOUBLE_EQ(gpos.at(5), 0.3);
+  EXPECT_DOUBLE_EQ(rate.at(5), 0.0);
+  // unsorted batches give the same answers
+  std::vector<int64_t> reversed(positions.rbegin(), positions.rend());
+  std::vector<double> gpos_reversed(positions.size()),
+      rate_reversed(positions.size());
+  map.interpolate("chr1", reversed.data(), reversed.size(),
+                  gpos_reversed.data(), rate_reversed.data());
+  for (unsigned i = 0; i < positions.size(); ++i) {
+    EXPECT_DOUBLE_EQ(gpos_reversed.at(positions.size() - 1 - i), gpos.at(i));
+    EXPECT_DOUBLE_EQ(rate_reversed.at(positions.size() - 1 - i), rate.at(i));
+  }
+  // other chromosomes are independent
+  map.interpolate("2", positions.data(), positions.size(), gpos.data(),
+                  rate.data());
+  EXPECT_DOUBLE_EQ(gpos.at(0), 0.0);
+  EXPECT_DOUBLE_EQ(gpos.at(1), 0.5);
+  EXPECT_DOUBLE_EQ(rate.at(1), 1.0);
+  EXPECT_DOUBLE_EQ(gpos.at(5), 1.0);
+  map.interpolate("X", positions.data(), positions.size(), gpos.data(),
+                  rate.data());
+  for (unsigned i = 0; i < positions.size(); ++i) {
+    EXPECT_DOUBLE_EQ(gpos.at(i), 0.0);
+    EXPECT_DOUBLE_EQ(rate.at(i), 0.0);
+  }
+}
+
+TEST(compiledGeneticMapTest, roundsRowsToNearestDouble) {
+  const char *content =
+      "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n"
+      "1 1000000 0.05 0.05\n"
+      "1 2000000 0.1 0.1\n";
+  igp::compiled_genetic_map map;
+  load_map(content, igp::BOLT, &map);
+  // the same rows as read by the GMP path
+  std::vector<double> reference_gpos, reference_rate;
+  {
+    std::istringstream strm(content);
+    igp::input_genetic_map_file mapfile;
+    mapfile.set_fallback_stream(&strm);
+    mapfile.open("", igp::BOLT);
+    igp::map_block block;
+    while (mapfile.get_block(&block, 65536)) {
+      for (unsigned i = 0; i < block.size(); ++i) {
+        reference_gpos.push_back(igp::mpf_to_double(block.get_gpos(i)));
+        reference_rate.push_back(igp::mpf_to_double(block.get_rate(i)));
+      }
+    }
+  }
+  ASSERT_EQ(reference_gpos.size(), 2u);
+  EXPECT_EQ(reference_gpos.at(0), 0.05);
+  EXPECT_EQ(reference_rate.at(0), 0.05);
+  std::vector<int64_t> positions = {1000000, 2000000};
+  std::vector<double> gpos(positions.size()), rate(positions.size());
+  map.interpolate("1", positions.data(), positions.size(), gpos.data(),
+                  rate.data());
+  for (unsigned i = 0; i < positions.size(); ++i) {
+    EXPECT_EQ(gpos.at(i), reference_gpos.at(i));
+    EXPECT_EQ(rate.at(i), reference_rate.at(i));
+  }
+}
+
+TEST(compiledGeneticMapTest, extendsToFinalEndPosition) {
+  igp::compiled_genetic_map map;
+  load_map(
+      "chr1\t0\t1000000\t1.0\n"
+      "chr1\t1000000\t2000000\t2.0\n",
+      igp::BEDGRAPH, &map);
+  std::vector<int64_t> positions = {1500001, 2000001, 5000000};
+  std::vector<double> gpos(positions.size()), rate(positions.size());
+  map.interpolate("chr1", positions.data(), positions.size(), gpos.data(),
+                  rate.data());
+  EXPECT_DOUBLE_EQ(gpos.at(0), 2.0);
+  EXPECT_DOUBLE_EQ(rate.at(0), 2.0);
+  // beyond the end of the final row, interpolation stops
+  EXPECT_DOUBLE_EQ(gpos.at(1), 3.0);
+  EXPECT_DOUBLE_EQ(rate.at(1), 0.0);
+  EXPECT_DOUBLE_EQ(gpos.at(2), 3.0);
+}
+
+TEST(compiledGeneticMapTest, accumulatesRateOnlyMapsPrecisely) {
+  std::string filename = boost::filesystem::unique_path().native();
+  write_long_bedgraph(filename, 17);
+  std::vector<int64_t> startpos;
+  std::vector<double> expected;
+  read_reference(filename, "chr2", &startpos, &expected);
+  ASSERT_EQ(startpos.size(), 150000u);
+  std::vector<double> serial_gpos(startpos.size()), rate(startpos.size());
+  for (unsigned n_threads = 1; n_threads <= 4; n_threads *= 2) {
+    igp::compiled_genetic_map map;
+    map.open(filename, igp::BEDGRAPH, n_threads);
+    EXPECT_EQ(map.size(), 300000u);
+    std::vector<double> gpos(startpos.size());
+    map.interpolate("chr2", startpos.data(), startpos.size(), gpos.data(),
+                    rate.data());
+    for (unsigned i = 0; i < startpos.size(); ++i) {
+      EXPECT_DOUBLE_EQ(gpos.at(i), expected.at(i));
+    }
+    // blocks do not depend on the number of threads, so neither do the
+    // results
+    if (n_threads == 1) {
+      serial_gpos = gpos;
+    } else {
+      EXPECT_EQ(gpos, serial_gpos);
+    }
+  }
+  boost::filesystem::remove(filename);
+}
+
+TEST(compiledGeneticMapTest, reusesCacheOfUnchangedMap) {
+  std::string filename = boost::filesystem::unique_path().native();
+  std::string cache_filename = filename + ".igpcache";
+  write_long_bedgraph(filename, 3);
+  std::vector<int64_t> positions = {150000, 2500000, 400000000};
+  std::vector<double> gpos(positions.size()), rate(positions.size());
+  std::vector<double> cached_gpos(positions.size()),
+      cached_rate(positions.size());
+  igp::compiled_genetic_map map;
+  map.open(filename, igp::BEDGRAPH, 2, true);
+  ASSERT_TRUE(boost::filesystem::exists(cache_filename));
+  map.interpolate("1", positions.data(), positions.size(), gpos.data(),
+                  rate.data());
+  igp::compiled_genetic_map cached;
+  cached.open(filename, igp::BEDGRAPH, 1, true);
+  EXPECT_EQ(cached.size(), map.size());
+  cached.interpolate("1", positions.data(), positions.size(),
+                     cached_gpos.data(), cached_rate.data());
+  EXPECT_EQ(cached_gpos, gpos);
+  EXPECT_EQ(cached_rate, rate);
+  // a cache for another format is ignored; as bolt, the first line is
+  // taken to be a header
+  igp::compiled_genetic_map other_format;
+  other_format.open(filename, igp::BOLT, 1, true);
+  EXPECT_EQ(other_format.size(), map.size() - 1);
+  // a changed map replaces its cache
+  {
+    std::ofstream output(filename.c_str());
+    output << "chr1\t0\t1000000\t1.0\n";
+  }
+  igp::compiled_genetic_map changed;
+  changed.open(filename, igp::BEDGRAPH, 1, true);
+  EXPECT_EQ(changed.size(), 1u);
+  // a damaged cache is ignored
+  boost::filesystem::resize_file(cache_filename, 40);
+  igp::compiled_genetic_map damaged;
+  damaged.open(filename, igp::BEDGRAPH, 1, true);
+  EXPECT_EQ(damaged.size(), 1u);
+  boost::filesystem::remove(filename);
+  boost::filesystem::remove(cache_filename);
+}
+
+TEST(compiledGeneticMapTest, rejectsInvalidUse) {
+  igp::compiled_genetic_map map;
+  EXPECT_THROW(map.load(NULL), std::runtime_error);
+  EXPECT_THROW(map.open("unit_tests/test.bw", igp::BIGWIG, 0),
+               std::runtime_error);
+  EXPECT_THROW(load_map("chr1\t1000\t2000\t1.0\n"
+                        "chr1\t0\t1000\t1.0\n",
+                        igp::BEDGRAPH, &map),
+               std::runtime_error);
+  std::vector<double> gpos(1), rate(1);
+  EXPECT_THROW(map.interpolate("1", NULL, 1, gpos.data(), rate.data()),
+               std::runtime_error);
+  EXPECT_THROW(igp::compiled_genetic_map copy(map), std::runtime_error);
+}
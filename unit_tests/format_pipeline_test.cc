@@ -0,0 +1,126 @@
+/*!
+ \file format_pipeline_test.cc
+ \brief test of format-specialized result reporting.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/format_pipeline.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+#include "interpolate-genetic-position/query_file.h"
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+void add_query(igp::record_batch *batch, const std::string &chr,
+               const mpz_class &pos1, const mpz_class &pos2,
+               const std::string &id, const std::string &label,
+               const mpf_class &gpos, const mpf_class &rate) {
+  unsigned i = batch->append(chr, pos1, pos2, id, "A", "C", label);
+  igp::query_result result;
+  result.set_chr(chr);
+  result.set_startpos(pos1);
+  result.set_endpos(pos2);
+  result.set_gpos(gpos);
+  result.set_rate(rate);
+  batch->get_mutable_results(i)->clear();
+  batch->get_mutable_results(i)->push_back(result);
+}
+
+/*!
+ * \brief report a batch through query_file, with or without
+ * a format pipeline, and capture the output file contents
+ */
+std::string report_batch(const igp::record_batch &batch,
+                         igp::format_type input_ft,
+                         igp::format_type output_ft, bool use_pipeline,
+                         unsigned fixed_width, bool morgans) {
+  std::string filename = boost::filesystem::unique_path().native();
+  {
+    igp::output_variant_file output;
+    output.set_fixed_width(fixed_width);
+    output.output_morgans(morgans);
+    igp::query_file qf(NULL, &output);
+    qf.initialize_output(filename, output_ft);
+    qf.set_step_interval(mpf_class("0.5"));
+    std::unique_ptr<igp::base_format_pipeline> pipeline;
+    if (use_pipeline) {
+      pipeline.reset(igp::make_format_pipeline(input_ft, output_ft, &output));
+      qf.set_format_pipeline(pipeline.get());
+    }
+    qf.report(batch);
+    output.close();
+  }
+  std::ifstream input(filename.c_str());
+  std::ostringstream contents;
+  contents << input.rdbuf();
+  input.close();
+  boost::filesystem::remove(filename);
+  return contents.str();
+}
+}  // namespace
+
+TEST(formatPipelineTest, factoryAcceptsOnlyValidCombinations) {
+  igp::output_variant_file output;
+  output.open("", igp::BIM);
+  std::unique_ptr<igp::base_format_pipeline> pipeline(
+      igp::make_format_pipeline(igp::VCF, igp::BIM, &output));
+  EXPECT_TRUE(pipeline.get() != NULL);
+  pipeline.reset(igp::make_format_pipeline(igp::BED, igp::BIM, &output));
+  EXPECT_TRUE(pipeline.get() == NULL);
+  pipeline.reset(igp::make_format_pipeline(igp::MAP, igp::BIM, &output));
+  EXPECT_TRUE(pipeline.get() == NULL);
+  EXPECT_THROW(igp::make_format_pipeline(igp::BIM, igp::MAP, &output),
+               std::runtime_error);
+}
+
+TEST(formatPipelineTest, variantPipelinesMatchGenericReport) {
+  igp::record_batch batch;
+  add_query(&batch, "1", 100, -1, "rs1", "", mpf_class("0.125"),
+            mpf_class("1.5"));
+  add_query(&batch, "1", 200, -1, "rs2", "", mpf_class("0.25"),
+            mpf_class("1.5"));
+  add_query(&batch, "2", 50, -1, "rs3", "", mpf_class("3.0"),
+            mpf_class("0.5"));
+  igp::format_type outputs[] = {igp::BIM, igp::MAP, igp::SNP};
+  for (unsigned i = 0; i < 3; ++i) {
+    for (unsigned fixed_width = 0; fixed_width < 4; fixed_width += 3) {
+      std::string expected =
+          report_batch(batch, igp::BIM, outputs[i], false, fixed_width, true);
+      EXPECT_FALSE(expected.empty());
+      EXPECT_EQ(
+          report_batch(batch, igp::BIM, outputs[i], true, fixed_width, true),
+          expected);
+    }
+  }
+}
+
+TEST(formatPipelineTest, bedPipelineAppliesLabelIncrements) {
+  igp::record_batch batch;
+  add_query(&batch, "1", 101, 200, "", "a", mpf_class("0.1"),
+            mpf_class("1.0"));
+  add_query(&batch, "1", 201, 300, "", "a", mpf_class("0.2"),
+            mpf_class("1.0"));
+  add_query(&batch, "1", 301, 400, "", "b", mpf_class("0.3"),
+            mpf_class("2.0"));
+  add_query(&batch, "2", 11, 20, "", "b", mpf_class("0.0"), mpf_class("2.0"));
+  // a new label adds the step interval; a new chromosome and closing
+  // the file each emit a placeholder row at the end of a chromosome
+  EXPECT_EQ(report_batch(batch, igp::BED, igp::BOLT, true, 0, false),
+            "chr\tposition\tCOMBINED_rate(cM/Mb)\tGenetic_Map(cM)\n"
+            "1\t101\t1\t0.1\n"
+            "1\t201\t1\t0.2\n"
+            "1\t301\t2\t0.8\n"
+            "1\t400\t0\t1.3002\n"
+            "2\t11\t2\t0\n"
+            "2\t20\t0\t0.500018\n");
+}
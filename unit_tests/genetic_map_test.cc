@@ -11,6 +11,7 @@
 #include "gtest/gtest.h"
 #include "unit_tests/input_genetic_map_file_test.h"
 
+using ::testing::_;
 using ::testing::AnyNumber;
 using ::testing::AtLeast;
 using ::testing::Return;
@@ -443,6 +444,9 @@ TEST_F(geneticMapTest, queryChromMatchEndOfBoltStyleMap) {
   igp::mock_input_genetic_map_file mockfile;
   igp::genetic_map gm(&mockfile);
   EXPECT_CALL(mockfile, close()).Times(AnyNumber());
+  EXPECT_CALL(mockfile, skip_to(_, _))
+      .Times(AnyNumber())
+      .WillRepeatedly(Return(false));
   EXPECT_CALL(mockfile, eof()).Times(AnyNumber()).WillRepeatedly(Return(true));
   EXPECT_CALL(mockfile, get_chr_lower_bound())
       .Times(AnyNumber())
@@ -488,6 +492,9 @@ TEST_F(geneticMapTest, querySameChromBeyondEndOfBedgraphStyleMap) {
   igp::mock_input_genetic_map_file mockfile;
   igp::genetic_map gm(&mockfile);
   EXPECT_CALL(mockfile, close()).Times(AnyNumber());
+  EXPECT_CALL(mockfile, skip_to(_, _))
+      .Times(AnyNumber())
+      .WillRepeatedly(Return(false));
   EXPECT_CALL(mockfile, eof()).Times(AnyNumber()).WillRepeatedly(Return(true));
   EXPECT_CALL(mockfile, get_chr_lower_bound())
       .Times(AnyNumber())
@@ -535,6 +542,9 @@ TEST_F(geneticMapTest, querySameChromWithinEndOfBedgraphStyleMap) {
   igp::mock_input_genetic_map_file mockfile;
   igp::genetic_map gm(&mockfile);
   EXPECT_CALL(mockfile, close()).Times(AnyNumber());
+  EXPECT_CALL(mockfile, skip_to(_, _))
+      .Times(AnyNumber())
+      .WillRepeatedly(Return(false));
   EXPECT_CALL(mockfile, eof()).Times(AnyNumber()).WillRepeatedly(Return(true));
   EXPECT_CALL(mockfile, get_chr_lower_bound())
       .Times(AnyNumber())
@@ -584,6 +594,9 @@ TEST_F(geneticMapTest,
   igp::mock_input_genetic_map_file mockfile;
   igp::genetic_map gm(&mockfile);
   EXPECT_CALL(mockfile, close()).Times(AnyNumber());
+  EXPECT_CALL(mockfile, skip_to(_, _))
+      .Times(AnyNumber())
+      .WillRepeatedly(Return(false));
   EXPECT_CALL(mockfile, eof()).Times(AnyNumber()).WillRepeatedly(Return(true));
   EXPECT_CALL(mockfile, get_chr_lower_bound())
       .Times(AnyNumber())
@@ -634,6 +647,9 @@ TEST_F(geneticMapTest,
   igp::mock_input_genetic_map_file mockfile;
   igp::genetic_map gm(&mockfile);
   EXPECT_CALL(mockfile, close()).Times(AnyNumber());
+  EXPECT_CALL(mockfile, skip_to(_, _))
+      .Times(AnyNumber())
+      .WillRepeatedly(Return(false));
   EXPECT_CALL(mockfile, eof()).Times(AnyNumber()).WillRepeatedly(Return(true));
   EXPECT_CALL(mockfile, get_chr_lower_bound())
       .Times(AnyNumber())
@@ -694,3 +710,67 @@ TEST_F(geneticMapTest, geneticMapFromCin) {
   EXPECT_EQ(result.get_gpos(), mpf_class("0.96"));
   EXPECT_EQ(result.get_rate(), mpf_class(0.0));
 }
+
+TEST_F(geneticMapTest, queryFinalIntervalOfMap) {
+  // once the last row of the map has been read, queries before it
+  // still interpolate within the final interval
+  std::string genetic_map_content =
+      "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n"
+      "1 1000000 0.1 0.0\n"
+      "1 2000000 0.2 0.1\n"
+      "1 3000000 0.0 0.3\n";
+  std::istringstream strm1(genetic_map_content);
+  igp::input_genetic_map_file realfile;
+  realfile.set_fallback_stream(&strm1);
+  realfile.open("", igp::BOLT);
+  igp::genetic_map gm(&realfile);
+  igp::query_result result;
+  gm.query("1", 2500000, -1, false, &result);
+  EXPECT_EQ(cmp(abs(result.get_gpos() - mpf_class("0.2")),
+                _mpf_error_tolerance),
+            -1);
+  EXPECT_EQ(result.get_rate(), mpf_class("0.2"));
+  gm.query("1", 3500000, -1, false, &result);
+  EXPECT_EQ(result.get_gpos(), mpf_class("0.3"));
+  EXPECT_EQ(result.get_rate(), mpf_class(0.0));
+}
+
+TEST_F(geneticMapTest, queryBeforeSingleRowChromosome) {
+  std::string genetic_map_content =
+      "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n"
+      "1 100000 1.0 0.0\n"
+      "2 500000 2.0 0.0\n"
+      "3 100000 0.0 0.0\n";
+  std::istringstream strm1(genetic_map_content);
+  igp::input_genetic_map_file realfile;
+  realfile.set_fallback_stream(&strm1);
+  realfile.open("", igp::BOLT);
+  igp::genetic_map gm(&realfile);
+  std::vector<igp::query_result> results;
+  gm.query("2", 100000, 700000, false, &results);
+  ASSERT_EQ(results.size(), 2u);
+  EXPECT_EQ(results.at(0).get_endpos(), mpz_class(500000));
+  EXPECT_EQ(results.at(0).get_gpos(), mpf_class(0.0));
+  EXPECT_EQ(results.at(0).get_rate(), mpf_class(0.0));
+  EXPECT_EQ(results.at(1).get_startpos(), mpz_class(500000));
+  EXPECT_EQ(results.at(1).get_gpos(), mpf_class(0.0));
+  EXPECT_EQ(results.at(1).get_rate(), mpf_class("2.0"));
+}
+
+TEST_F(geneticMapTest, regionEndsWithinFinalBedgraphRow) {
+  std::string genetic_map_content =
+      "chr1\t0\t1000000\t1.0\n"
+      "chr2\t0\t1000000\t1.0\n";
+  std::istringstream strm1(genetic_map_content);
+  igp::input_genetic_map_file realfile;
+  realfile.set_fallback_stream(&strm1);
+  realfile.open("", igp::BEDGRAPH);
+  igp::genetic_map gm(&realfile);
+  std::vector<igp::query_result> results;
+  gm.query("chr1", 200001, 300001, false, &results);
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results.at(0).get_endpos(), mpz_class(300001));
+  EXPECT_EQ(cmp(abs(results.at(0).get_gpos() - mpf_class("0.2")),
+                _mpf_error_tolerance),
+            -1);
+}
@@ -0,0 +1,92 @@
+/*!
+ \file gmp_arena_test.cc
+ \brief test of per-thread GMP arena allocator.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/gmp_arena.h"
+
+#include <gmpxx.h>
+
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+TEST(gmpArenaTest, arithmeticIsUnchanged) {
+  igp::gmp_arena::install();
+  EXPECT_TRUE(igp::gmp_arena::installed());
+  {
+    mpz_class a("123456789012345678901234567890");
+    mpz_class b = a * a + 7;
+    mpf_class c("0.125");
+    mpf_class d = c * 8 + mpf_class(1000000.0);
+    EXPECT_EQ(b % 10, mpz_class(7));
+    EXPECT_EQ(d, mpf_class(1000001.0));
+    // force a realloc of an existing value well past its original size
+    mpz_class e = 1;
+    for (unsigned i = 0; i < 50; ++i) {
+      e *= a;
+    }
+    EXPECT_EQ(e / a, mpz_class(a * e / a / a));
+  }
+  igp::gmp_arena::uninstall();
+  EXPECT_FALSE(igp::gmp_arena::installed());
+}
+
+TEST(gmpArenaTest, resetRecyclesChunks) {
+  igp::gmp_arena::install();
+  {
+    mpf_class persistent("1.5");
+    // warm the arena up, then check steady state does not hit malloc
+    for (unsigned batch = 0; batch < 3; ++batch) {
+      for (unsigned i = 0; i < 10000; ++i) {
+        mpf_class tmp = persistent * i + mpf_class(1000000.0);
+      }
+      igp::gmp_arena::reset();
+    }
+    unsigned long long system_allocations =
+        igp::gmp_arena::get_system_allocations();
+    unsigned long long arena_allocations =
+        igp::gmp_arena::get_arena_allocations();
+    for (unsigned batch = 0; batch < 3; ++batch) {
+      for (unsigned i = 0; i < 10000; ++i) {
+        mpf_class tmp = persistent * i + mpf_class(1000000.0);
+      }
+      igp::gmp_arena::reset();
+    }
+    EXPECT_EQ(igp::gmp_arena::get_system_allocations(), system_allocations);
+    EXPECT_GT(igp::gmp_arena::get_arena_allocations(), arena_allocations);
+    EXPECT_EQ(persistent, mpf_class("1.5"));
+  }
+  igp::gmp_arena::uninstall();
+}
+
+TEST(gmpArenaTest, valuesCanBeFreedOnAnotherThread) {
+  igp::gmp_arena::install();
+  {
+    std::vector<std::unique_ptr<mpz_class> > values;
+    std::thread producer([&values]() {
+      for (unsigned i = 0; i < 1000; ++i) {
+        values.push_back(std::unique_ptr<mpz_class>(new mpz_class(i)));
+        *values.back() *= mpz_class("1000000000000000000000000");
+      }
+    });
+    producer.join();
+    ASSERT_EQ(values.size(), 1000u);
+    EXPECT_EQ(*values.at(999), mpz_class("999000000000000000000000000"));
+    values.clear();
+  }
+  igp::gmp_arena::uninstall();
+}
+
+TEST(gmpArenaTest, reportsActivity) {
+  std::ostringstream o;
+  igp::gmp_arena::report(o);
+  EXPECT_EQ(o.str().find("gmp arena: "), 0UL);
+}
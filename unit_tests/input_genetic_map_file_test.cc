@@ -130,3 +130,55 @@ TEST_F(inputGeneticMapFileTest, catchesEofInFallbackStream) {
   mapfile.set_fallback_stream(&strm1);
   EXPECT_FALSE(mapfile.get());
 }
+
+TEST_F(inputGeneticMapFileTest, blocksMatchBoundCursor) {
+  std::string content =
+      "chr1\t0\t10\t0.5\n"
+      "chr1\t10\t20\t1.5\n"
+      "chr1\t20\t30\t2.5\n"
+      "chr1\t30\t40\t3.5\n"
+      "chr1\t40\t50\t4.5\n"
+      "chr2\t0\t10\t0.25\n"
+      "chr2\t10\t20\t0.75\n"
+      "chr3\t5\t15\t1.0\n";
+  // every row, as reported by the lower bound of the cursor
+  std::istringstream strm1(content);
+  igp::input_genetic_map_file cursor;
+  cursor.set_fallback_stream(&strm1);
+  cursor.open("", igp::BEDGRAPH);
+  std::vector<std::string> chrs;
+  std::vector<mpz_class> startpos;
+  std::vector<mpf_class> gpos;
+  do {
+    chrs.push_back(cursor.get_chr_lower_bound());
+    startpos.push_back(cursor.get_startpos_lower_bound());
+    gpos.push_back(cursor.get_gpos_lower_bound());
+  } while (cursor.get());
+  chrs.push_back(cursor.get_chr_upper_bound());
+  startpos.push_back(cursor.get_startpos_upper_bound());
+  gpos.push_back(cursor.get_gpos_upper_bound());
+  ASSERT_EQ(chrs.size(), 8u);
+  for (unsigned max_rows = 1; max_rows <= 6; ++max_rows) {
+    std::istringstream strm2(content);
+    igp::input_genetic_map_file mapfile;
+    mapfile.set_fallback_stream(&strm2);
+    mapfile.open("", igp::BEDGRAPH);
+    igp::map_block block;
+    unsigned n_rows = 0, n_blocks = 0;
+    while (mapfile.get_block(&block, max_rows)) {
+      ++n_blocks;
+      EXPECT_LE(block.size(), max_rows);
+      for (unsigned i = 0; i < block.size(); ++i, ++n_rows) {
+        ASSERT_LT(n_rows, chrs.size());
+        EXPECT_EQ(block.get_chr(), chrs.at(n_rows));
+        EXPECT_EQ(block.get_startpos(i), startpos.at(n_rows));
+        EXPECT_EQ(block.get_gpos(i), gpos.at(n_rows));
+      }
+    }
+    EXPECT_EQ(n_rows, chrs.size());
+    // a block never spans chromosomes
+    EXPECT_GE(n_blocks, 3u);
+    EXPECT_FALSE(mapfile.get_block(&block, max_rows));
+    EXPECT_TRUE(block.empty());
+  }
+}
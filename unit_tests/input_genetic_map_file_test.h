@@ -47,6 +47,10 @@ class mock_input_genetic_map_file : public base_input_genetic_map_file {
   MOCK_METHOD(mpf_class, get_gpos_upper_bound, (), (const, override));
   MOCK_METHOD(mpf_class, get_rate_lower_bound, (), (const, override));
   MOCK_METHOD(mpf_class, get_rate_upper_bound, (), (const, override));
+  MOCK_METHOD(bool, get_block, (map_block * block, unsigned max_rows),
+              (override));
+  MOCK_METHOD(bool, skip_to, (const std::string &chr, const mpz_class &pos),
+              (override));
 };
 }  // namespace interpolate_genetic_position
 
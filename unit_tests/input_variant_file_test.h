@@ -46,6 +46,14 @@ class mock_input_variant_file : public base_input_variant_file {
   MOCK_METHOD(const std::string &, get_a2, (), (const, override));
   MOCK_METHOD(const std::vector<std::string> &, get_line_contents, (),
               (const, override));
+  MOCK_METHOD(const bcf_hdr_t *, get_vcf_header, (), (const, override));
+  MOCK_METHOD(bcf1_t *, get_vcf_record, (), (const, override));
+  MOCK_METHOD(void, set_vcf_fields,
+              (bool need_varid, bool need_alleles, bool need_record),
+              (override));
+  MOCK_METHOD(void, read_header,
+              (const std::string &prefix, std::vector<std::string> *lines),
+              (override));
   MOCK_METHOD(bool, eof, (), (override));
 };
 }  // namespace interpolate_genetic_position
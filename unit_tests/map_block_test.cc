@@ -0,0 +1,56 @@
+/*!
+ \file map_block_test.cc
+ \brief test of contiguous genetic map block.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/map_block.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+TEST(mapBlockTest, storesRowsFromOneChromosome) {
+  igp::map_block block;
+  EXPECT_TRUE(block.empty());
+  block.append("1", 100, -1, mpf_class("0.5"), mpf_class("1.5"));
+  block.append("1", 200, -1, mpf_class("0.6"), mpf_class("2.5"));
+  EXPECT_EQ(block.size(), 2u);
+  EXPECT_EQ(block.get_chr(), "1");
+  EXPECT_EQ(block.get_startpos(1), mpz_class(200));
+  EXPECT_EQ(block.get_endpos(1), mpz_class(-1));
+  EXPECT_EQ(block.get_gpos(0), mpf_class("0.5"));
+  EXPECT_EQ(block.get_rate(1), mpf_class("2.5"));
+  EXPECT_THROW(block.get_startpos(2), std::runtime_error);
+  EXPECT_THROW(block.append("2", 300, -1, 0.0, 0.0), std::runtime_error);
+  block.clear();
+  EXPECT_TRUE(block.empty());
+  EXPECT_NO_THROW(block.append("2", 300, -1, 0.0, 0.0));
+  EXPECT_EQ(block.get_chr(), "2");
+  EXPECT_EQ(block.get_startpos(0), mpz_class(300));
+}
+
+TEST(mapBlockTest, searchKernelsAgree) {
+  igp::map_block block;
+  for (unsigned i = 1; i <= 50; ++i) {
+    block.append("1", 1000 * i, -1, 0.0, 0.0);
+  }
+  std::vector<mpz_class> positions;
+  for (unsigned pos = 0; pos <= 52000; pos += 250) {
+    positions.push_back(pos);
+  }
+  std::vector<unsigned> merged;
+  block.upper_bounds(positions, &merged);
+  ASSERT_EQ(merged.size(), positions.size());
+  for (unsigned i = 0; i < positions.size(); ++i) {
+    unsigned expected = positions.at(i).get_ui() / 1000;
+    if (expected > 50) expected = 50;
+    EXPECT_EQ(block.upper_bound(positions.at(i)), expected);
+    EXPECT_EQ(merged.at(i), expected);
+  }
+  igp::map_block empty_block;
+  EXPECT_EQ(empty_block.upper_bound(100), 0u);
+}
@@ -0,0 +1,136 @@
+/*!
+ \file map_index_test.cc
+ \brief test of genetic map sidecar index.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/map_index.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+TEST(mapIndexTest, findsLastCheckpointBeforeSortedQueries) {
+  igp::map_index index;
+  EXPECT_TRUE(index.empty());
+  index.add("1", 100, 0, 0, 0.0);
+  index.add("1", 5000, 1024, 20000, 0.0);
+  index.add("2", 100, 2000, 40000, 0.0);
+  index.add("2", 9000, 3024, 60000, 0.0);
+  EXPECT_EQ(index.size(), 4u);
+  EXPECT_EQ(index.at(2).chr, 2);
+  // before the first row of the chromosome
+  EXPECT_EQ(index.find("1", 50), nullptr);
+  const igp::map_index::checkpoint *found = index.find("chr1", 6000);
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->row, 1024u);
+  EXPECT_EQ(found->locator, 20000u);
+  // nothing new since the previous query
+  EXPECT_EQ(index.find("1", 7000), nullptr);
+  // checkpoints starting exactly at the query count
+  found = index.find("2", 9000);
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->row, 3024u);
+  EXPECT_EQ(index.find("3", 100), nullptr);
+  index.clear();
+  EXPECT_TRUE(index.empty());
+}
+
+TEST(mapIndexTest, skipsChromosomesWithoutQueries) {
+  igp::map_index index;
+  index.add("1", 100, 0, 0, 0.0);
+  index.add("2", 100, 10, 1000, 0.0);
+  index.add("3", 100, 20, 2000, 0.0);
+  const igp::map_index::checkpoint *found = index.find("3", 500);
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->row, 20u);
+}
+
+TEST(mapIndexTest, restoresGeneticPositionsExactly) {
+  std::string map_filename = boost::filesystem::unique_path().native();
+  std::string index_filename = igp::map_index::sidecar_filename(map_filename);
+  EXPECT_TRUE(igp::map_index::identify(map_filename, igp::BEDGRAPH, 1024)
+                  .empty());
+  std::ofstream map_file(map_filename.c_str());
+  map_file << "chr1 0 100 1.5\n";
+  map_file.close();
+  std::vector<int64_t> header =
+      igp::map_index::identify(map_filename, igp::BEDGRAPH, 1024);
+  EXPECT_FALSE(header.empty());
+  // values without a finite decimal or hexadecimal representation
+  mpf_class third = mpf_class(1) / 3, negative = mpf_class(-2) / 7;
+  igp::map_index index;
+  index.add("1", 100, 0, 0, third);
+  index.add("X", 200, 1024, 5000, negative);
+  index.add("X", 300, 2048, 9000, 0.0);
+  ASSERT_TRUE(index.save(index_filename, header));
+  igp::map_index restored;
+  EXPECT_FALSE(restored.restore(
+      index_filename,
+      igp::map_index::identify(map_filename, igp::BEDGRAPH, 512)));
+  EXPECT_FALSE(restored.restore(
+      index_filename, igp::map_index::identify(map_filename, igp::BOLT, 1024)));
+  ASSERT_TRUE(restored.restore(index_filename, header));
+  ASSERT_EQ(restored.size(), 3u);
+  EXPECT_EQ(cmp(restored.at(0).gpos, third), 0);
+  EXPECT_EQ(cmp(restored.at(1).gpos, negative), 0);
+  EXPECT_EQ(cmp(restored.at(2).gpos, 0), 0);
+  EXPECT_EQ(restored.at(1).chr, 23);
+  EXPECT_EQ(restored.at(1).startpos, 200);
+  EXPECT_EQ(restored.at(1).row, 1024u);
+  EXPECT_EQ(restored.at(1).locator, 5000u);
+  // a truncated index is rejected
+  boost::filesystem::resize_file(
+      index_filename, boost::filesystem::file_size(index_filename) - 4);
+  EXPECT_FALSE(restored.restore(index_filename, header));
+  boost::filesystem::remove(index_filename);
+  boost::filesystem::remove(map_filename);
+}
+
+TEST(mapIndexTest, restoresGzipAccessPoints) {
+  std::string map_filename = boost::filesystem::unique_path().native();
+  std::string index_filename = igp::map_index::sidecar_filename(map_filename);
+  std::ofstream map_file(map_filename.c_str());
+  map_file << "chr1 0 100 1.5\n";
+  map_file.close();
+  std::vector<int64_t> header =
+      igp::map_index::identify(map_filename, igp::BEDGRAPH, 1024);
+  igp::map_index index;
+  index.add("1", 100, 0, 0, 0.0);
+  std::vector<igp::seekable_gzip_reader::access_point> points(2);
+  points.at(0).out = 0;
+  points.at(0).in = 10;
+  points.at(0).bits = 0;
+  points.at(1).out = 1048580;
+  points.at(1).in = 300000;
+  points.at(1).bits = 5;
+  points.at(1).window.assign(32768, 'x');
+  points.at(1).window.at(7) = 'y';
+  index.set_access_points(points);
+  ASSERT_TRUE(index.save(index_filename, header));
+  igp::map_index restored;
+  ASSERT_TRUE(restored.restore(index_filename, header));
+  const std::vector<igp::seekable_gzip_reader::access_point> &observed =
+      restored.get_access_points();
+  ASSERT_EQ(observed.size(), 2u);
+  EXPECT_EQ(observed.at(0).in, 10u);
+  EXPECT_TRUE(observed.at(0).window.empty());
+  EXPECT_EQ(observed.at(1).out, 1048580u);
+  EXPECT_EQ(observed.at(1).in, 300000u);
+  EXPECT_EQ(observed.at(1).bits, 5);
+  EXPECT_EQ(observed.at(1).window, points.at(1).window);
+  restored.clear();
+  EXPECT_TRUE(restored.get_access_points().empty());
+  // a window cut short is rejected
+  boost::filesystem::resize_file(
+      index_filename, boost::filesystem::file_size(index_filename) - 100);
+  EXPECT_FALSE(restored.restore(index_filename, header));
+  boost::filesystem::remove(index_filename);
+  boost::filesystem::remove(map_filename);
+}
@@ -0,0 +1,67 @@
+/*!
+ \file mapped_line_reader_test.cc
+ \brief test of memory-mapped line reader.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/mapped_line_reader.h"
+
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+void write_file(const std::string &filename, const std::string &contents) {
+  std::ofstream output(filename.c_str(), std::ios::binary);
+  output << contents;
+  output.close();
+}
+}  // namespace
+
+TEST(mappedLineReaderTest, readsLinesInPlace) {
+  std::string filename = boost::filesystem::unique_path().native();
+  write_file(filename, "1 rs1 0 500000\n\n3\trs3\t0\t1000000");
+  igp::mapped_line_reader reader;
+  EXPECT_FALSE(reader.is_open());
+  EXPECT_TRUE(reader.eof());
+  ASSERT_TRUE(reader.open(filename));
+  EXPECT_TRUE(reader.is_open());
+  std::string_view line;
+  EXPECT_FALSE(reader.eof());
+  EXPECT_TRUE(reader.getline(&line));
+  EXPECT_EQ(line, "1 rs1 0 500000");
+  EXPECT_TRUE(reader.getline(&line));
+  EXPECT_EQ(line, "");
+  EXPECT_TRUE(reader.getline(&line));
+  EXPECT_EQ(line, "3\trs3\t0\t1000000");
+  EXPECT_TRUE(reader.eof());
+  EXPECT_FALSE(reader.getline(&line));
+  reader.close();
+  EXPECT_FALSE(reader.is_open());
+  boost::filesystem::remove(filename);
+}
+
+TEST(mappedLineReaderTest, emptyFileHasNoLines) {
+  std::string filename = boost::filesystem::unique_path().native();
+  write_file(filename, "");
+  igp::mapped_line_reader reader;
+  ASSERT_TRUE(reader.open(filename));
+  std::string_view line;
+  EXPECT_TRUE(reader.eof());
+  EXPECT_FALSE(reader.getline(&line));
+  reader.close();
+  boost::filesystem::remove(filename);
+}
+
+TEST(mappedLineReaderTest, refusesWhatCannotBeMapped) {
+  igp::mapped_line_reader reader;
+  EXPECT_FALSE(reader.open("/this/file/does/not/exist"));
+  EXPECT_FALSE(reader.open(boost::filesystem::temp_directory_path().native()));
+  EXPECT_FALSE(reader.is_open());
+}
@@ -0,0 +1,83 @@
+/*!
+ \file memory_profiler_test.cc
+ \brief test of allocation instrumentation.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/memory_profiler.h"
+
+#include <gmpxx.h>
+
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+TEST(memoryProfilerTest, stageNameConversion) {
+  EXPECT_EQ(igp::profile_stage_to_string(igp::STAGE_SETUP), "setup");
+  EXPECT_EQ(igp::profile_stage_to_string(igp::STAGE_READ), "read");
+  EXPECT_EQ(igp::profile_stage_to_string(igp::STAGE_INTERPOLATE),
+            "interpolate");
+  EXPECT_EQ(igp::profile_stage_to_string(igp::STAGE_WRITE), "write");
+  EXPECT_THROW(igp::profile_stage_to_string(igp::N_PROFILE_STAGES),
+               std::runtime_error);
+}
+
+TEST(memoryProfilerTest, stageGuardRestoresPreviousStage) {
+  igp::profile_stage initial = igp::memory_profiler::get_current_stage();
+  {
+    igp::memory_profiler::stage_guard guard1(igp::STAGE_READ);
+    EXPECT_EQ(igp::memory_profiler::get_current_stage(), igp::STAGE_READ);
+    {
+      igp::memory_profiler::stage_guard guard2(igp::STAGE_WRITE);
+      EXPECT_EQ(igp::memory_profiler::get_current_stage(), igp::STAGE_WRITE);
+    }
+    EXPECT_EQ(igp::memory_profiler::get_current_stage(), igp::STAGE_READ);
+  }
+  EXPECT_EQ(igp::memory_profiler::get_current_stage(), initial);
+}
+
+TEST(memoryProfilerTest, countsOnlyWhileEnabled) {
+  igp::memory_profiler::reset();
+  {
+    igp::memory_profiler::stage_guard guard(igp::STAGE_READ);
+    igp::memory_profiler::record_allocation(100, false);
+  }
+  EXPECT_EQ(igp::memory_profiler::get_allocations(igp::STAGE_READ), 0ULL);
+}
+
+TEST(memoryProfilerTest, countsHeapAndGmpAllocationsByStage) {
+  igp::memory_profiler::enable();
+  {
+    // the replacement operator new is only linked into the command line
+    // program, so heap allocations are reported by hand here
+    igp::memory_profiler::stage_guard guard(igp::STAGE_READ);
+    igp::memory_profiler::record_allocation(100, false);
+    igp::memory_profiler::record_allocation(24, false);
+  }
+  {
+    igp::memory_profiler::stage_guard guard(igp::STAGE_INTERPOLATE);
+    mpz_class value("123456789012345678901234567890");
+    value *= value;
+  }
+  igp::memory_profiler::record_row();
+  igp::memory_profiler::record_row();
+  igp::memory_profiler::disable();
+  EXPECT_GE(igp::memory_profiler::get_allocations(igp::STAGE_READ), 2ULL);
+  EXPECT_GE(igp::memory_profiler::get_bytes(igp::STAGE_READ), 100ULL);
+  EXPECT_EQ(igp::memory_profiler::get_gmp_allocations(igp::STAGE_READ), 0ULL);
+  EXPECT_GE(igp::memory_profiler::get_gmp_allocations(igp::STAGE_INTERPOLATE),
+            1ULL);
+  EXPECT_GT(igp::memory_profiler::get_gmp_bytes(igp::STAGE_INTERPOLATE), 0ULL);
+  EXPECT_EQ(igp::memory_profiler::get_rows(), 2ULL);
+  EXPECT_GT(igp::memory_profiler::get_peak_rss_kb(), 0L);
+  std::ostringstream o;
+  igp::memory_profiler::report(o);
+  EXPECT_EQ(o.str().find("memory profile: 2 rows processed"), 0UL);
+  EXPECT_NE(o.str().find("interpolate"), std::string::npos);
+  EXPECT_NE(o.str().find("total"), std::string::npos);
+  igp::memory_profiler::reset();
+}
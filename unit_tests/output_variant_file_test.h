@@ -38,6 +38,17 @@ class mock_output_variant_file : public base_output_variant_file {
                const mpf_class &gpos, const mpf_class &rate,
                const std::string &a1, const std::string &a2),
               (override));
+  MOCK_METHOD(void, write_vcf,
+              (bcf1_t * record, const mpf_class &gpos, const mpf_class &rate),
+              (override));
+  MOCK_METHOD(void, set_vcf_header, (const bcf_hdr_t *header), (override));
+  MOCK_METHOD(void, write_pvar,
+              (const std::vector<std::string> &line_contents,
+               const std::string &chr, const mpf_class &gpos),
+              (override));
+  MOCK_METHOD(void, set_pvar_header,
+              (const std::vector<std::string> &header_lines, int cm_column),
+              (override));
   MOCK_METHOD(format_type, get_format, (), (const, override));
   MOCK_METHOD(void, output_morgans, (bool use_morgans), (override));
   MOCK_METHOD(bool, output_morgans, (), (const, override));
@@ -0,0 +1,89 @@
+/*!
+ \file parallel_bigwig_map_file_test.cc
+ \brief test of parallel bigwig genetic map decoding.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/parallel_bigwig_map_file.h"
+
+#include "gtest/gtest.h"
+#include "interpolate-genetic-position/input_genetic_map_file.h"
+#include "interpolate-genetic-position/map_block.h"
+
+namespace igp = interpolate_genetic_position;
+
+TEST(parallelBigwigMapFileTest, matchesStreamedBigwig) {
+  for (unsigned n_threads = 1; n_threads <= 8; n_threads *= 2) {
+    igp::input_genetic_map_file streamed;
+    igp::parallel_bigwig_map_file decoded;
+    decoded.set_threads(n_threads);
+    streamed.open("unit_tests/test.bw", igp::BIGWIG);
+    decoded.open("unit_tests/test.bw", igp::BIGWIG);
+    bool more = true;
+    unsigned rows = 0;
+    while (more) {
+      EXPECT_EQ(decoded.get_chr_lower_bound(), streamed.get_chr_lower_bound());
+      EXPECT_EQ(decoded.get_chr_upper_bound(), streamed.get_chr_upper_bound());
+      EXPECT_EQ(decoded.get_startpos_lower_bound(),
+                streamed.get_startpos_lower_bound());
+      EXPECT_EQ(decoded.get_startpos_upper_bound(),
+                streamed.get_startpos_upper_bound());
+      EXPECT_EQ(decoded.get_endpos_lower_bound(),
+                streamed.get_endpos_lower_bound());
+      EXPECT_EQ(decoded.get_endpos_upper_bound(),
+                streamed.get_endpos_upper_bound());
+      EXPECT_EQ(decoded.get_gpos_lower_bound(),
+                streamed.get_gpos_lower_bound());
+      EXPECT_EQ(decoded.get_gpos_upper_bound(),
+                streamed.get_gpos_upper_bound());
+      EXPECT_EQ(decoded.get_rate_lower_bound(),
+                streamed.get_rate_lower_bound());
+      EXPECT_EQ(decoded.get_rate_upper_bound(),
+                streamed.get_rate_upper_bound());
+      EXPECT_EQ(decoded.eof(), streamed.eof());
+      more = streamed.get();
+      EXPECT_EQ(decoded.get(), more);
+      ++rows;
+    }
+    EXPECT_TRUE(decoded.eof());
+    // chromosomes are served in karyotypic order, with genetic
+    // position restarting on each
+    EXPECT_EQ(rows, 7u);
+    EXPECT_EQ(decoded.get_chr_lower_bound(), "chr22");
+  }
+}
+
+TEST(parallelBigwigMapFileTest, matchesStreamedBlocks) {
+  igp::input_genetic_map_file streamed;
+  igp::parallel_bigwig_map_file decoded;
+  decoded.set_threads(3);
+  streamed.open("unit_tests/test.bw", igp::BIGWIG);
+  decoded.open("unit_tests/test.bw", igp::BIGWIG);
+  igp::map_block streamed_block, decoded_block;
+  unsigned blocks = 0;
+  while (streamed.get_block(&streamed_block, 1)) {
+    ASSERT_TRUE(decoded.get_block(&decoded_block, 1));
+    ASSERT_EQ(decoded_block.size(), streamed_block.size());
+    EXPECT_EQ(decoded_block.get_chr(), streamed_block.get_chr());
+    EXPECT_EQ(decoded_block.get_startpos(0), streamed_block.get_startpos(0));
+    EXPECT_EQ(decoded_block.get_endpos(0), streamed_block.get_endpos(0));
+    EXPECT_EQ(decoded_block.get_gpos(0), streamed_block.get_gpos(0));
+    EXPECT_EQ(decoded_block.get_rate(0), streamed_block.get_rate(0));
+    ++blocks;
+  }
+  EXPECT_FALSE(decoded.get_block(&decoded_block, 1));
+  EXPECT_EQ(blocks, 8u);
+}
+
+TEST(parallelBigwigMapFileTest, rejectsInvalidUse) {
+  igp::parallel_bigwig_map_file decoded;
+  EXPECT_THROW(decoded.set_threads(0), std::runtime_error);
+  EXPECT_THROW(decoded.open("unit_tests/test.bw", igp::BEDGRAPH),
+               std::runtime_error);
+  EXPECT_THROW(decoded.open("README.md", igp::BIGWIG), std::runtime_error);
+  EXPECT_THROW(decoded.open("dummyfile.txt", igp::BIGWIG), std::runtime_error);
+  EXPECT_THROW(decoded.get_fallback_stream(), std::runtime_error);
+  EXPECT_THROW(igp::parallel_bigwig_map_file copy(decoded),
+               std::runtime_error);
+}
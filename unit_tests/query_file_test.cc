@@ -14,6 +14,7 @@
 
 using ::testing::AtLeast;
 using ::testing::Return;
+using ::testing::ReturnRef;
 
 namespace igp = interpolate_genetic_position;
 
@@ -108,3 +109,141 @@ TEST(queryFileTest, preventNullSettingOfStepInterval) {
   igp::query_file qf(NULL, NULL);
   EXPECT_THROW(qf.set_step_interval(mpf_class(0.0)), std::runtime_error);
 }
+
+TEST(queryFileTest, canReadBatchesFromCin) {
+  std::string bim_content =
+      "1 rs1 0 100 A C\n"
+      "1 rs2 0 200 G T\n"
+      "2 rs3 0 300 C G\n";
+  std::istringstream strm1(bim_content);
+  igp::input_variant_file infile;
+  infile.set_fallback_stream(&strm1);
+  igp::mock_output_variant_file mock_outfile;
+  igp::query_file qf(&infile, &mock_outfile);
+  qf.open("", igp::BIM);
+  igp::record_batch batch;
+  EXPECT_EQ(qf.get_batch(&batch, 2), 2u);
+  EXPECT_EQ(batch.get_chr(0), "1");
+  EXPECT_EQ(batch.get_pos1(0), mpz_class(100));
+  EXPECT_EQ(batch.get_pos2(0), mpz_class(-1));
+  EXPECT_EQ(batch.get_id(0), "rs1");
+  EXPECT_EQ(batch.get_a1(1), "G");
+  EXPECT_EQ(batch.get_a2(1), "T");
+  EXPECT_EQ(batch.get_chr_index(0), batch.get_chr_index(1));
+  EXPECT_EQ(qf.get_batch(&batch, 2), 1u);
+  EXPECT_EQ(batch.get_chr(0), "2");
+  EXPECT_EQ(batch.get_id(0), "rs3");
+  EXPECT_EQ(qf.get_batch(&batch, 2), 0u);
+}
+
+TEST(queryFileTest, batchedBedInputMatchesPerQueryInput) {
+  // gaps between regions on the same chromosome become extra queries
+  std::string bed_content =
+      "chr1\t99\t199\ta\n"
+      "chr1\t299\t399\tb\n"
+      "chr1\t399\t499\tb\n"
+      "chr1\t599\t699\tc\n"
+      "chr2\t99\t199\td\n"
+      "chr2\t499\t599\te\n";
+  std::istringstream strm1(bed_content);
+  igp::input_variant_file infile1;
+  infile1.set_fallback_stream(&strm1);
+  igp::mock_output_variant_file mock_outfile;
+  igp::query_file qf1(&infile1, &mock_outfile);
+  qf1.open("", igp::BED);
+  std::vector<std::string> expected;
+  while (qf1.get()) {
+    expected.push_back(qf1.get_chr() + ":" + qf1.get_pos1().get_str() + "-" +
+                       qf1.get_pos2().get_str());
+  }
+  ASSERT_EQ(expected.size(), 9u);
+  for (unsigned batch_size = 2; batch_size <= 10; ++batch_size) {
+    std::istringstream strm2(bed_content);
+    igp::input_variant_file infile2;
+    infile2.set_fallback_stream(&strm2);
+    igp::query_file qf2(&infile2, &mock_outfile);
+    qf2.open("", igp::BED);
+    igp::record_batch batch;
+    std::vector<std::string> observed;
+    while (qf2.get_batch(&batch, batch_size)) {
+      EXPECT_LE(batch.size(), batch_size);
+      for (unsigned i = 0; i < batch.size(); ++i) {
+        observed.push_back(batch.get_chr(i) + ":" +
+                           batch.get_pos1(i).get_str() + "-" +
+                           batch.get_pos2(i).get_str());
+      }
+    }
+    EXPECT_EQ(observed, expected);
+  }
+}
+
+TEST(queryFileTest, batchesFallBackToPerVariantInterface) {
+  igp::mock_input_variant_file mock_infile;
+  igp::mock_output_variant_file mock_outfile;
+  std::string chr = "3", varid = "rs5", a1 = "A", a2 = "G";
+  mpz_class pos1 = 12345, pos2 = -1;
+  std::vector<std::string> line_contents(9, "");
+  EXPECT_CALL(mock_infile, open("test.vcf")).Times(1).WillOnce(Return());
+  EXPECT_CALL(mock_infile, set_format_parameters(0, 1, -1, -1, false, 9))
+      .Times(1)
+      .WillOnce(Return());
+  EXPECT_CALL(mock_infile, get_variant())
+      .Times(2)
+      .WillOnce(Return(true))
+      .WillOnce(Return(false));
+  EXPECT_CALL(mock_infile, get_chr()).WillRepeatedly(ReturnRef(chr));
+  EXPECT_CALL(mock_infile, get_pos1()).WillRepeatedly(ReturnRef(pos1));
+  EXPECT_CALL(mock_infile, get_pos2()).WillRepeatedly(ReturnRef(pos2));
+  EXPECT_CALL(mock_infile, get_varid()).WillRepeatedly(ReturnRef(varid));
+  EXPECT_CALL(mock_infile, get_a1()).WillRepeatedly(ReturnRef(a1));
+  EXPECT_CALL(mock_infile, get_a2()).WillRepeatedly(ReturnRef(a2));
+  EXPECT_CALL(mock_infile, get_line_contents())
+      .WillRepeatedly(ReturnRef(line_contents));
+  igp::query_file qf(&mock_infile, &mock_outfile);
+  qf.open("test.vcf", igp::VCF);
+  igp::record_batch batch;
+  EXPECT_EQ(qf.get_batch(&batch, 10), 1u);
+  EXPECT_EQ(batch.get_chr(0), "3");
+  EXPECT_EQ(batch.get_pos1(0), mpz_class(12345));
+  EXPECT_EQ(batch.get_id(0), "rs5");
+  EXPECT_EQ(batch.get_a1(0), "A");
+  EXPECT_EQ(batch.get_a2(0), "G");
+  EXPECT_EQ(batch.get_label(0), "");
+}
+
+TEST(queryFileTest, vcfInputOnlyDecodesFieldsUsedByOutput) {
+  igp::mock_input_variant_file mock_infile;
+  igp::mock_output_variant_file mock_outfile;
+  std::string chr = "3", varid = "rs5", a1 = "A", a2 = "G";
+  mpz_class pos1 = 12345, pos2 = -1;
+  std::vector<std::string> line_contents(9, "");
+  EXPECT_CALL(mock_infile, open("test.vcf")).Times(1).WillOnce(Return());
+  EXPECT_CALL(mock_infile, set_format_parameters(0, 1, -1, -1, false, 9))
+      .Times(1)
+      .WillOnce(Return());
+  EXPECT_CALL(mock_infile, set_vcf_fields(true, false, false))
+      .Times(1)
+      .WillOnce(Return());
+  EXPECT_CALL(mock_outfile, open("", igp::MAP)).Times(1).WillOnce(Return());
+  EXPECT_CALL(mock_infile, get_variant())
+      .Times(2)
+      .WillOnce(Return(true))
+      .WillOnce(Return(false));
+  EXPECT_CALL(mock_infile, get_chr()).WillRepeatedly(ReturnRef(chr));
+  EXPECT_CALL(mock_infile, get_pos1()).WillRepeatedly(ReturnRef(pos1));
+  EXPECT_CALL(mock_infile, get_pos2()).WillRepeatedly(ReturnRef(pos2));
+  EXPECT_CALL(mock_infile, get_varid()).WillRepeatedly(ReturnRef(varid));
+  EXPECT_CALL(mock_infile, get_a1()).WillRepeatedly(ReturnRef(a1));
+  EXPECT_CALL(mock_infile, get_a2()).WillRepeatedly(ReturnRef(a2));
+  EXPECT_CALL(mock_infile, get_line_contents())
+      .WillRepeatedly(ReturnRef(line_contents));
+  igp::query_file qf(&mock_infile, &mock_outfile);
+  qf.open("test.vcf", igp::VCF);
+  qf.initialize_output("", igp::MAP);
+  igp::record_batch batch;
+  EXPECT_EQ(qf.get_batch(&batch, 10), 1u);
+  EXPECT_EQ(batch.get_id(0), "rs5");
+  // map output has no alleles, so none are stored
+  EXPECT_EQ(batch.get_a1(0), "");
+  EXPECT_EQ(batch.get_a2(0), "");
+}
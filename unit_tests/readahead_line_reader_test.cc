@@ -0,0 +1,93 @@
+/*!
+ \file readahead_line_reader_test.cc
+ \brief test of background read-ahead line reader.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/readahead_line_reader.h"
+
+#include <zlib.h>
+
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+std::vector<std::string> read_all(igp::readahead_line_reader *reader) {
+  std::vector<std::string> lines;
+  std::string_view line;
+  while (!reader->eof()) {
+    EXPECT_TRUE(reader->getline(&line));
+    lines.push_back(std::string(line));
+  }
+  EXPECT_FALSE(reader->getline(&line));
+  return lines;
+}
+}  // namespace
+
+TEST(readaheadLineReaderTest, splicesLinesAcrossChunks) {
+  std::string content = "1 rs1 0 100\n1 rs2 0 200\n\n2 rs3 0 300";
+  std::vector<std::string> expected = {"1 rs1 0 100", "1 rs2 0 200", "",
+                                       "2 rs3 0 300"};
+  // chunk sizes smaller than, equal to, and larger than a line
+  for (unsigned chunk_size = 1; chunk_size <= content.size() + 1;
+       ++chunk_size) {
+    std::istringstream strm1(content);
+    igp::readahead_line_reader reader(&strm1, chunk_size);
+    EXPECT_EQ(read_all(&reader), expected);
+  }
+}
+
+TEST(readaheadLineReaderTest, readsGzipStreams) {
+  std::string filename = boost::filesystem::unique_path().native() + ".gz";
+  std::string content = "chr1 1000000 0.1 0\nchr1 2000000 0.2 0.1\n";
+  gzFile output = gzopen(filename.c_str(), "wb");
+  ASSERT_TRUE(output != NULL);
+  gzwrite(output, content.c_str(), content.size());
+  gzclose(output);
+  gzFile input = gzopen(filename.c_str(), "rb");
+  ASSERT_TRUE(input != NULL);
+  {
+    igp::readahead_line_reader reader(input, 7);
+    std::vector<std::string> expected = {"chr1 1000000 0.1 0",
+                                         "chr1 2000000 0.2 0.1"};
+    EXPECT_EQ(read_all(&reader), expected);
+  }
+  gzclose(input);
+  boost::filesystem::remove(filename);
+}
+
+TEST(readaheadLineReaderTest, skipsTextAcrossChunks) {
+  std::string content = "1 rs1 0 100\n1 rs2 0 200\n2 rs3 0 300\n";
+  std::istringstream strm1(content);
+  igp::readahead_line_reader reader(&strm1, 5);
+  std::string_view line;
+  EXPECT_TRUE(reader.skip(12));
+  EXPECT_TRUE(reader.getline(&line));
+  EXPECT_EQ(line, "1 rs2 0 200");
+  EXPECT_TRUE(reader.skip(0));
+  EXPECT_FALSE(reader.skip(100));
+  EXPECT_TRUE(reader.eof());
+}
+
+TEST(readaheadLineReaderTest, stopsWithUnreadInput) {
+  std::string content(100000, 'x');
+  std::istringstream strm1(content);
+  igp::readahead_line_reader reader(&strm1, 10);
+  EXPECT_FALSE(reader.eof());
+  // destruction must not wait for the rest of the input to be read
+}
+
+TEST(readaheadLineReaderTest, rejectsNullSource) {
+  EXPECT_THROW(igp::readahead_line_reader(static_cast<std::istream *>(NULL)),
+               std::runtime_error);
+  EXPECT_THROW(igp::readahead_line_reader(static_cast<gzFile>(NULL)),
+               std::runtime_error);
+}
@@ -0,0 +1,105 @@
+/*!
+ \file record_batch_test.cc
+ \brief test of reusable query record batch.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/record_batch.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+TEST(recordBatchTest, storesRecordsInOrder) {
+  igp::record_batch rb;
+  EXPECT_TRUE(rb.empty());
+  EXPECT_EQ(rb.append("chr1", 100, -1, "rs1", "A", "C", "x"), 0u);
+  EXPECT_EQ(rb.append("chr1", 200, 300, "rs2", "G", "T", "y"), 1u);
+  EXPECT_EQ(rb.append("chr2", 50, -1, "", "", "", ""), 2u);
+  EXPECT_EQ(rb.size(), 3u);
+  EXPECT_EQ(rb.get_chr(0), "chr1");
+  EXPECT_EQ(rb.get_chr(2), "chr2");
+  EXPECT_EQ(rb.get_chr_index(0), rb.get_chr_index(1));
+  EXPECT_NE(rb.get_chr_index(1), rb.get_chr_index(2));
+  EXPECT_EQ(rb.get_pos1(1), mpz_class(200));
+  EXPECT_EQ(rb.get_pos2(1), mpz_class(300));
+  EXPECT_EQ(rb.get_pos2(2), mpz_class(-1));
+  EXPECT_EQ(rb.get_id(1), "rs2");
+  EXPECT_EQ(rb.get_a1(1), "G");
+  EXPECT_EQ(rb.get_a2(1), "T");
+  EXPECT_EQ(rb.get_label(0), "x");
+  EXPECT_TRUE(rb.get_results(0).empty());
+  EXPECT_THROW(rb.get_id(3), std::runtime_error);
+}
+
+TEST(recordBatchTest, clearAllowsRefill) {
+  igp::record_batch rb;
+  rb.append("chr1", 100, -1, "rs1", "A", "C", "");
+  rb.append("chr1", 200, -1, "rs2", "A", "C", "");
+  rb.get_mutable_results(1)->push_back(igp::query_result());
+  rb.clear();
+  EXPECT_EQ(rb.size(), 0u);
+  EXPECT_THROW(rb.get_chr(0), std::runtime_error);
+  rb.append("chr3", 10, -1, "rs3", "G", "T", "");
+  EXPECT_EQ(rb.size(), 1u);
+  EXPECT_EQ(rb.get_chr(0), "chr3");
+  EXPECT_EQ(rb.get_chr_index(0), 0u);
+  EXPECT_EQ(rb.get_id(0), "rs3");
+  EXPECT_EQ(rb.get_pos1(0), mpz_class(10));
+}
+
+TEST(recordBatchTest, keepsResultSetsApart) {
+  igp::record_batch rb;
+  EXPECT_EQ(rb.get_result_sets(), 1u);
+  rb.append("chr1", 100, -1, "rs1", "A", "C", "");
+  rb.set_result_sets(2);
+  rb.append("chr1", 200, -1, "rs2", "A", "C", "");
+  rb.get_mutable_results(1)->push_back(igp::query_result());
+  EXPECT_TRUE(rb.get_results(0, 1).empty());
+  EXPECT_TRUE(rb.get_results(1, 1).empty());
+  rb.get_mutable_results(0, 1)->resize(2);
+  EXPECT_TRUE(rb.get_results(0).empty());
+  EXPECT_EQ(rb.get_results(1).size(), 1u);
+  EXPECT_EQ(rb.get_results(0, 1).size(), 2u);
+  EXPECT_THROW(rb.get_results(0, 2), std::runtime_error);
+  EXPECT_THROW(rb.set_result_sets(0), std::runtime_error);
+}
+
+TEST(recordBatchTest, vcfRecordsOnlyKeptWhenRequested) {
+  igp::record_batch rb;
+  bcf1_t *record = bcf_init();
+  ASSERT_TRUE(record != NULL);
+  record->pos = 99;
+  rb.append("chr1", 100, -1, "rs1", "A", "C", "");
+  EXPECT_FALSE(rb.get_retain_vcf_records());
+  EXPECT_NO_THROW(rb.set_vcf_record(0, record));
+  EXPECT_THROW(rb.get_vcf_record(0), std::runtime_error);
+  rb.set_retain_vcf_records(true);
+  rb.clear();
+  EXPECT_TRUE(rb.get_retain_vcf_records());
+  rb.append("chr1", 100, -1, "rs1", "A", "C", "");
+  EXPECT_THROW(rb.set_vcf_record(0, NULL), std::runtime_error);
+  EXPECT_NO_THROW(rb.set_vcf_record(0, record));
+  bcf_destroy(record);
+  ASSERT_TRUE(rb.get_vcf_record(0) != NULL);
+  EXPECT_EQ(rb.get_vcf_record(0)->pos, 99);
+}
+
+TEST(recordBatchTest, lineContentsOnlyKeptWhenRequested) {
+  igp::record_batch rb;
+  std::vector<std::string> line = {"1", "100", "rs1", "A", "C", "AF=0.1"};
+  rb.append("1", 100, -1, "rs1", "C", "A", "");
+  EXPECT_FALSE(rb.get_retain_line_contents());
+  rb.set_line_contents(0, line);
+  EXPECT_THROW(rb.get_line_contents(0), std::runtime_error);
+  rb.set_retain_line_contents(true);
+  rb.set_line_contents(0, line);
+  EXPECT_EQ(rb.get_line_contents(0), line);
+  rb.clear();
+  EXPECT_TRUE(rb.get_retain_line_contents());
+  EXPECT_THROW(rb.get_line_contents(0), std::runtime_error);
+}
@@ -0,0 +1,72 @@
+/*!
+ \file ring_buffer_test.cc
+ \brief test of single-producer/single-consumer ring buffer.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/ring_buffer.h"
+
+#include <atomic>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+TEST(ringBufferTest, rejectsZeroCapacity) {
+  EXPECT_THROW(igp::spsc_ring_buffer<int> rb(0), std::runtime_error);
+}
+
+TEST(ringBufferTest, respectsCapacityAndOrder) {
+  igp::spsc_ring_buffer<int> rb(3);
+  int value = 0;
+  EXPECT_EQ(rb.capacity(), 3u);
+  EXPECT_FALSE(rb.try_pop(&value));
+  EXPECT_TRUE(rb.try_push(1));
+  EXPECT_TRUE(rb.try_push(2));
+  EXPECT_TRUE(rb.try_push(3));
+  EXPECT_FALSE(rb.try_push(4));
+  EXPECT_TRUE(rb.try_pop(&value));
+  EXPECT_EQ(value, 1);
+  EXPECT_TRUE(rb.try_push(4));
+  for (int expected = 2; expected <= 4; ++expected) {
+    EXPECT_TRUE(rb.try_pop(&value));
+    EXPECT_EQ(value, expected);
+  }
+  EXPECT_FALSE(rb.try_pop(&value));
+}
+
+TEST(ringBufferTest, blockingCallsStopOnAbort) {
+  igp::spsc_ring_buffer<int> rb(1);
+  std::atomic<bool> abort(true);
+  int value = 0;
+  EXPECT_FALSE(rb.pop(&value, abort));
+  EXPECT_TRUE(rb.push(1, abort));
+  EXPECT_FALSE(rb.push(2, abort));
+  EXPECT_TRUE(rb.pop(&value, abort));
+  EXPECT_EQ(value, 1);
+}
+
+TEST(ringBufferTest, transfersAcrossThreadsInOrder) {
+  igp::spsc_ring_buffer<unsigned> rb(4);
+  std::atomic<bool> abort(false);
+  const unsigned n_values = 100000;
+  unsigned long long sum = 0;
+  bool in_order = true;
+  std::thread consumer([&]() {
+    unsigned value = 0;
+    for (unsigned expected = 0; expected < n_values; ++expected) {
+      if (!rb.pop(&value, abort)) return;
+      in_order = in_order && value == expected;
+      sum += value;
+    }
+  });
+  for (unsigned i = 0; i < n_values; ++i) {
+    EXPECT_TRUE(rb.push(i, abort));
+  }
+  consumer.join();
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(sum,
+            static_cast<unsigned long long>(n_values) * (n_values - 1) / 2);
+}
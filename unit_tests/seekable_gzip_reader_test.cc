@@ -0,0 +1,136 @@
+/*!
+ \file seekable_gzip_reader_test.cc
+ \brief test of gzip decompression from access points.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/seekable_gzip_reader.h"
+
+#include <zlib.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+/*!
+ * \brief write text to a gzip file as two members, with several access
+ * points' worth of poorly compressible map rows in each
+ * \param filename name of file to write
+ * \return uncompressed text of file
+ */
+std::string create_two_member_gzip(const std::string &filename) {
+  std::string members[2];
+  unsigned state = 12345;
+  for (unsigned m = 0; m < 2; ++m) {
+    std::ostringstream text;
+    for (unsigned row = 0; row < 120000; ++row) {
+      state = state * 1103515245u + 12345u;
+      text << "chr" << m + 1 << ' ' << row * 100 << ' ' << (state >> 8) % 9973
+           << ".0" << (state >> 4) % 97 << ' ' << state % 100003 << '\n';
+    }
+    members[m] = text.str();
+    gzFile output = gzopen(filename.c_str(), m ? "ab" : "wb");
+    EXPECT_TRUE(output != NULL);
+    gzwrite(output, members[m].c_str(), members[m].size());
+    gzclose(output);
+  }
+  return members[0] + members[1];
+}
+std::string read_all(igp::seekable_gzip_reader *reader) {
+  std::string text;
+  std::vector<char> buffer(100000);
+  size_t n_read = 0;
+  while ((n_read = reader->read(buffer.data(), buffer.size()))) {
+    text.append(buffer.data(), n_read);
+  }
+  return text;
+}
+}  // namespace
+
+TEST(seekableGzipReaderTest, recordsAccessPointsWhileReading) {
+  std::string filename = boost::filesystem::unique_path().native() + ".gz";
+  std::string content = create_two_member_gzip(filename);
+  igp::seekable_gzip_reader reader;
+  reader.set_record_access_points(true);
+  ASSERT_TRUE(reader.open(filename));
+  EXPECT_EQ(read_all(&reader), content);
+  EXPECT_EQ(reader.tell(), content.size());
+  const std::vector<igp::seekable_gzip_reader::access_point> &points =
+      reader.get_access_points();
+  ASSERT_GT(points.size(), 3u);
+  EXPECT_EQ(points.front().out, 0u);
+  for (unsigned i = 1; i < points.size(); ++i) {
+    EXPECT_GE(points.at(i).out - points.at(i - 1).out,
+              igp::seekable_gzip_reader::access_point_span);
+    EXPECT_EQ(points.at(i).window.size(), 32768u);
+  }
+  boost::filesystem::remove(filename);
+}
+
+TEST(seekableGzipReaderTest, seeksFromAccessPoints) {
+  std::string filename = boost::filesystem::unique_path().native() + ".gz";
+  std::string content = create_two_member_gzip(filename);
+  std::vector<igp::seekable_gzip_reader::access_point> points;
+  {
+    igp::seekable_gzip_reader recorder;
+    recorder.set_record_access_points(true);
+    ASSERT_TRUE(recorder.open(filename));
+    read_all(&recorder);
+    points = recorder.get_access_points();
+  }
+  // forward and backward, within and across spans and members
+  const uint64_t offsets[] = {5000000, 5000100, 100,     2500000,
+                              content.size() / 2, content.size() - 10,
+                              0,       3333333, 3333333};
+  for (unsigned threads = 1; threads <= 4; threads += 3) {
+    igp::seekable_gzip_reader reader;
+    reader.set_threads(threads);
+    ASSERT_TRUE(reader.open(filename));
+    reader.set_access_points(points);
+    std::vector<char> buffer(70000);
+    for (unsigned i = 0; i < sizeof(offsets) / sizeof(uint64_t); ++i) {
+      reader.seek(offsets[i]);
+      EXPECT_EQ(reader.tell(), offsets[i]);
+      size_t n_read = reader.read(buffer.data(), buffer.size());
+      EXPECT_EQ(std::string(buffer.data(), n_read),
+                content.substr(offsets[i], buffer.size()));
+    }
+    // the rest of the text, decoded ahead on workers when threaded
+    reader.seek(1000);
+    EXPECT_EQ(read_all(&reader), content.substr(1000));
+    reader.seek(content.size() + 10);
+    EXPECT_EQ(reader.read(buffer.data(), buffer.size()), 0u);
+  }
+  boost::filesystem::remove(filename);
+}
+
+TEST(seekableGzipReaderTest, refusesFilesWithoutGzipHeader) {
+  std::string filename = boost::filesystem::unique_path().native() + ".gz";
+  igp::seekable_gzip_reader reader;
+  EXPECT_FALSE(reader.open(filename));
+  std::ofstream output(filename.c_str());
+  output << "chr1 1000000 0.1 0\n";
+  output.close();
+  EXPECT_FALSE(reader.open(filename));
+  EXPECT_FALSE(reader.is_open());
+  boost::filesystem::remove(filename);
+}
+
+TEST(seekableGzipReaderTest, rejectsTruncatedFiles) {
+  std::string filename = boost::filesystem::unique_path().native() + ".gz";
+  create_two_member_gzip(filename);
+  boost::filesystem::resize_file(filename,
+                                 boost::filesystem::file_size(filename) / 2);
+  igp::seekable_gzip_reader reader;
+  ASSERT_TRUE(reader.open(filename));
+  EXPECT_THROW(read_all(&reader), std::runtime_error);
+  boost::filesystem::remove(filename);
+}
@@ -0,0 +1,136 @@
+/*!
+ \file shared_genetic_map_file_test.cc
+ \brief test of genetic map shared between readers.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/shared_genetic_map_file.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+#include "interpolate-genetic-position/input_genetic_map_file.h"
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+/*!
+ * \brief step a shared map and the streamed map through every row,
+ * expecting the same bounds and eof() at each step
+ * \param shared opened shared map reader
+ * \param streamed opened streamed map reader
+ * \return number of steps taken before the streamed map ran out
+ */
+unsigned expect_same_rows(igp::shared_genetic_map_file *shared,
+                          igp::input_genetic_map_file *streamed) {
+  bool more = true;
+  unsigned steps = 0;
+  while (more) {
+    EXPECT_EQ(shared->get_chr_lower_bound(), streamed->get_chr_lower_bound());
+    EXPECT_EQ(shared->get_chr_upper_bound(), streamed->get_chr_upper_bound());
+    EXPECT_EQ(shared->get_startpos_lower_bound(),
+              streamed->get_startpos_lower_bound());
+    EXPECT_EQ(shared->get_startpos_upper_bound(),
+              streamed->get_startpos_upper_bound());
+    EXPECT_EQ(shared->get_endpos_lower_bound(),
+              streamed->get_endpos_lower_bound());
+    EXPECT_EQ(shared->get_endpos_upper_bound(),
+              streamed->get_endpos_upper_bound());
+    EXPECT_EQ(shared->get_gpos_lower_bound(),
+              streamed->get_gpos_lower_bound());
+    EXPECT_EQ(shared->get_gpos_upper_bound(),
+              streamed->get_gpos_upper_bound());
+    EXPECT_EQ(shared->get_rate_lower_bound(),
+              streamed->get_rate_lower_bound());
+    EXPECT_EQ(shared->get_rate_upper_bound(),
+              streamed->get_rate_upper_bound());
+    EXPECT_EQ(shared->eof(), streamed->eof());
+    more = streamed->get();
+    EXPECT_EQ(shared->get(), more);
+    ++steps;
+  }
+  EXPECT_EQ(shared->eof(), streamed->eof());
+  return steps;
+}
+}  // namespace
+
+TEST(sharedGeneticMapFileTest, matchesStreamedTextMaps) {
+  std::string filename = boost::filesystem::unique_path().native();
+  {
+    std::ofstream output(filename.c_str());
+    output << "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n"
+              "1 1000000 0.1 0\n"
+              "1 2000000 0.2 0.1\n"
+              "2 500000 1.0 0\n"
+              "2 1500000 0.0 1.0\n";
+  }
+  igp::input_genetic_map_file streamed;
+  igp::shared_genetic_map_file shared;
+  streamed.open(filename, igp::BOLT);
+  shared.open(filename, igp::BOLT);
+  EXPECT_EQ(shared.size(), 4u);
+  EXPECT_EQ(expect_same_rows(&shared, &streamed), 3u);
+  streamed.close();
+  {
+    std::ofstream output(filename.c_str());
+    output << "chr1\t0\t1\t0.012\nchr1\t1\t2\t0.111\nchr4\t2\t3\t0.213\n";
+  }
+  streamed.open(filename, igp::BEDGRAPH);
+  shared.open(filename, igp::BEDGRAPH);
+  EXPECT_EQ(shared.size(), 3u);
+  EXPECT_EQ(expect_same_rows(&shared, &streamed), 2u);
+  streamed.close();
+  boost::filesystem::remove(filename);
+}
+
+TEST(sharedGeneticMapFileTest, matchesStreamedBigwig) {
+  for (unsigned n_threads = 1; n_threads <= 2; ++n_threads) {
+    igp::input_genetic_map_file streamed;
+    igp::shared_genetic_map_file shared;
+    shared.set_threads(n_threads);
+    streamed.open("unit_tests/test.bw", igp::BIGWIG);
+    shared.open("unit_tests/test.bw", igp::BIGWIG);
+    // bigwig maps only report eof() after a read past the final row
+    EXPECT_EQ(expect_same_rows(&shared, &streamed), 7u);
+  }
+}
+
+TEST(sharedGeneticMapFileTest, readersAreIndependent) {
+  std::istringstream strm(
+      "chr position COMBINED_rate(cM/Mb) Genetic_Map(cM)\n"
+      "1 1000000 0.1 0\n"
+      "1 2000000 0.2 0.1\n"
+      "1 3000000 0.0 0.3\n");
+  igp::shared_genetic_map_file shared, first, second;
+  shared.set_fallback_stream(&strm);
+  shared.open("", igp::BOLT);
+  first.share(shared);
+  EXPECT_TRUE(first.get());
+  EXPECT_EQ(first.get_startpos_lower_bound(), mpz_class(2000000));
+  // a new reader starts from the beginning, and the rows outlive the
+  // reader they were loaded by
+  shared.close();
+  second.share(first);
+  EXPECT_EQ(second.get_startpos_lower_bound(), mpz_class(1000000));
+  EXPECT_EQ(first.get_startpos_lower_bound(), mpz_class(2000000));
+  igp::map_block block;
+  EXPECT_TRUE(second.get_block(&block, 10));
+  EXPECT_EQ(block.size(), 3u);
+  EXPECT_EQ(block.get_gpos(2), mpf_class("0.3"));
+  EXPECT_FALSE(second.get_block(&block, 10));
+}
+
+TEST(sharedGeneticMapFileTest, rejectsInvalidUse) {
+  igp::shared_genetic_map_file shared, unopened;
+  EXPECT_THROW(shared.set_threads(0), std::runtime_error);
+  EXPECT_THROW(shared.share(unopened), std::runtime_error);
+  EXPECT_THROW(shared.get_fallback_stream(), std::runtime_error);
+  EXPECT_THROW(shared.open("", igp::BOLT), std::runtime_error);
+  EXPECT_THROW(shared.open("dummyfile.txt", igp::BOLT), std::runtime_error);
+  EXPECT_TRUE(shared.eof());
+  EXPECT_THROW(igp::shared_genetic_map_file copy(shared), std::runtime_error);
+}
@@ -7,6 +7,11 @@
 
 #include "interpolate-genetic-position/utilities.h"
 
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -44,6 +49,18 @@ TEST(utilitiesTest, vcfNameConversion) {
   EXPECT_EQ(igp::string_to_format_type("vcf"), igp::VCF);
 }
 
+TEST(utilitiesTest, bcfNameConversion) {
+  EXPECT_EQ(igp::string_to_format_type("bcf"), igp::BCF);
+}
+
+TEST(utilitiesTest, pvarNameConversion) {
+  EXPECT_EQ(igp::string_to_format_type("pvar"), igp::PVAR);
+}
+
+TEST(utilitiesTest, arrowNameConversion) {
+  EXPECT_EQ(igp::string_to_format_type("arrow"), igp::ARROW);
+}
+
 TEST(utilitiesTest, chromosomeToIntegerAutosome) {
   int chrint = 0;
   EXPECT_TRUE(igp::chromosome_to_integer("2", &chrint));
@@ -180,4 +197,93 @@ TEST(utilitiesTest, detectInvalidFormatCombinations) {
   EXPECT_THROW(igp::check_io_combinations("vcf", "bolt"), std::domain_error);
   EXPECT_NO_THROW(igp::check_io_combinations("vcf", "map"));
   EXPECT_NO_THROW(igp::check_io_combinations("vcf", "snp"));
+  EXPECT_NO_THROW(igp::check_io_combinations("vcf", "vcf"));
+  EXPECT_NO_THROW(igp::check_io_combinations("vcf", "bcf"));
+  EXPECT_THROW(igp::check_io_combinations("bim", "vcf"), std::domain_error);
+  EXPECT_THROW(igp::check_io_combinations("bed", "bcf"), std::domain_error);
+  EXPECT_NO_THROW(igp::check_io_combinations("pvar", "bim"));
+  EXPECT_THROW(igp::check_io_combinations("pvar", "bolt"), std::domain_error);
+  EXPECT_NO_THROW(igp::check_io_combinations("pvar", "map"));
+  EXPECT_NO_THROW(igp::check_io_combinations("pvar", "snp"));
+  EXPECT_NO_THROW(igp::check_io_combinations("pvar", "pvar"));
+  EXPECT_THROW(igp::check_io_combinations("pvar", "vcf"), std::domain_error);
+  EXPECT_THROW(igp::check_io_combinations("bim", "pvar"), std::domain_error);
+  EXPECT_THROW(igp::check_io_combinations("vcf", "pvar"), std::domain_error);
+  EXPECT_NO_THROW(igp::check_io_combinations("bim", "arrow"));
+  EXPECT_NO_THROW(igp::check_io_combinations("map", "arrow"));
+  EXPECT_NO_THROW(igp::check_io_combinations("snp", "arrow"));
+  EXPECT_NO_THROW(igp::check_io_combinations("vcf", "arrow"));
+  EXPECT_NO_THROW(igp::check_io_combinations("pvar", "arrow"));
+  EXPECT_NO_THROW(igp::check_io_combinations("bed", "arrow"));
+  EXPECT_THROW(igp::check_io_combinations("arrow", "bim"), std::domain_error);
+  EXPECT_NO_THROW(igp::check_io_combinations("bim", "bigwig"));
+  EXPECT_NO_THROW(igp::check_io_combinations("map", "bigwig"));
+  EXPECT_NO_THROW(igp::check_io_combinations("snp", "bigwig"));
+  EXPECT_NO_THROW(igp::check_io_combinations("vcf", "bigwig"));
+  EXPECT_NO_THROW(igp::check_io_combinations("pvar", "bigwig"));
+  EXPECT_NO_THROW(igp::check_io_combinations("bed", "bigwig"));
+}
+
+TEST(utilitiesTest, readFilenameList) {
+  std::string filename = boost::filesystem::unique_path().native();
+  {
+    std::ofstream output(filename.c_str());
+    output << "batch1.bim\n\n# skipped\n  dir/batch 2.bim \r\n";
+  }
+  std::vector<std::string> expected = {"batch1.bim", "dir/batch 2.bim"};
+  EXPECT_EQ(igp::read_filename_list(filename), expected);
+  boost::filesystem::remove(filename);
+  EXPECT_THROW(igp::read_filename_list(filename), std::runtime_error);
+}
+
+TEST(utilitiesTest, deriveOutputFilename) {
+  EXPECT_EQ(igp::derive_output_filename("in/batch1.bim", "out", "map"),
+            "out/batch1.map");
+  EXPECT_EQ(igp::derive_output_filename("batch1.vcf.gz", "out/", "bim"),
+            "out/batch1.bim");
+  EXPECT_EQ(igp::derive_output_filename("/a/b.c/batch1", "out", "bigwig"),
+            "out/batch1.bw");
+  EXPECT_EQ(igp::derive_output_filename("in/.hidden", "out", "map"),
+            "out/.hidden.map");
+  EXPECT_THROW(igp::derive_output_filename("batch1.bim", "out", "nope"),
+               std::runtime_error);
+}
+
+TEST(utilitiesTest, deriveMapOutputFilename) {
+  EXPECT_EQ(igp::derive_map_output_filename("out.bim", "maps/male.txt.gz"),
+            "out.male.bim");
+  EXPECT_EQ(igp::derive_map_output_filename("res/out.vcf.gz", "female.bw"),
+            "res/out.female.vcf.gz");
+  EXPECT_EQ(igp::derive_map_output_filename("res.d/out", "a.b/male"),
+            "res.d/out.male");
+  EXPECT_EQ(igp::derive_map_output_filename("out.gz", "male.txt"),
+            "out.male.gz");
+  EXPECT_EQ(igp::derive_map_output_filename(".out", "male.txt"),
+            ".out.male");
+}
+
+TEST(utilitiesTest, outputFileExtension) {
+  EXPECT_EQ(igp::output_file_extension(igp::BOLT), "bolt");
+  EXPECT_EQ(igp::output_file_extension(igp::BIGWIG), "bw");
+  EXPECT_EQ(igp::output_file_extension(igp::VCF), "vcf");
+  EXPECT_EQ(igp::output_file_extension(igp::ARROW), "arrow");
+  EXPECT_THROW(igp::output_file_extension(igp::BEDGRAPH), std::runtime_error);
+}
+
+TEST(utilitiesTest, mpfToDoubleRoundsToNearest) {
+  EXPECT_EQ(igp::mpf_to_double(mpf_class("0.05")), 0.05);
+  EXPECT_EQ(igp::mpf_to_double(mpf_class("-0.05")), -0.05);
+  EXPECT_EQ(igp::mpf_to_double(mpf_class("1.5")), 1.5);
+  EXPECT_EQ(igp::mpf_to_double(mpf_class(0)), 0.0);
+  // halfway cases go to the even neighbour
+  mpf_class ulp(1, 128), value(1, 128);
+  mpf_div_2exp(ulp.get_mpf_t(), ulp.get_mpf_t(), 52);
+  value += ulp / 2;
+  EXPECT_EQ(igp::mpf_to_double(value), 1.0);
+  value += ulp;
+  EXPECT_EQ(igp::mpf_to_double(value), 1.0 + 2.0 * ulp.get_d());
+  // just past halfway rounds up
+  mpf_class above(1, 128);
+  above += ulp / 2 + ulp / 1024;
+  EXPECT_EQ(igp::mpf_to_double(above), 1.0 + ulp.get_d());
 }
@@ -0,0 +1,88 @@
+/*!
+ \file zstd_line_reader_test.cc
+ \brief test of streaming zstd line reader.
+ \copyright Released under the MIT License.
+ Copyright 2023 Lightning Auriga
+ */
+
+#include "interpolate-genetic-position/zstd_line_reader.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+#include "gtest/gtest.h"
+
+namespace igp = interpolate_genetic_position;
+
+namespace {
+/*!
+ * \brief compress text as a single zstd frame
+ */
+std::string compress_frame(const std::string &text) {
+  std::vector<char> buffer(ZSTD_compressBound(text.size()));
+  size_t res =
+      ZSTD_compress(buffer.data(), buffer.size(), text.data(), text.size(), 3);
+  if (ZSTD_isError(res)) {
+    throw std::runtime_error("compress_frame: compression failed");
+  }
+  return std::string(buffer.data(), res);
+}
+
+void write_file(const std::string &filename, const std::string &contents) {
+  std::ofstream output(filename.c_str(), std::ios::binary);
+  output << contents;
+  output.close();
+}
+}  // namespace
+
+TEST(zstdLineReaderTest, readsLinesAcrossFrames) {
+  std::string filename = boost::filesystem::unique_path().native() + ".zst";
+  // a line longer than a decompression block, and a final line with
+  // no newline, split over two concatenated frames
+  std::string long_line(ZSTD_DStreamOutSize() * 2 + 17, 'x');
+  write_file(filename, compress_frame("#CHROM\tPOS\n1\t100\n" + long_line +
+                                      "\n") +
+                           compress_frame("2\t200"));
+  igp::zstd_line_reader reader;
+  EXPECT_FALSE(reader.is_open());
+  reader.open(filename);
+  EXPECT_TRUE(reader.is_open());
+  std::string line = "";
+  EXPECT_FALSE(reader.eof());
+  EXPECT_TRUE(reader.getline(&line));
+  EXPECT_EQ(line, "#CHROM\tPOS");
+  EXPECT_TRUE(reader.getline(&line));
+  EXPECT_EQ(line, "1\t100");
+  EXPECT_TRUE(reader.getline(&line));
+  EXPECT_EQ(line, long_line);
+  EXPECT_FALSE(reader.eof());
+  EXPECT_TRUE(reader.getline(&line));
+  EXPECT_EQ(line, "2\t200");
+  EXPECT_TRUE(reader.eof());
+  EXPECT_FALSE(reader.getline(&line));
+  reader.close();
+  EXPECT_FALSE(reader.is_open());
+  boost::filesystem::remove(filename);
+}
+
+TEST(zstdLineReaderTest, rejectsTruncatedInput) {
+  std::string filename = boost::filesystem::unique_path().native() + ".zst";
+  std::string frame = compress_frame("1\t100\n2\t200\n");
+  write_file(filename, frame.substr(0, frame.size() - 4));
+  igp::zstd_line_reader reader;
+  reader.open(filename);
+  std::string line = "";
+  EXPECT_THROW(
+      while (reader.getline(&line)) {}, std::runtime_error);
+  reader.close();
+  boost::filesystem::remove(filename);
+}
+
+TEST(zstdLineReaderTest, rejectsMissingFile) {
+  igp::zstd_line_reader reader;
+  EXPECT_THROW(reader.open("/this/file/does/not/exist.zst"),
+               std::runtime_error);
+  EXPECT_FALSE(reader.is_open());
+}